@@ -0,0 +1,295 @@
+/**
+ * pb-cpp-data-bench: parsing throughput on the generated reference datasets (bench/generator.h).
+ * Every benchmark runs until --min-time has passed, and at least three times, and reports the fastest
+ * run as MB/s and rows/s.  --save writes the results as JSON and --baseline compares against such a
+ * file, exiting with status 1 when a benchmark got slower by more than --threshold percent.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/cpu.h>
+#include <pb/csv.h>
+#include <pb/json.h>
+#include <pb/properties.h>
+
+#include "generator.h"
+
+
+namespace {
+
+    constexpr uint64_t SEED = 0x7062637070646174ull;
+
+    struct Options {
+        std::string filter;
+        size_t size = 8 << 20;
+        double min_time = 0.5;
+        std::string baseline;
+        std::string save;
+        double threshold = 10.0;
+        std::string data_dir;
+    };
+
+    struct Benchmark {
+        std::string name;
+        std::string data;
+        size_t rows;
+        std::function<size_t(std::string_view)> run;    // Returns something derived from the result, so it is not optimized away
+    };
+
+    struct Result {
+        std::string name;
+        size_t bytes;
+        size_t rows;
+        size_t iterations;
+        double seconds;         // Fastest run
+
+        double mb_per_s() const { return static_cast<double>(bytes) / seconds / 1e6; }
+        double rows_per_s() const { return static_cast<double>(rows) / seconds; }
+    };
+
+    volatile size_t sink;
+
+    size_t parse_size(std::string_view text) {
+        size_t scale = 1;
+        if (!text.empty() && (text.back() == 'K' || text.back() == 'k')) {
+            scale = 1 << 10;
+        } else if (!text.empty() && (text.back() == 'M' || text.back() == 'm')) {
+            scale = 1 << 20;
+        } else if (!text.empty() && (text.back() == 'G' || text.back() == 'g')) {
+            scale = 1 << 30;
+        }
+        if (scale != 1) {
+            text.remove_suffix(1);
+        }
+        return static_cast<size_t>(std::stoull(std::string(text))) * scale;
+    }
+
+    void usage() {
+        std::puts("usage: pb-cpp-data-bench [options]\n"
+                  "  --filter=TEXT       run the benchmarks whose name contains TEXT\n"
+                  "  --size=BYTES        size of the large datasets, K, M and G suffixes allowed (default 8M)\n"
+                  "  --min-time=SECONDS  minimum time per benchmark (default 0.5)\n"
+                  "  --save=FILE         write the results as JSON\n"
+                  "  --baseline=FILE     compare against results saved with --save\n"
+                  "  --threshold=PERCENT slowdown reported as a regression (default 10)\n"
+                  "  --cpu-level=LEVEL   cap the SIMD level: scalar, sse2, sse4.2, avx2 or avx512\n"
+                  "  --write-data=DIR    write the datasets to DIR and exit\n"
+                  "  --list              list the benchmarks and exit");
+    }
+
+    std::vector<Benchmark> make_benchmarks(const Options& options) {
+        std::vector<Benchmark> benchmarks;
+        auto add = [&](std::string name, std::string data, size_t rows, std::function<size_t(std::string_view)> run) {
+            if (name.find(options.filter) != std::string::npos) {
+                benchmarks.push_back(Benchmark{ std::move(name), std::move(data), rows, std::move(run) });
+            }
+        };
+
+        for (pb::bench::CsvShape shape : { pb::bench::CsvShape::NARROW_NUMERIC, pb::bench::CsvShape::WIDE_TEXT,
+                                           pb::bench::CsvShape::QUOTED }) {
+            size_t rows = 0;
+            std::string data = pb::bench::generate_csv(shape, options.size, SEED, &rows);
+            add("csv-count/" + pb::bench::csv_shape_name(shape), data, rows, [](std::string_view text) {
+                pb::CSVProperties properties;
+                properties.set_has_header(true);
+                return pb::CSV(properties).count_rows(text);
+            });
+            add("csv/" + pb::bench::csv_shape_name(shape), std::move(data), rows, [](std::string_view text) {
+                pb::CSVProperties properties;
+                properties.set_delimiter(pb::COMMA);
+                properties.set_has_header(true);
+                pb::CSV csv(properties);
+                csv.parse(text);
+                return csv.get_row_count();
+            });
+        }
+
+        for (pb::bench::JsonShape shape : { pb::bench::JsonShape::FLAT, pb::bench::JsonShape::DEEP,
+                                            pb::bench::JsonShape::ARRAYS }) {
+            size_t rows = 0;
+            std::string data = pb::bench::generate_json(shape, options.size, SEED, &rows);
+            add("json/" + pb::bench::json_shape_name(shape), std::move(data), rows, [](std::string_view text) {
+                return pb::read_json(text).size();
+            });
+        }
+
+        // Small files measure the fixed costs, large ones the per byte ones
+        const std::pair<const char*, size_t> properties_sizes[] = {
+            { "properties/4K", 4 << 10 }, { "properties/256K", 256 << 10 }, { "properties/large", options.size }
+        };
+        for (const auto& [name, bytes] : properties_sizes) {
+            size_t rows = 0;
+            std::string data = pb::bench::generate_properties(std::min(bytes, options.size), SEED, &rows);
+            add(name, std::move(data), rows, [](std::string_view text) {
+                pb::Properties properties;
+                properties.parse(text);
+                return properties.size();
+            });
+        }
+        return benchmarks;
+    }
+
+    Result measure(const Benchmark& benchmark, double min_time) {
+        using clock = std::chrono::steady_clock;
+        sink = benchmark.run(benchmark.data);      // Warm up caches and allocator
+        Result result{ benchmark.name, benchmark.data.size(), benchmark.rows, 0, 1e300 };
+        clock::time_point start = clock::now();
+        do {
+            clock::time_point begin = clock::now();
+            sink = benchmark.run(benchmark.data);
+            std::chrono::duration<double> elapsed = clock::now() - begin;
+            result.seconds = std::min(result.seconds, elapsed.count());
+            ++result.iterations;
+        } while (result.iterations < 3 || std::chrono::duration<double>(clock::now() - start).count() < min_time);
+        return result;
+    }
+
+    std::string results_json(const std::vector<Result>& results, const Options& options) {
+        std::ostringstream out;
+        out << "{\n  \"cpu_level\": \"" << pb::cpu_level_name(pb::cpu_level()) << "\",\n";
+        out << "  \"size\": " << options.size << ",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            char line[256];
+            std::snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"mb_per_s\": %.3f, \"rows_per_s\": %.1f}",
+                          i > 0 ? "," : "", results[i].name.c_str(), results[i].mb_per_s(), results[i].rows_per_s());
+            out << line;
+        }
+        out << "\n  ]\n}\n";
+        return out.str();
+    }
+
+    // MB/s per benchmark name in a file written by --save
+    std::map<std::string, double, std::less<>> read_baseline(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open baseline: " + path);
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        pb::Blob blob = pb::read_json(text);
+        std::map<std::string, double, std::less<>> baseline;
+        pb::BlobView results = blob.root()["results"];
+        for (size_t i = 0; i < results.size(); ++i) {
+            pb::BlobView result = results[i];
+            baseline.emplace(std::string(result["name"].as_string()), result["mb_per_s"].as_double());
+        }
+        return baseline;
+    }
+
+    int run(const Options& options) {
+        std::vector<Benchmark> benchmarks = make_benchmarks(options);
+        if (!options.data_dir.empty()) {
+            for (const Benchmark& benchmark : benchmarks) {
+                std::string name = benchmark.name;
+                std::replace(name.begin(), name.end(), '/', '-');
+                std::string extension = name.substr(0, name.find('-'));
+                std::string path = options.data_dir + "/" + name + "." + extension;
+                std::ofstream(path, std::ios::binary) << benchmark.data;
+                std::printf("%s (%zu bytes, %zu rows)\n", path.c_str(), benchmark.data.size(), benchmark.rows);
+            }
+            return 0;
+        }
+
+        std::map<std::string, double, std::less<>> baseline;
+        if (!options.baseline.empty()) {
+            baseline = read_baseline(options.baseline);
+        }
+
+        std::printf("cpu level %s, large datasets %zu bytes\n\n", std::string(pb::cpu_level_name(pb::cpu_level())).c_str(),
+                    options.size);
+        std::printf("%-24s %12s %10s %14s %8s\n", "benchmark", "bytes", "MB/s", "rows/s", "change");
+        std::vector<Result> results;
+        int regressions = 0;
+        for (const Benchmark& benchmark : benchmarks) {
+            Result result = measure(benchmark, options.min_time);
+            std::string change;
+            auto found = baseline.find(result.name);
+            if (found != baseline.end() && found->second > 0) {
+                double percent = (result.mb_per_s() / found->second - 1.0) * 100.0;
+                char text[32];
+                std::snprintf(text, sizeof(text), "%+.1f%%", percent);
+                change = text;
+                if (percent < -options.threshold) {
+                    change += " REGRESSION";
+                    ++regressions;
+                }
+            }
+            std::printf("%-24s %12zu %10.1f %14.0f %8s\n", result.name.c_str(), result.bytes, result.mb_per_s(),
+                        result.rows_per_s(), change.c_str());
+            results.push_back(result);
+        }
+
+        if (!options.save.empty()) {
+            std::ofstream(options.save, std::ios::binary) << results_json(results, options);
+        }
+        if (regressions > 0) {
+            std::printf("\n%d benchmark(s) more than %.1f%% slower than %s\n", regressions, options.threshold,
+                        options.baseline.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+}
+
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view argument(argv[i]);
+            size_t equals = argument.find('=');
+            std::string_view name = argument.substr(0, equals);
+            std::string value(equals == std::string_view::npos ? std::string_view() : argument.substr(equals + 1));
+            if (name == "--filter") {
+                options.filter = value;
+            } else if (name == "--size") {
+                options.size = parse_size(value);
+            } else if (name == "--min-time") {
+                options.min_time = std::stod(value);
+            } else if (name == "--save") {
+                options.save = value;
+            } else if (name == "--baseline") {
+                options.baseline = value;
+            } else if (name == "--threshold") {
+                options.threshold = std::stod(value);
+            } else if (name == "--write-data") {
+                options.data_dir = value;
+            } else if (name == "--cpu-level") {
+                std::optional<pb::CpuLevel> level = pb::parse_cpu_level(value);
+                if (!level) {
+                    throw std::runtime_error("Unknown CPU level: " + value);
+                }
+                pb::set_cpu_level(*level);
+            } else if (name == "--list") {
+                Options small = options;
+                small.size = 1 << 10;
+                for (const Benchmark& benchmark : make_benchmarks(small)) {
+                    std::puts(benchmark.name.c_str());
+                }
+                return 0;
+            } else {
+                usage();
+                return name == "--help" ? 0 : 2;
+            }
+        }
+        return run(options);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "pb-cpp-data-bench: %s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,284 @@
+/**
+ * Deterministic reference datasets for the benchmarks.
+ * Every generator takes a target size in bytes and a seed and always produces the same text for the
+ * same arguments, on every platform, so results from different machines and builds compare the same
+ * input.  Generation stops at the first record boundary past the target size.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+
+namespace pb::bench {
+
+    // splitmix64: tiny, fast, and defined by its arithmetic alone, unlike the std distributions
+    class Random {
+        public:
+            explicit Random(uint64_t seed) : state_(seed) {}
+
+            uint64_t next() {
+                uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            // Uniform in [0, bound)
+            uint64_t below(uint64_t bound) {
+                return next() % bound;
+            }
+
+            bool chance(unsigned percent) {
+                return below(100) < percent;
+            }
+
+        private:
+            uint64_t state_;
+    };
+
+    enum class CsvShape {
+        NARROW_NUMERIC,     // 6 columns of integers and decimals
+        WIDE_TEXT,          // 40 columns of words
+        QUOTED              // 8 columns, most quoted, with embedded separators, quotes and line breaks
+    };
+
+    enum class JsonShape {
+        FLAT,               // An array of small objects with scalar members
+        DEEP,               // An array of objects nested 24 levels deep
+        ARRAYS              // An array of objects holding long numeric arrays
+    };
+
+    namespace detail {
+
+        inline constexpr std::string_view BENCH_WORDS[] = {
+            "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel", "india", "juliet",
+            "kilo", "lima", "mike", "november", "oscar", "papa", "quebec", "romeo", "sierra", "tango",
+            "uniform", "victor", "whiskey", "xray", "yankee", "zulu", "data", "value", "record", "column"
+        };
+
+        inline std::string_view bench_word(Random& random) {
+            return BENCH_WORDS[random.below(std::size(BENCH_WORDS))];
+        }
+
+        inline void bench_append_decimal(std::string& out, Random& random) {
+            if (random.chance(30)) {
+                out.push_back('-');
+            }
+            out += std::to_string(random.below(100000));
+            out.push_back('.');
+            uint64_t fraction = random.below(10000);
+            for (uint64_t scale = 1000; scale > 0; scale /= 10) {
+                out.push_back(static_cast<char>('0' + fraction / scale % 10));
+            }
+        }
+
+        inline void bench_append_words(std::string& out, Random& random, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    out.push_back(' ');
+                }
+                out += bench_word(random);
+            }
+        }
+
+    } // namespace detail
+
+    inline std::string csv_shape_name(CsvShape shape) {
+        switch (shape) {
+            case CsvShape::NARROW_NUMERIC: return "narrow-numeric";
+            case CsvShape::WIDE_TEXT: return "wide-text";
+            case CsvShape::QUOTED: return "quoted";
+        }
+        return "unknown";
+    }
+
+    inline std::string json_shape_name(JsonShape shape) {
+        switch (shape) {
+            case JsonShape::FLAT: return "flat";
+            case JsonShape::DEEP: return "deep";
+            case JsonShape::ARRAYS: return "arrays";
+        }
+        return "unknown";
+    }
+
+    /**
+     * CSV with a header line.  rows receives the number of data records.
+     */
+    inline std::string generate_csv(CsvShape shape, size_t bytes, uint64_t seed, size_t* rows = nullptr) {
+        Random random(seed);
+        std::string out;
+        out.reserve(bytes + 4096);
+        size_t columns = shape == CsvShape::NARROW_NUMERIC ? 6 : shape == CsvShape::WIDE_TEXT ? 40 : 8;
+        for (size_t column = 0; column < columns; ++column) {
+            out += (column > 0 ? ",column" : "column") + std::to_string(column);
+        }
+        out.push_back('\n');
+
+        size_t count = 0;
+        while (out.size() < bytes) {
+            for (size_t column = 0; column < columns; ++column) {
+                if (column > 0) {
+                    out.push_back(',');
+                }
+                switch (shape) {
+                    case CsvShape::NARROW_NUMERIC:
+                        if (column % 2 == 0) {
+                            out += std::to_string(random.below(1000000000));
+                        } else {
+                            detail::bench_append_decimal(out, random);
+                        }
+                        break;
+                    case CsvShape::WIDE_TEXT:
+                        detail::bench_append_words(out, random, 1 + random.below(3));
+                        break;
+                    case CsvShape::QUOTED:
+                        if (random.chance(80)) {
+                            out.push_back('"');
+                            detail::bench_append_words(out, random, 2 + random.below(6));
+                            if (random.chance(40)) {
+                                out += ", ";
+                                out += detail::bench_word(random);
+                            }
+                            if (random.chance(25)) {
+                                out += " \"\"";
+                                out += detail::bench_word(random);
+                                out += "\"\"";
+                            }
+                            if (random.chance(5)) {
+                                out += "\r\n";
+                                out += detail::bench_word(random);
+                            }
+                            out.push_back('"');
+                        } else {
+                            out += std::to_string(random.below(100000));
+                        }
+                        break;
+                }
+            }
+            out += shape == CsvShape::QUOTED ? "\r\n" : "\n";
+            ++count;
+        }
+        if (rows != nullptr) {
+            *rows = count;
+        }
+        return out;
+    }
+
+    /**
+     * A JSON array of objects.  rows receives the number of array elements.
+     */
+    inline std::string generate_json(JsonShape shape, size_t bytes, uint64_t seed, size_t* rows = nullptr) {
+        Random random(seed);
+        std::string out;
+        out.reserve(bytes + 4096);
+        out.push_back('[');
+        size_t count = 0;
+        while (out.size() < bytes) {
+            out += count > 0 ? ",\n" : "\n";
+            switch (shape) {
+                case JsonShape::FLAT:
+                    out += "{\"id\":" + std::to_string(count);
+                    out += ",\"name\":\"";
+                    detail::bench_append_words(out, random, 1 + random.below(3));
+                    out += "\",\"price\":";
+                    detail::bench_append_decimal(out, random);
+                    out += ",\"active\":";
+                    out += random.chance(50) ? "true" : "false";
+                    out += ",\"note\":";
+                    out += random.chance(20) ? "null" : "\"" + std::string(detail::bench_word(random)) + "\\n\"";
+                    out.push_back('}');
+                    break;
+                case JsonShape::DEEP: {
+                    constexpr size_t DEPTH = 24;
+                    for (size_t level = 0; level < DEPTH; ++level) {
+                        out += "{\"";
+                        out += detail::bench_word(random);
+                        out += "\":" + std::to_string(random.below(1000)) + ",\"child\":";
+                    }
+                    out += "[]";
+                    out.append(DEPTH, '}');
+                    break;
+                }
+                case JsonShape::ARRAYS: {
+                    out += "{\"series\":\"";
+                    out += detail::bench_word(random);
+                    out += "\",\"values\":[";
+                    for (size_t i = 0; i < 64; ++i) {
+                        if (i > 0) {
+                            out.push_back(',');
+                        }
+                        if (i % 4 == 3) {
+                            detail::bench_append_decimal(out, random);
+                        } else {
+                            out += std::to_string(random.below(100000));
+                        }
+                    }
+                    out += "]}";
+                    break;
+                }
+            }
+            ++count;
+        }
+        out += "\n]\n";
+        if (rows != nullptr) {
+            *rows = count;
+        }
+        return out;
+    }
+
+    /**
+     * A .properties file with dotted keys, comments, blank lines, ':' and ' ' separators and the
+     * occasional escaped or continued value.  rows receives the number of entries.
+     */
+    inline std::string generate_properties(size_t bytes, uint64_t seed, size_t* rows = nullptr) {
+        Random random(seed);
+        std::string out;
+        out.reserve(bytes + 4096);
+        size_t count = 0;
+        while (out.size() < bytes) {
+            if (random.chance(5)) {
+                out += "# ";
+                detail::bench_append_words(out, random, 3 + random.below(5));
+                out += "\n\n";
+            }
+            size_t parts = 2 + random.below(3);
+            for (size_t part = 0; part < parts; ++part) {
+                if (part > 0) {
+                    out.push_back('.');
+                }
+                out += detail::bench_word(random);
+            }
+            out += "." + std::to_string(count);
+            uint64_t separator = random.below(10);
+            out += separator < 7 ? " = " : separator < 9 ? ": " : " ";
+            switch (random.below(8)) {
+                case 0: out += std::to_string(random.below(65536)); break;
+                case 1: out += random.chance(50) ? "true" : "false"; break;
+                case 2: out += std::to_string(random.below(600)) + "ms"; break;
+                case 3:
+                    detail::bench_append_words(out, random, 2);
+                    out += " \\\n    ";
+                    detail::bench_append_words(out, random, 2);
+                    break;
+                case 4:
+                    out += "C:\\\\data\\\\";
+                    out += detail::bench_word(random);
+                    break;
+                default: detail::bench_append_words(out, random, 1 + random.below(6)); break;
+            }
+            out.push_back('\n');
+            ++count;
+        }
+        if (rows != nullptr) {
+            *rows = count;
+        }
+        return out;
+    }
+
+} // namespace pb::bench
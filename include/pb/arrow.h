@@ -0,0 +1,273 @@
+/**
+ * Export of columnar data through the Arrow C Data Interface, without depending on the Arrow library.
+ * Buffers are handed to the consumer as is.  The exported arrays keep the producer's storage alive
+ * through a shared pointer that is dropped when the consumer calls release.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/csv.h>
+
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+
+namespace pb {
+
+    namespace detail {
+
+        struct ArrowArrayData {
+            std::shared_ptr<const void> owner;      // Keeps the exported buffers alive
+            std::vector<const void*> buffers;
+            std::vector<ArrowArray*> children;
+        };
+
+        struct ArrowSchemaData {
+            std::string format;
+            std::string name;
+            std::vector<ArrowSchema*> children;
+        };
+
+        inline void arrow_release_array(ArrowArray* array) {
+            ArrowArrayData* data = static_cast<ArrowArrayData*>(array->private_data);
+            for (ArrowArray* child : data->children) {
+                if (child->release) {
+                    child->release(child);
+                }
+                delete child;
+            }
+            delete data;
+            array->release = nullptr;
+        }
+
+        inline void arrow_release_schema(ArrowSchema* schema) {
+            ArrowSchemaData* data = static_cast<ArrowSchemaData*>(schema->private_data);
+            for (ArrowSchema* child : data->children) {
+                if (child->release) {
+                    child->release(child);
+                }
+                delete child;
+            }
+            delete data;
+            schema->release = nullptr;
+        }
+
+        // Releases and frees a child that has not been handed to its parent yet
+        struct ArrowChildDeleter {
+            void operator()(ArrowArray* array) const {
+                if (array->release) {
+                    array->release(array);
+                }
+                delete array;
+            }
+            void operator()(ArrowSchema* schema) const {
+                if (schema->release) {
+                    schema->release(schema);
+                }
+                delete schema;
+            }
+        };
+
+        using ArrowArrayPtr = std::unique_ptr<ArrowArray, ArrowChildDeleter>;
+        using ArrowSchemaPtr = std::unique_ptr<ArrowSchema, ArrowChildDeleter>;
+
+        // Fills out.  Ownership of the children passes to out only once nothing else can throw, so
+        // they are released by the caller's vector if building out fails.
+        inline void arrow_make_array(ArrowArray* out, int64_t length, int64_t null_count, std::vector<const void*> buffers,
+                                     std::vector<ArrowArrayPtr>& children, std::shared_ptr<const void> owner) {
+            std::unique_ptr<ArrowArrayData> data(new ArrowArrayData{ std::move(owner), std::move(buffers), {} });
+            data->children.reserve(children.size());
+            for (ArrowArrayPtr& child : children) {
+                data->children.push_back(child.release());
+            }
+            children.clear();
+            out->length = length;
+            out->null_count = null_count;
+            out->offset = 0;
+            out->n_buffers = static_cast<int64_t>(data->buffers.size());
+            out->n_children = static_cast<int64_t>(data->children.size());
+            out->buffers = data->buffers.data();
+            out->children = data->children.empty() ? nullptr : data->children.data();
+            out->dictionary = nullptr;
+            out->release = &arrow_release_array;
+            out->private_data = data.release();
+        }
+
+        inline void arrow_make_array(ArrowArray* out, int64_t length, int64_t null_count, std::vector<const void*> buffers,
+                                     std::shared_ptr<const void> owner) {
+            std::vector<ArrowArrayPtr> children;
+            arrow_make_array(out, length, null_count, std::move(buffers), children, std::move(owner));
+        }
+
+        inline void arrow_make_schema(ArrowSchema* out, std::string format, std::string name, int64_t flags,
+                                      std::vector<ArrowSchemaPtr>& children) {
+            std::unique_ptr<ArrowSchemaData> data(new ArrowSchemaData{ std::move(format), std::move(name), {} });
+            data->children.reserve(children.size());
+            for (ArrowSchemaPtr& child : children) {
+                data->children.push_back(child.release());
+            }
+            children.clear();
+            out->format = data->format.c_str();
+            out->name = data->name.c_str();
+            out->metadata = nullptr;
+            out->flags = flags;
+            out->n_children = static_cast<int64_t>(data->children.size());
+            out->children = data->children.empty() ? nullptr : data->children.data();
+            out->dictionary = nullptr;
+            out->release = &arrow_release_schema;
+            out->private_data = data.release();
+        }
+
+        inline void arrow_make_schema(ArrowSchema* out, std::string format, std::string name, int64_t flags) {
+            std::vector<ArrowSchemaPtr> children;
+            arrow_make_schema(out, std::move(format), std::move(name), flags, children);
+        }
+
+        inline const char* arrow_blob_format(BlobElementDataType type) {
+            switch (type) {
+                case NULL_VALUE: return "n";
+                case BOOLEAN: return "b";
+                case STRING: return "u";
+                case BINARY: return "z";
+                case UNSIGNED_INTEGER: return "L";
+                case INTEGER: return "l";
+                case FLOAT: return "g";
+                case DATE: return "tsm:";
+                default:
+                    throw std::runtime_error("Blob column type cannot be exported to Arrow");
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Exports a parsed CSV as an Arrow struct array with one utf8 child per column.  The children point
+     * straight at the CSVColumnData buffers, which stay alive until release even if the CSV is re-parsed
+     * or destroyed.
+     */
+    inline void export_arrow(const CSV& csv, ArrowArray* out_array, ArrowSchema* out_schema) {
+        const std::vector<std::shared_ptr<CSVColumnData>>& columns = csv.get_column_data();
+        std::vector<detail::ArrowArrayPtr> arrays;
+        std::vector<detail::ArrowSchemaPtr> schemas;
+        arrays.reserve(columns.size());
+        schemas.reserve(columns.size());
+        for (size_t c = 0; c < columns.size(); ++c) {
+            const CSVColumnData& column = *columns[c];
+            arrays.emplace_back(new ArrowArray());
+            detail::arrow_make_array(arrays.back().get(), static_cast<int64_t>(column.size()), 0,
+                                     { nullptr, column.offsets().data(), column.chars().data() }, columns[c]);
+            schemas.emplace_back(new ArrowSchema());
+            detail::arrow_make_schema(schemas.back().get(), "u", csv.get_column_name(c), 0);
+        }
+        detail::arrow_make_array(out_array, static_cast<int64_t>(csv.get_row_count()), 0, { nullptr }, arrays, nullptr);
+        try {
+            detail::arrow_make_schema(out_schema, "+s", "", 0, schemas);
+        } catch (...) {
+            out_array->release(out_array);
+            throw;
+        }
+    }
+
+    /**
+     * Exports a columnar (shredded) Blob ARRAY as an Arrow struct array.  The validity bitmaps, values
+     * and string offsets of the columns already follow the Arrow layout and are exported in place, the
+     * Blob is kept alive until release.  array must be a view into blob.
+     */
+    inline void export_arrow(std::shared_ptr<const Blob> blob, const BlobView& array, ArrowArray* out_array, ArrowSchema* out_schema) {
+        if (!array.is_columnar()) {
+            throw std::runtime_error("Only columnar Blob arrays can be exported to Arrow");
+        }
+        std::vector<detail::ArrowArrayPtr> arrays;
+        std::vector<detail::ArrowSchemaPtr> schemas;
+        arrays.reserve(array.column_count());
+        schemas.reserve(array.column_count());
+        for (size_t c = 0; c < array.column_count(); ++c) {
+            BlobColumn column = array.column(c);
+            int64_t rows = static_cast<int64_t>(column.size());
+            int64_t nulls = static_cast<int64_t>(column.null_count());
+            const void* validity = nulls == 0 ? nullptr : column.validity_bitmap();
+
+            std::vector<const void*> buffers;
+            switch (column.type()) {
+                case NULL_VALUE:
+                    break;
+                case STRING:
+                case BINARY:
+                    if (column.offsets()[column.size()] > static_cast<uint32_t>(INT32_MAX)) {
+                        throw std::runtime_error("Blob column exceeds the Arrow 32 bit offset range");
+                    }
+                    buffers = { validity, column.value_data(), column.string_data() };
+                    break;
+                default:
+                    buffers = { validity, column.value_data() };
+                    break;
+            }
+
+            arrays.emplace_back(new ArrowArray());
+            detail::arrow_make_array(arrays.back().get(), rows, nulls, std::move(buffers), blob);
+            schemas.emplace_back(new ArrowSchema());
+            detail::arrow_make_schema(schemas.back().get(), detail::arrow_blob_format(column.type()), std::string(column.name()),
+                                      nulls == 0 ? 0 : ARROW_FLAG_NULLABLE);
+        }
+        detail::arrow_make_array(out_array, static_cast<int64_t>(array.size()), 0, { nullptr }, arrays, blob);
+        try {
+            detail::arrow_make_schema(out_schema, "+s", "", 0, schemas);
+        } catch (...) {
+            out_array->release(out_array);
+            throw;
+        }
+    }
+
+} // namespace pb
@@ -0,0 +1,205 @@
+/**
+ * Coroutine based asynchronous parsing.
+ * An event loop pushes input into an AsyncInput as it arrives, a socket read callback for example, and
+ * a parser coroutine consumes it, suspending when the input runs dry instead of blocking a thread.  The
+ * parser hands out batches through an AsyncGenerator, which any coroutine can co_await.  Pushing input
+ * resumes the parser on the pushing thread, and the parser resumes its consumer as soon as it has a
+ * batch, so one thread can drive any number of concurrent streams.
+ *
+ *     pb::AsyncInput upload;
+ *     auto batches = pb::read_csv_async(upload, properties);
+ *     while (auto batch = co_await batches.next()) {
+ *         store(*batch);
+ *     }
+ *     // elsewhere, on the same thread: upload.push(bytes) ... upload.close()
+ */
+
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <pb/blob.h>
+#include <pb/csv.h>
+
+
+namespace pb {
+
+    /**
+     * AsyncGenerator: a coroutine that produces values with co_yield and may co_await in between.  The
+     * consumer co_awaits next(), which runs the generator up to its next value; nullopt means it
+     * finished.  An exception thrown by the generator is rethrown by next().  The generator starts
+     * suspended, only runs inside next(), and is destroyed with the AsyncGenerator.
+     */
+    template <typename T>
+    class AsyncGenerator {
+        public:
+            struct promise_type;
+            using Handle = std::coroutine_handle<promise_type>;
+
+            // Suspends the generator and resumes its consumer
+            struct Transfer {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(Handle handle) noexcept { return handle.promise().consumer; }
+                void await_resume() noexcept {}
+            };
+
+            struct promise_type {
+                std::optional<T> value;
+                std::exception_ptr error;
+                std::coroutine_handle<> consumer = std::noop_coroutine();
+
+                AsyncGenerator get_return_object() { return AsyncGenerator(Handle::from_promise(*this)); }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                Transfer final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { error = std::current_exception(); }
+
+                Transfer yield_value(T next) {
+                    value = std::move(next);
+                    return {};
+                }
+            };
+
+            struct NextAwaiter {
+                Handle handle;
+
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+                    handle.promise().consumer = consumer;
+                    handle.promise().value.reset();
+                    return handle;
+                }
+
+                std::optional<T> await_resume() {
+                    if (!handle) {
+                        return std::nullopt;
+                    }
+                    promise_type& promise = handle.promise();
+                    if (promise.error) {
+                        std::rethrow_exception(std::exchange(promise.error, nullptr));
+                    }
+                    return std::exchange(promise.value, std::nullopt);
+                }
+            };
+
+            AsyncGenerator() = default;
+            AsyncGenerator(const AsyncGenerator&) = delete;
+            AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+            AsyncGenerator(AsyncGenerator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+            AsyncGenerator& operator=(AsyncGenerator&& other) noexcept {
+                if (this != &other) {
+                    destroy();
+                    handle_ = std::exchange(other.handle_, nullptr);
+                }
+                return *this;
+            }
+
+            ~AsyncGenerator() {
+                destroy();
+            }
+
+            // co_await next() for the next value, nullopt once the generator finished
+            NextAwaiter next() { return NextAwaiter{ handle_ }; }
+
+        private:
+            explicit AsyncGenerator(Handle handle) : handle_(handle) {}
+
+            void destroy() {
+                if (handle_) {
+                    handle_.destroy();
+                    handle_ = nullptr;
+                }
+            }
+
+            Handle handle_;
+    };
+
+    /**
+     * AsyncInput: a byte stream fed by the application and read by one coroutine.  push() copies the
+     * data, since the caller's buffer is usually reused for the next read, and resumes the reader if it
+     * is waiting.  Not thread safe: push, close and fail must be called on the thread that drives the
+     * reader.
+     */
+    class AsyncInput {
+        public:
+            AsyncInput() = default;
+            AsyncInput(const AsyncInput&) = delete;
+            AsyncInput& operator=(const AsyncInput&) = delete;
+
+            void push(std::string_view data);
+
+            // Ends the input; the reader sees the end once it consumed what was pushed
+            void close();
+
+            // Ends the input with an error, rethrown to the reader
+            void fail(std::exception_ptr error);
+
+            // Bytes pushed and not read yet, to pause a producer that runs ahead
+            size_t buffered() const { return pending_.size(); }
+
+            bool closed() const { return closed_; }
+
+            struct ReadAwaiter {
+                AsyncInput& input;
+                std::string& buffer;
+                std::coroutine_handle<> handle;
+
+                ReadAwaiter(AsyncInput& input, std::string& buffer) : input(input), buffer(buffer) {}
+                ReadAwaiter(const ReadAwaiter&) = delete;
+                ReadAwaiter& operator=(const ReadAwaiter&) = delete;
+
+                // A reader destroyed while it waits must not be resumed
+                ~ReadAwaiter() {
+                    if (handle && input.waiter_ == handle) {
+                        input.waiter_ = nullptr;
+                    }
+                }
+
+                bool await_ready() const noexcept { return !input.pending_.empty() || input.closed_; }
+                void await_suspend(std::coroutine_handle<> waiting);
+                bool await_resume();
+            };
+
+            /**
+             * co_await read(buffer): waits for input and appends all of it to buffer.  Returns false, with
+             * nothing appended, once the input is closed and drained.  Only one coroutine may wait at a
+             * time.
+             */
+            ReadAwaiter read(std::string& buffer) { return ReadAwaiter(*this, buffer); }
+
+        private:
+            void resume();
+
+            std::string pending_;
+            bool closed_ = false;
+            std::exception_ptr error_;
+            std::coroutine_handle<> waiter_;
+    };
+
+    /**
+     * Parses CSV from input into batches of up to batch_rows records, each a CSV (see pb/csv.h) holding
+     * the batch's rows.  The first batch resolves the delimiter and, with a header, the column names;
+     * later batches carry them in their properties.  Records are only split at a newline outside quotes,
+     * so '\r' alone does not end a record here.  Throws std::runtime_error, from next(), on malformed
+     * input.
+     */
+    AsyncGenerator<CSV> read_csv_async(AsyncInput& input, CSVProperties properties = CSVProperties(),
+                                       size_t batch_rows = 1024);
+
+    /**
+     * Parses newline delimited JSON from input into batches of up to batch_lines lines, each a Blob whose
+     * root is an ARRAY of the records as read_ndjson builds it.  Errors name the line within the whole
+     * input.
+     */
+    AsyncGenerator<Blob> read_ndjson_async(AsyncInput& input, size_t batch_lines = 1024);
+
+} // namespace pb
@@ -0,0 +1,366 @@
+/**
+ * Typed binding between Blobs and C++ structs.
+ * A struct is bound by listing its fields once with PB_BIND, which specializes BlobBinding.  Decoding
+ * and encoding are then generated per struct at compile time: field names live in a constexpr table,
+ * members that arrive in declaration order are matched with a single comparison, and a columnar ARRAY
+ * decodes into a std::vector column by column straight from the column buffers.
+ *
+ *     struct Point { int x; double y; std::optional<std::string> label; };
+ *     PB_BIND(Point, PB_FIELD(Point, x), PB_FIELD(Point, y), PB_FIELD(Point, label))
+ *
+ *     std::vector<Point> points = pb::from_json<std::vector<Point>>(text);
+ */
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/json.h>
+
+
+namespace pb {
+
+    /**
+     * BlobBinding: specialized for every bound struct, with a constexpr tuple of BlobField named fields.
+     */
+    template <typename T>
+    struct BlobBinding;
+
+    template <typename C, typename M>
+    struct BlobField {
+        std::string_view name;
+        M C::* member;
+    };
+
+    template <typename C, typename M>
+    constexpr BlobField<C, M> bind_field(std::string_view name, M C::* member) {
+        return BlobField<C, M>{ name, member };
+    }
+
+    template <typename T>
+    concept BlobBound = requires { BlobBinding<T>::fields; };
+
+    // DATE values bind to milliseconds on the system clock
+    using BlobDate = std::chrono::time_point<std::chrono::system_clock, std::chrono::milliseconds>;
+
+    #define PB_FIELD(Type, member) ::pb::bind_field(#member, &Type::member)
+
+    #define PB_BIND(Type, ...) \
+        template <> \
+        struct pb::BlobBinding<Type> { \
+            static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+        };
+
+    namespace detail {
+
+        template <typename T>
+        struct bind_is_vector : std::false_type {};
+
+        template <typename T>
+        struct bind_is_vector<std::vector<T>> : std::true_type {};
+
+        template <typename T>
+        struct bind_is_optional : std::false_type {};
+
+        template <typename T>
+        struct bind_is_optional<std::optional<T>> : std::true_type {};
+
+        template <typename T>
+        constexpr bool bind_is_number = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+        template <typename T>
+        constexpr size_t bind_field_count = std::tuple_size_v<std::remove_cvref_t<decltype(BlobBinding<T>::fields)>>;
+
+        template <typename T>
+        constexpr auto bind_field_names = std::apply(
+            [](const auto&... field) { return std::array<std::string_view, sizeof...(field)>{ field.name... }; },
+            BlobBinding<T>::fields);
+
+        [[noreturn]] inline void bind_fail(const char* message) {
+            throw std::runtime_error(message);
+        }
+
+        template <typename M>
+        M bind_from_int(int64_t value) {
+            if constexpr (std::is_floating_point_v<M>) {
+                return static_cast<M>(value);
+            } else {
+                if (!std::in_range<M>(value)) {
+                    bind_fail("Blob integer does not fit the bound field");
+                }
+                return static_cast<M>(value);
+            }
+        }
+
+        template <typename M>
+        M bind_from_uint(uint64_t value) {
+            if constexpr (std::is_floating_point_v<M>) {
+                return static_cast<M>(value);
+            } else {
+                if (!std::in_range<M>(value)) {
+                    bind_fail("Blob integer does not fit the bound field");
+                }
+                return static_cast<M>(value);
+            }
+        }
+
+        template <typename M>
+        M bind_from_double(double value) {
+            if constexpr (!std::is_floating_point_v<M>) {
+                bind_fail("Blob FLOAT cannot be bound to an integer field");
+            }
+            return static_cast<M>(value);
+        }
+
+        template <typename T>
+        void bind_decode(const BlobView& value, T& out);
+
+        // Calls f(field) for the field at a runtime index; the fold expands to one comparison per field
+        template <typename T, typename F>
+        void bind_with_field(size_t index, F&& f) {
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((index == I ? (f(std::get<I>(BlobBinding<T>::fields)), 0) : 0), ...);
+            }(std::make_index_sequence<bind_field_count<T>>());
+        }
+
+        template <typename T>
+        size_t bind_find_field(std::string_view key, size_t expected) {
+            constexpr size_t count = bind_field_count<T>;
+            if (expected < count && bind_field_names<T>[expected] == key) {
+                return expected;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (bind_field_names<T>[i] == key) {
+                    return i;
+                }
+            }
+            return count;
+        }
+
+        template <BlobBound T>
+        void bind_decode_object(const BlobView& value, T& out) {
+            if (value.type() != OBJECT) {
+                bind_fail("Blob value bound to a struct is not an OBJECT");
+            }
+            size_t expected = 0;
+            value.for_each_member([&](std::string_view key, const BlobView& member) {
+                size_t index = bind_find_field<T>(key, expected);
+                expected = index + 1;
+                bind_with_field<T>(index, [&](const auto& field) { bind_decode(member, out.*(field.member)); });
+            });
+        }
+
+        template <typename T, typename M>
+        void bind_decode_column(const BlobColumn& column, std::vector<T>& out, M T::* member) {
+            size_t rows = column.size();
+            if constexpr (bind_is_number<M>) {
+                const uint8_t* values = column.value_data();
+                switch (column.type()) {
+                    case INTEGER:
+                        for (size_t row = 0; row < rows; ++row) {
+                            if (column.is_valid(row)) {
+                                out[row].*member = bind_from_int<M>(blob_load<int64_t>(values + 8 * row));
+                            }
+                        }
+                        return;
+                    case UNSIGNED_INTEGER:
+                        for (size_t row = 0; row < rows; ++row) {
+                            if (column.is_valid(row)) {
+                                out[row].*member = bind_from_uint<M>(blob_load<uint64_t>(values + 8 * row));
+                            }
+                        }
+                        return;
+                    case FLOAT:
+                        for (size_t row = 0; row < rows; ++row) {
+                            if (column.is_valid(row)) {
+                                out[row].*member = bind_from_double<M>(blob_load<double>(values + 8 * row));
+                            }
+                        }
+                        return;
+                    default:
+                        break;
+                }
+            }
+            for (size_t row = 0; row < rows; ++row) {
+                bind_decode(column.at(row), out[row].*member);
+            }
+        }
+
+        // Columnar rows are decoded field by field, each field from one contiguous column
+        template <BlobBound T>
+        void bind_decode_columns(const BlobView& array, std::vector<T>& out) {
+            std::vector<BlobColumn> columns;
+            for (size_t c = 0; c < array.column_count(); ++c) {
+                columns.push_back(array.column(c));
+            }
+            out.assign(array.size(), T());
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ([&] {
+                    const auto& field = std::get<I>(BlobBinding<T>::fields);
+                    for (const BlobColumn& column : columns) {
+                        if (column.name() == field.name) {
+                            bind_decode_column(column, out, field.member);
+                            break;
+                        }
+                    }
+                }(), ...);
+            }(std::make_index_sequence<bind_field_count<T>>());
+        }
+
+        /**
+         * Decodes value into out.  A null value leaves out as it is, except for std::optional which it
+         * resets.  Throws std::runtime_error when the type does not match the field.
+         */
+        template <typename T>
+        void bind_decode(const BlobView& value, T& out) {
+            BlobElementDataType type = value.type();
+            if (type == NULL_VALUE) {
+                if constexpr (bind_is_optional<T>::value) {
+                    out.reset();
+                }
+                return;
+            }
+            if constexpr (bind_is_optional<T>::value) {
+                bind_decode(value, out.emplace());
+            } else if constexpr (std::is_same_v<T, bool>) {
+                out = value.as_bool();
+            } else if constexpr (bind_is_number<T>) {
+                switch (type) {
+                    case INTEGER: out = bind_from_int<T>(value.as_int()); break;
+                    case UNSIGNED_INTEGER: out = bind_from_uint<T>(value.as_uint()); break;
+                    case DATE: out = bind_from_int<T>(value.as_date()); break;
+                    case FLOAT: out = bind_from_double<T>(value.as_double()); break;
+                    default: bind_fail("Blob value bound to a number is not numeric");
+                }
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                out = std::string(value.as_string());
+            } else if constexpr (std::is_same_v<T, BlobDate>) {
+                out = BlobDate(std::chrono::milliseconds(value.as_date()));
+            } else if constexpr (bind_is_vector<T>::value) {
+                using E = typename T::value_type;
+                if (type != ARRAY) {
+                    bind_fail("Blob value bound to a vector is not an ARRAY");
+                }
+                if constexpr (BlobBound<E>) {
+                    if (value.is_columnar()) {
+                        bind_decode_columns(value, out);
+                        return;
+                    }
+                }
+                if constexpr (bind_is_number<E>) {
+                    if (value.is_delta() && value.data()[BLOB_CONTAINER_HEADER_SIZE] != UNSIGNED_INTEGER) {
+                        std::vector<int64_t> integers;
+                        value.decode_integers(integers);
+                        out.resize(integers.size());
+                        for (size_t i = 0; i < integers.size(); ++i) {
+                            out[i] = bind_from_int<E>(integers[i]);
+                        }
+                        return;
+                    }
+                }
+                out.clear();
+                out.reserve(value.size());
+                value.for_each_element([&](const BlobView& element) { bind_decode(element, out.emplace_back()); });
+            } else if constexpr (BlobBound<T>) {
+                bind_decode_object(value, out);
+            } else {
+                static_assert(BlobBound<T>, "Type cannot be bound to a Blob value, bind it with PB_BIND");
+            }
+        }
+
+        template <typename T>
+        void bind_encode(BlobBuilder& builder, const T& value) {
+            if constexpr (bind_is_optional<T>::value) {
+                if (value) {
+                    bind_encode(builder, *value);
+                } else {
+                    builder.add_null();
+                }
+            } else if constexpr (std::is_same_v<T, bool>) {
+                builder.add_bool(value);
+            } else if constexpr (std::is_floating_point_v<T>) {
+                builder.add_double(value);
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                builder.add_int(value);
+            } else if constexpr (std::is_integral_v<T>) {
+                builder.add_uint(value);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                builder.add_string(value);
+            } else if constexpr (std::is_same_v<T, BlobDate>) {
+                builder.add_date(value.time_since_epoch().count());
+            } else if constexpr (bind_is_vector<T>::value) {
+                builder.begin_array();
+                for (const auto& element : value) {
+                    bind_encode(builder, element);
+                }
+                builder.end_array();
+            } else if constexpr (BlobBound<T>) {
+                builder.begin_object();
+                std::apply([&](const auto&... field) {
+                    ((builder.key(field.name), bind_encode(builder, value.*(field.member))), ...);
+                }, BlobBinding<T>::fields);
+                builder.end_object();
+            } else {
+                static_assert(BlobBound<T>, "Type cannot be bound to a Blob value, bind it with PB_BIND");
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Decodes value into out.  Members without a field are ignored, fields without a member or with a
+     * null keep their value.  Throws std::runtime_error when a value does not fit its field.
+     */
+    template <typename T>
+    void from_blob(const BlobView& value, T& out) {
+        detail::bind_decode(value, out);
+    }
+
+    template <typename T>
+    T from_blob(const BlobView& value) {
+        T out{};
+        detail::bind_decode(value, out);
+        return out;
+    }
+
+    template <typename T>
+    T from_blob(const Blob& blob) {
+        return from_blob<T>(blob.root());
+    }
+
+    template <typename T>
+    void to_blob(BlobBuilder& builder, const T& value) {
+        detail::bind_encode(builder, value);
+    }
+
+    template <typename T>
+    Blob to_blob(const T& value) {
+        BlobBuilder builder;
+        detail::bind_encode(builder, value);
+        return builder.build();
+    }
+
+    template <typename T>
+    T from_json(std::string_view text) {
+        return from_blob<T>(read_json(text));
+    }
+
+    template <typename T>
+    std::string to_json(const T& value) {
+        return write_json(to_blob(value));
+    }
+
+} // namespace pb
@@ -1,3 +1,29 @@
+/**
+ * Blob: a binary memory structure that can store any type of data in any structure.
+ * Every element starts with a one byte tag, the BlobElementDataType lives in the low nibble and the
+ * BlobEncoding in the high nibble.  See docs/blob.md for the full layout.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <pb/cpu.h>
+
+
 namespace pb {
 
     enum BlobElementDataType {
@@ -13,18 +39,889 @@ namespace pb {
         BINARY
     };
 
+    /**
+     * BlobEncoding: how an element is laid out in the data section.
+     */
+    enum BlobEncoding : uint8_t {
+        BLOB_ENCODING_DEFAULT = 0,
+        BLOB_ENCODING_COLUMNAR = 1,    // ARRAY of same-shaped OBJECTs stored as one typed column per field
+        BLOB_ENCODING_WIDTH_1 = 2,     // INTEGER, UNSIGNED_INTEGER or DATE stored in 1 byte
+        BLOB_ENCODING_WIDTH_2 = 3,     // ... in 2 bytes
+        BLOB_ENCODING_WIDTH_4 = 4,     // ... in 4 bytes
+        BLOB_ENCODING_DELTA = 5        // ARRAY of one integer type stored as bit-packed deltas
+    };
+
+    namespace detail {
+
+        constexpr size_t BLOB_CONTAINER_HEADER_SIZE = 9;   // tag, u32 count, u32 body size
+        constexpr size_t BLOB_COLUMNAR_HEADER_SIZE = 13;   // container header, u32 column count
+        constexpr size_t BLOB_COLUMN_ALIGNMENT = 8;
+        constexpr size_t BLOB_DELTA_HEADER_SIZE = 19;      // container header, u8 type, u8 bit width, i64 min delta
+        constexpr size_t BLOB_DELTA_BLOCK = 128;           // Values per block, each block starts from a stored base
+        constexpr size_t BLOB_DELTA_PADDING = 8;           // Lets the decoder load a full word past the last value
+
+        inline uint8_t blob_make_tag(BlobElementDataType type, uint8_t encoding = BLOB_ENCODING_DEFAULT) {
+            return static_cast<uint8_t>(type) | static_cast<uint8_t>(encoding << 4);
+        }
+
+        inline BlobElementDataType blob_tag_type(uint8_t tag) {
+            return static_cast<BlobElementDataType>(tag & 0x0F);
+        }
+
+        inline uint8_t blob_tag_encoding(uint8_t tag) {
+            return tag >> 4;
+        }
+
+        template <typename T>
+        inline T blob_load(const uint8_t* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        inline void blob_append(std::vector<uint8_t>& out, T value) {
+            size_t pos = out.size();
+            out.resize(pos + sizeof(T));
+            std::memcpy(out.data() + pos, &value, sizeof(T));
+        }
+
+        template <typename T>
+        inline void blob_patch(std::vector<uint8_t>& out, size_t pos, T value) {
+            std::memcpy(out.data() + pos, &value, sizeof(T));
+        }
+
+        // Big endian helpers for the interchange formats
+        template <typename T>
+        inline T blob_load_be(const uint8_t* p) {
+            T value = 0;
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                value = static_cast<T>((value << 8) | p[i]);
+            }
+            return value;
+        }
+
+        template <typename T>
+        inline void blob_append_be(std::vector<uint8_t>& out, T value) {
+            for (size_t i = sizeof(T); i > 0; --i) {
+                out.push_back(static_cast<uint8_t>(value >> (8 * (i - 1))));
+            }
+        }
+
+        inline bool blob_is_scalar(BlobElementDataType type) {
+            return type != OBJECT && type != ARRAY;
+        }
+
+        // Size in bytes of a fixed width scalar payload, 0 for the variable width types.
+        inline size_t blob_fixed_width(BlobElementDataType type) {
+            switch (type) {
+                case BOOLEAN:
+                    return 1;
+                case UNSIGNED_INTEGER:
+                case INTEGER:
+                case FLOAT:
+                case DATE:
+                    return 8;
+                default:
+                    return 0;
+            }
+        }
+
+        inline bool blob_is_integer(BlobElementDataType type) {
+            return type == INTEGER || type == UNSIGNED_INTEGER || type == DATE;
+        }
+
+        // Stored width of a scalar payload, taking the compact integer encodings into account
+        inline size_t blob_payload_width(uint8_t tag) {
+            switch (blob_tag_encoding(tag)) {
+                case BLOB_ENCODING_WIDTH_1: return 1;
+                case BLOB_ENCODING_WIDTH_2: return 2;
+                case BLOB_ENCODING_WIDTH_4: return 4;
+                default: return blob_fixed_width(blob_tag_type(tag));
+            }
+        }
+
+        // Total size in bytes of the encoded element starting at p, tag included.
+        inline size_t blob_element_size(const uint8_t* p) {
+            BlobElementDataType type = blob_tag_type(*p);
+            switch (type) {
+                case NULL_VALUE:
+                    return 1;
+                case STRING:
+                case BINARY:
+                    return 5 + blob_load<uint32_t>(p + 1);
+                case OBJECT:
+                case ARRAY:
+                    return BLOB_CONTAINER_HEADER_SIZE + blob_load<uint32_t>(p + 5);
+                default:
+                    return 1 + blob_payload_width(*p);
+            }
+        }
+
+        // 64 bit pattern of the numeric scalar at p, compact integers sign or zero extended
+        inline uint64_t blob_scalar_bits(const uint8_t* p) {
+            size_t width = blob_payload_width(*p);
+            if (width == 8) {
+                return blob_load<uint64_t>(p + 1);
+            }
+            uint64_t value = 0;
+            std::memcpy(&value, p + 1, width);
+            BlobElementDataType type = blob_tag_type(*p);
+            if (type != UNSIGNED_INTEGER && (value >> (8 * width - 1)) != 0) {
+                value |= ~uint64_t(0) << (8 * width);
+            }
+            return value;
+        }
+
+        /**
+         * Decodes values [first, first + count) of the delta ARRAY at array, count must not cross a block.
+         * Layout after the container header: u8 element type, u8 bit width, i64 min delta, one i64 base per
+         * block of BLOB_DELTA_BLOCK values, then (delta - min delta) of every value but the first, bit-packed.
+         * The deltas are unpacked and summed by the SIMD kernels of the active CPU level.
+         */
+        inline void blob_delta_decode(const uint8_t* array, size_t first, size_t count, uint64_t* out) {
+            size_t total = blob_load<uint32_t>(array + 1);
+            unsigned bits = array[BLOB_CONTAINER_HEADER_SIZE + 1];
+            uint64_t min_delta = blob_load<uint64_t>(array + BLOB_CONTAINER_HEADER_SIZE + 2);
+            size_t blocks = (total + BLOB_DELTA_BLOCK - 1) / BLOB_DELTA_BLOCK;
+            const uint8_t* bases = array + BLOB_DELTA_HEADER_SIZE;
+            const uint8_t* packed = bases + 8 * blocks;
+
+            // values[j] is the value at block_start + j, value i taking the delta packed at index i - 1
+            size_t block_start = first - first % BLOB_DELTA_BLOCK;
+            uint64_t values[BLOB_DELTA_BLOCK];
+            values[0] = blob_load<uint64_t>(bases + 8 * (first / BLOB_DELTA_BLOCK));
+            size_t needed = first + count - block_start - 1;
+            CpuLevel level = cpu_level();
+            unpack_kernel(level)(packed, bits, block_start, needed, values + 1);
+            prefix_sum_kernel(level)(values + 1, needed, values[0], min_delta);
+            std::copy_n(values + (first - block_start), count, out);
+        }
+
+        // True if the encoded element at p is, or contains, a columnar ARRAY
+        inline bool blob_contains_columnar(const uint8_t* p) {
+            BlobElementDataType type = blob_tag_type(*p);
+            if (type != OBJECT && type != ARRAY) {
+                return false;
+            }
+            uint8_t encoding = blob_tag_encoding(*p);
+            if (encoding == BLOB_ENCODING_COLUMNAR) {
+                return true;
+            }
+            if (encoding != BLOB_ENCODING_DEFAULT) {
+                return false;
+            }
+            uint32_t count = blob_load<uint32_t>(p + 1);
+            const uint8_t* element = p + BLOB_CONTAINER_HEADER_SIZE;
+            for (uint32_t i = 0; i < count; ++i) {
+                if (type == OBJECT) {
+                    element += 4 + blob_load<uint32_t>(element);
+                }
+                if (blob_contains_columnar(element)) {
+                    return true;
+                }
+                element += blob_element_size(element);
+            }
+            return false;
+        }
+
+        inline const uint8_t* blob_null_element() {
+            static const uint8_t tag = NULL_VALUE;
+            return &tag;
+        }
+
+    } // namespace detail
+
+    class BlobView;
+
+    /**
+     * BlobColumn: a view of one field of a columnar (shredded) ARRAY.
+     * Values of a fixed width type are stored contiguously and 8 byte aligned so scans can run over
+     * a plain span.  Nulls are tracked in a validity bitmap, bit i of byte i/8 being row i.
+     */
+    class BlobColumn {
+        public:
+            BlobColumn() = default;
+
+            BlobColumn(const uint8_t* array, const uint8_t* entry) : array_(array), entry_(entry) {
+                uint32_t name_len = detail::blob_load<uint32_t>(entry);
+                rows_ = detail::blob_load<uint32_t>(array + 1);
+                name_ = std::string_view(reinterpret_cast<const char*>(entry + 4), name_len);
+                type_ = static_cast<BlobElementDataType>(entry[4 + name_len]);
+                validity_ = array + detail::blob_load<uint32_t>(entry + 5 + name_len);
+                values_ = array + detail::blob_load<uint32_t>(entry + 9 + name_len);
+            }
+
+            // Size in bytes of the directory entry at entry
+            static size_t entry_size(const uint8_t* entry) {
+                return 13 + detail::blob_load<uint32_t>(entry);
+            }
+
+            std::string_view name() const { return name_; }
+            BlobElementDataType type() const { return type_; }
+            size_t size() const { return rows_; }
+
+            bool is_valid(size_t row) const {
+                return (validity_[row >> 3] >> (row & 7)) & 1;
+            }
+
+            size_t null_count() const {
+                size_t count = 0;
+                for (size_t row = 0; row < rows_; ++row) {
+                    count += is_valid(row) ? 0 : 1;
+                }
+                return count;
+            }
+
+            const uint8_t* validity_bitmap() const { return validity_; }
+
+            /**
+             * Contiguous values of a numeric column.  T must be int64_t for INTEGER and DATE, uint64_t for
+             * UNSIGNED_INTEGER and double for FLOAT.  Rows that are null hold 0.
+             */
+            template <typename T>
+            std::span<const T> values() const {
+                bool matches = false;
+                if constexpr (std::is_same_v<T, double>) {
+                    matches = type_ == FLOAT;
+                } else if constexpr (std::is_same_v<T, int64_t>) {
+                    matches = type_ == INTEGER || type_ == DATE;
+                } else if constexpr (std::is_same_v<T, uint64_t>) {
+                    matches = type_ == UNSIGNED_INTEGER;
+                }
+                if (!matches) {
+                    throw std::runtime_error("Blob column type does not match the requested value type");
+                }
+                if (reinterpret_cast<uintptr_t>(values_) % alignof(T) != 0) {
+                    throw std::runtime_error("Blob column values are not aligned");
+                }
+                return std::span<const T>(reinterpret_cast<const T*>(values_), rows_);
+            }
+
+            // BOOLEAN columns are stored as a bitmap with the same bit order as the validity bitmap
+            bool bool_at(size_t row) const {
+                return (values_[row >> 3] >> (row & 7)) & 1;
+            }
+
+            // STRING and BINARY columns store rows + 1 offsets followed by the concatenated bytes
+            std::span<const uint32_t> offsets() const {
+                if (type_ != STRING && type_ != BINARY) {
+                    throw std::runtime_error("Blob column does not hold STRING or BINARY values");
+                }
+                return std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(values_), rows_ + 1);
+            }
+
+            const uint8_t* string_data() const {
+                return values_ + sizeof(uint32_t) * (rows_ + 1);
+            }
+
+            std::string_view string_at(size_t row) const {
+                uint32_t begin = detail::blob_load<uint32_t>(values_ + sizeof(uint32_t) * row);
+                uint32_t end = detail::blob_load<uint32_t>(values_ + sizeof(uint32_t) * (row + 1));
+                return std::string_view(reinterpret_cast<const char*>(string_data()) + begin, end - begin);
+            }
+
+            const uint8_t* value_data() const { return values_; }
+
+            BlobView at(size_t row) const;
+
+        private:
+            const uint8_t* array_ = nullptr;     // Tag of the columnar ARRAY
+            const uint8_t* entry_ = nullptr;     // Directory entry of this column
+            const uint8_t* validity_ = nullptr;
+            const uint8_t* values_ = nullptr;
+            std::string_view name_;
+            BlobElementDataType type_ = NULL_VALUE;
+            size_t rows_ = 0;
+    };
+
+    /**
+     * BlobView: a read only, non owning handle to one element of a Blob.
+     * Rows and fields of a columnar ARRAY are exposed as ordinary OBJECTs and scalars so callers do not
+     * need to know how an array was stored.
+     */
+    class BlobView {
+        public:
+            BlobView() = default;
+
+            explicit BlobView(const uint8_t* element) : p_(element) {}
+
+            BlobElementDataType type() const {
+                switch (kind_) {
+                    case ROW:
+                        return OBJECT;
+                    case CELL: {
+                        BlobColumn column(p_, entry_);
+                        return column.is_valid(row_) ? column.type() : NULL_VALUE;
+                    }
+                    case VALUE:
+                        return static_cast<BlobElementDataType>(p_[detail::BLOB_CONTAINER_HEADER_SIZE]);
+                    default:
+                        return detail::blob_tag_type(*p_);
+                }
+            }
+
+            bool is_null() const { return type() == NULL_VALUE; }
+            bool is_object() const { return type() == OBJECT; }
+            bool is_array() const { return type() == ARRAY; }
+
+            bool is_columnar() const {
+                return kind_ == ENCODED && *p_ == detail::blob_make_tag(ARRAY, BLOB_ENCODING_COLUMNAR);
+            }
+
+            bool is_delta() const {
+                return kind_ == ENCODED && detail::blob_tag_type(*p_) == ARRAY && detail::blob_tag_encoding(*p_) == BLOB_ENCODING_DELTA;
+            }
+
+            bool as_bool() const {
+                expect(BOOLEAN);
+                if (kind_ == CELL) {
+                    return BlobColumn(p_, entry_).bool_at(row_);
+                }
+                return p_[1] != 0;
+            }
+
+            int64_t as_int() const {
+                BlobElementDataType t = type();
+                if (t == UNSIGNED_INTEGER) {
+                    uint64_t value = bits();
+                    if (value > static_cast<uint64_t>(INT64_MAX)) {
+                        throw std::out_of_range("Blob UNSIGNED_INTEGER does not fit in an INTEGER");
+                    }
+                    return static_cast<int64_t>(value);
+                }
+                expect(INTEGER);
+                return static_cast<int64_t>(bits());
+            }
+
+            uint64_t as_uint() const {
+                BlobElementDataType t = type();
+                if (t == INTEGER) {
+                    int64_t value = static_cast<int64_t>(bits());
+                    if (value < 0) {
+                        throw std::out_of_range("Blob INTEGER does not fit in an UNSIGNED_INTEGER");
+                    }
+                    return static_cast<uint64_t>(value);
+                }
+                expect(UNSIGNED_INTEGER);
+                return bits();
+            }
+
+            double as_double() const {
+                switch (type()) {
+                    case INTEGER:
+                        return static_cast<double>(static_cast<int64_t>(bits()));
+                    case UNSIGNED_INTEGER:
+                        return static_cast<double>(bits());
+                    default:
+                        expect(FLOAT);
+                        return std::bit_cast<double>(bits());
+                }
+            }
+
+            // DATE values are milliseconds since the Unix epoch
+            int64_t as_date() const {
+                expect(DATE);
+                return static_cast<int64_t>(bits());
+            }
+
+            std::string_view as_string() const {
+                expect(STRING);
+                return bytes();
+            }
+
+            std::span<const uint8_t> as_binary() const {
+                expect(BINARY);
+                std::string_view value = bytes();
+                return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+            }
+
+            // Number of elements of an ARRAY or members of an OBJECT, 0 for scalars
+            size_t size() const {
+                if (kind_ == ROW) {
+                    return detail::blob_load<uint32_t>(p_ + detail::BLOB_CONTAINER_HEADER_SIZE);
+                }
+                if (kind_ == CELL || detail::blob_is_scalar(type())) {
+                    return 0;
+                }
+                return detail::blob_load<uint32_t>(p_ + 1);
+            }
+
+            BlobView operator[](size_t index) const {
+                expect(ARRAY);
+                if (index >= size()) {
+                    throw std::out_of_range("Blob array index out of range");
+                }
+                if (is_columnar()) {
+                    return BlobView(p_, nullptr, static_cast<uint32_t>(index), ROW);
+                }
+                if (is_delta()) {
+                    uint64_t value;
+                    detail::blob_delta_decode(p_, index, 1, &value);
+                    return BlobView(p_, value);
+                }
+                const uint8_t* element = p_ + detail::BLOB_CONTAINER_HEADER_SIZE;
+                for (size_t i = 0; i < index; ++i) {
+                    element += detail::blob_element_size(element);
+                }
+                return BlobView(element);
+            }
+
+            BlobView operator[](std::string_view key) const {
+                std::optional<BlobView> value = find(key);
+                if (!value) {
+                    throw std::out_of_range("Key not found in Blob object: " + std::string(key));
+                }
+                return *value;
+            }
+
+            std::optional<BlobView> find(std::string_view key) const {
+                std::optional<BlobView> result;
+                for_each_member([&](std::string_view member_key, const BlobView& value) {
+                    if (!result && member_key == key) {
+                        result = value;
+                    }
+                });
+                return result;
+            }
+
+            bool contains(std::string_view key) const {
+                return find(key).has_value();
+            }
+
+            // Calls f(BlobView) for every element of an ARRAY
+            template <typename F>
+            void for_each_element(F&& f) const {
+                expect(ARRAY);
+                uint32_t count = detail::blob_load<uint32_t>(p_ + 1);
+                if (is_columnar()) {
+                    for (uint32_t row = 0; row < count; ++row) {
+                        f(BlobView(p_, nullptr, row, ROW));
+                    }
+                    return;
+                }
+                if (is_delta()) {
+                    uint64_t values[detail::BLOB_DELTA_BLOCK];
+                    for (size_t first = 0; first < count; first += detail::BLOB_DELTA_BLOCK) {
+                        size_t n = std::min<size_t>(detail::BLOB_DELTA_BLOCK, count - first);
+                        detail::blob_delta_decode(p_, first, n, values);
+                        for (size_t i = 0; i < n; ++i) {
+                            f(BlobView(p_, values[i]));
+                        }
+                    }
+                    return;
+                }
+                const uint8_t* element = p_ + detail::BLOB_CONTAINER_HEADER_SIZE;
+                for (uint32_t i = 0; i < count; ++i) {
+                    f(BlobView(element));
+                    element += detail::blob_element_size(element);
+                }
+            }
+
+            /**
+             * Decodes an ARRAY of INTEGER, UNSIGNED_INTEGER or DATE values into out.  Delta arrays are
+             * decoded a block at a time without going through a view per element.
+             */
+            void decode_integers(std::vector<int64_t>& out) const {
+                expect(ARRAY);
+                size_t count = size();
+                out.resize(count);
+                if (is_delta()) {
+                    for (size_t first = 0; first < count; first += detail::BLOB_DELTA_BLOCK) {
+                        size_t n = std::min<size_t>(detail::BLOB_DELTA_BLOCK, count - first);
+                        detail::blob_delta_decode(p_, first, n, reinterpret_cast<uint64_t*>(out.data() + first));
+                    }
+                    return;
+                }
+                size_t i = 0;
+                for_each_element([&](const BlobView& element) {
+                    if (!detail::blob_is_integer(element.type())) {
+                        throw std::runtime_error("Blob array element is not an integer");
+                    }
+                    out[i++] = static_cast<int64_t>(element.bits());
+                });
+            }
+
+            // Calls f(std::string_view key, BlobView value) for every member of an OBJECT
+            template <typename F>
+            void for_each_member(F&& f) const {
+                expect(OBJECT);
+                if (kind_ == ROW) {
+                    const uint8_t* entry = p_ + detail::BLOB_COLUMNAR_HEADER_SIZE;
+                    uint32_t columns = detail::blob_load<uint32_t>(p_ + detail::BLOB_CONTAINER_HEADER_SIZE);
+                    for (uint32_t i = 0; i < columns; ++i) {
+                        BlobView value(p_, entry, row_, CELL);
+                        f(BlobColumn(p_, entry).name(), value);
+                        entry += BlobColumn::entry_size(entry);
+                    }
+                    return;
+                }
+                uint32_t count = detail::blob_load<uint32_t>(p_ + 1);
+                const uint8_t* member = p_ + detail::BLOB_CONTAINER_HEADER_SIZE;
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint32_t key_len = detail::blob_load<uint32_t>(member);
+                    std::string_view key(reinterpret_cast<const char*>(member + 4), key_len);
+                    const uint8_t* value = member + 4 + key_len;
+                    f(key, BlobView(value));
+                    member = value + detail::blob_element_size(value);
+                }
+            }
+
+            // Columns of a columnar ARRAY
+            size_t column_count() const {
+                expect_columnar();
+                return detail::blob_load<uint32_t>(p_ + detail::BLOB_CONTAINER_HEADER_SIZE);
+            }
+
+            BlobColumn column(size_t index) const {
+                if (index >= column_count()) {
+                    throw std::out_of_range("Blob column index out of range");
+                }
+                const uint8_t* entry = p_ + detail::BLOB_COLUMNAR_HEADER_SIZE;
+                for (size_t i = 0; i < index; ++i) {
+                    entry += BlobColumn::entry_size(entry);
+                }
+                return BlobColumn(p_, entry);
+            }
+
+            BlobColumn column(std::string_view name) const {
+                size_t count = column_count();
+                const uint8_t* entry = p_ + detail::BLOB_COLUMNAR_HEADER_SIZE;
+                for (size_t i = 0; i < count; ++i) {
+                    BlobColumn column(p_, entry);
+                    if (column.name() == name) {
+                        return column;
+                    }
+                    entry += BlobColumn::entry_size(entry);
+                }
+                throw std::out_of_range("Blob column not found: " + std::string(name));
+            }
+
+            // Pointer to the encoded element, only meaningful when the view is not a columnar row or field
+            const uint8_t* data() const { return kind_ == ENCODED ? p_ : nullptr; }
+
+        private:
+            friend class BlobColumn;
+
+            enum Kind : uint8_t {
+                ENCODED,    // p_ points at an encoded element
+                ROW,        // row_ of the columnar ARRAY at p_
+                CELL,       // row_ of the column whose directory entry is entry_
+                VALUE       // value_ decoded from the delta ARRAY at p_
+            };
+
+            BlobView(const uint8_t* array, const uint8_t* entry, uint32_t row, Kind kind)
+                : p_(array), entry_(entry), row_(row), kind_(kind) {}
+
+            BlobView(const uint8_t* array, uint64_t value)
+                : p_(array), value_(value), kind_(VALUE) {}
+
+            void expect(BlobElementDataType expected) const {
+                if (type() != expected) {
+                    throw std::runtime_error("Blob element has an unexpected data type");
+                }
+            }
+
+            void expect_columnar() const {
+                if (!is_columnar()) {
+                    throw std::runtime_error("Blob element is not a columnar ARRAY");
+                }
+            }
+
+            // 64 bit pattern of a numeric scalar
+            uint64_t bits() const {
+                switch (kind_) {
+                    case CELL:
+                        return detail::blob_load<uint64_t>(BlobColumn(p_, entry_).value_data() + 8 * static_cast<size_t>(row_));
+                    case VALUE:
+                        return value_;
+                    default:
+                        return detail::blob_scalar_bits(p_);
+                }
+            }
+
+            std::string_view bytes() const {
+                if (kind_ == CELL) {
+                    return BlobColumn(p_, entry_).string_at(row_);
+                }
+                return std::string_view(reinterpret_cast<const char*>(p_ + 5), detail::blob_load<uint32_t>(p_ + 1));
+            }
+
+            const uint8_t* p_ = detail::blob_null_element();
+            const uint8_t* entry_ = nullptr;
+            uint64_t value_ = 0;
+            uint32_t row_ = 0;
+            Kind kind_ = ENCODED;
+    };
+
+    inline BlobView BlobColumn::at(size_t row) const {
+        if (row >= rows_) {
+            throw std::out_of_range("Blob column row out of range");
+        }
+        return BlobView(array_, entry_, static_cast<uint32_t>(row), BlobView::CELL);
+    }
+
+    /**
+     * Blob: owns the encoded bytes of a single root element.
+     */
     class Blob {
         public:
             Blob() = default;
+            Blob(const Blob&) = default;
+            Blob(Blob&&) = default;
+            Blob& operator=(const Blob&) = default;
+            Blob& operator=(Blob&&) = default;
             ~Blob() = default;
 
-            // Add methods to serialize and deserialize to/from JSON, CSV, etc.
-            // Add methods to handle memory mapping if needed.
+            explicit Blob(std::vector<uint8_t> data) : data_(std::move(data)) {}
+
+            /**
+             * root_offset skips leading padding, used when an element is copied out of a larger Blob so its
+             * columnar data keeps the same 8 byte alignment.
+             */
+            Blob(std::vector<uint8_t> data, size_t root_offset) : data_(std::move(data)), root_offset_(root_offset) {
+                if (root_offset_ > data_.size()) {
+                    throw std::out_of_range("Blob root offset exceeds its size");
+                }
+            }
+
+            BlobView root() const {
+                return root_offset_ == data_.size() ? BlobView() : BlobView(data_.data() + root_offset_);
+            }
+
+            const uint8_t* data() const { return data_.data(); }
+            size_t size() const { return data_.size(); }
+            size_t root_offset() const { return root_offset_; }
+            bool empty() const { return root_offset_ == data_.size(); }
+
+            /**
+             * Metadata describes the data and its structure, for example the source format or the JSON Schema
+             * of the root element.  It travels with the Blob when it is archived.
+             */
+            void set_metadata(const std::string& key, std::string value) {
+                metadata_[key] = std::move(value);
+            }
+
+            std::optional<std::string_view> get_metadata(std::string_view key) const {
+                auto found = metadata_.find(key);
+                if (found == metadata_.end()) {
+                    return std::nullopt;
+                }
+                return std::string_view(found->second);
+            }
+
+            const std::map<std::string, std::string, std::less<>>& metadata() const { return metadata_; }
 
         private:
-            // Add private members to store metadata and data.
-            void* metadata_ = nullptr; // Pointer to metadata structure
-            void* data_ = nullptr;     // Pointer to the actual data
+            std::vector<uint8_t> data_;     // Encoded root element
+            size_t root_offset_ = 0;
+            std::map<std::string, std::string, std::less<>> metadata_;
+    };
+
+    /**
+     * BlobBuilder: writes a Blob one event at a time.
+     * When an ARRAY is closed and every element is an OBJECT with the same keys and scalar values of a
+     * consistent type (nulls allowed), the array is shredded into one typed column per key.
+     * Integers are stored in the smallest of 1, 2, 4 or 8 bytes that holds them, and an ARRAY of one
+     * integer type is stored as bit-packed deltas when that is smaller, which suits sorted IDs and
+     * timestamps.  The per value calls are inline; the array re-encoders and add_value live in src/blob.cpp.
+     */
+    class BlobBuilder {
+        public:
+            BlobBuilder() = default;
+
+            void set_shred_arrays(bool enabled) { shred_arrays_ = enabled; }
+            void set_shred_min_rows(size_t rows) { shred_min_rows_ = rows; }
+            void set_compact_integers(bool enabled) { compact_integers_ = enabled; }
+            void set_delta_arrays(bool enabled) { delta_arrays_ = enabled; }
+
+            void reserve(size_t bytes) { buffer_.reserve(bytes); }
+
+            void begin_object() { begin_container(OBJECT); }
+            void end_object() { end_container(OBJECT); }
+            void begin_array() { begin_container(ARRAY); }
+
+            void end_array() {
+                end_array(true);
+            }
+
+            // reencode false keeps the row layout, for arrays that are only an intermediate container
+            void end_array(bool reencode);
+
+            void key(std::string_view name) {
+                if (stack_.empty() || !stack_.back().object || stack_.back().has_key) {
+                    throw std::runtime_error("Blob key is only allowed inside an object before a value");
+                }
+                stack_.back().has_key = true;
+                append_bytes(name.data(), name.size());
+            }
+
+            void add_null() {
+                begin_value();
+                buffer_.push_back(detail::blob_make_tag(NULL_VALUE));
+            }
+
+            void add_bool(bool value) {
+                begin_value();
+                buffer_.push_back(detail::blob_make_tag(BOOLEAN));
+                buffer_.push_back(value ? 1 : 0);
+            }
+
+            void add_int(int64_t value) { add_integer(INTEGER, static_cast<uint64_t>(value)); }
+            void add_uint(uint64_t value) { add_integer(UNSIGNED_INTEGER, value); }
+            void add_double(double value) { add_fixed(FLOAT, value); }
+
+            // Milliseconds since the Unix epoch
+            void add_date(int64_t value) { add_integer(DATE, static_cast<uint64_t>(value)); }
+
+            void add_string(std::string_view value) {
+                begin_value();
+                buffer_.push_back(detail::blob_make_tag(STRING));
+                append_bytes(value.data(), value.size());
+            }
+
+            void add_binary(const void* data, size_t size) {
+                begin_value();
+                buffer_.push_back(detail::blob_make_tag(BINARY));
+                append_bytes(data, size);
+            }
+
+            /**
+             * Writes a copy of value, which may come from another Blob.  Encoded elements are copied in bulk
+             * unless that would break the 8 byte alignment of columnar data inside them, in which case they
+             * are re-encoded.
+             */
+            void add_value(const BlobView& value);
+
+            Blob build() {
+                if (!stack_.empty() || !has_root_) {
+                    throw std::runtime_error("Blob is incomplete");
+                }
+                Blob blob(std::move(buffer_));
+                reset();
+                return blob;
+            }
+
+            void reset() {
+                buffer_.clear();
+                stack_.clear();
+                has_root_ = false;
+            }
+
+        private:
+            struct Frame {
+                size_t start;           // Offset of the container tag
+                uint32_t count;         // Elements or members written so far
+                bool object;
+                bool has_key;           // An object key was written and awaits its value
+            };
+
+            void begin_value() {
+                if (stack_.empty()) {
+                    if (has_root_) {
+                        throw std::runtime_error("Blob already has a root element");
+                    }
+                    has_root_ = true;
+                    return;
+                }
+                Frame& frame = stack_.back();
+                if (frame.object) {
+                    if (!frame.has_key) {
+                        throw std::runtime_error("Blob object value requires a key");
+                    }
+                    frame.has_key = false;
+                }
+                frame.count++;
+            }
+
+            template <typename T>
+            void add_fixed(BlobElementDataType type, T value) {
+                begin_value();
+                buffer_.push_back(detail::blob_make_tag(type));
+                detail::blob_append(buffer_, value);
+            }
+
+            void add_integer(BlobElementDataType type, uint64_t value) {
+                if (!compact_integers_) {
+                    add_fixed(type, value);
+                    return;
+                }
+                begin_value();
+                size_t width = integer_width(type, value);
+                uint8_t encoding = width == 1 ? BLOB_ENCODING_WIDTH_1 : width == 2 ? BLOB_ENCODING_WIDTH_2
+                                 : width == 4 ? BLOB_ENCODING_WIDTH_4 : BLOB_ENCODING_DEFAULT;
+                buffer_.push_back(detail::blob_make_tag(type, encoding));
+                size_t pos = buffer_.size();
+                buffer_.resize(pos + width);
+                std::memcpy(buffer_.data() + pos, &value, width);
+            }
+
+            // Smallest width that holds value, sign extended for INTEGER and DATE
+            static size_t integer_width(BlobElementDataType type, uint64_t value) {
+                if (type == UNSIGNED_INTEGER) {
+                    return value <= UINT8_MAX ? 1 : value <= UINT16_MAX ? 2 : value <= UINT32_MAX ? 4 : 8;
+                }
+                int64_t signed_value = static_cast<int64_t>(value);
+                return (signed_value >= INT8_MIN && signed_value <= INT8_MAX) ? 1
+                     : (signed_value >= INT16_MIN && signed_value <= INT16_MAX) ? 2
+                     : (signed_value >= INT32_MIN && signed_value <= INT32_MAX) ? 4 : 8;
+            }
+
+            /**
+             * Re-encodes the ARRAY at start as bit-packed deltas when every element is the same integer type
+             * and the result is smaller.  See detail::blob_delta_decode for the layout.
+             */
+            void delta_array(size_t start);
+
+            void append_bytes(const void* data, size_t size) {
+                if (size > UINT32_MAX) {
+                    throw std::runtime_error("Blob string exceeds maximum size");
+                }
+                detail::blob_append<uint32_t>(buffer_, static_cast<uint32_t>(size));
+                const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                buffer_.insert(buffer_.end(), bytes, bytes + size);
+            }
+
+            void begin_container(BlobElementDataType type) {
+                begin_value();
+                stack_.push_back(Frame{ buffer_.size(), 0, type == OBJECT, false });
+                buffer_.push_back(detail::blob_make_tag(type));
+                detail::blob_append<uint32_t>(buffer_, 0);
+                detail::blob_append<uint32_t>(buffer_, 0);
+            }
+
+            void end_container(BlobElementDataType type) {
+                if (stack_.empty() || stack_.back().object != (type == OBJECT) || stack_.back().has_key) {
+                    throw std::runtime_error("Blob container end does not match its begin");
+                }
+                Frame frame = stack_.back();
+                stack_.pop_back();
+                size_t body = buffer_.size() - frame.start - detail::BLOB_CONTAINER_HEADER_SIZE;
+                if (body > UINT32_MAX) {
+                    throw std::runtime_error("Blob container exceeds maximum size");
+                }
+                detail::blob_patch<uint32_t>(buffer_, frame.start + 1, frame.count);
+                detail::blob_patch<uint32_t>(buffer_, frame.start + 5, static_cast<uint32_t>(body));
+            }
+
+            /**
+             * Re-encodes the ARRAY at start as columns when its elements are homogeneous, leaves it as is
+             * otherwise.  Layout: header, u32 column count, a directory of (name, type, validity offset,
+             * values offset) entries, then for each column an aligned validity bitmap and aligned values.
+             */
+            void shred_array(size_t start);
+
+            // Index of key in names, checking the expected position first, names.size() if missing
+            static size_t find_name(const std::vector<std::string_view>& names, std::string_view key, size_t hint);
+
+            std::vector<uint8_t> buffer_;
+            std::vector<Frame> stack_;
+            bool has_root_ = false;
+            bool shred_arrays_ = true;
+            size_t shred_min_rows_ = 2;
+            bool compact_integers_ = true;
+            bool delta_arrays_ = true;
+            size_t delta_min_values_ = 8;
     };
 
 } // namespace pb
@@ -0,0 +1,421 @@
+/**
+ * Blob archives: the data section of a Blob split into fixed size blocks that are compressed one by one,
+ * with a block index in the archive metadata.  A reader only decompresses the blocks a read touches and
+ * keeps a small LRU of decoded blocks, so point lookups stay cheap on archived files.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/lz4.h>
+
+
+namespace pb {
+
+    /**
+     * BlobBlockCodec: An abstract base class for the block compression used by Blob archives.
+     * Codecs that need a third party library, zstd for a better ratio for example, are provided by the
+     * application by implementing this interface with a codec id of its own.
+     */
+    class BlobBlockCodec {
+        public:
+            virtual ~BlobBlockCodec() = default;
+
+            // Identifies the codec in the archive header
+            virtual uint16_t id() const = 0;
+
+            // Compresses size bytes from src into out, replacing its contents
+            virtual void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) = 0;
+
+            // Decompresses into dst, which holds exactly the original raw_size bytes
+            virtual void decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t raw_size) = 0;
+    };
+
+    enum BlobBlockCodecId : uint16_t {
+        BLOB_CODEC_NONE = 0,
+        BLOB_CODEC_LZ4 = 1,
+        BLOB_CODEC_ZSTD = 2         // Reserved for an application provided zstd codec
+    };
+
+    /**
+     * BlobBlockCodecNone: A codec that stores blocks as is.
+     */
+    class BlobBlockCodecNone : public BlobBlockCodec {
+        public:
+            virtual uint16_t id() const override { return BLOB_CODEC_NONE; }
+
+            virtual void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) override {
+                out.assign(src, src + size);
+            }
+
+            virtual void decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t raw_size) override {
+                if (size != raw_size) {
+                    throw std::runtime_error("Stored block size does not match");
+                }
+                std::memcpy(dst, src, size);
+            }
+    };
+
+    /**
+     * BlobBlockCodecLZ4: A codec that compresses blocks in the LZ4 block format, built for speed.
+     */
+    class BlobBlockCodecLZ4 : public BlobBlockCodec {
+        public:
+            virtual uint16_t id() const override { return BLOB_CODEC_LZ4; }
+
+            virtual void compress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) override {
+                lz4_compress_block(src, size, out);
+            }
+
+            virtual void decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t raw_size) override {
+                lz4_decompress_block(src, size, dst, raw_size);
+            }
+    };
+
+    namespace detail {
+
+        constexpr uint32_t BLOB_ARCHIVE_MAGIC = 0x424c4250;    // "PBLB"
+        constexpr uint16_t BLOB_ARCHIVE_VERSION = 2;
+        constexpr size_t BLOB_ARCHIVE_HEADER_SIZE = 40;
+        constexpr size_t BLOB_ARCHIVE_INDEX_ENTRY_SIZE = 12;   // u64 offset, u32 stored size
+
+    } // namespace detail
+
+    constexpr size_t BLOB_ARCHIVE_DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * Writes blob as an archive.  Layout, little endian:
+     *   u32 magic, u16 version, u16 codec id, u32 block size, u32 block count, u64 raw size, u64 root offset,
+     *   u64 metadata offset
+     *   block index: u64 offset from the start of the archive, u32 stored size per block
+     *   blocks
+     *   metadata: u32 count, then u32 key length, key, u32 value length, value per entry
+     * A block whose compressed form is not smaller than the raw data is stored raw, which the reader
+     * recognises by its stored size being the raw size.
+     */
+    inline std::vector<uint8_t> write_blob_archive(const Blob& blob, BlobBlockCodec& codec,
+                                                   size_t block_size = BLOB_ARCHIVE_DEFAULT_BLOCK_SIZE) {
+        if (block_size == 0 || block_size > UINT32_MAX) {
+            throw std::runtime_error("Invalid Blob archive block size");
+        }
+        size_t raw_size = blob.size();
+        size_t blocks = (raw_size + block_size - 1) / block_size;
+        if (blocks > UINT32_MAX) {
+            throw std::runtime_error("Blob archive has too many blocks");
+        }
+
+        std::vector<uint8_t> out;
+        detail::blob_append<uint32_t>(out, detail::BLOB_ARCHIVE_MAGIC);
+        detail::blob_append<uint16_t>(out, detail::BLOB_ARCHIVE_VERSION);
+        detail::blob_append<uint16_t>(out, codec.id());
+        detail::blob_append<uint32_t>(out, static_cast<uint32_t>(block_size));
+        detail::blob_append<uint32_t>(out, static_cast<uint32_t>(blocks));
+        detail::blob_append<uint64_t>(out, raw_size);
+        detail::blob_append<uint64_t>(out, blob.root_offset());
+        detail::blob_append<uint64_t>(out, 0);
+        size_t index = out.size();
+        out.resize(index + blocks * detail::BLOB_ARCHIVE_INDEX_ENTRY_SIZE);
+
+        std::vector<uint8_t> compressed;
+        for (size_t b = 0; b < blocks; ++b) {
+            const uint8_t* block = blob.data() + b * block_size;
+            size_t size = std::min(block_size, raw_size - b * block_size);
+            codec.compress(block, size, compressed);
+            size_t entry = index + b * detail::BLOB_ARCHIVE_INDEX_ENTRY_SIZE;
+            detail::blob_patch<uint64_t>(out, entry, out.size());
+            if (compressed.size() < size) {
+                detail::blob_patch<uint32_t>(out, entry + 8, static_cast<uint32_t>(compressed.size()));
+                out.insert(out.end(), compressed.begin(), compressed.end());
+            } else {
+                detail::blob_patch<uint32_t>(out, entry + 8, static_cast<uint32_t>(size));
+                out.insert(out.end(), block, block + size);
+            }
+        }
+
+        detail::blob_patch<uint64_t>(out, 32, out.size());
+        detail::blob_append<uint32_t>(out, static_cast<uint32_t>(blob.metadata().size()));
+        for (const auto& [key, value] : blob.metadata()) {
+            detail::blob_append<uint32_t>(out, static_cast<uint32_t>(key.size()));
+            out.insert(out.end(), key.begin(), key.end());
+            detail::blob_append<uint32_t>(out, static_cast<uint32_t>(value.size()));
+            out.insert(out.end(), value.begin(), value.end());
+        }
+        return out;
+    }
+
+    /**
+     * BlobArchiveReader: random access to the data section of a Blob archive, which is typically memory
+     * mapped.  Decoded blocks are kept in an LRU cache of cache_blocks entries.  Reads are thread safe.
+     */
+    class BlobArchiveReader {
+        public:
+            BlobArchiveReader(std::span<const uint8_t> archive, BlobBlockCodec& codec, size_t cache_blocks = 16)
+                : archive_(archive), codec_(codec), cache_blocks_(std::max<size_t>(cache_blocks, 1)) {
+                if (archive.size() < detail::BLOB_ARCHIVE_HEADER_SIZE
+                    || detail::blob_load<uint32_t>(archive.data()) != detail::BLOB_ARCHIVE_MAGIC) {
+                    throw std::runtime_error("Not a Blob archive");
+                }
+                if (detail::blob_load<uint16_t>(archive.data() + 4) != detail::BLOB_ARCHIVE_VERSION) {
+                    throw std::runtime_error("Unsupported Blob archive version");
+                }
+                if (detail::blob_load<uint16_t>(archive.data() + 6) != codec.id()) {
+                    throw std::runtime_error("Blob archive was written with a different codec");
+                }
+                block_size_ = detail::blob_load<uint32_t>(archive.data() + 8);
+                block_count_ = detail::blob_load<uint32_t>(archive.data() + 12);
+                raw_size_ = detail::blob_load<uint64_t>(archive.data() + 16);
+                root_offset_ = detail::blob_load<uint64_t>(archive.data() + 24);
+                if (block_size_ == 0 || block_count_ != (raw_size_ + block_size_ - 1) / block_size_
+                    || archive.size() < detail::BLOB_ARCHIVE_HEADER_SIZE + block_count_ * detail::BLOB_ARCHIVE_INDEX_ENTRY_SIZE
+                    || root_offset_ > raw_size_) {
+                    throw std::runtime_error("Corrupt Blob archive header");
+                }
+                read_metadata(detail::blob_load<uint64_t>(archive.data() + 32));
+            }
+
+            // Metadata of the archived Blob, available without decompressing anything
+            const std::map<std::string, std::string, std::less<>>& metadata() const { return metadata_; }
+
+            // Size of the uncompressed data section
+            size_t size() const { return raw_size_; }
+
+            // Number of blocks decompressed so far, cache hits excluded
+            size_t blocks_decoded() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return blocks_decoded_;
+            }
+
+            size_t read(void* buffer, size_t size, size_t offset) {
+                if (offset > raw_size_ || size > raw_size_ - offset) {
+                    throw std::out_of_range("Read exceeds Blob archive size");
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                uint8_t* out = static_cast<uint8_t*>(buffer);
+                size_t done = 0;
+                while (done < size) {
+                    size_t position = offset + done;
+                    const std::vector<uint8_t>& block = load_block(position / block_size_);
+                    size_t within = position % block_size_;
+                    size_t take = std::min(size - done, block.size() - within);
+                    std::memcpy(out + done, block.data() + within, take);
+                    done += take;
+                }
+                return size;
+            }
+
+            /**
+             * Copies the element at offset into a Blob of its own, keeping its offset modulo 8 so columnar
+             * data stays aligned.
+             */
+            Blob read_element(size_t offset) {
+                uint8_t header[detail::BLOB_CONTAINER_HEADER_SIZE] = {};
+                read(header, std::min(sizeof(header), raw_size_ - std::min(offset, raw_size_)), offset);
+                size_t size = detail::blob_element_size(header);
+                size_t padding = offset % detail::BLOB_COLUMN_ALIGNMENT;
+                std::vector<uint8_t> data(padding + size);
+                read(data.data() + padding, size, offset);
+                return Blob(std::move(data), padding);
+            }
+
+            Blob root() {
+                return read_element(root_offset_);
+            }
+
+            /**
+             * Looks up a JSON Pointer (RFC 6901), for example "/orders/3/id", reading only the element headers
+             * and keys along the path.  Columnar and delta arrays are read whole once the path reaches them.
+             * Throws std::out_of_range if the path does not exist.
+             */
+            Blob at(std::string_view pointer) {
+                if (!pointer.empty() && pointer[0] != '/') {
+                    throw std::runtime_error("JSON Pointer must start with '/'");
+                }
+                size_t offset = root_offset_;
+                while (!pointer.empty()) {
+                    pointer.remove_prefix(1);
+                    size_t end = std::min(pointer.find('/'), pointer.size());
+                    std::string token = unescape(pointer.substr(0, end));
+                    pointer.remove_prefix(end);
+
+                    uint8_t header[detail::BLOB_CONTAINER_HEADER_SIZE] = {};
+                    read(header, std::min(sizeof(header), raw_size_ - offset), offset);
+                    BlobElementDataType type = detail::blob_tag_type(header[0]);
+                    uint32_t count = detail::blob_load<uint32_t>(header + 1);
+
+                    if (header[0] == detail::blob_make_tag(OBJECT)) {
+                        offset = find_member(offset, count, token);
+                    } else if (header[0] == detail::blob_make_tag(ARRAY)) {
+                        offset = find_element(offset, count, parse_index(token));
+                    } else if (type == ARRAY) {
+                        // Columnar and delta arrays have no per element offsets, finish in memory
+                        Blob array = read_element(offset);
+                        BlobView value = array.root()[parse_index(token)];
+                        while (!pointer.empty()) {
+                            pointer.remove_prefix(1);
+                            end = std::min(pointer.find('/'), pointer.size());
+                            token = unescape(pointer.substr(0, end));
+                            pointer.remove_prefix(end);
+                            value = value.is_array() ? value[parse_index(token)] : value[std::string_view(token)];
+                        }
+                        BlobBuilder builder;
+                        builder.add_value(value);
+                        return builder.build();
+                    } else {
+                        throw std::out_of_range("JSON Pointer descends into a scalar");
+                    }
+                }
+                return read_element(offset);
+            }
+
+            // Decompresses the whole data section
+            Blob to_blob() {
+                std::vector<uint8_t> data(raw_size_);
+                read(data.data(), raw_size_, 0);
+                Blob blob(std::move(data), root_offset_);
+                for (const auto& [key, value] : metadata_) {
+                    blob.set_metadata(key, value);
+                }
+                return blob;
+            }
+
+        private:
+            void read_metadata(size_t offset) {
+                auto take = [&](size_t size) {
+                    if (offset > archive_.size() || size > archive_.size() - offset) {
+                        throw std::runtime_error("Corrupt Blob archive metadata");
+                    }
+                    const uint8_t* at = archive_.data() + offset;
+                    offset += size;
+                    return at;
+                };
+                uint32_t count = detail::blob_load<uint32_t>(take(4));
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint32_t key_len = detail::blob_load<uint32_t>(take(4));
+                    std::string key(reinterpret_cast<const char*>(take(key_len)), key_len);
+                    uint32_t value_len = detail::blob_load<uint32_t>(take(4));
+                    metadata_[std::move(key)] = std::string(reinterpret_cast<const char*>(take(value_len)), value_len);
+                }
+            }
+
+            const std::vector<uint8_t>& load_block(size_t index) {
+                auto found = cache_index_.find(index);
+                if (found != cache_index_.end()) {
+                    cache_.splice(cache_.begin(), cache_, found->second);
+                    return found->second->second;
+                }
+
+                size_t entry = detail::BLOB_ARCHIVE_HEADER_SIZE + index * detail::BLOB_ARCHIVE_INDEX_ENTRY_SIZE;
+                uint64_t stored_offset = detail::blob_load<uint64_t>(archive_.data() + entry);
+                uint32_t stored_size = detail::blob_load<uint32_t>(archive_.data() + entry + 8);
+                if (stored_offset > archive_.size() || stored_size > archive_.size() - stored_offset) {
+                    throw std::runtime_error("Corrupt Blob archive block index");
+                }
+                size_t raw = std::min<size_t>(block_size_, raw_size_ - index * block_size_);
+
+                std::vector<uint8_t> block;
+                if (cache_.size() >= cache_blocks_) {
+                    // Reuse the buffer of the least recently used block
+                    block = std::move(cache_.back().second);
+                    cache_index_.erase(cache_.back().first);
+                    cache_.pop_back();
+                }
+                block.resize(raw);
+                const uint8_t* stored = archive_.data() + stored_offset;
+                if (stored_size == raw) {
+                    std::memcpy(block.data(), stored, raw);
+                } else {
+                    codec_.decompress(stored, stored_size, block.data(), raw);
+                }
+                blocks_decoded_++;
+
+                cache_.emplace_front(index, std::move(block));
+                cache_index_[index] = cache_.begin();
+                return cache_.front().second;
+            }
+
+            size_t element_size(size_t offset) {
+                uint8_t header[detail::BLOB_CONTAINER_HEADER_SIZE] = {};
+                read(header, std::min(sizeof(header), raw_size_ - offset), offset);
+                return detail::blob_element_size(header);
+            }
+
+            size_t find_member(size_t offset, uint32_t count, const std::string& key) {
+                size_t member = offset + detail::BLOB_CONTAINER_HEADER_SIZE;
+                std::string name;
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint32_t key_len;
+                    read(&key_len, sizeof(key_len), member);
+                    size_t value = member + 4 + key_len;
+                    if (key_len == key.size()) {
+                        name.resize(key_len);
+                        read(name.data(), key_len, member + 4);
+                        if (name == key) {
+                            return value;
+                        }
+                    }
+                    member = value + element_size(value);
+                }
+                throw std::out_of_range("Key not found in Blob object: " + key);
+            }
+
+            size_t find_element(size_t offset, uint32_t count, size_t index) {
+                if (index >= count) {
+                    throw std::out_of_range("Blob array index out of range");
+                }
+                size_t element = offset + detail::BLOB_CONTAINER_HEADER_SIZE;
+                for (size_t i = 0; i < index; ++i) {
+                    element += element_size(element);
+                }
+                return element;
+            }
+
+            static size_t parse_index(const std::string& token) {
+                if (token.empty() || token.find_first_not_of("0123456789") != std::string::npos) {
+                    throw std::out_of_range("JSON Pointer token is not an array index: " + token);
+                }
+                return std::stoull(token);
+            }
+
+            static std::string unescape(std::string_view token) {
+                std::string result;
+                for (size_t i = 0; i < token.size(); ++i) {
+                    if (token[i] == '~' && i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1')) {
+                        result.push_back(token[i + 1] == '0' ? '~' : '/');
+                        ++i;
+                    } else {
+                        result.push_back(token[i]);
+                    }
+                }
+                return result;
+            }
+
+            std::span<const uint8_t> archive_;
+            BlobBlockCodec& codec_;
+            size_t cache_blocks_;
+            size_t block_size_ = 0;
+            size_t block_count_ = 0;
+            size_t raw_size_ = 0;
+            size_t root_offset_ = 0;
+            size_t blocks_decoded_ = 0;
+            std::map<std::string, std::string, std::less<>> metadata_;
+            std::list<std::pair<size_t, std::vector<uint8_t>>> cache_;       // Most recently used first
+            std::unordered_map<size_t, std::list<std::pair<size_t, std::vector<uint8_t>>>::iterator> cache_index_;
+            mutable std::mutex mutex_;
+    };
+
+} // namespace pb
@@ -0,0 +1,552 @@
+/**
+ * Equality, hashing and diff of Blobs, computed on the binary layout.
+ * Comparison is structural: OBJECT members match by key in any order and values compare equal whatever
+ * their encoding (integer width, delta or columnar arrays).  Identical encodings short-circuit with
+ * memcmp.  diff produces a JSON Patch (RFC 6902) as a Blob and apply_patch applies it.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <pb/blob.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr uint64_t BLOB_HASH_K0 = 0xa0761d6478bd642full;
+        constexpr uint64_t BLOB_HASH_K1 = 0xe7037ed1a0b428dbull;
+        constexpr uint64_t BLOB_HASH_K2 = 0x8ebc6af09c88c6e3ull;
+        constexpr size_t BLOB_SORTED_LOOKUP_MIN = 16;     // Objects with more members are matched through a sorted index
+
+        // Folds the 128 bit product of a and b into 64 bits
+        inline uint64_t blob_hash_mum(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+            unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+            uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32, b_lo = b & 0xffffffff, b_hi = b >> 32;
+            uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+            uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+            uint64_t low = (cross << 32) | (lo_lo & 0xffffffff);
+            uint64_t high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+            return low ^ high;
+#endif
+        }
+
+        /**
+         * Multiply-fold hash over 16 bytes per step, in the style of wyhash and XXH3: each step is one
+         * 64x64->128 bit multiply of two loaded words.
+         */
+        inline uint64_t blob_hash_bytes(const void* data, size_t size, uint64_t seed) {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            uint64_t h = seed ^ BLOB_HASH_K0;
+            size_t remaining = size;
+            while (remaining >= 16) {
+                h = blob_hash_mum(blob_load<uint64_t>(p) ^ BLOB_HASH_K1, blob_load<uint64_t>(p + 8) ^ h);
+                p += 16;
+                remaining -= 16;
+            }
+            uint8_t tail[16] = {};
+            std::memcpy(tail, p, remaining);
+            h = blob_hash_mum(blob_load<uint64_t>(tail) ^ BLOB_HASH_K1, blob_load<uint64_t>(tail + 8) ^ h);
+            return blob_hash_mum(h ^ BLOB_HASH_K2, static_cast<uint64_t>(size) ^ BLOB_HASH_K1);
+        }
+
+        inline uint64_t blob_hash_word(uint64_t value, uint64_t seed) {
+            return blob_hash_mum(value ^ BLOB_HASH_K1, seed ^ BLOB_HASH_K2) ^ seed;
+        }
+
+        // FLOAT values hash and compare by value, with -0.0 equal to 0.0 and NaN equal to NaN
+        inline uint64_t blob_canonical_double(double value) {
+            if (value == 0) {
+                return 0;
+            }
+            if (value != value) {
+                return 0x7ff8000000000000ull;
+            }
+            return std::bit_cast<uint64_t>(value);
+        }
+
+        inline uint64_t blob_hash(const BlobView& value) {
+            BlobElementDataType type = value.type();
+            uint64_t seed = static_cast<uint64_t>(type) * BLOB_HASH_K0;
+            switch (type) {
+                case NULL_VALUE:
+                    return blob_hash_word(0, seed);
+                case BOOLEAN:
+                    return blob_hash_word(value.as_bool() ? 1 : 0, seed);
+                case INTEGER:
+                case DATE:
+                    return blob_hash_word(static_cast<uint64_t>(type == DATE ? value.as_date() : value.as_int()), seed);
+                case UNSIGNED_INTEGER:
+                    return blob_hash_word(value.as_uint(), seed);
+                case FLOAT:
+                    return blob_hash_word(blob_canonical_double(value.as_double()), seed);
+                case STRING: {
+                    std::string_view text = value.as_string();
+                    return blob_hash_bytes(text.data(), text.size(), seed);
+                }
+                case BINARY: {
+                    std::span<const uint8_t> bytes = value.as_binary();
+                    return blob_hash_bytes(bytes.data(), bytes.size(), seed);
+                }
+                case ARRAY: {
+                    uint64_t h = blob_hash_word(value.size(), seed);
+                    value.for_each_element([&](const BlobView& element) {
+                        h = blob_hash_mum(h ^ BLOB_HASH_K1, blob_hash(element) ^ BLOB_HASH_K2);
+                    });
+                    return h;
+                }
+                case OBJECT: {
+                    // Members are summed so their order does not matter
+                    uint64_t sum = 0;
+                    value.for_each_member([&](std::string_view key, const BlobView& member) {
+                        uint64_t key_hash = blob_hash_bytes(key.data(), key.size(), BLOB_HASH_K2);
+                        sum += blob_hash_mum(key_hash ^ BLOB_HASH_K0, blob_hash(member) ^ BLOB_HASH_K1);
+                    });
+                    return blob_hash_word(sum, blob_hash_word(value.size(), seed));
+                }
+            }
+            return seed;
+        }
+
+        inline std::vector<BlobView> blob_elements(const BlobView& array) {
+            std::vector<BlobView> elements;
+            elements.reserve(array.size());
+            array.for_each_element([&](const BlobView& element) { elements.push_back(element); });
+            return elements;
+        }
+
+        using BlobMember = std::pair<std::string_view, BlobView>;
+
+        inline std::vector<BlobMember> blob_sorted_members(const BlobView& object) {
+            std::vector<BlobMember> members;
+            members.reserve(object.size());
+            object.for_each_member([&](std::string_view key, const BlobView& value) { members.emplace_back(key, value); });
+            std::stable_sort(members.begin(), members.end(),
+                             [](const BlobMember& a, const BlobMember& b) { return a.first < b.first; });
+            return members;
+        }
+
+        /**
+         * Looks members up by key, through a sorted copy of the members for large objects so matching
+         * two objects stays O(n log n).
+         */
+        class BlobMemberLookup {
+            public:
+                explicit BlobMemberLookup(const BlobView& object) : object_(object) {
+                    if (object.size() > BLOB_SORTED_LOOKUP_MIN) {
+                        sorted_ = blob_sorted_members(object);
+                    }
+                }
+
+                std::optional<BlobView> find(std::string_view key) const {
+                    if (sorted_.empty()) {
+                        return object_.find(key);
+                    }
+                    auto found = std::lower_bound(sorted_.begin(), sorted_.end(), key,
+                                                  [](const BlobMember& member, std::string_view k) { return member.first < k; });
+                    if (found == sorted_.end() || found->first != key) {
+                        return std::nullopt;
+                    }
+                    return found->second;
+                }
+
+            private:
+                BlobView object_;
+                std::vector<BlobMember> sorted_;
+        };
+
+        inline bool blob_equal(const BlobView& a, const BlobView& b) {
+            if (a.data() != nullptr && b.data() != nullptr) {
+                size_t size = blob_element_size(a.data());
+                if (a.data() == b.data()
+                    || (size == blob_element_size(b.data()) && std::memcmp(a.data(), b.data(), size) == 0)) {
+                    return true;
+                }
+            }
+            BlobElementDataType type = a.type();
+            if (type != b.type()) {
+                return false;
+            }
+            switch (type) {
+                case NULL_VALUE:
+                    return true;
+                case BOOLEAN:
+                    return a.as_bool() == b.as_bool();
+                case INTEGER:
+                    return a.as_int() == b.as_int();
+                case UNSIGNED_INTEGER:
+                    return a.as_uint() == b.as_uint();
+                case DATE:
+                    return a.as_date() == b.as_date();
+                case FLOAT:
+                    return blob_canonical_double(a.as_double()) == blob_canonical_double(b.as_double());
+                case STRING:
+                    return a.as_string() == b.as_string();
+                case BINARY: {
+                    std::span<const uint8_t> x = a.as_binary();
+                    std::span<const uint8_t> y = b.as_binary();
+                    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+                }
+                case ARRAY: {
+                    if (a.size() != b.size()) {
+                        return false;
+                    }
+                    std::vector<BlobView> elements = blob_elements(b);
+                    size_t i = 0;
+                    bool equal = true;
+                    a.for_each_element([&](const BlobView& element) {
+                        equal = equal && blob_equal(element, elements[i]);
+                        ++i;
+                    });
+                    return equal;
+                }
+                case OBJECT: {
+                    if (a.size() != b.size()) {
+                        return false;
+                    }
+                    BlobMemberLookup lookup(b);
+                    bool equal = true;
+                    a.for_each_member([&](std::string_view key, const BlobView& member) {
+                        if (equal) {
+                            std::optional<BlobView> other = lookup.find(key);
+                            equal = other && blob_equal(member, *other);
+                        }
+                    });
+                    return equal;
+                }
+            }
+            return false;
+        }
+
+        // Appends key to a JSON Pointer, escaping '~' and '/'
+        inline std::string blob_pointer_append(const std::string& path, std::string_view key) {
+            std::string result = path;
+            result.push_back('/');
+            for (char c : key) {
+                if (c == '~') {
+                    result += "~0";
+                } else if (c == '/') {
+                    result += "~1";
+                } else {
+                    result.push_back(c);
+                }
+            }
+            return result;
+        }
+
+        inline void blob_patch_op(BlobBuilder& patch, const char* op, const std::string& path, const BlobView* value) {
+            patch.begin_object();
+            patch.key("op");
+            patch.add_string(op);
+            patch.key("path");
+            patch.add_string(path);
+            if (value != nullptr) {
+                patch.key("value");
+                patch.add_value(*value);
+            }
+            patch.end_object();
+        }
+
+        inline void blob_diff(BlobBuilder& patch, const BlobView& a, const BlobView& b, const std::string& path) {
+            if (blob_equal(a, b)) {
+                return;
+            }
+            BlobElementDataType type = a.type();
+            if (type != b.type() || (type != OBJECT && type != ARRAY)) {
+                blob_patch_op(patch, "replace", path, &b);
+                return;
+            }
+            if (type == OBJECT) {
+                BlobMemberLookup lookup(b);
+                a.for_each_member([&](std::string_view key, const BlobView& member) {
+                    std::optional<BlobView> other = lookup.find(key);
+                    if (!other) {
+                        blob_patch_op(patch, "remove", blob_pointer_append(path, key), nullptr);
+                    } else {
+                        blob_diff(patch, member, *other, blob_pointer_append(path, key));
+                    }
+                });
+                BlobMemberLookup original(a);
+                b.for_each_member([&](std::string_view key, const BlobView& member) {
+                    if (!original.find(key)) {
+                        blob_patch_op(patch, "add", blob_pointer_append(path, key), &member);
+                    }
+                });
+                return;
+            }
+
+            // Arrays are compared index by index; surplus elements are removed from the end backwards or
+            // appended, so every index in the patch refers to the array as it is at that point
+            std::vector<BlobView> x = blob_elements(a);
+            std::vector<BlobView> y = blob_elements(b);
+            size_t common = std::min(x.size(), y.size());
+            for (size_t i = 0; i < common; ++i) {
+                blob_diff(patch, x[i], y[i], path + "/" + std::to_string(i));
+            }
+            for (size_t i = x.size(); i > common; --i) {
+                blob_patch_op(patch, "remove", path + "/" + std::to_string(i - 1), nullptr);
+            }
+            for (size_t i = common; i < y.size(); ++i) {
+                blob_patch_op(patch, "add", path + "/" + std::to_string(i), &y[i]);
+            }
+        }
+
+        /**
+         * The operations of a patch arranged by path.  Applying it copies the document once and
+         * substitutes the edited values on the way.
+         */
+        struct BlobPatchNode {
+            enum Op { NONE, REPLACE, REMOVE };
+            Op op = NONE;
+            BlobView value;
+            std::map<std::string, BlobPatchNode, std::less<>> children;
+            std::vector<BlobView> appended;     // Elements added past the end of an ARRAY
+        };
+
+        inline std::vector<std::string> blob_pointer_tokens(std::string_view pointer) {
+            std::vector<std::string> tokens;
+            if (pointer.empty()) {
+                return tokens;
+            }
+            if (pointer[0] != '/') {
+                throw std::runtime_error("Invalid JSON Pointer: " + std::string(pointer));
+            }
+            size_t start = 1;
+            while (true) {
+                size_t end = pointer.find('/', start);
+                std::string_view raw = pointer.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+                std::string token;
+                for (size_t i = 0; i < raw.size(); ++i) {
+                    if (raw[i] == '~' && i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')) {
+                        token.push_back(raw[++i] == '0' ? '~' : '/');
+                    } else {
+                        token.push_back(raw[i]);
+                    }
+                }
+                tokens.push_back(std::move(token));
+                if (end == std::string_view::npos) {
+                    return tokens;
+                }
+                start = end + 1;
+            }
+        }
+
+        inline bool blob_parse_index(std::string_view token, size_t& index) {
+            if (token.empty() || token.size() > 18 || (token.size() > 1 && token[0] == '0')) {
+                return false;
+            }
+            index = 0;
+            for (char c : token) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                index = index * 10 + static_cast<size_t>(c - '0');
+            }
+            return true;
+        }
+
+        inline void blob_apply(BlobBuilder& out, const BlobView& value, const BlobPatchNode& node) {
+            if (node.op == BlobPatchNode::REPLACE) {
+                out.add_value(node.value);
+                return;
+            }
+            if (node.children.empty() && node.appended.empty()) {
+                out.add_value(value);
+                return;
+            }
+            if (value.type() == OBJECT) {
+                out.begin_object();
+                value.for_each_member([&](std::string_view key, const BlobView& member) {
+                    auto edit = node.children.find(key);
+                    if (edit == node.children.end()) {
+                        out.key(key);
+                        out.add_value(member);
+                    } else if (edit->second.op != BlobPatchNode::REMOVE) {
+                        out.key(key);
+                        blob_apply(out, member, edit->second);
+                    }
+                });
+                for (const auto& [key, edit] : node.children) {
+                    if (edit.op == BlobPatchNode::REPLACE && !value.contains(key)) {
+                        out.key(key);
+                        out.add_value(edit.value);
+                    }
+                }
+                out.end_object();
+                return;
+            }
+            if (value.type() == ARRAY) {
+                size_t count = value.size();
+                for (const auto& [token, edit] : node.children) {
+                    size_t index;
+                    if (!blob_parse_index(token, index) || index >= count) {
+                        throw std::runtime_error("Patch path is not an element of the Blob array: " + token);
+                    }
+                }
+                out.begin_array();
+                size_t i = 0;
+                value.for_each_element([&](const BlobView& element) {
+                    auto edit = node.children.find(std::to_string(i++));
+                    if (edit == node.children.end()) {
+                        out.add_value(element);
+                    } else if (edit->second.op != BlobPatchNode::REMOVE) {
+                        blob_apply(out, element, edit->second);
+                    }
+                });
+                for (const BlobView& element : node.appended) {
+                    out.add_value(element);
+                }
+                out.end_array();
+                return;
+            }
+            throw std::runtime_error("Patch path goes through a Blob scalar");
+        }
+
+    } // namespace detail
+
+    /**
+     * Structural hash: equal values hash equally whatever their encoding and OBJECT member order.
+     */
+    inline uint64_t hash(const BlobView& value) {
+        return detail::blob_hash(value);
+    }
+
+    inline uint64_t hash(const Blob& blob) {
+        return detail::blob_hash(blob.root());
+    }
+
+    inline bool operator==(const BlobView& a, const BlobView& b) {
+        return detail::blob_equal(a, b);
+    }
+
+    // Compares the data only, metadata is not part of a Blob's value
+    inline bool operator==(const Blob& a, const Blob& b) {
+        return detail::blob_equal(a.root(), b.root());
+    }
+
+    /**
+     * Returns a JSON Patch (RFC 6902), an ARRAY of add, remove and replace operations, that turns a into b.
+     */
+    inline Blob diff(const BlobView& a, const BlobView& b) {
+        BlobBuilder patch;
+        patch.begin_array();
+        detail::blob_diff(patch, a, b, "");
+        patch.end_array();
+        return patch.build();
+    }
+
+    inline Blob diff(const Blob& a, const Blob& b) {
+        return diff(a.root(), b.root());
+    }
+
+    /**
+     * Applies a JSON Patch to document.  Supports the add, remove and replace operations, with array
+     * insertions limited to appending at the end ("-" or the array size), which covers every patch
+     * produced by diff.  Throws std::runtime_error on any other operation or a path that does not fit.
+     */
+    inline Blob apply_patch(const BlobView& document, const BlobView& patch) {
+        detail::BlobPatchNode root;
+        patch.for_each_element([&](const BlobView& operation) {
+            std::string_view op = operation["op"].as_string();
+            std::vector<std::string> tokens = detail::blob_pointer_tokens(operation["path"].as_string());
+            if (op != "add" && op != "remove" && op != "replace") {
+                throw std::runtime_error("Unsupported JSON Patch operation: " + std::string(op));
+            }
+
+            // Walks the patch tree alongside the document so array appends can be told from replacements
+            detail::BlobPatchNode* node = &root;
+            std::optional<BlobView> current = document;
+            for (size_t t = 0; t < tokens.size(); ++t) {
+                const std::string& token = tokens[t];
+                bool last = t + 1 == tokens.size();
+                if (node->op != detail::BlobPatchNode::NONE || !current) {
+                    throw std::runtime_error("Patch path goes through an edited value: " + token);
+                }
+                if (current->type() == ARRAY) {
+                    size_t index = 0;
+                    bool numeric = detail::blob_parse_index(token, index);
+                    size_t end = current->size() + node->appended.size();
+                    if (last && op == "add" && (token == "-" || (numeric && index == end))) {
+                        node->appended.push_back(operation["value"]);
+                        node = nullptr;
+                        break;
+                    }
+                    if (!numeric || index >= current->size()) {
+                        throw std::runtime_error("Patch array index out of range: " + token);
+                    }
+                    if (last && op == "add") {
+                        throw std::runtime_error("Patch inserts into the middle of an array: " + token);
+                    }
+                    if (last && op == "remove") {
+                        size_t removed = static_cast<size_t>(std::count_if(node->children.begin(), node->children.end(),
+                            [](const auto& child) { return child.second.op == detail::BlobPatchNode::REMOVE; }));
+                        if (index + removed + 1 != current->size() || !node->appended.empty()) {
+                            throw std::runtime_error("Patch removes an array element other than the last: " + token);
+                        }
+                    }
+                    current = (*current)[index];
+                } else if (current->type() == OBJECT) {
+                    current = current->find(token);
+                    if (!current && !(last && op == "add")) {
+                        throw std::runtime_error("Patch path not found: " + token);
+                    }
+                } else {
+                    throw std::runtime_error("Patch path goes through a Blob scalar");
+                }
+                node = &node->children[token];
+                if (node->op == detail::BlobPatchNode::REMOVE) {
+                    throw std::runtime_error("Patch path was removed: " + token);
+                }
+            }
+            if (node == nullptr) {
+                return;
+            }
+            if (op == "remove") {
+                if (tokens.empty()) {
+                    throw std::runtime_error("Patch cannot remove the root element");
+                }
+                node->op = detail::BlobPatchNode::REMOVE;
+            } else {
+                node->op = detail::BlobPatchNode::REPLACE;
+                node->value = operation["value"];
+            }
+            node->children.clear();
+            node->appended.clear();
+        });
+
+        BlobBuilder out;
+        detail::blob_apply(out, document, root);
+        return out.build();
+    }
+
+    inline Blob apply_patch(const Blob& document, const Blob& patch) {
+        return apply_patch(document.root(), patch.root());
+    }
+
+} // namespace pb
+
+
+template <>
+struct std::hash<pb::Blob> {
+    size_t operator()(const pb::Blob& blob) const {
+        return static_cast<size_t>(pb::hash(blob));
+    }
+};
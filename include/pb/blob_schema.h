@@ -0,0 +1,604 @@
+/**
+ * Schema inference for Blob.
+ * BlobSchema makes a single pass over one or more Blobs and merges what it sees per path: the data
+ * types, nullability, numeric and length ranges and a HyperLogLog estimate of the distinct values.
+ * Columnar and delta arrays are summarized straight from their columns and blocks.  The result is
+ * exported as JSON Schema and can be stored in the Blob metadata so readers know the shape of the data
+ * without probing it.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/json.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t SCHEMA_HLL_REGISTERS = 256;      // Standard error of about 6.5%
+
+        // One splitmix64 step, spreads the bits of a value over the whole word
+        inline uint64_t schema_mix(uint64_t value) {
+            value += 0x9e3779b97f4a7c15ull;
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ull;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebull;
+            return value ^ (value >> 31);
+        }
+
+        inline uint64_t schema_hash_bytes(std::string_view bytes) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (char c : bytes) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+            }
+            return schema_mix(hash);
+        }
+
+        // Number of code points in UTF-8 text, which is what JSON Schema string lengths count
+        inline uint64_t schema_utf8_length(std::string_view text) {
+            uint64_t length = 0;
+            for (char c : text) {
+                length += (static_cast<uint8_t>(c) & 0xc0) != 0x80 ? 1 : 0;
+            }
+            return length;
+        }
+
+        inline const char* schema_type_name(BlobElementDataType type) {
+            switch (type) {
+                case NULL_VALUE: return "NULL_VALUE";
+                case OBJECT: return "OBJECT";
+                case ARRAY: return "ARRAY";
+                case BOOLEAN: return "BOOLEAN";
+                case STRING: return "STRING";
+                case UNSIGNED_INTEGER: return "UNSIGNED_INTEGER";
+                case INTEGER: return "INTEGER";
+                case FLOAT: return "FLOAT";
+                case DATE: return "DATE";
+                case BINARY: return "BINARY";
+            }
+            return "";
+        }
+
+    } // namespace detail
+
+    /**
+     * BlobSchemaNode: what was seen at one path.  Counts include nulls, so a property is required when
+     * it was present in every OBJECT seen at its parent path.
+     */
+    struct BlobSchemaNode {
+        uint32_t types = 0;                 // Bit per BlobElementDataType seen
+        uint32_t encodings = 0;             // Bit per BlobEncoding seen on ARRAYs
+        uint64_t count = 0;                 // Values seen, nulls included
+        uint64_t null_count = 0;
+        uint64_t object_count = 0;          // OBJECTs seen, the denominator for required properties
+
+        int64_t int_min = std::numeric_limits<int64_t>::max();          // INTEGER
+        int64_t int_max = std::numeric_limits<int64_t>::min();
+        uint64_t uint_min = std::numeric_limits<uint64_t>::max();       // UNSIGNED_INTEGER
+        uint64_t uint_max = 0;
+        double double_min = std::numeric_limits<double>::infinity();    // FLOAT, NaN is ignored
+        double double_max = -std::numeric_limits<double>::infinity();
+        int64_t date_min = std::numeric_limits<int64_t>::max();         // DATE
+        int64_t date_max = std::numeric_limits<int64_t>::min();
+        uint64_t length_min = std::numeric_limits<uint64_t>::max();     // STRING, in code points
+        uint64_t length_max = 0;
+        uint64_t items_min = std::numeric_limits<uint64_t>::max();      // ARRAY
+        uint64_t items_max = 0;
+
+        std::array<uint8_t, detail::SCHEMA_HLL_REGISTERS> registers{};  // HyperLogLog over scalar values
+
+        std::vector<std::pair<std::string, std::unique_ptr<BlobSchemaNode>>> properties;   // In first seen order
+        std::map<std::string, size_t, std::less<>> property_index;
+        std::unique_ptr<BlobSchemaNode> items;
+
+        bool has(BlobElementDataType type) const { return (types >> type) & 1; }
+
+        const BlobSchemaNode* property(std::string_view key) const {
+            auto found = property_index.find(key);
+            return found == property_index.end() ? nullptr : properties[found->second].second.get();
+        }
+
+        bool is_required(std::string_view key) const {
+            const BlobSchemaNode* node = property(key);
+            return node != nullptr && node->count == object_count;
+        }
+
+        // Estimated number of distinct non null scalar values
+        uint64_t distinct() const {
+            constexpr double m = static_cast<double>(detail::SCHEMA_HLL_REGISTERS);
+            double sum = 0;
+            size_t zeros = 0;
+            for (uint8_t rank : registers) {
+                sum += std::ldexp(1.0, -rank);
+                zeros += rank == 0 ? 1 : 0;
+            }
+            if (zeros == detail::SCHEMA_HLL_REGISTERS) {
+                return 0;
+            }
+            double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+            if (estimate <= 2.5 * m && zeros > 0) {
+                estimate = m * std::log(m / static_cast<double>(zeros));     // Linear counting for small sets
+            }
+            return static_cast<uint64_t>(std::llround(estimate));
+        }
+
+        BlobSchemaNode& child(std::string_view key) {
+            auto found = property_index.find(key);
+            if (found != property_index.end()) {
+                return *properties[found->second].second;
+            }
+            property_index.emplace(std::string(key), properties.size());
+            properties.emplace_back(std::string(key), std::make_unique<BlobSchemaNode>());
+            return *properties.back().second;
+        }
+
+        BlobSchemaNode& item() {
+            if (!items) {
+                items = std::make_unique<BlobSchemaNode>();
+            }
+            return *items;
+        }
+
+        void observe_hash(uint64_t hash) {
+            size_t index = hash >> 56;
+            uint64_t rest = hash << 8;
+            uint8_t rank = rest == 0 ? 57 : static_cast<uint8_t>(std::countl_zero(rest) + 1);
+            registers[index] = std::max(registers[index], rank);
+        }
+
+        void observe_null() {
+            types |= 1u << NULL_VALUE;
+            ++count;
+            ++null_count;
+        }
+
+        void observe_bool(bool value) {
+            types |= 1u << BOOLEAN;
+            ++count;
+            observe_hash(detail::schema_mix(value ? 1 : 0));
+        }
+
+        void observe_int(int64_t value) {
+            types |= 1u << INTEGER;
+            ++count;
+            int_min = std::min(int_min, value);
+            int_max = std::max(int_max, value);
+            observe_hash(detail::schema_mix(static_cast<uint64_t>(value)));
+        }
+
+        void observe_uint(uint64_t value) {
+            types |= 1u << UNSIGNED_INTEGER;
+            ++count;
+            uint_min = std::min(uint_min, value);
+            uint_max = std::max(uint_max, value);
+            observe_hash(detail::schema_mix(value));
+        }
+
+        void observe_double(double value) {
+            types |= 1u << FLOAT;
+            ++count;
+            if (!std::isnan(value)) {
+                double_min = std::min(double_min, value);
+                double_max = std::max(double_max, value);
+            }
+            observe_hash(detail::schema_mix(std::bit_cast<uint64_t>(value)));
+        }
+
+        void observe_date(int64_t value) {
+            types |= 1u << DATE;
+            ++count;
+            date_min = std::min(date_min, value);
+            date_max = std::max(date_max, value);
+            observe_hash(detail::schema_mix(static_cast<uint64_t>(value)));
+        }
+
+        void observe_string(std::string_view value) {
+            types |= 1u << STRING;
+            ++count;
+            uint64_t length = detail::schema_utf8_length(value);
+            length_min = std::min(length_min, length);
+            length_max = std::max(length_max, length);
+            observe_hash(detail::schema_hash_bytes(value));
+        }
+
+        void observe_binary(std::span<const uint8_t> value) {
+            types |= 1u << BINARY;
+            ++count;
+            observe_hash(detail::schema_hash_bytes(std::string_view(reinterpret_cast<const char*>(value.data()), value.size())));
+        }
+
+        void observe_items(uint64_t size) {
+            items_min = std::min(items_min, size);
+            items_max = std::max(items_max, size);
+        }
+
+        void merge(const BlobSchemaNode& other) {
+            types |= other.types;
+            encodings |= other.encodings;
+            count += other.count;
+            null_count += other.null_count;
+            object_count += other.object_count;
+            int_min = std::min(int_min, other.int_min);
+            int_max = std::max(int_max, other.int_max);
+            uint_min = std::min(uint_min, other.uint_min);
+            uint_max = std::max(uint_max, other.uint_max);
+            double_min = std::min(double_min, other.double_min);
+            double_max = std::max(double_max, other.double_max);
+            date_min = std::min(date_min, other.date_min);
+            date_max = std::max(date_max, other.date_max);
+            length_min = std::min(length_min, other.length_min);
+            length_max = std::max(length_max, other.length_max);
+            items_min = std::min(items_min, other.items_min);
+            items_max = std::max(items_max, other.items_max);
+            for (size_t i = 0; i < registers.size(); ++i) {
+                registers[i] = std::max(registers[i], other.registers[i]);
+            }
+            for (const auto& [key, node] : other.properties) {
+                child(key).merge(*node);
+            }
+            if (other.items) {
+                item().merge(*other.items);
+            }
+        }
+    };
+
+    /**
+     * BlobSchema: infers the schema of a Blob, or of a stream of Blobs added one after another.
+     * Schemas built on different threads can be combined with merge.
+     */
+    class BlobSchema {
+        public:
+            void add(const BlobView& value) {
+                add(root_, value);
+            }
+
+            void add(const Blob& blob) {
+                add(root_, blob.root());
+            }
+
+            void merge(const BlobSchema& other) {
+                root_.merge(other.root_);
+            }
+
+            const BlobSchemaNode& root() const { return root_; }
+
+            /**
+             * Exports the schema as a JSON Schema document.  Blob specific details that JSON Schema has no
+             * keyword for are added as extensions: "x-pb-type" (the Blob data types), "x-pb-encoding" (the
+             * array encodings), "x-null-count" and "x-distinct" (the estimated distinct values).
+             */
+            Blob to_json_schema() const {
+                BlobBuilder builder;
+                builder.begin_object();
+                builder.key("$schema");
+                builder.add_string("https://json-schema.org/draft/2020-12/schema");
+                write_node(builder, root_);
+                builder.end_object();
+                return builder.build();
+            }
+
+            std::string to_json() const {
+                return write_json(to_json_schema());
+            }
+
+        private:
+            static void add(BlobSchemaNode& node, const BlobView& value) {
+                switch (value.type()) {
+                    case NULL_VALUE:
+                        node.observe_null();
+                        break;
+                    case BOOLEAN:
+                        node.observe_bool(value.as_bool());
+                        break;
+                    case INTEGER:
+                        node.observe_int(value.as_int());
+                        break;
+                    case UNSIGNED_INTEGER:
+                        node.observe_uint(value.as_uint());
+                        break;
+                    case FLOAT:
+                        node.observe_double(value.as_double());
+                        break;
+                    case DATE:
+                        node.observe_date(value.as_date());
+                        break;
+                    case STRING:
+                        node.observe_string(value.as_string());
+                        break;
+                    case BINARY:
+                        node.observe_binary(value.as_binary());
+                        break;
+                    case OBJECT:
+                        node.types |= 1u << OBJECT;
+                        ++node.count;
+                        ++node.object_count;
+                        value.for_each_member([&](std::string_view key, const BlobView& member) {
+                            add(node.child(key), member);
+                        });
+                        break;
+                    case ARRAY:
+                        add_array(node, value);
+                        break;
+                }
+            }
+
+            static void add_array(BlobSchemaNode& node, const BlobView& array) {
+                node.types |= 1u << ARRAY;
+                ++node.count;
+                node.observe_items(array.size());
+                if (array.is_columnar()) {
+                    node.encodings |= 1u << BLOB_ENCODING_COLUMNAR;
+                    add_columns(node.item(), array);
+                } else if (array.is_delta()) {
+                    node.encodings |= 1u << BLOB_ENCODING_DELTA;
+                    add_integers(node.item(), array);
+                } else {
+                    node.encodings |= 1u << BLOB_ENCODING_DEFAULT;
+                    array.for_each_element([&](const BlobView& element) { add(node.item(), element); });
+                }
+            }
+
+            // Rows of a columnar ARRAY all have the same keys, so each column is summarized in one scan
+            static void add_columns(BlobSchemaNode& node, const BlobView& array) {
+                size_t rows = array.size();
+                if (rows == 0) {
+                    return;
+                }
+                node.types |= 1u << OBJECT;
+                node.count += rows;
+                node.object_count += rows;
+                for (size_t c = 0; c < array.column_count(); ++c) {
+                    BlobColumn column = array.column(c);
+                    BlobSchemaNode& field = node.child(column.name());
+                    const uint8_t* values = column.value_data();
+                    for (size_t row = 0; row < rows; ++row) {
+                        if (!column.is_valid(row)) {
+                            field.observe_null();
+                            continue;
+                        }
+                        switch (column.type()) {
+                            case BOOLEAN:
+                                field.observe_bool(column.bool_at(row));
+                                break;
+                            case INTEGER:
+                                field.observe_int(detail::blob_load<int64_t>(values + 8 * row));
+                                break;
+                            case UNSIGNED_INTEGER:
+                                field.observe_uint(detail::blob_load<uint64_t>(values + 8 * row));
+                                break;
+                            case FLOAT:
+                                field.observe_double(detail::blob_load<double>(values + 8 * row));
+                                break;
+                            case DATE:
+                                field.observe_date(detail::blob_load<int64_t>(values + 8 * row));
+                                break;
+                            case STRING:
+                                field.observe_string(column.string_at(row));
+                                break;
+                            case BINARY: {
+                                std::string_view bytes = column.string_at(row);
+                                field.observe_binary(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()));
+                                break;
+                            }
+                            default:
+                                field.observe_null();
+                                break;
+                        }
+                    }
+                }
+            }
+
+            static void add_integers(BlobSchemaNode& node, const BlobView& array) {
+                auto type = static_cast<BlobElementDataType>(array.data()[detail::BLOB_CONTAINER_HEADER_SIZE]);
+                std::vector<int64_t> values;
+                array.decode_integers(values);
+                for (int64_t value : values) {
+                    switch (type) {
+                        case UNSIGNED_INTEGER:
+                            node.observe_uint(static_cast<uint64_t>(value));
+                            break;
+                        case DATE:
+                            node.observe_date(value);
+                            break;
+                        default:
+                            node.observe_int(value);
+                            break;
+                    }
+                }
+            }
+
+            static void write_names(BlobBuilder& builder, const std::vector<const char*>& names) {
+                if (names.size() == 1) {
+                    builder.add_string(names[0]);
+                    return;
+                }
+                builder.begin_array();
+                for (const char* name : names) {
+                    builder.add_string(name);
+                }
+                builder.end_array();
+            }
+
+            static void write_node(BlobBuilder& builder, const BlobSchemaNode& node) {
+                if (node.types == 0) {
+                    return;     // Nothing seen, any value is allowed
+                }
+
+                // JSON Schema types, "number" already covers integers
+                bool number = node.has(FLOAT);
+                bool integer = !number && (node.has(INTEGER) || node.has(UNSIGNED_INTEGER));
+                bool string = node.has(STRING) || node.has(DATE) || node.has(BINARY);
+                std::vector<const char*> types;
+                if (node.has(NULL_VALUE)) types.push_back("null");
+                if (node.has(BOOLEAN)) types.push_back("boolean");
+                if (node.has(OBJECT)) types.push_back("object");
+                if (node.has(ARRAY)) types.push_back("array");
+                if (string) types.push_back("string");
+                if (integer) types.push_back("integer");
+                if (number) types.push_back("number");
+                builder.key("type");
+                write_names(builder, types);
+
+                std::vector<const char*> pb_types;
+                for (int type = NULL_VALUE; type <= BINARY; ++type) {
+                    if (node.has(static_cast<BlobElementDataType>(type))) {
+                        pb_types.push_back(detail::schema_type_name(static_cast<BlobElementDataType>(type)));
+                    }
+                }
+                builder.key("x-pb-type");
+                write_names(builder, pb_types);
+
+                uint32_t strings = node.types & ((1u << STRING) | (1u << DATE) | (1u << BINARY));
+                if (strings == 1u << DATE) {
+                    builder.key("format");
+                    builder.add_string("date-time");
+                    builder.key("formatMinimum");
+                    builder.add_date(node.date_min);
+                    builder.key("formatMaximum");
+                    builder.add_date(node.date_max);
+                } else if (strings == 1u << BINARY) {
+                    builder.key("contentEncoding");
+                    builder.add_string("base64");
+                }
+                if (strings == 1u << STRING) {
+                    builder.key("minLength");
+                    builder.add_uint(node.length_min);
+                    builder.key("maxLength");
+                    builder.add_uint(node.length_max);
+                }
+                write_range(builder, node, number, integer);
+
+                if (node.has(NULL_VALUE)) {
+                    builder.key("x-null-count");
+                    builder.add_uint(node.null_count);
+                }
+                uint64_t distinct = node.distinct();
+                if (distinct > 0) {
+                    builder.key("x-distinct");
+                    builder.add_uint(distinct);
+                }
+
+                if (node.has(OBJECT)) {
+                    builder.key("properties");
+                    builder.begin_object();
+                    for (const auto& [key, child] : node.properties) {
+                        builder.key(key);
+                        builder.begin_object();
+                        write_node(builder, *child);
+                        builder.end_object();
+                    }
+                    builder.end_object();
+                    builder.key("required");
+                    builder.begin_array();
+                    for (const auto& [key, child] : node.properties) {
+                        if (child->count == node.object_count) {
+                            builder.add_string(key);
+                        }
+                    }
+                    builder.end_array();
+                }
+
+                if (node.has(ARRAY)) {
+                    builder.key("minItems");
+                    builder.add_uint(node.items_min);
+                    builder.key("maxItems");
+                    builder.add_uint(node.items_max);
+                    std::vector<const char*> encodings;
+                    if (node.encodings & (1u << BLOB_ENCODING_DEFAULT)) encodings.push_back("default");
+                    if (node.encodings & (1u << BLOB_ENCODING_COLUMNAR)) encodings.push_back("columnar");
+                    if (node.encodings & (1u << BLOB_ENCODING_DELTA)) encodings.push_back("delta");
+                    builder.key("x-pb-encoding");
+                    write_names(builder, encodings);
+                    if (node.items) {
+                        builder.key("items");
+                        builder.begin_object();
+                        write_node(builder, *node.items);
+                        builder.end_object();
+                    }
+                }
+            }
+
+            // minimum and maximum over every numeric type seen, exact while only integers were seen
+            static void write_range(BlobBuilder& builder, const BlobSchemaNode& node, bool number, bool integer) {
+                if (number) {
+                    double low = node.double_min;
+                    double high = node.double_max;
+                    if (node.has(INTEGER)) {
+                        low = std::min(low, static_cast<double>(node.int_min));
+                        high = std::max(high, static_cast<double>(node.int_max));
+                    }
+                    if (node.has(UNSIGNED_INTEGER)) {
+                        low = std::min(low, static_cast<double>(node.uint_min));
+                        high = std::max(high, static_cast<double>(node.uint_max));
+                    }
+                    if (low <= high) {
+                        builder.key("minimum");
+                        builder.add_double(low);
+                        builder.key("maximum");
+                        builder.add_double(high);
+                    }
+                } else if (integer && !node.has(UNSIGNED_INTEGER)) {
+                    builder.key("minimum");
+                    builder.add_int(node.int_min);
+                    builder.key("maximum");
+                    builder.add_int(node.int_max);
+                } else if (integer && !node.has(INTEGER)) {
+                    builder.key("minimum");
+                    builder.add_uint(node.uint_min);
+                    builder.key("maximum");
+                    builder.add_uint(node.uint_max);
+                } else if (integer) {
+                    builder.key("minimum");
+                    if (node.int_min < 0) {
+                        builder.add_int(node.int_min);
+                    } else {
+                        builder.add_uint(std::min(static_cast<uint64_t>(node.int_min), node.uint_min));
+                    }
+                    builder.key("maximum");
+                    if (node.int_max < 0 || static_cast<uint64_t>(node.int_max) < node.uint_max) {
+                        builder.add_uint(node.uint_max);
+                    } else {
+                        builder.add_int(node.int_max);
+                    }
+                }
+            }
+
+            BlobSchemaNode root_;
+    };
+
+    // Metadata key under which the JSON Schema of a Blob is stored
+    inline constexpr std::string_view BLOB_SCHEMA_METADATA_KEY = "schema";
+
+    /**
+     * Infers the schema of blob and stores it as JSON Schema text in its metadata.
+     */
+    inline void store_schema(Blob& blob) {
+        BlobSchema schema;
+        schema.add(blob);
+        blob.set_metadata(std::string(BLOB_SCHEMA_METADATA_KEY), schema.to_json());
+    }
+
+    inline void store_schema(Blob& blob, const BlobSchema& schema) {
+        blob.set_metadata(std::string(BLOB_SCHEMA_METADATA_KEY), schema.to_json());
+    }
+
+} // namespace pb
@@ -0,0 +1,30 @@
+/**
+ * CBOR (RFC 8949) reader and writer for Blob.
+ * Major types map directly onto BlobElementDataType, byte and text strings are copied in bulk and the
+ * epoch time tag (1) maps onto DATE.  CBOR has no separate signedness, so non negative integers read
+ * back as INTEGER unless they only fit in an UNSIGNED_INTEGER.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <pb/blob.h>
+
+
+namespace pb {
+
+    /**
+     * Parses a single CBOR data item into a Blob.  Throws std::runtime_error on malformed input and
+     * non text map keys.
+     */
+    Blob read_cbor(std::span<const uint8_t> data);
+
+    std::vector<uint8_t> write_cbor(const BlobView& value);
+
+    std::vector<uint8_t> write_cbor(const Blob& blob);
+
+} // namespace pb
@@ -0,0 +1,88 @@
+/**
+ * Compressing sinks and decompressing sources over any BlobBlockCodec.
+ * The stream is the data cut into fixed size blocks, each compressed on its own like the blocks of a
+ * Blob archive, so the LZ4 codec or an application provided one (zstd, ...) applies to any reader or
+ * writer.  Layout, little endian:
+ *   u32 magic "PBCS", u16 version, u16 codec id, u32 block size
+ *   per block: u32 raw size, u32 stored size, stored bytes (raw when the stored size is the raw size)
+ *   u32 0 after the last block
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/blob_archive.h>
+#include <pb/io.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr uint32_t COMPRESSED_STREAM_MAGIC = 0x53434250;     // "PBCS"
+        constexpr uint16_t COMPRESSED_STREAM_VERSION = 1;
+        constexpr size_t COMPRESSED_STREAM_HEADER_SIZE = 12;
+
+    } // namespace detail
+
+    constexpr size_t COMPRESSED_STREAM_DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    /**
+     * CompressingSink: compresses what is written to it into sink, one block at a time.  finish() writes
+     * the last block and the end marker; the destructor calls it if it was not called, ignoring errors.
+     */
+    class CompressingSink : public Sink {
+        public:
+            CompressingSink(Sink& sink, BlobBlockCodec& codec, size_t block_size = COMPRESSED_STREAM_DEFAULT_BLOCK_SIZE);
+            virtual ~CompressingSink();
+
+            virtual void write(std::string_view data) override;
+
+            // Compresses what is pending as a short block and flushes sink
+            virtual void flush() override;
+
+            void finish();
+
+        private:
+            void write_block();
+
+            Sink& sink_;
+            BlobBlockCodec& codec_;
+            size_t block_size_;
+            std::string pending_;
+            std::vector<uint8_t> compressed_;
+            bool finished_ = false;
+    };
+
+    /**
+     * DecompressingSource: reads a stream written by CompressingSink from source, returning one
+     * decompressed block per next().  codec must have the id the stream was written with.  Throws
+     * std::runtime_error on a corrupt or truncated stream.
+     */
+    class DecompressingSource : public Source {
+        public:
+            DecompressingSource(Source& source, BlobBlockCodec& codec);
+
+            virtual std::string_view next() override;
+
+        private:
+            // Exactly size bytes of the source: borrowed when they lie within its current buffer
+            std::string_view read(size_t size);
+            uint32_t read_u32();
+
+            Source& source_;
+            BlobBlockCodec& codec_;
+            size_t block_size_ = 0;
+            std::string_view buffer_;       // Unread part of the source's current buffer
+            std::string gathered_;
+            std::vector<uint8_t> block_;
+            bool ended_ = false;
+    };
+
+} // namespace pb
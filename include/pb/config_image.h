@@ -0,0 +1,571 @@
+/**
+ * Compiled configuration images.
+ * A .properties or JSON file is compiled once into a binary image: a minimal perfect hash table over
+ * fixed size records, a string pool, and every value pre-typed as a Blob scalar type.  Workers map the
+ * image and look keys up with one hash, one seed load and one key compare, without parsing anything.
+ * The image carries a checksum of its source, so a stale image can be detected, and one of its own
+ * bytes.
+ *
+ *     pb::compile_config_file("service.properties", "service.pbci");     // at build or deploy time
+ *     pb::ConfigImage config("service.pbci");                             // in every worker
+ *     int port = config.get<int>("http.port");
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/blob_compare.h>
+#include <pb/json.h>
+#include <pb/mapped_file.h>
+#include <pb/properties.h>
+#include <pb/string_util.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr uint32_t CONFIG_IMAGE_MAGIC = 0x49434250;     // "PBCI"
+        constexpr uint16_t CONFIG_IMAGE_VERSION = 1;
+        constexpr size_t CONFIG_IMAGE_HEADER_SIZE = 48;
+        constexpr size_t CONFIG_IMAGE_RECORD_SIZE = 32;
+        constexpr uint64_t CONFIG_IMAGE_SEED = 0x5eed5eed0c0ff1ceull;
+        constexpr uint32_t CONFIG_IMAGE_DIRECT = 0x80000000u;  // Seed word flag: the low bits are the slot
+
+        inline uint64_t config_key_hash(std::string_view key) {
+            return blob_hash_bytes(key.data(), key.size(), CONFIG_IMAGE_SEED);
+        }
+
+        // Slot of a key hash in a table of count records for a bucket seed
+        inline size_t config_slot(uint64_t hash, uint32_t seed, size_t count) {
+            if (seed & CONFIG_IMAGE_DIRECT) {
+                return seed & ~CONFIG_IMAGE_DIRECT;
+            }
+            return static_cast<size_t>(blob_hash_word(hash, seed) % count);
+        }
+
+        inline size_t config_bucket(uint64_t hash, size_t buckets) {
+            return static_cast<size_t>(hash % buckets);
+        }
+
+        struct ConfigItem {
+            std::string key;
+            std::string text;
+            BlobElementDataType type;
+            uint64_t value;
+        };
+
+        // Infers the type of a .properties value, as it would be read back with get<T>
+        inline ConfigItem config_typed_item(std::string_view key, std::string_view text) {
+            ConfigItem item{ std::string(key), std::string(text), STRING, 0 };
+            std::string_view trimmed = trim_view(text);
+            if (std::optional<int64_t> integer = parse_integer(trimmed)) {
+                item.type = INTEGER;
+                item.value = static_cast<uint64_t>(*integer);
+            } else if (std::optional<double> number = parse_double(trimmed)) {
+                item.type = FLOAT;
+                item.value = std::bit_cast<uint64_t>(*number);
+            } else if (std::optional<bool> boolean = parse_boolean(trimmed)) {
+                item.type = BOOLEAN;
+                item.value = *boolean ? 1 : 0;
+            } else if (std::optional<int64_t> date = parse_iso_date(trimmed)) {
+                item.type = DATE;
+                item.value = static_cast<uint64_t>(*date);
+            }
+            return item;
+        }
+
+        // Flattens nested OBJECTs and ARRAYs into dotted keys: {"http": {"ports": [80]}} gives http.ports.0
+        inline void config_flatten(const BlobView& value, std::string& path, std::vector<ConfigItem>& items) {
+            size_t length = path.size();
+            auto child = [&](std::string_view name) {
+                if (length > 0) {
+                    path.push_back('.');
+                }
+                path += name;
+            };
+            ConfigItem item{ path, std::string(), value.type(), 0 };
+            switch (value.type()) {
+                case OBJECT:
+                    value.for_each_member([&](std::string_view key, const BlobView& member) {
+                        child(key);
+                        config_flatten(member, path, items);
+                        path.resize(length);
+                    });
+                    return;
+                case ARRAY: {
+                    size_t index = 0;
+                    value.for_each_element([&](const BlobView& element) {
+                        child(std::to_string(index++));
+                        config_flatten(element, path, items);
+                        path.resize(length);
+                    });
+                    return;
+                }
+                case NULL_VALUE:
+                    break;
+                case BOOLEAN:
+                    item.value = value.as_bool() ? 1 : 0;
+                    item.text = value.as_bool() ? "true" : "false";
+                    break;
+                case INTEGER:
+                    item.value = static_cast<uint64_t>(value.as_int());
+                    item.text = std::to_string(value.as_int());
+                    break;
+                case UNSIGNED_INTEGER:
+                    item.value = value.as_uint();
+                    item.text = std::to_string(value.as_uint());
+                    break;
+                case FLOAT: {
+                    item.value = std::bit_cast<uint64_t>(value.as_double());
+                    char buffer[32];
+                    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.as_double());
+                    item.text.assign(buffer, result.ptr);
+                    break;
+                }
+                case DATE:
+                    item.value = static_cast<uint64_t>(value.as_date());
+                    json_append_date(item.text, value.as_date());
+                    break;
+                case STRING:
+                    item.text = std::string(value.as_string());
+                    break;
+                case BINARY:
+                    json_append_base64(item.text, value.as_binary());
+                    break;
+            }
+            items.push_back(std::move(item));
+        }
+
+        /**
+         * Lays out items as an image.  Layout, little endian:
+         *   u32 magic, u16 version, u16 reserved, u32 count, u32 bucket count, u64 source checksum,
+         *   u64 image checksum (of every byte after the header), u64 image size, u32 records offset,
+         *   u32 pool offset
+         *   u32 seed per bucket
+         *   records, one per slot: u32 key offset, u32 key length, u32 text offset, u32 text length,
+         *   u8 Blob type, 7 bytes padding, u64 value (INTEGER, UNSIGNED_INTEGER, FLOAT bits, BOOLEAN, DATE)
+         *   string pool
+         * The hash is CHD style: keys go to buckets by hash, buckets are placed largest first by searching
+         * a seed that sends all their keys to free slots, and single key buckets take a free slot directly.
+         */
+        inline std::vector<uint8_t> config_write_image(std::vector<ConfigItem>& items, uint64_t source_checksum) {
+            // Later definitions of a key win, at the position of the first
+            std::unordered_map<std::string, size_t> positions;
+            size_t kept = 0;
+            for (size_t i = 0; i < items.size(); ++i) {
+                auto [position, inserted] = positions.emplace(items[i].key, kept);
+                if (inserted) {
+                    if (kept != i) {
+                        items[kept] = std::move(items[i]);
+                    }
+                    ++kept;
+                } else {
+                    items[position->second] = std::move(items[i]);
+                }
+            }
+            items.resize(kept);
+
+            size_t count = items.size();
+            size_t buckets = std::max<size_t>(count, 1);
+            std::vector<uint64_t> hashes(count);
+            std::vector<std::vector<uint32_t>> members(buckets);
+            for (size_t i = 0; i < count; ++i) {
+                hashes[i] = config_key_hash(items[i].key);
+                members[config_bucket(hashes[i], buckets)].push_back(static_cast<uint32_t>(i));
+            }
+            std::vector<uint32_t> order(buckets);
+            for (size_t b = 0; b < buckets; ++b) {
+                order[b] = static_cast<uint32_t>(b);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return members[a].size() > members[b].size();
+            });
+
+            std::vector<uint32_t> seeds(buckets, 0);
+            std::vector<uint32_t> slots(count, UINT32_MAX);     // Item of each slot
+            std::vector<size_t> taken;
+            size_t next_free = 0;
+            for (uint32_t bucket : order) {
+                const std::vector<uint32_t>& keys = members[bucket];
+                if (keys.empty()) {
+                    break;
+                }
+                if (keys.size() == 1) {
+                    while (slots[next_free] != UINT32_MAX) {
+                        ++next_free;
+                    }
+                    seeds[bucket] = CONFIG_IMAGE_DIRECT | static_cast<uint32_t>(next_free);
+                    slots[next_free] = keys[0];
+                    continue;
+                }
+                for (uint32_t seed = 1;; ++seed) {
+                    if (seed == CONFIG_IMAGE_DIRECT) {
+                        throw std::runtime_error("Cannot build a perfect hash for the configuration");
+                    }
+                    taken.clear();
+                    bool placed = true;
+                    for (uint32_t key : keys) {
+                        size_t slot = config_slot(hashes[key], seed, count);
+                        if (slots[slot] != UINT32_MAX || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                            placed = false;
+                            break;
+                        }
+                        taken.push_back(slot);
+                    }
+                    if (placed) {
+                        seeds[bucket] = seed;
+                        for (size_t k = 0; k < keys.size(); ++k) {
+                            slots[taken[k]] = keys[k];
+                        }
+                        break;
+                    }
+                }
+            }
+
+            size_t records = CONFIG_IMAGE_HEADER_SIZE + 4 * buckets;
+            records = (records + 7) & ~size_t(7);
+            size_t pool = records + CONFIG_IMAGE_RECORD_SIZE * count;
+            std::vector<uint8_t> out(pool);
+            blob_patch<uint32_t>(out, 0, CONFIG_IMAGE_MAGIC);
+            blob_patch<uint16_t>(out, 4, CONFIG_IMAGE_VERSION);
+            blob_patch<uint32_t>(out, 8, static_cast<uint32_t>(count));
+            blob_patch<uint32_t>(out, 12, static_cast<uint32_t>(buckets));
+            blob_patch<uint64_t>(out, 16, source_checksum);
+            for (size_t b = 0; b < buckets; ++b) {
+                blob_patch<uint32_t>(out, CONFIG_IMAGE_HEADER_SIZE + 4 * b, seeds[b]);
+            }
+            auto append = [&](std::string_view text) {
+                if (out.size() + text.size() > UINT32_MAX) {
+                    throw std::runtime_error("Configuration image exceeds 4 GiB");
+                }
+                uint32_t offset = static_cast<uint32_t>(out.size());
+                out.insert(out.end(), text.begin(), text.end());
+                return offset;
+            };
+            for (size_t slot = 0; slot < count; ++slot) {
+                const ConfigItem& item = items[slots[slot]];
+                uint32_t key = append(item.key);
+                uint32_t text = append(item.text);
+                size_t record = records + CONFIG_IMAGE_RECORD_SIZE * slot;
+                blob_patch<uint32_t>(out, record, key);
+                blob_patch<uint32_t>(out, record + 4, static_cast<uint32_t>(item.key.size()));
+                blob_patch<uint32_t>(out, record + 8, text);
+                blob_patch<uint32_t>(out, record + 12, static_cast<uint32_t>(item.text.size()));
+                out[record + 16] = static_cast<uint8_t>(item.type);
+                blob_patch<uint64_t>(out, record + 24, item.value);
+            }
+            blob_patch<uint64_t>(out, 32, out.size());
+            blob_patch<uint32_t>(out, 40, static_cast<uint32_t>(records));
+            blob_patch<uint32_t>(out, 44, static_cast<uint32_t>(pool));
+            blob_patch<uint64_t>(out, 24, blob_hash_bytes(out.data() + CONFIG_IMAGE_HEADER_SIZE,
+                                                          out.size() - CONFIG_IMAGE_HEADER_SIZE, CONFIG_IMAGE_SEED));
+            return out;
+        }
+
+    } // namespace detail
+
+    // Checksum of a configuration source, as recorded in the images compiled from it
+    inline uint64_t config_source_checksum(std::string_view source) {
+        return detail::blob_hash_bytes(source.data(), source.size(), detail::CONFIG_IMAGE_SEED);
+    }
+
+    /**
+     * Compiles .properties text into an image.  Values that parse as an integer, a real number, a
+     * boolean or an ISO 8601 date are stored with that type, anything else as a STRING.
+     */
+    inline std::vector<uint8_t> compile_properties_image(std::string_view text) {
+        Properties properties;
+        properties.parse(text);
+        std::vector<detail::ConfigItem> items;
+        items.reserve(properties.size());
+        for (const PropertiesEntry& entry : properties.entries()) {
+            items.push_back(detail::config_typed_item(entry.key, entry.value));
+        }
+        return detail::config_write_image(items, config_source_checksum(text));
+    }
+
+    /**
+     * Compiles a Blob into an image, nested members flattened into dotted keys and array elements into
+     * their index.  Scalars keep their Blob type; BINARY is stored as base64 text.
+     */
+    inline std::vector<uint8_t> compile_config_image(const BlobView& value, uint64_t source_checksum = 0) {
+        std::vector<detail::ConfigItem> items;
+        std::string path;
+        detail::config_flatten(value, path, items);
+        return detail::config_write_image(items, source_checksum);
+    }
+
+    inline std::vector<uint8_t> compile_json_image(std::string_view text) {
+        Blob blob = read_json(text);
+        return compile_config_image(blob.root(), config_source_checksum(text));
+    }
+
+    /**
+     * Compiles the file at source_path, JSON if its name ends in ".json" and .properties otherwise, and
+     * writes the image to image_path.  Throws std::runtime_error if either file cannot be accessed.
+     */
+    inline void compile_config_file(const std::string& source_path, const std::string& image_path) {
+        MappedFile source(source_path);
+        std::vector<uint8_t> image = std::string_view(source_path).ends_with(".json")
+            ? compile_json_image(source.view()) : compile_properties_image(source.view());
+        std::ofstream out(image_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!out) {
+            throw std::runtime_error("Cannot write file: " + image_path);
+        }
+    }
+
+    /**
+     * ConfigImage: read only access to a compiled image, mapped from a file or over caller owned bytes.
+     * Opening checks the header and bounds only; verify() checks the image checksum.  Lookups take no
+     * locks and do not allocate, except get<std::string>.  Throws std::runtime_error for a malformed
+     * image.
+     */
+    class ConfigImage {
+        public:
+            // Views image, which must outlive the ConfigImage
+            explicit ConfigImage(std::span<const uint8_t> image) {
+                open(image);
+            }
+
+            // Takes ownership of a compiled image
+            explicit ConfigImage(std::vector<uint8_t>&& image) : owned_(std::move(image)) {
+                open(owned_);
+            }
+
+            // Maps the image file at path
+            explicit ConfigImage(const std::string& path) : file_(path) {
+                open(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(file_.data()), file_.size()));
+            }
+
+            ConfigImage(const ConfigImage&) = delete;
+            ConfigImage& operator=(const ConfigImage&) = delete;
+            ConfigImage(ConfigImage&&) = default;
+            ConfigImage& operator=(ConfigImage&&) = default;
+
+            size_t size() const { return count_; }
+            bool empty() const { return count_ == 0; }
+
+            uint64_t source_checksum() const { return detail::blob_load<uint64_t>(image_.data() + 16); }
+
+            // True if the image was not compiled from source
+            bool is_stale(std::string_view source) const {
+                return source_checksum() != config_source_checksum(source);
+            }
+
+            // Recomputes the image checksum; false if the image is damaged
+            bool verify() const {
+                return detail::blob_load<uint64_t>(image_.data() + 24)
+                    == detail::blob_hash_bytes(image_.data() + detail::CONFIG_IMAGE_HEADER_SIZE,
+                                               image_.size() - detail::CONFIG_IMAGE_HEADER_SIZE, detail::CONFIG_IMAGE_SEED);
+            }
+
+            std::optional<std::string_view> get(std::string_view key) const {
+                const uint8_t* record = find(key);
+                if (record == nullptr) {
+                    return std::nullopt;
+                }
+                return text(record);
+            }
+
+            std::string_view get(std::string_view key, std::string_view fallback) const {
+                const uint8_t* record = find(key);
+                return record == nullptr ? fallback : text(record);
+            }
+
+            std::string_view at(std::string_view key) const {
+                const uint8_t* record = find(key);
+                if (record == nullptr) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                return text(record);
+            }
+
+            bool contains(std::string_view key) const {
+                return find(key) != nullptr;
+            }
+
+            // Type the value was compiled with
+            std::optional<BlobElementDataType> type(std::string_view key) const {
+                const uint8_t* record = find(key);
+                if (record == nullptr) {
+                    return std::nullopt;
+                }
+                return static_cast<BlobElementDataType>(record[16]);
+            }
+
+            /**
+             * The value of key as T, with the types of Properties::get<T>.  A value compiled with a
+             * matching type is returned without parsing, any other is parsed from its text.  Throws
+             * std::out_of_range if the key is missing and std::runtime_error if the value does not
+             * convert to T.
+             */
+            template <typename T>
+            T get(std::string_view key) const {
+                const uint8_t* record = find(key);
+                if (record == nullptr) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                std::optional<T> value = typed<T>(record);
+                if (!value) {
+                    throw std::runtime_error("Property has an invalid value for the requested type: " + std::string(key));
+                }
+                return *value;
+            }
+
+            template <typename T>
+            T get(std::string_view key, std::type_identity_t<T> fallback) const {
+                const uint8_t* record = find(key);
+                if (record == nullptr) {
+                    return fallback;
+                }
+                std::optional<T> value = typed<T>(record);
+                return value ? *value : fallback;
+            }
+
+            // Calls f(key, text) for every entry, in slot order
+            template <typename F>
+            void for_each(F&& f) const {
+                for (size_t slot = 0; slot < count_; ++slot) {
+                    const uint8_t* record = records_ + detail::CONFIG_IMAGE_RECORD_SIZE * slot;
+                    f(key(record), text(record));
+                }
+            }
+
+        private:
+            void open(std::span<const uint8_t> image) {
+                if (image.size() < detail::CONFIG_IMAGE_HEADER_SIZE
+                    || detail::blob_load<uint32_t>(image.data()) != detail::CONFIG_IMAGE_MAGIC) {
+                    throw std::runtime_error("Not a configuration image");
+                }
+                if (detail::blob_load<uint16_t>(image.data() + 4) != detail::CONFIG_IMAGE_VERSION) {
+                    throw std::runtime_error("Unsupported configuration image version");
+                }
+                count_ = detail::blob_load<uint32_t>(image.data() + 8);
+                buckets_ = detail::blob_load<uint32_t>(image.data() + 12);
+                size_t records = detail::blob_load<uint32_t>(image.data() + 40);
+                size_t pool = detail::blob_load<uint32_t>(image.data() + 44);
+                if (detail::blob_load<uint64_t>(image.data() + 32) != image.size() || buckets_ == 0
+                    || records < detail::CONFIG_IMAGE_HEADER_SIZE + 4 * buckets_
+                    || pool != records + detail::CONFIG_IMAGE_RECORD_SIZE * count_ || pool > image.size()) {
+                    throw std::runtime_error("Corrupt configuration image header");
+                }
+                image_ = image;
+                seeds_ = image.data() + detail::CONFIG_IMAGE_HEADER_SIZE;
+                records_ = image.data() + records;
+                for (size_t slot = 0; slot < count_; ++slot) {
+                    const uint8_t* record = records_ + detail::CONFIG_IMAGE_RECORD_SIZE * slot;
+                    uint64_t key_end = uint64_t(detail::blob_load<uint32_t>(record)) + detail::blob_load<uint32_t>(record + 4);
+                    uint64_t text_end = uint64_t(detail::blob_load<uint32_t>(record + 8)) + detail::blob_load<uint32_t>(record + 12);
+                    if (key_end > image.size() || text_end > image.size()) {
+                        throw std::runtime_error("Corrupt configuration image record");
+                    }
+                }
+            }
+
+            const uint8_t* find(std::string_view key) const {
+                if (count_ == 0) {
+                    return nullptr;
+                }
+                uint64_t hash = detail::config_key_hash(key);
+                uint32_t seed = detail::blob_load<uint32_t>(seeds_ + 4 * detail::config_bucket(hash, buckets_));
+                size_t slot = detail::config_slot(hash, seed, count_);
+                if (slot >= count_) {
+                    return nullptr;
+                }
+                const uint8_t* record = records_ + detail::CONFIG_IMAGE_RECORD_SIZE * slot;
+                return this->key(record) == key ? record : nullptr;
+            }
+
+            std::string_view key(const uint8_t* record) const {
+                return std::string_view(reinterpret_cast<const char*>(image_.data()) + detail::blob_load<uint32_t>(record),
+                                        detail::blob_load<uint32_t>(record + 4));
+            }
+
+            std::string_view text(const uint8_t* record) const {
+                return std::string_view(reinterpret_cast<const char*>(image_.data()) + detail::blob_load<uint32_t>(record + 8),
+                                        detail::blob_load<uint32_t>(record + 12));
+            }
+
+            template <typename T>
+            std::optional<T> typed(const uint8_t* record) const {
+                BlobElementDataType type = static_cast<BlobElementDataType>(record[16]);
+                uint64_t value = detail::blob_load<uint64_t>(record + 24);
+                int64_t integer = static_cast<int64_t>(value);
+                std::string_view source = text(record);
+                if constexpr (std::is_same_v<T, std::string_view>) {
+                    return source;
+                } else if constexpr (std::is_same_v<T, std::string>) {
+                    return std::string(source);
+                } else if constexpr (std::is_same_v<T, bool>) {
+                    if (type == BOOLEAN || (type == INTEGER && value <= 1)) {
+                        return value != 0;
+                    }
+                    return parse_boolean(source);
+                } else if constexpr (std::is_integral_v<T>) {
+                    if (type == INTEGER) {
+                        return std::in_range<T>(integer) ? std::optional<T>(static_cast<T>(integer)) : std::nullopt;
+                    }
+                    if (type == UNSIGNED_INTEGER) {
+                        return std::in_range<T>(value) ? std::optional<T>(static_cast<T>(value)) : std::nullopt;
+                    }
+                    std::optional<int64_t> parsed = parse_integer(source);
+                    return parsed && std::in_range<T>(*parsed) ? std::optional<T>(static_cast<T>(*parsed)) : std::nullopt;
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    switch (type) {
+                        case FLOAT: return static_cast<T>(std::bit_cast<double>(value));
+                        case INTEGER: return static_cast<T>(integer);
+                        case UNSIGNED_INTEGER: return static_cast<T>(value);
+                        default: break;
+                    }
+                    std::optional<double> parsed = parse_double(source);
+                    return parsed ? std::optional<T>(static_cast<T>(*parsed)) : std::nullopt;
+                } else if constexpr (detail::properties_is_duration<T>::value) {
+                    // A plain number is milliseconds, as in parse_duration
+                    if (type == INTEGER) {
+                        return std::chrono::duration_cast<T>(std::chrono::milliseconds(integer));
+                    }
+                    std::optional<std::chrono::nanoseconds> parsed = parse_duration(source);
+                    return parsed ? std::optional<T>(std::chrono::duration_cast<T>(*parsed)) : std::nullopt;
+                } else if constexpr (detail::properties_is_sys_time<T>::value) {
+                    std::optional<int64_t> milliseconds = type == DATE ? std::optional<int64_t>(integer) : parse_iso_date(source);
+                    if (!milliseconds) {
+                        return std::nullopt;
+                    }
+                    return std::chrono::time_point_cast<typename T::duration>(
+                        std::chrono::sys_time<std::chrono::milliseconds>(std::chrono::milliseconds(*milliseconds)));
+                } else {
+                    static_assert(std::is_same_v<T, bool>, "Unsupported configuration value type");
+                }
+            }
+
+            MappedFile file_;
+            std::vector<uint8_t> owned_;
+            std::span<const uint8_t> image_;
+            const uint8_t* seeds_ = nullptr;
+            const uint8_t* records_ = nullptr;
+            size_t count_ = 0;
+            size_t buckets_ = 0;
+    };
+
+} // namespace pb
@@ -0,0 +1,98 @@
+/**
+ * Runtime CPU feature detection and kernel dispatch.
+ * The CPU is probed once, on first use, and the best supported instruction set level is selected.  Each
+ * SIMD kernel exists once per level, compiled in the library with the matching target attributes, and
+ * callers bind the kernel of the active level through a function pointer.  The PB_CPU_LEVEL environment
+ * variable (scalar, sse2, sse4.2, avx2, avx512) caps the level, which is how tests exercise every path.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+namespace pb {
+
+    // Instruction set levels, each implying the ones below it
+    enum class CpuLevel : int {
+        SCALAR = 0,
+        SSE2 = 1,
+        SSE42 = 2,
+        AVX2 = 3,       // AVX2 with BMI1 and BMI2, Haswell and later
+        AVX512 = 4      // AVX-512 F and BW, Skylake-SP and later
+    };
+
+    struct CpuFeatures {
+        bool sse2 = false;
+        bool sse42 = false;
+        bool popcnt = false;
+        bool avx2 = false;
+        bool bmi1 = false;
+        bool bmi2 = false;
+        bool avx512f = false;
+        bool avx512bw = false;
+    };
+
+    // Features of the CPU, restricted to those the operating system saves the registers of
+    const CpuFeatures& cpu_features();
+
+    // Best level the CPU supports, ignoring PB_CPU_LEVEL
+    CpuLevel cpu_supported_level();
+
+    // Level kernels are bound at: the supported level, capped by PB_CPU_LEVEL or set_cpu_level
+    CpuLevel cpu_level();
+
+    // Caps the active level, for tests and benchmarks.  Returns the level applied, never above the supported one.
+    CpuLevel set_cpu_level(CpuLevel level);
+
+    std::string_view cpu_level_name(CpuLevel level);
+
+    // Parses a level name as accepted by PB_CPU_LEVEL, case insensitive
+    std::optional<CpuLevel> parse_cpu_level(std::string_view name);
+
+    namespace detail {
+
+        // Up to eight characters to search for, with a lookup table for the scalar paths
+        struct ScanSet {
+            uint8_t characters[8] = {};
+            size_t count = 0;
+            bool table[256] = {};
+        };
+
+        // Returns the first position in [p, end) holding a character of set, or end
+        using ScanKernel = const char* (*)(const ScanSet& set, const char* p, const char* end);
+
+        // The scan kernel of a level, falling back to the best level below it that was compiled in
+        ScanKernel scan_kernel(CpuLevel level);
+
+        /**
+         * Appends base plus the offset just past every '\n' of [p, end) that is outside quotes to
+         * line_ends.  Every quote character toggles in_quotes, which carries over between calls; a quote
+         * of 0 disables quoting.
+         */
+        using LineKernel = void (*)(const char* p, const char* end, char quote, bool& in_quotes, uint64_t base,
+                                    std::vector<uint64_t>& line_ends);
+
+        LineKernel line_kernel(CpuLevel level);
+
+        /**
+         * Unpacks count values of bits width (0 to 64) starting at value index first of packed.  Reads up
+         * to eight bytes past the last value, which the delta encoding pads for.
+         */
+        using UnpackKernel = void (*)(const uint8_t* packed, unsigned bits, size_t first, size_t count, uint64_t* out);
+
+        UnpackKernel unpack_kernel(CpuLevel level);
+
+        // Replaces values[i] with start plus the sum of step + values[j] for j <= i, wrapping modulo 2^64
+        using PrefixSumKernel = void (*)(uint64_t* values, size_t count, uint64_t start, uint64_t step);
+
+        PrefixSumKernel prefix_sum_kernel(CpuLevel level);
+
+    } // namespace detail
+
+} // namespace pb
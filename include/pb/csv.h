@@ -1,7 +1,17 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 
+#include <pb/delimited.h>
+#include <pb/io.h>
+
 namespace pb {
 
     enum CSVDelimiter {
@@ -9,14 +19,15 @@ namespace pb {
         COMMA,
         TAB
     };
-    
+
     enum CSVQuoteStyle {
         NONE,
         DOUBLE,
         SINGLE
     };
 
-    enum CSVDataType {
+    // Scoped so the names do not collide with BlobElementDataType
+    enum class CSVDataType {
         STRING,
         INTEGER,
         FLOAT,
@@ -26,7 +37,7 @@ namespace pb {
 
     class CSVColumn {
         public:
-            CSVColumn(const std::string& name, CSVDataType dataType = STRING)
+            CSVColumn(const std::string& name, CSVDataType dataType = CSVDataType::STRING)
                 : name_(name), dataType_(dataType) {}
 
             const std::string& get_name() const { return name_; }
@@ -39,7 +50,7 @@ namespace pb {
 
     class CSVProperties {
         public:
-            CSVProperties() : delimiter_(UNKNOWN) {}
+            CSVProperties() : delimiter_(UNKNOWN), quote_style_(DOUBLE) {}
 
             void add_column(const CSVColumn& column) {
                 columns_.push_back(column);
@@ -49,6 +60,15 @@ namespace pb {
                 delimiter_ = delimiter;
             }
 
+            void set_quote_style(CSVQuoteStyle quote_style) {
+                quote_style_ = quote_style;
+            }
+
+            // When set the first record holds the column names instead of data
+            void set_has_header(bool has_header) {
+                has_header_ = has_header;
+            }
+
             const std::vector<CSVColumn>& getColumns() const {
                 return columns_;
             }
@@ -57,28 +77,515 @@ namespace pb {
                 return delimiter_;
             }
 
+            CSVQuoteStyle get_quote_style() const {
+                return quote_style_;
+            }
+
+            bool get_has_header() const {
+                return has_header_;
+            }
+
         private:
             std::vector<CSVColumn> columns_;
             CSVDelimiter delimiter_;
+            CSVQuoteStyle quote_style_;
+            bool has_header_ = false;
 
     };
 
+    /**
+     * CSVColumnData: the values of one column stored contiguously, with rows + 1 offsets into the
+     * character buffer.  This is the layout of an Arrow utf8 array, so it can be exported as is.
+     */
+    class CSVColumnData {
+        public:
+            CSVColumnData() : offsets_(1, 0) {}
+
+            size_t size() const { return offsets_.size() - 1; }
+
+            std::string_view at(size_t row) const {
+                return std::string_view(chars_.data() + offsets_[row], offsets_[row + 1] - offsets_[row]);
+            }
+
+            void append(std::string_view value) {
+                if (chars_.size() + value.size() > static_cast<size_t>(INT32_MAX)) {
+                    throw std::runtime_error("CSV column exceeds maximum size");
+                }
+                chars_.insert(chars_.end(), value.begin(), value.end());
+                offsets_.push_back(static_cast<int32_t>(chars_.size()));
+            }
+
+            const std::vector<char>& chars() const { return chars_; }
+            const std::vector<int32_t>& offsets() const { return offsets_; }
+
+        private:
+            std::vector<char> chars_;
+            std::vector<int32_t> offsets_;
+    };
+
+    /**
+     * CSVDialect: the field delimiter, quote and escape characters of a CSV variant as compile time
+     * constants.  A quote of 0 disables quoting.  An escape equal to the quote means a quote is doubled
+     * inside a quoted field; any other escape character takes the character after it literally.  Records
+     * end at '\n', "\r\n" or '\r'.
+     */
+    template <char Delimiter, char Quote, char Escape = Quote>
+    struct CSVDialect {
+        static constexpr char delimiter = Delimiter;
+        static constexpr char quote = Quote;
+        static constexpr char escape = Escape;
+    };
+
+    using CSVDialectComma = CSVDialect<',', '"'>;          // RFC 4180
+    using CSVDialectTab = CSVDialect<'\t', 0>;             // Plain TSV
+    using CSVDialectQuotedTab = CSVDialect<'\t', '"'>;     // TSV as spreadsheets write it
+
+    /**
+     * CSVParser: tokenize_delimited (see pb/delimited.h) for one dialect.  With the separators known at
+     * compile time the tests on them fold into constants, a dialect without quotes loses the quote
+     * handling altogether, and the scanners are built once per call instead of once per quoted field.
+     * CSV::parse picks an instantiation from its properties and falls back to tokenize_delimited for
+     * the other combinations.
+     */
+    template <typename Dialect>
+    class CSVParser {
+        public:
+            /**
+             * Calls on_field(size_t column, std::string_view field) for every field and
+             * on_record(size_t fields) at the end of every record, exactly as tokenize_delimited does.
+             * Throws std::runtime_error on an unterminated quoted field.
+             */
+            template <typename Field, typename Record>
+            static void tokenize(std::string_view data, Field&& on_field, Record&& on_record) {
+                static constexpr char separators[] = { Dialect::delimiter, '\n', '\r' };
+                static constexpr char quotes[] = { Dialect::quote, Dialect::escape };
+                const DelimiterScanner scanner(std::string_view(separators, sizeof(separators)));
+                const DelimiterScanner quoted(std::string_view(quotes, Dialect::escape == Dialect::quote ? 1 : 2));
+                const char* const begin = data.data();
+                const char* const end = begin + data.size();
+
+                std::string scratch;
+                size_t column = 0;
+                size_t i = 0;
+                const size_t size = data.size();
+
+                while (i < size) {
+                    if (column == 0 && (data[i] == '\n' || data[i] == '\r')) {
+                        ++i;
+                        continue;
+                    }
+
+                    std::string_view field;
+                    if (Dialect::quote != 0 && data[i] == Dialect::quote) {
+                        scratch.clear();
+                        i = read_quoted(data, i + 1, quoted, scratch);
+                        const char* stop = scanner.find(begin + i, end);
+                        scratch.append(begin + i, stop);
+                        i = static_cast<size_t>(stop - begin);
+                        field = scratch;
+                    } else {
+                        size_t start = i;
+                        i = static_cast<size_t>(scanner.find(begin + i, end) - begin);
+                        field = data.substr(start, i - start);
+                    }
+
+                    on_field(column, field);
+                    ++column;
+
+                    if (i < size && data[i] == Dialect::delimiter) {
+                        ++i;
+                        if (i == size) {
+                            on_field(column, std::string_view());
+                            ++column;
+                        } else {
+                            continue;
+                        }
+                    }
+                    if (i < size && data[i] == '\r') {
+                        ++i;
+                    }
+                    if (i < size && data[i] == '\n') {
+                        ++i;
+                    }
+                    on_record(column);
+                    column = 0;
+                }
+            }
+
+        private:
+            // Reads the quoted text starting at i, after the opening quote, into out; returns the position after the closing quote
+            static size_t read_quoted(std::string_view data, size_t i, const DelimiterScanner& quoted, std::string& out) {
+                const char* begin = data.data();
+                const char* end = begin + data.size();
+                while (true) {
+                    const char* found = quoted.find(begin + i, end);
+                    out.append(begin + i, found);
+                    if (found == end) {
+                        throw std::runtime_error("Unterminated quoted field");
+                    }
+                    i = static_cast<size_t>(found - begin) + 1;
+                    if constexpr (Dialect::escape == Dialect::quote) {
+                        if (i < data.size() && data[i] == Dialect::quote) {
+                            out.push_back(Dialect::quote);
+                            ++i;
+                            continue;
+                        }
+                    } else {
+                        if (*found == Dialect::escape) {
+                            if (i == data.size()) {
+                                throw std::runtime_error("Unterminated quoted field");
+                            }
+                            out.push_back(data[i]);
+                            ++i;
+                            continue;
+                        }
+                    }
+                    return i;
+                }
+            }
+    };
+
     class CSV {
         public:
             // Constructor
             CSV() = default;
 
-            // Method to parse CSV data
-            void parse(const std::string& data);
+            explicit CSV(const CSVProperties& properties) : properties_(properties) {}
+
+            /**
+             * Parses RFC 4180 style data into columns.  An UNKNOWN delimiter is detected from the first
+             * line and stored back into the properties.  Rows with fewer fields are padded with empty
+             * values, rows with more fields add columns.  Throws std::runtime_error on an unterminated
+             * quoted field.
+             */
+            void parse(std::string_view data) {
+                columns_.clear();
+                header_columns_.clear();
+                rows_ = 0;
+                data_.clear();
+                data_current_ = false;
+
+                bool header = properties_.get_has_header();
+                std::vector<std::string> names;
+                tokenize(data,
+                    [&](size_t column, std::string_view field) {
+                        if (header) {
+                            names.emplace_back(field);
+                        } else {
+                            append_field(column, field);
+                        }
+                    },
+                    [&](size_t fields) {
+                        if (header) {
+                            set_header(names);
+                            header = false;
+                        } else {
+                            end_row(fields);
+                        }
+                    });
+            }
+
+            // Parses the rest of source, without a copy when it is in memory
+            void parse(Source& source) {
+                std::string storage;
+                parse(read_all(source, storage));
+            }
+
+            /**
+             * Parses data and reports it to visitor (see pb/visitor.h) as an ARRAY with one element per
+             * record, without storing any columns.  When the columns are named, by the header or the
+             * properties, records are OBJECTs keyed by column name with missing trailing fields reported as
+             * null, otherwise they are ARRAYs of strings.  Fields of INTEGER, FLOAT and BOOLEAN columns are
+             * converted, an empty field being null; DATE columns are reported as strings.  Throws
+             * std::runtime_error on an unterminated quoted field or a field that does not convert.
+             */
+            template <typename Visitor>
+            void parse(std::string_view data, Visitor& visitor) {
+                header_columns_.clear();
+                bool header = properties_.get_has_header();
+                std::vector<std::string> names;
+                visitor.on_array_begin();
+                tokenize(data,
+                    [&](size_t column, std::string_view field) {
+                        if (header) {
+                            names.emplace_back(field);
+                            return;
+                        }
+                        const std::vector<CSVColumn>& columns = get_columns();
+                        if (column == 0) {
+                            if (columns.empty()) {
+                                visitor.on_array_begin();
+                            } else {
+                                visitor.on_object_begin();
+                            }
+                        }
+                        if (columns.empty()) {
+                            visitor.on_string(field);
+                            return;
+                        }
+                        visitor.on_key(column < columns.size() ? std::string_view(columns[column].get_name())
+                                                               : std::string_view(std::to_string(column)));
+                        visit_field(visitor, column < columns.size() ? columns[column].get_data_type() : CSVDataType::STRING, field);
+                    },
+                    [&](size_t fields) {
+                        if (header) {
+                            set_header(names);
+                            header = false;
+                            return;
+                        }
+                        const std::vector<CSVColumn>& columns = get_columns();
+                        if (columns.empty()) {
+                            visitor.on_array_end();
+                            return;
+                        }
+                        for (size_t c = fields; c < columns.size(); ++c) {
+                            visitor.on_key(columns[c].get_name());
+                            visitor.on_null();
+                        }
+                        visitor.on_object_end();
+                    });
+                visitor.on_array_end();
+            }
+
+            template <typename Visitor>
+            void parse(Source& source, Visitor& visitor) {
+                std::string storage;
+                parse(read_all(source, storage), visitor);
+            }
+
+            /**
+             * Counts the records of data without tokenizing it: only the newlines outside quotes are
+             * located, by the SIMD line kernel (see LineIndexer in pb/delimited.h), so this runs at close
+             * to memory speed on a mapped file.  Blank lines and the header, when the properties have one,
+             * are not counted, which makes it get_row_count() after parse for well formed data.  '\r'
+             * alone does not end a record here.
+             */
+            size_t count_rows(std::string_view data) const {
+                SpanSource source(data);
+                return count_rows(source);
+            }
+
+            // Counts the records of the rest of source a piece at a time, without gathering it
+            size_t count_rows(Source& source) const {
+                size_t records = 0;
+                index_records(source, [&](uint64_t) { ++records; });
+                return records > 0 && properties_.get_has_header() ? records - 1 : records;
+            }
+
+            /**
+             * The byte offset of the start of every record of data, the header included, from the same
+             * scan as count_rows.  Record i spans [offsets[i], offsets[i + 1]) and the last one runs to the
+             * end, so ranges of records can be parsed separately, in parallel for example, and the index
+             * reused by every later pass over the same data.
+             */
+            std::vector<uint64_t> index_lines(std::string_view data) const {
+                SpanSource source(data);
+                return index_lines(source);
+            }
+
+            std::vector<uint64_t> index_lines(Source& source) const {
+                std::vector<uint64_t> offsets;
+                index_records(source, [&](uint64_t offset) { offsets.push_back(offset); });
+                return offsets;
+            }
 
             // Method to get parsed data
-            const std::vector<std::vector<std::string>>& getData() const;
+            const std::vector<std::vector<std::string>>& getData() const {
+                if (!data_current_) {
+                    data_.assign(rows_, std::vector<std::string>(columns_.size()));
+                    for (size_t c = 0; c < columns_.size(); ++c) {
+                        for (size_t r = 0; r < rows_; ++r) {
+                            data_[r][c] = std::string(columns_[c]->at(r));
+                        }
+                    }
+                    data_current_ = true;
+                }
+                return data_;
+            }
+
+            // Columnar result, shared so exported buffers can outlive the next parse
+            const std::vector<std::shared_ptr<CSVColumnData>>& get_column_data() const {
+                return columns_;
+            }
+
+            /**
+             * The columns of the properties or, when those name none, the ones read from the header by the
+             * last parse.  The header's columns are not stored in the properties, so each parse names its
+             * columns from its own header.
+             */
+            const std::vector<CSVColumn>& get_columns() const {
+                return properties_.getColumns().empty() ? header_columns_ : properties_.getColumns();
+            }
+
+            // Name of a column from get_columns(), or its index when it is not named
+            std::string get_column_name(size_t column) const {
+                const std::vector<CSVColumn>& columns = get_columns();
+                return column < columns.size() ? columns[column].get_name() : std::to_string(column);
+            }
+
+            size_t get_row_count() const {
+                return rows_;
+            }
+
+            const CSVProperties& get_properties() const {
+                return properties_;
+            }
 
         private:
-            std::vector<std::vector<std::string>> data_;
+            /**
+             * Splits RFC 4180 style data into fields.  Calls on_field(size_t column, std::string_view field)
+             * for every field and on_record(size_t fields) at the end of every record.  The field is only
+             * valid during the call.
+             */
+            template <typename Field, typename Record>
+            void tokenize(std::string_view data, Field&& on_field, Record&& on_record) {
+                if (properties_.get_delimiter() == UNKNOWN) {
+                    properties_.set_delimiter(detect_delimiter(data));
+                }
+                CSVDelimiter delimiter = properties_.get_delimiter();
+                CSVQuoteStyle quote_style = properties_.get_quote_style();
+                if (delimiter == COMMA && quote_style == DOUBLE) {
+                    CSVParser<CSVDialectComma>::tokenize(data, on_field, on_record);
+                    return;
+                }
+                if (delimiter == TAB && quote_style == NONE) {
+                    CSVParser<CSVDialectTab>::tokenize(data, on_field, on_record);
+                    return;
+                }
+                if (delimiter == TAB && quote_style == DOUBLE) {
+                    CSVParser<CSVDialectQuotedTab>::tokenize(data, on_field, on_record);
+                    return;
+                }
+                DelimitedFormat format;
+                format.field = properties_.get_delimiter() == TAB ? '\t' : ',';
+                format.quote = quote_char(properties_.get_quote_style());
+                tokenize_delimited(data, format, on_field, on_record);
+            }
+
+            // Header names become the columns of this parse unless the properties already define them
+            void set_header(const std::vector<std::string>& names) {
+                if (properties_.getColumns().empty()) {
+                    for (const std::string& name : names) {
+                        header_columns_.emplace_back(name);
+                    }
+                }
+            }
+
+            template <typename Visitor>
+            static void visit_field(Visitor& visitor, CSVDataType type, std::string_view field) {
+                if (type == CSVDataType::STRING || type == CSVDataType::DATE) {
+                    visitor.on_string(field);
+                    return;
+                }
+                if (field.empty()) {
+                    visitor.on_null();
+                    return;
+                }
+                const char* end = field.data() + field.size();
+                if (type == CSVDataType::INTEGER) {
+                    int64_t value;
+                    auto result = std::from_chars(field.data(), end, value);
+                    if (result.ec == std::errc() && result.ptr == end) {
+                        visitor.on_int64(value);
+                        return;
+                    }
+                } else if (type == CSVDataType::FLOAT) {
+                    double value;
+                    auto result = std::from_chars(field.data(), end, value);
+                    if (result.ec == std::errc() && result.ptr == end) {
+                        visitor.on_double(value);
+                        return;
+                    }
+                } else if (field == "true" || field == "TRUE" || field == "1") {
+                    visitor.on_bool(true);
+                    return;
+                } else if (field == "false" || field == "FALSE" || field == "0") {
+                    visitor.on_bool(false);
+                    return;
+                }
+                throw std::runtime_error("Invalid value in CSV field: " + std::string(field));
+            }
+
+            static char quote_char(CSVQuoteStyle quote_style) {
+                switch (quote_style) {
+                    case DOUBLE: return '"';
+                    case SINGLE: return '\'';
+                    default: return 0;
+                }
+            }
+
+            /**
+             * Calls on_record(uint64_t offset) with the start of every record of source that is not blank.
+             * The newlines come from a LineIndexer in slices that keep the offsets cache resident; a line is
+             * blank when it holds nothing but '\r', which its first byte settles for any other line.
+             */
+            template <typename Record>
+            void index_records(Source& source, Record&& on_record) const {
+                static constexpr size_t SLICE_SIZE = 64 * 1024;
+                LineIndexer indexer(quote_char(properties_.get_quote_style()));
+                std::vector<uint64_t> line_ends;
+                uint64_t base = 0;          // Offset of the current slice
+                uint64_t start = 0;         // Start of the current line
+                bool content = false;       // Whether the current line so far holds more than '\r'
+                auto has_content = [](std::string_view text) {
+                    return text.find_first_not_of('\r') != std::string_view::npos;
+                };
+                for (std::string_view piece = source.next(); !piece.empty(); piece = source.next()) {
+                    for (size_t offset = 0; offset < piece.size(); offset += SLICE_SIZE) {
+                        std::string_view slice = piece.substr(offset, SLICE_SIZE);
+                        line_ends.clear();
+                        indexer.find(slice, base, line_ends);
+                        for (uint64_t end : line_ends) {
+                            uint64_t from = start > base ? start : base;
+                            if (content || has_content(slice.substr(from - base, end - 1 - from))) {
+                                on_record(start);
+                            }
+                            start = end;
+                            content = false;
+                        }
+                        uint64_t from = start > base ? start : base;
+                        content = content || has_content(slice.substr(from - base));
+                        base += slice.size();
+                    }
+                }
+                if (content) {
+                    on_record(start);
+                }
+            }
+
+            static CSVDelimiter detect_delimiter(std::string_view data) {
+                size_t commas = 0;
+                size_t tabs = 0;
+                for (char c : data.substr(0, data.find('\n'))) {
+                    commas += c == ',';
+                    tabs += c == '\t';
+                }
+                return tabs > commas ? TAB : COMMA;
+            }
+
+            void append_field(size_t column, std::string_view field) {
+                while (columns_.size() <= column) {
+                    auto added = std::make_shared<CSVColumnData>();
+                    for (size_t r = 0; r < rows_; ++r) {
+                        added->append(std::string_view());
+                    }
+                    columns_.push_back(std::move(added));
+                }
+                columns_[column]->append(field);
+            }
+
+            void end_row(size_t fields) {
+                for (size_t c = fields; c < columns_.size(); ++c) {
+                    columns_[c]->append(std::string_view());
+                }
+                ++rows_;
+            }
+
+            CSVProperties properties_;
+            std::vector<CSVColumn> header_columns_;                 // Named by the header of the last parse
+            std::vector<std::shared_ptr<CSVColumnData>> columns_;
+            size_t rows_ = 0;
+            mutable std::vector<std::vector<std::string>> data_;   // Row view built on demand from columns_
+            mutable bool data_current_ = false;
     };
-    void CSV::parse(const std::string& data) {
-        // Implementation of CSV parsing logic
-        // This is a placeholder for actual parsing logic
-    }   
-}
\ No newline at end of file
+}
@@ -0,0 +1,390 @@
+/**
+ * Shared tokenizer core for delimited text: CSV, .properties, INI, key=value fields and query strings.
+ * DelimiterScanner finds the next of a small set of special characters with the SIMD kernel of the
+ * active CPU level, 16 to 64 bytes at a time, so every format skips ordinary text with the same
+ * vectorized loop instead of a character by character one.  The formats differ only in which characters
+ * separate fields, records and keys from values.
+ */
+
+
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/cpu.h>
+
+
+namespace pb {
+
+    /**
+     * DelimiterScanner: finds the first occurrence of any of up to eight characters.  The search kernel
+     * of the active CPU level (pb/cpu.h) is bound when the scanner is constructed.
+     */
+    class DelimiterScanner {
+        public:
+            static constexpr size_t MAX_CHARACTERS = 8;
+
+            explicit DelimiterScanner(std::string_view characters) {
+                if (characters.size() > MAX_CHARACTERS) {
+                    throw std::runtime_error("DelimiterScanner supports at most 8 characters");
+                }
+                for (char c : characters) {
+                    uint8_t byte = static_cast<uint8_t>(c);
+                    if (!set_.table[byte]) {
+                        set_.table[byte] = true;
+                        set_.characters[set_.count++] = byte;
+                    }
+                }
+                kernel_ = detail::scan_kernel(set_.count == 0 ? CpuLevel::SCALAR : cpu_level());
+            }
+
+            bool matches(char c) const {
+                return set_.table[static_cast<uint8_t>(c)];
+            }
+
+            // First position in [p, end) holding one of the characters, or end
+            const char* find(const char* p, const char* end) const {
+                return kernel_(set_, p, end);
+            }
+
+            size_t find(std::string_view text, size_t from = 0) const {
+                if (from >= text.size()) {
+                    return std::string_view::npos;
+                }
+                const char* end = text.data() + text.size();
+                const char* found = kernel_(set_, text.data() + from, end);
+                return found == end ? std::string_view::npos : static_cast<size_t>(found - text.data());
+            }
+
+        private:
+            detail::ScanSet set_;
+            detail::ScanKernel kernel_;
+    };
+
+    /**
+     * LineIndexer: finds the newlines of delimited text that are outside quotes, with the line kernel of
+     * the active CPU level, without looking at fields.  Every quote character toggles the quoted state,
+     * which is exact for RFC 4180 data, doubled quotes included.  The state carries over between calls, so
+     * text can be indexed a piece at a time.  '\r' alone does not end a line.
+     */
+    class LineIndexer {
+        public:
+            explicit LineIndexer(char quote = '"') : quote_(quote), kernel_(detail::line_kernel(cpu_level())) {}
+
+            // Appends base plus the offset just past every newline of data outside quotes to line_ends
+            void find(std::string_view data, uint64_t base, std::vector<uint64_t>& line_ends) {
+                kernel_(data.data(), data.data() + data.size(), quote_, in_quotes_, base, line_ends);
+            }
+
+            // Whether the text so far ends inside a quoted field
+            bool in_quotes() const { return in_quotes_; }
+
+        private:
+            char quote_;
+            bool in_quotes_ = false;
+            detail::LineKernel kernel_;
+    };
+
+    /**
+     * DelimitedFormat: the separators of a delimited format.  A record separator of '\n' also accepts
+     * "\r\n" and "\r".  0 disables assignment or quoting.
+     */
+    struct DelimitedFormat {
+        char field = ',';
+        char record = '\n';
+        char assignment = 0;        // Splits a field into key and value
+        char quote = '"';           // Quotes a field or value, doubled inside it
+    };
+
+    namespace detail {
+
+        inline bool delimited_is_space(char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        inline std::string_view delimited_trim(std::string_view text) {
+            while (!text.empty() && delimited_is_space(text.front())) {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && delimited_is_space(text.back())) {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        /**
+         * Reads the quoted text starting after the opening quote at i into out, leaving i after the closing
+         * quote.  quoted finds the quote character and is built once per parse by the caller.
+         */
+        inline void delimited_read_quoted(std::string_view data, size_t& i, char quote, const DelimiterScanner& quoted, std::string& out) {
+            const char* begin = data.data();
+            const char* end = begin + data.size();
+            while (true) {
+                const char* found = quoted.find(begin + i, end);
+                out.append(begin + i, found);
+                if (found == end) {
+                    throw std::runtime_error("Unterminated quoted field");
+                }
+                i = static_cast<size_t>(found - begin) + 1;
+                if (i < data.size() && data[i] == quote) {
+                    out.push_back(quote);
+                    ++i;
+                    continue;
+                }
+                return;
+            }
+        }
+
+        inline std::string delimited_scanner_characters(const DelimitedFormat& format, bool with_assignment) {
+            std::string characters{ format.field, format.record };
+            if (format.record == '\n') {
+                characters.push_back('\r');
+            }
+            if (with_assignment && format.assignment != 0) {
+                characters.push_back(format.assignment);
+            }
+            return characters;
+        }
+
+        inline bool delimited_is_record_end(const DelimitedFormat& format, char c) {
+            return c == format.record || (format.record == '\n' && c == '\r');
+        }
+
+        // Skips the record separator at i, "\r\n" counting as one
+        inline void delimited_skip_record_end(const DelimitedFormat& format, std::string_view data, size_t& i) {
+            if (format.record == '\n') {
+                if (i < data.size() && data[i] == '\r') {
+                    ++i;
+                }
+                if (i < data.size() && data[i] == '\n') {
+                    ++i;
+                }
+            } else if (i < data.size() && data[i] == format.record) {
+                ++i;
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Splits RFC 4180 style data into fields.  Calls on_field(size_t column, std::string_view field) for
+     * every field and on_record(size_t fields) at the end of every record.  Empty records are skipped, a
+     * delimiter at the very end adds an empty field, and text between a closing quote and the next
+     * separator is kept.  The field is only valid during the call.  Throws std::runtime_error on an
+     * unterminated quoted field.
+     */
+    template <typename Field, typename Record>
+    void tokenize_delimited(std::string_view data, const DelimitedFormat& format, Field&& on_field, Record&& on_record) {
+        const DelimiterScanner scanner(detail::delimited_scanner_characters(format, false));
+        const char quote = format.quote;
+        const DelimiterScanner quoted(std::string_view(&quote, 1));
+        const char* const begin = data.data();
+        const char* const end = begin + data.size();
+
+        std::string scratch;
+        size_t column = 0;
+        size_t i = 0;
+        const size_t size = data.size();
+
+        while (i < size) {
+            if (column == 0 && detail::delimited_is_record_end(format, data[i])) {
+                ++i;
+                continue;
+            }
+
+            std::string_view field;
+            if (quote != 0 && data[i] == quote) {
+                scratch.clear();
+                ++i;
+                detail::delimited_read_quoted(data, i, quote, quoted, scratch);
+                const char* stop = scanner.find(begin + i, end);
+                scratch.append(begin + i, stop);
+                i = static_cast<size_t>(stop - begin);
+                field = scratch;
+            } else {
+                size_t start = i;
+                i = static_cast<size_t>(scanner.find(begin + i, end) - begin);
+                field = data.substr(start, i - start);
+            }
+
+            on_field(column, field);
+            ++column;
+
+            if (i < size && data[i] == format.field) {
+                ++i;
+                if (i == size) {
+                    on_field(column, std::string_view());
+                    ++column;
+                } else {
+                    continue;
+                }
+            }
+            detail::delimited_skip_record_end(format, data, i);
+            on_record(column);
+            column = 0;
+        }
+    }
+
+    /**
+     * Splits key/value fields such as "user=bob; ip=10.0.0.1" or "a:1,b:2".  Calls
+     * on_pair(std::string_view key, std::string_view value) for every non empty field, with spaces around
+     * keys and values removed.  A field without the assignment character has an empty value.  A value
+     * that starts with the quote character runs to the closing quote, separators included.  Both views
+     * are only valid during the call.
+     */
+    template <typename Pair>
+    void parse_key_values(std::string_view data, const DelimitedFormat& format, Pair&& on_pair) {
+        if (format.assignment == 0) {
+            throw std::runtime_error("Key/value parsing needs an assignment character");
+        }
+        const DelimiterScanner scanner(detail::delimited_scanner_characters(format, true));
+        const DelimiterScanner values(detail::delimited_scanner_characters(format, false));
+        const DelimiterScanner quoted(std::string_view(&format.quote, 1));
+        const char* const begin = data.data();
+        const char* const end = begin + data.size();
+        std::string scratch;
+        size_t i = 0;
+        while (i < data.size()) {
+            size_t start = i;
+            i = static_cast<size_t>(scanner.find(begin + i, end) - begin);
+            std::string_view key = detail::delimited_trim(data.substr(start, i - start));
+            std::string_view value;
+            if (i < data.size() && data[i] == format.assignment) {
+                ++i;
+                while (i < data.size() && detail::delimited_is_space(data[i])) {
+                    ++i;
+                }
+                if (format.quote != 0 && i < data.size() && data[i] == format.quote) {
+                    scratch.clear();
+                    ++i;
+                    detail::delimited_read_quoted(data, i, format.quote, quoted, scratch);
+                    value = scratch;
+                    // Ignore anything up to the separator
+                    while (i < data.size() && data[i] != format.field && !detail::delimited_is_record_end(format, data[i])) {
+                        ++i;
+                    }
+                } else {
+                    size_t value_start = i;
+                    i = static_cast<size_t>(values.find(begin + i, end) - begin);
+                    value = detail::delimited_trim(data.substr(value_start, i - value_start));
+                }
+            }
+            if (!key.empty() || !value.empty()) {
+                on_pair(key, value);
+            }
+            if (i < data.size()) {
+                ++i;
+                if (data[i - 1] == '\r' && i < data.size() && data[i] == '\n') {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    /**
+     * Splits a URL query string, "a=1&b=two%20words", with '+' and %XX decoded in keys and values.  A
+     * leading '?' is skipped.  Calls on_pair(std::string_view key, std::string_view value), views valid
+     * during the call only.
+     */
+    template <typename Pair>
+    void parse_query_string(std::string_view data, Pair&& on_pair) {
+        if (!data.empty() && data.front() == '?') {
+            data.remove_prefix(1);
+        }
+        const DelimiterScanner scanner("&=");
+        const DelimiterScanner encoded("%+");
+        std::string key;
+        std::string value;
+        auto decode = [&](std::string_view text, std::string& out) -> std::string_view {
+            if (encoded.find(text) == std::string_view::npos) {
+                return text;
+            }
+            out.clear();
+            for (size_t i = 0; i < text.size(); ++i) {
+                char c = text[i];
+                if (c == '+') {
+                    out.push_back(' ');
+                } else if (c == '%' && i + 2 < text.size() && std::isxdigit(static_cast<uint8_t>(text[i + 1]))
+                           && std::isxdigit(static_cast<uint8_t>(text[i + 2]))) {
+                    auto digit = [](char h) { return h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10; };
+                    out.push_back(static_cast<char>(digit(text[i + 1]) * 16 + digit(text[i + 2])));
+                    i += 2;
+                } else {
+                    out.push_back(c);
+                }
+            }
+            return out;
+        };
+        size_t i = 0;
+        while (i < data.size()) {
+            size_t start = i;
+            size_t stop = scanner.find(data, i);
+            stop = stop == std::string_view::npos ? data.size() : stop;
+            std::string_view raw_key = data.substr(start, stop - start);
+            std::string_view raw_value;
+            i = stop;
+            if (i < data.size() && data[i] == '=') {
+                size_t value_end = data.find('&', i + 1);
+                value_end = value_end == std::string_view::npos ? data.size() : value_end;
+                raw_value = data.substr(i + 1, value_end - i - 1);
+                i = value_end;
+            }
+            if (!raw_key.empty() || !raw_value.empty()) {
+                on_pair(decode(raw_key, key), decode(raw_value, value));
+            }
+            ++i;
+        }
+    }
+
+    /**
+     * Parses INI text.  Calls on_entry(std::string_view section, std::string_view key, std::string_view
+     * value) for every "key = value" or "key: value" line, section being the last "[section]" header or
+     * empty before the first.  Lines starting with ';' or '#' are comments.  Keys and values are trimmed
+     * and a value in double quotes is unquoted.  Throws std::runtime_error on an unterminated section
+     * header.
+     */
+    template <typename Entry>
+    void parse_ini(std::string_view data, Entry&& on_entry) {
+        const DelimiterScanner lines("\n\r");
+        const DelimiterScanner assignment("=:");
+        std::string_view section;
+        size_t i = 0;
+        if (data.starts_with("\xEF\xBB\xBF")) {
+            i = 3;
+        }
+        while (i < data.size()) {
+            size_t stop = lines.find(data, i);
+            stop = stop == std::string_view::npos ? data.size() : stop;
+            std::string_view line = detail::delimited_trim(data.substr(i, stop - i));
+            i = stop + 1;
+            if (line.empty() || line.front() == ';' || line.front() == '#') {
+                continue;
+            }
+            if (line.front() == '[') {
+                size_t close = line.find(']');
+                if (close == std::string_view::npos) {
+                    throw std::runtime_error("Unterminated INI section header");
+                }
+                section = detail::delimited_trim(line.substr(1, close - 1));
+                continue;
+            }
+            size_t separator = assignment.find(line);
+            std::string_view key = detail::delimited_trim(line.substr(0, separator));
+            std::string_view value;
+            if (separator != std::string_view::npos) {
+                value = detail::delimited_trim(line.substr(separator + 1));
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                    value = value.substr(1, value.size() - 2);
+                }
+            }
+            on_entry(section, key, value);
+        }
+    }
+
+} // namespace pb
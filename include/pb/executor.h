@@ -0,0 +1,194 @@
+/**
+ * Work stealing thread pool shared by the parallel stages of the library.
+ * Every worker owns a deque: tasks it submits go to the back and it takes its own work from the back,
+ * newest first, while idle workers steal from the front of the others, oldest first.  Tasks submitted
+ * from outside the pool go to a shared queue.  A thread waiting on a TaskGroup runs queued tasks
+ * instead of blocking, so groups nest without tying up workers.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace pb {
+
+    /**
+     * Executor: a fixed set of worker threads with per worker deques.  Parallel functions of the library
+     * take an Executor& and default to Executor::shared(), so an application can confine the library to
+     * a pool of its own.  The destructor runs the tasks still queued, then joins the workers.
+     */
+    class Executor {
+        public:
+            using Task = std::function<void()>;
+
+            /**
+             * Starts threads workers, 0 for one per core.  With pin_threads worker i is bound to core
+             * i modulo the core count (Linux and Windows, ignored elsewhere).
+             */
+            explicit Executor(size_t threads = 0, bool pin_threads = false);
+            ~Executor();
+
+            Executor(const Executor&) = delete;
+            Executor& operator=(const Executor&) = delete;
+
+            // The pool used when a caller does not pass one: one worker per core but one, as the waiting caller helps
+            static Executor& shared();
+
+            size_t size() const { return workers_.size(); }
+
+            // Queues task, on the calling worker's deque when called from a worker of this executor.  task must not throw.
+            void submit(Task task);
+
+            // Runs one queued task on the calling thread, if there is one
+            bool run_one();
+
+            // Whether the calling thread is one of the workers
+            bool in_worker() const;
+
+        private:
+            struct Worker {
+                std::mutex mutex;
+                std::deque<Task> tasks;
+                std::thread thread;
+            };
+
+            std::optional<Task> take(size_t self);
+            void work(size_t index);
+
+            std::vector<std::unique_ptr<Worker>> workers_;
+            std::mutex injected_mutex_;
+            std::deque<Task> injected_;             // Tasks submitted from outside the pool
+            std::atomic<std::ptrdiff_t> queued_{ 0 };    // Briefly -1 when a task is taken before its submit counted it
+            std::mutex sleep_mutex_;
+            std::condition_variable sleep_;
+            bool stopping_ = false;
+    };
+
+    /**
+     * TaskGroup: fork/join over an Executor.  run() forks a task, wait() joins them all, running queued
+     * tasks meanwhile, and rethrows the first exception a task threw.  The destructor waits too, without
+     * rethrowing.
+     *
+     *     pb::TaskGroup group(executor);
+     *     group.run([&] { left = sum(a, mid); });
+     *     right = sum(mid, b);
+     *     group.wait();
+     */
+    class TaskGroup {
+        public:
+            explicit TaskGroup(Executor& executor = Executor::shared()) : executor_(executor) {}
+
+            ~TaskGroup() {
+                join();
+            }
+
+            TaskGroup(const TaskGroup&) = delete;
+            TaskGroup& operator=(const TaskGroup&) = delete;
+
+            template <typename F>
+            void run(F&& task) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++pending_;
+                }
+                executor_.submit([this, task = std::forward<F>(task)]() mutable {
+                    try {
+                        task();
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (!error_) {
+                            error_ = std::current_exception();
+                        }
+                    }
+                    // Last access to the group: wait() may return, and the group go away, once it is unlocked
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (--pending_ == 0) {
+                        done_.notify_all();
+                    }
+                });
+            }
+
+            void wait() {
+                join();
+                std::exception_ptr error;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    std::swap(error, error_);
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+        private:
+            void join() {
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (pending_ == 0) {
+                            return;
+                        }
+                    }
+                    if (executor_.run_one()) {
+                        continue;
+                    }
+                    // Everything of ours is running elsewhere; wake up now and then to help with what it forks
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    done_.wait_for(lock, std::chrono::milliseconds(1), [this] { return pending_ == 0; });
+                }
+            }
+
+            Executor& executor_;
+            std::mutex mutex_;
+            std::condition_variable done_;
+            size_t pending_ = 0;
+            std::exception_ptr error_;
+    };
+
+    /**
+     * Calls body(i) for every i in [0, count) on at most max_tasks threads, the caller included (0 for
+     * the executor's workers plus the caller).  Indices are handed out one at a time, so uneven items
+     * balance out.  After an exception the remaining items are skipped, and the first one thrown is
+     * rethrown once every task stopped.
+     */
+    template <typename Body>
+    void parallel_for(Executor& executor, size_t count, Body&& body, size_t max_tasks = 0) {
+        if (count == 0) {
+            return;
+        }
+        size_t tasks = std::min(count, max_tasks == 0 ? executor.size() + 1 : max_tasks);
+        std::atomic<size_t> next(0);
+        auto drain = [&]() {
+            try {
+                for (size_t i = next++; i < count; i = next++) {
+                    body(i);
+                }
+            } catch (...) {
+                next = count;       // The others stop after their current item
+                throw;
+            }
+        };
+        TaskGroup group(executor);
+        for (size_t t = 1; t < tasks; ++t) {
+            group.run(drain);
+        }
+        drain();
+        group.wait();
+    }
+
+} // namespace pb
@@ -0,0 +1,198 @@
+/**
+ * Sources and sinks: one input and one output interface for every reader and writer of the library.
+ * A Source hands out borrowed buffers: an in memory or mapped source returns its data itself, a stream
+ * returns its internal read buffer, so nothing is copied on the way to the parser.  Readers ask for the
+ * whole input with read_all, which only gathers into storage when the source is a stream.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/mapped_file.h>
+
+
+namespace pb {
+
+    class Memory;
+
+    /**
+     * Source: An abstract base class for sequential input.
+     */
+    class Source {
+        public:
+            virtual ~Source() = default;
+
+            /**
+             * The next piece of the input, empty at the end.  The buffer is borrowed: it stays valid until
+             * the next call or the destruction of the source.  Throws std::runtime_error on a read error.
+             */
+            virtual std::string_view next() = 0;
+
+            // Bytes left to read, when known
+            virtual std::optional<uint64_t> remaining() const { return std::nullopt; }
+
+            /**
+             * Consumes the rest of the input and returns it as one borrowed view, valid as long as the
+             * source, when the source holds it in memory.  Otherwise returns nullopt and consumes nothing.
+             */
+            virtual std::optional<std::string_view> next_contiguous() { return std::nullopt; }
+    };
+
+    /**
+     * Sink: An abstract base class for sequential output.
+     */
+    class Sink {
+        public:
+            virtual ~Sink() = default;
+
+            // Appends data.  Throws std::runtime_error on a write error.
+            virtual void write(std::string_view data) = 0;
+
+            // Pushes buffered output to its destination
+            virtual void flush() {}
+    };
+
+    /**
+     * SpanSource: a source over memory owned by the caller, returned in one piece.
+     */
+    class SpanSource : public Source {
+        public:
+            explicit SpanSource(std::string_view data) : data_(data) {}
+            explicit SpanSource(std::span<const uint8_t> data)
+                : data_(reinterpret_cast<const char*>(data.data()), data.size()) {}
+
+            virtual std::string_view next() override;
+            virtual std::optional<uint64_t> remaining() const override { return data_.size(); }
+            virtual std::optional<std::string_view> next_contiguous() override { return next(); }
+
+        private:
+            std::string_view data_;
+    };
+
+    /**
+     * MemorySource: the first size bytes of a pb::Memory (pb/memory.h), all of it by default, borrowed.
+     * The memory must not grow or be re-initialized while the source is read.
+     */
+    class MemorySource : public SpanSource {
+        public:
+            explicit MemorySource(Memory& memory);
+            MemorySource(Memory& memory, size_t size);
+    };
+
+    /**
+     * MappedFileSource: a file mapped read only (see MappedFile), returned in one piece.  Throws
+     * std::runtime_error if the file cannot be opened or mapped.
+     */
+    class MappedFileSource : public Source {
+        public:
+            explicit MappedFileSource(const std::string& path) : file_(path), data_(file_.view()) {}
+
+            virtual std::string_view next() override;
+            virtual std::optional<uint64_t> remaining() const override { return data_.size(); }
+            virtual std::optional<std::string_view> next_contiguous() override { return next(); }
+
+        private:
+            MappedFile file_;
+            std::string_view data_;
+    };
+
+    constexpr size_t FILE_SOURCE_DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+    /**
+     * FileSource: a file, pipe or standard input read in buffer_size pieces into one reused buffer.  The
+     * C stream is switched to unbuffered, so the data is copied once, from the kernel into that buffer.
+     * Throws std::runtime_error if the file cannot be opened.
+     */
+    class FileSource : public Source {
+        public:
+            explicit FileSource(const std::string& path, size_t buffer_size = FILE_SOURCE_DEFAULT_BUFFER_SIZE);
+
+            // Reads an open stream, stdin for example, which stays open afterwards
+            explicit FileSource(std::FILE* file, size_t buffer_size = FILE_SOURCE_DEFAULT_BUFFER_SIZE);
+
+            FileSource(const FileSource&) = delete;
+            FileSource& operator=(const FileSource&) = delete;
+            virtual ~FileSource();
+
+            virtual std::string_view next() override;
+            virtual std::optional<uint64_t> remaining() const override;
+
+        private:
+            std::FILE* file_;
+            bool owned_;
+            std::optional<uint64_t> remaining_;
+            std::vector<char> buffer_;
+    };
+
+    /**
+     * StringSink: appends to a string owned by the caller.
+     */
+    class StringSink : public Sink {
+        public:
+            explicit StringSink(std::string& out) : out_(out) {}
+
+            virtual void write(std::string_view data) override { out_.append(data); }
+
+        private:
+            std::string& out_;
+    };
+
+    /**
+     * MemorySink: writes into a pb::Memory from offset on, growing it by its policy.
+     */
+    class MemorySink : public Sink {
+        public:
+            explicit MemorySink(Memory& memory, size_t offset = 0) : memory_(memory), offset_(offset) {}
+
+            virtual void write(std::string_view data) override;
+
+            // Offset after the last byte written
+            size_t offset() const { return offset_; }
+
+        private:
+            Memory& memory_;
+            size_t offset_;
+    };
+
+    /**
+     * FileSink: writes a file, replacing it, or an open stream such as stdout.  Throws
+     * std::runtime_error if the file cannot be created or written.
+     */
+    class FileSink : public Sink {
+        public:
+            explicit FileSink(const std::string& path);
+
+            // Writes an open stream, which stays open afterwards
+            explicit FileSink(std::FILE* file) : file_(file), owned_(false) {}
+
+            FileSink(const FileSink&) = delete;
+            FileSink& operator=(const FileSink&) = delete;
+            virtual ~FileSink();
+
+            virtual void write(std::string_view data) override;
+            virtual void flush() override;
+
+        private:
+            std::FILE* file_;
+            bool owned_;
+    };
+
+    /**
+     * The rest of the input of source as one view: borrowed when the source holds it in memory, otherwise
+     * gathered into storage, which is replaced.
+     */
+    std::string_view read_all(Source& source, std::string& storage);
+
+    // Copies the rest of source to sink
+    void copy_all(Source& source, Sink& sink);
+
+} // namespace pb
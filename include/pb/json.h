@@ -0,0 +1,483 @@
+/**
+ * JSON reader and writer for Blob.
+ * The reader drives a visitor (pb/visitor.h) directly from the text, strings without escapes are handed
+ * to it straight from the input.  Reading into a Blob goes through BlobBuilderVisitor.  The writer renders DATE as an ISO 8601 string and BINARY as base64.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <pb/blob.h>
+#include <pb/io.h>
+#include <pb/visitor.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t JSON_MAX_DEPTH = 512;
+
+        inline bool json_is_space(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        inline void json_append_utf8(std::string& out, uint32_t code) {
+            if (code < 0x80) {
+                out.push_back(static_cast<char>(code));
+            } else if (code < 0x800) {
+                out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            } else if (code < 0x10000) {
+                out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            } else {
+                out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            }
+        }
+
+        template <BlobVisitor Visitor>
+        class JsonReader {
+            public:
+                JsonReader(std::string_view text, Visitor& visitor)
+                    : p_(text.data()), end_(text.data() + text.size()), visitor_(visitor) {}
+
+                // Reads one value surrounded by optional whitespace
+                void read_document() {
+                    skip_space();
+                    read_value(0);
+                    skip_space();
+                    if (p_ != end_) {
+                        fail("Trailing characters after JSON document");
+                    }
+                }
+
+            private:
+                [[noreturn]] void fail(const char* message) const {
+                    throw std::runtime_error(message);
+                }
+
+                void skip_space() {
+                    while (p_ < end_ && json_is_space(*p_)) {
+                        ++p_;
+                    }
+                }
+
+                char peek() {
+                    if (p_ >= end_) {
+                        fail("Unexpected end of JSON");
+                    }
+                    return *p_;
+                }
+
+                void expect_literal(std::string_view literal) {
+                    if (static_cast<size_t>(end_ - p_) < literal.size() || std::memcmp(p_, literal.data(), literal.size()) != 0) {
+                        fail("Invalid JSON literal");
+                    }
+                    p_ += literal.size();
+                }
+
+                void read_value(size_t depth) {
+                    if (depth > JSON_MAX_DEPTH) {
+                        fail("JSON document is nested too deeply");
+                    }
+                    switch (peek()) {
+                        case '{': read_object(depth); break;
+                        case '[': read_array(depth); break;
+                        case '"': visitor_.on_string(read_string()); break;
+                        case 't': expect_literal("true"); visitor_.on_bool(true); break;
+                        case 'f': expect_literal("false"); visitor_.on_bool(false); break;
+                        case 'n': expect_literal("null"); visitor_.on_null(); break;
+                        default: read_number(); break;
+                    }
+                }
+
+                void read_object(size_t depth) {
+                    ++p_;
+                    visitor_.on_object_begin();
+                    skip_space();
+                    if (peek() == '}') {
+                        ++p_;
+                        visitor_.on_object_end();
+                        return;
+                    }
+                    while (true) {
+                        skip_space();
+                        if (peek() != '"') {
+                            fail("JSON object key must be a string");
+                        }
+                        visitor_.on_key(read_string());
+                        skip_space();
+                        if (peek() != ':') {
+                            fail("Expected ':' in JSON object");
+                        }
+                        ++p_;
+                        skip_space();
+                        read_value(depth + 1);
+                        skip_space();
+                        char c = peek();
+                        ++p_;
+                        if (c == '}') {
+                            break;
+                        }
+                        if (c != ',') {
+                            fail("Expected ',' or '}' in JSON object");
+                        }
+                    }
+                    visitor_.on_object_end();
+                }
+
+                void read_array(size_t depth) {
+                    ++p_;
+                    visitor_.on_array_begin();
+                    skip_space();
+                    if (peek() == ']') {
+                        ++p_;
+                        visitor_.on_array_end();
+                        return;
+                    }
+                    while (true) {
+                        skip_space();
+                        read_value(depth + 1);
+                        skip_space();
+                        char c = peek();
+                        ++p_;
+                        if (c == ']') {
+                            break;
+                        }
+                        if (c != ',') {
+                            fail("Expected ',' or ']' in JSON array");
+                        }
+                    }
+                    visitor_.on_array_end();
+                }
+
+                // Strings without escapes are returned as a view of the input, others are decoded into scratch_
+                std::string_view read_string() {
+                    ++p_;
+                    const char* start = p_;
+                    while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+                        if (static_cast<unsigned char>(*p_) < 0x20) {
+                            fail("Control character in JSON string");
+                        }
+                        ++p_;
+                    }
+                    if (peek() == '"') {
+                        return std::string_view(start, static_cast<size_t>(p_++ - start));
+                    }
+
+                    scratch_.assign(start, p_);
+                    while (true) {
+                        char c = peek();
+                        ++p_;
+                        if (c == '"') {
+                            return scratch_;
+                        }
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            fail("Control character in JSON string");
+                        }
+                        if (c != '\\') {
+                            scratch_.push_back(c);
+                            continue;
+                        }
+                        char escape = peek();
+                        ++p_;
+                        switch (escape) {
+                            case '"': scratch_.push_back('"'); break;
+                            case '\\': scratch_.push_back('\\'); break;
+                            case '/': scratch_.push_back('/'); break;
+                            case 'b': scratch_.push_back('\b'); break;
+                            case 'f': scratch_.push_back('\f'); break;
+                            case 'n': scratch_.push_back('\n'); break;
+                            case 'r': scratch_.push_back('\r'); break;
+                            case 't': scratch_.push_back('\t'); break;
+                            case 'u': {
+                                uint32_t code = read_hex4();
+                                if (code >= 0xd800 && code <= 0xdbff) {
+                                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+                                        fail("Unpaired surrogate in JSON string");
+                                    }
+                                    p_ += 2;
+                                    uint32_t low = read_hex4();
+                                    if (low < 0xdc00 || low > 0xdfff) {
+                                        fail("Unpaired surrogate in JSON string");
+                                    }
+                                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                                } else if (code >= 0xdc00 && code <= 0xdfff) {
+                                    fail("Unpaired surrogate in JSON string");
+                                }
+                                json_append_utf8(scratch_, code);
+                                break;
+                            }
+                            default:
+                                fail("Invalid escape in JSON string");
+                        }
+                    }
+                }
+
+                uint32_t read_hex4() {
+                    if (end_ - p_ < 4) {
+                        fail("Unexpected end of JSON");
+                    }
+                    uint32_t code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        char c = *p_++;
+                        code <<= 4;
+                        if (c >= '0' && c <= '9') {
+                            code |= static_cast<uint32_t>(c - '0');
+                        } else if (c >= 'a' && c <= 'f') {
+                            code |= static_cast<uint32_t>(c - 'a' + 10);
+                        } else if (c >= 'A' && c <= 'F') {
+                            code |= static_cast<uint32_t>(c - 'A' + 10);
+                        } else {
+                            fail("Invalid \\u escape in JSON string");
+                        }
+                    }
+                    return code;
+                }
+
+                // Integers become INTEGER, or UNSIGNED_INTEGER above INT64_MAX, anything with a fraction or exponent FLOAT
+                void read_number() {
+                    const char* start = p_;
+                    bool negative = p_ < end_ && *p_ == '-';
+                    if (negative) {
+                        ++p_;
+                    }
+                    const char* digits = p_;
+                    while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                        ++p_;
+                    }
+                    if (p_ == digits || (*digits == '0' && p_ - digits > 1)) {
+                        fail("Invalid JSON number");
+                    }
+                    bool integral = true;
+                    if (p_ < end_ && *p_ == '.') {
+                        integral = false;
+                        const char* fraction = ++p_;
+                        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                            ++p_;
+                        }
+                        if (p_ == fraction) {
+                            fail("Invalid JSON number");
+                        }
+                    }
+                    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+                        integral = false;
+                        ++p_;
+                        if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                            ++p_;
+                        }
+                        const char* exponent = p_;
+                        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                            ++p_;
+                        }
+                        if (p_ == exponent) {
+                            fail("Invalid JSON number");
+                        }
+                    }
+
+                    if (integral) {
+                        if (negative) {
+                            int64_t value;
+                            auto result = std::from_chars(start, p_, value);
+                            if (result.ec == std::errc()) {
+                                visitor_.on_int64(value);
+                                return;
+                            }
+                        } else {
+                            uint64_t value;
+                            auto result = std::from_chars(start, p_, value);
+                            if (result.ec == std::errc()) {
+                                if (value <= static_cast<uint64_t>(INT64_MAX)) {
+                                    visitor_.on_int64(static_cast<int64_t>(value));
+                                } else {
+                                    visitor_.on_uint64(value);
+                                }
+                                return;
+                            }
+                        }
+                        // Out of range integers fall back to FLOAT
+                    }
+                    double value;
+                    auto result = std::from_chars(start, p_, value);
+                    if (result.ec == std::errc::result_out_of_range) {
+                        // from_chars leaves value unset, so overflow becomes infinity and underflow zero
+                        value = number_overflows(start, p_) ? std::numeric_limits<double>::infinity() : 0.0;
+                        if (negative) {
+                            value = -value;
+                        }
+                    } else if (result.ec != std::errc()) {
+                        fail("Invalid JSON number");
+                    }
+                    visitor_.on_double(value);
+                }
+
+                /**
+                 * For a number from_chars found out of range: true if its magnitude is too large, false if too
+                 * small.  The decimal exponent of the first significant digit decides, the exponent saturating.
+                 */
+                static bool number_overflows(const char* p, const char* end) {
+                    if (p < end && *p == '-') {
+                        ++p;
+                    }
+                    int64_t magnitude = 0;
+                    bool significant = false;
+                    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+                        significant = significant || *p != '0';
+                        magnitude += significant ? 1 : 0;
+                    }
+                    if (p < end && *p == '.') {
+                        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+                            if (significant) {
+                                continue;
+                            }
+                            significant = *p != '0';
+                            magnitude -= significant ? 0 : 1;
+                        }
+                    }
+                    int64_t exponent = 0;
+                    if (p < end && (*p == 'e' || *p == 'E')) {
+                        ++p;
+                        bool negative_exponent = p < end && *p == '-';
+                        if (p < end && (*p == '+' || *p == '-')) {
+                            ++p;
+                        }
+                        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+                            exponent = std::min<int64_t>(exponent * 10 + (*p - '0'), 1000000);
+                        }
+                        if (negative_exponent) {
+                            exponent = -exponent;
+                        }
+                    }
+                    return magnitude + exponent > 0;
+                }
+
+                const char* p_;
+                const char* end_;
+                Visitor& visitor_;
+                std::string scratch_;
+        };
+
+        /**
+         * Converts milliseconds since the Unix epoch to an ISO 8601 UTC string, using the days from civil
+         * algorithm by Howard Hinnant.
+         */
+        inline void json_append_date(std::string& out, int64_t milliseconds) {
+            int64_t days = milliseconds / 86400000;
+            int64_t ms_of_day = milliseconds % 86400000;
+            if (ms_of_day < 0) {
+                ms_of_day += 86400000;
+                days -= 1;
+            }
+            days += 719468;
+            int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            int64_t doe = days - era * 146097;
+            int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            int64_t mp = (5 * doy + 2) / 153;
+            int64_t day = doy - (153 * mp + 2) / 5 + 1;
+            int64_t month = mp < 10 ? mp + 3 : mp - 9;
+            int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+            char buffer[40];
+            int length = std::snprintf(buffer, sizeof(buffer), "%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.%03lldZ",
+                                       static_cast<long long>(year), static_cast<long long>(month), static_cast<long long>(day),
+                                       static_cast<long long>(ms_of_day / 3600000), static_cast<long long>(ms_of_day / 60000 % 60),
+                                       static_cast<long long>(ms_of_day / 1000 % 60), static_cast<long long>(ms_of_day % 1000));
+            out.append(buffer, static_cast<size_t>(length));
+        }
+
+        inline void json_append_base64(std::string& out, std::span<const uint8_t> bytes) {
+            static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            size_t i = 0;
+            for (; i + 3 <= bytes.size(); i += 3) {
+                uint32_t group = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+                out.push_back(alphabet[group >> 18]);
+                out.push_back(alphabet[(group >> 12) & 0x3f]);
+                out.push_back(alphabet[(group >> 6) & 0x3f]);
+                out.push_back(alphabet[group & 0x3f]);
+            }
+            if (i < bytes.size()) {
+                uint32_t group = bytes[i] << 16;
+                if (i + 1 < bytes.size()) {
+                    group |= bytes[i + 1] << 8;
+                }
+                out.push_back(alphabet[group >> 18]);
+                out.push_back(alphabet[(group >> 12) & 0x3f]);
+                out.push_back(i + 1 < bytes.size() ? alphabet[(group >> 6) & 0x3f] : '=');
+                out.push_back('=');
+            }
+        }
+
+        inline void json_append_string(std::string& out, std::string_view value) {
+            out.push_back('"');
+            for (char c : value) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buffer[8];
+                            std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                            out += buffer;
+                        } else {
+                            out.push_back(c);
+                        }
+                }
+            }
+            out.push_back('"');
+        }
+
+        // Appends value as JSON text
+        void json_write(std::string& out, const BlobView& value);
+
+        // Compiled once in the library, for read_json and read_ndjson
+        extern template class JsonReader<BlobBuilderVisitor>;
+
+    } // namespace detail
+
+    /**
+     * Parses a single JSON document into a Blob.  Throws std::runtime_error on malformed input.
+     */
+    Blob read_json(std::string_view text);
+
+    // Parses the rest of source as a single JSON document
+    Blob read_json(Source& source);
+
+    /**
+     * Parses a single JSON document and reports it to visitor without building a Blob.  Integers are
+     * reported through on_int64, or on_uint64 above INT64_MAX.  Throws std::runtime_error on malformed
+     * input, possibly after some events were delivered.
+     */
+    template <BlobVisitor Visitor>
+    void read_json(std::string_view text, Visitor& visitor) {
+        detail::JsonReader<Visitor> reader(text, visitor);
+        reader.read_document();
+    }
+
+    std::string write_json(const BlobView& value);
+
+    std::string write_json(const Blob& blob);
+
+    void write_json(const BlobView& value, Sink& sink);
+
+} // namespace pb
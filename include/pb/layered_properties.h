@@ -0,0 +1,294 @@
+/**
+ * Layered configuration: defaults, files, environment and command line merged into one index.
+ * Layers are added in increasing precedence.  Each layer is merged into a flattened open addressing
+ * table as it is added, so precedence is resolved once at load time and a lookup costs one probe no
+ * matter how many layers there are.  Every flattened entry remembers the layer its value came from.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <pb/properties.h>
+
+#ifndef _WIN32
+extern char** environ;
+#endif
+
+
+namespace pb {
+
+    namespace detail {
+
+        // Escapes text so parsing it as a .properties key or value gives text back
+        inline void properties_escape(std::string& out, std::string_view text, bool key) {
+            for (size_t i = 0; i < text.size(); ++i) {
+                char c = text[i];
+                switch (c) {
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\f': out += "\\f"; break;
+                    default:
+                        if ((key && (c == '=' || c == ':' || c == ' ' || (i == 0 && (c == '#' || c == '!'))))
+                            || (!key && i == 0 && c == ' ')) {
+                            out.push_back('\\');
+                        }
+                        out.push_back(c);
+                        break;
+                }
+            }
+        }
+
+        inline void properties_append_line(std::string& out, std::string_view key, std::string_view value) {
+            properties_escape(out, key, true);
+            out.push_back('=');
+            properties_escape(out, value, false);
+            out.push_back('\n');
+        }
+
+    } // namespace detail
+
+    struct LayeredEntry {
+        std::string_view key;
+        std::string_view value;
+        size_t layer;
+    };
+
+    /**
+     * LayeredProperties: a stack of named Properties layers, later layers overriding earlier ones, with
+     * one flattened index over the winning values.  Within a layer a repeated key keeps its last value,
+     * like Properties.  Layers are owned, so views stay valid for the lifetime of the object.
+     *
+     *     pb::LayeredProperties config;
+     *     config.add("defaults", std::move(defaults));
+     *     config.add("file", pb::Properties("service.properties"));
+     *     config.add_environment("environment", "SERVICE_");
+     *     config.add_arguments("command line", argc, argv);
+     *     config.layer_name(*config.layer_of("http.port"));     // "environment"
+     */
+    class LayeredProperties {
+        public:
+            LayeredProperties() = default;
+            LayeredProperties(const LayeredProperties&) = delete;
+            LayeredProperties& operator=(const LayeredProperties&) = delete;
+            LayeredProperties(LayeredProperties&&) = default;
+            LayeredProperties& operator=(LayeredProperties&&) = default;
+
+            // Adds a layer above every existing one and returns its index
+            size_t add(std::string name, Properties properties) {
+                size_t layer = layers_.size();
+                const Properties& stored = layers_.emplace_back(Layer{ std::move(name), std::move(properties) }).properties;
+                reserve(entries_.size() + stored.size());
+                for (const PropertiesEntry& entry : stored.entries()) {
+                    put(entry.key, entry.value, layer);
+                }
+                return layer;
+            }
+
+            /**
+             * Adds the environment variables starting with prefix as a layer.  The prefix is removed, the
+             * rest lower cased and '_' replaced by '.': with prefix "SERVICE_", SERVICE_HTTP_PORT sets
+             * http.port.  variables is a null terminated array of NAME=value strings.
+             */
+            size_t add_environment(std::string name, std::string_view prefix, const char* const* variables) {
+                std::string text;
+                for (; variables != nullptr && *variables != nullptr; ++variables) {
+                    std::string_view variable(*variables);
+                    size_t equals = variable.find('=');
+                    if (equals == std::string_view::npos || equals <= prefix.size() || !variable.starts_with(prefix)) {
+                        continue;
+                    }
+                    std::string key(variable.substr(prefix.size(), equals - prefix.size()));
+                    for (char& c : key) {
+                        c = c == '_' ? '.' : static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+                    }
+                    detail::properties_append_line(text, key, variable.substr(equals + 1));
+                }
+                return add_text(std::move(name), std::move(text));
+            }
+
+            // As above, from the environment of the process
+            size_t add_environment(std::string name, std::string_view prefix) {
+#ifdef _WIN32
+                return add_environment(std::move(name), prefix, _environ);
+#else
+                return add_environment(std::move(name), prefix, environ);
+#endif
+            }
+
+            /**
+             * Adds command line options as a layer: --key=value and -Dkey=value set key, a bare --key sets
+             * it to "true".  Other arguments, and argv[0], are ignored.
+             */
+            size_t add_arguments(std::string name, int argc, const char* const* argv) {
+                std::string text;
+                for (int i = 1; i < argc; ++i) {
+                    std::string_view argument(argv[i]);
+                    if (argument.starts_with("--") && argument.size() > 2) {
+                        argument.remove_prefix(2);
+                    } else if (argument.starts_with("-D") && argument.size() > 2) {
+                        argument.remove_prefix(2);
+                    } else {
+                        continue;
+                    }
+                    size_t equals = argument.find('=');
+                    if (equals == std::string_view::npos) {
+                        detail::properties_append_line(text, argument, "true");
+                    } else if (equals > 0) {
+                        detail::properties_append_line(text, argument.substr(0, equals), argument.substr(equals + 1));
+                    }
+                }
+                return add_text(std::move(name), std::move(text));
+            }
+
+            std::optional<std::string_view> get(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    return std::nullopt;
+                }
+                return entries_[index].value;
+            }
+
+            std::string_view get(std::string_view key, std::string_view fallback) const {
+                size_t index = find(key);
+                return index == NOT_FOUND ? fallback : entries_[index].value;
+            }
+
+            std::string_view at(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                return entries_[index].value;
+            }
+
+            /**
+             * The winning value as T, parsed and cached by the layer that holds it; see Properties::get<T>.
+             * Throws std::out_of_range if the key is missing and std::runtime_error if it does not parse.
+             */
+            template <typename T>
+            T get(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                return layers_[entries_[index].layer].properties.template get<T>(key);
+            }
+
+            template <typename T>
+            T get(std::string_view key, std::type_identity_t<T> fallback) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    return fallback;
+                }
+                return layers_[entries_[index].layer].properties.template get<T>(key, fallback);
+            }
+
+            bool contains(std::string_view key) const {
+                return find(key) != NOT_FOUND;
+            }
+
+            // Index of the layer the value of key comes from
+            std::optional<size_t> layer_of(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    return std::nullopt;
+                }
+                return entries_[index].layer;
+            }
+
+            const std::string& layer_name(size_t layer) const { return layers_.at(layer).name; }
+            const Properties& layer(size_t layer) const { return layers_.at(layer).properties; }
+            size_t layer_count() const { return layers_.size(); }
+
+            size_t size() const { return entries_.size(); }
+            bool empty() const { return entries_.empty(); }
+
+            // Winning entries, in order of first definition across the layers
+            const std::vector<LayeredEntry>& entries() const { return entries_; }
+
+        private:
+            static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+            struct Layer {
+                std::string name;
+                Properties properties;
+            };
+
+            size_t add_text(std::string name, std::string text) {
+                Properties properties;
+                properties.parse_owned(std::move(text));
+                return add(std::move(name), std::move(properties));
+            }
+
+            size_t find(std::string_view key) const {
+                if (slots_.empty()) {
+                    return NOT_FOUND;
+                }
+                uint64_t hash = detail::properties_hash(key);
+                size_t mask = slots_.size() - 1;
+                for (size_t slot = hash & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+                    size_t index = slots_[slot] - 1;
+                    if (hashes_[index] == hash && entries_[index].key == key) {
+                        return index;
+                    }
+                }
+                return NOT_FOUND;
+            }
+
+            // Grows the table so count entries keep the load factor at most 1/2
+            void reserve(size_t count) {
+                size_t capacity = slots_.empty() ? 8 : slots_.size();
+                while (capacity < count * 2) {
+                    capacity <<= 1;
+                }
+                if (capacity == slots_.size()) {
+                    return;
+                }
+                slots_.assign(capacity, 0);
+                size_t mask = capacity - 1;
+                for (size_t i = 0; i < entries_.size(); ++i) {
+                    size_t slot = hashes_[i] & mask;
+                    while (slots_[slot] != 0) {
+                        slot = (slot + 1) & mask;
+                    }
+                    slots_[slot] = static_cast<uint32_t>(i + 1);
+                }
+            }
+
+            void put(std::string_view key, std::string_view value, size_t layer) {
+                uint64_t hash = detail::properties_hash(key);
+                size_t mask = slots_.size() - 1;
+                size_t slot = hash & mask;
+                for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+                    size_t index = slots_[slot] - 1;
+                    if (hashes_[index] == hash && entries_[index].key == key) {
+                        entries_[index].value = value;
+                        entries_[index].layer = layer;
+                        return;
+                    }
+                }
+                entries_.push_back(LayeredEntry{ key, value, layer });
+                hashes_.push_back(hash);
+                slots_[slot] = static_cast<uint32_t>(entries_.size());
+            }
+
+            std::deque<Layer> layers_;                  // A deque, so adding a layer keeps views into the others
+            std::vector<LayeredEntry> entries_;
+            std::vector<uint64_t> hashes_;              // Hash of each entry's key
+            std::vector<uint32_t> slots_;               // Entry index + 1, 0 for an empty slot
+    };
+
+} // namespace pb
@@ -1 +1,35 @@
-// dummy header file for library.
\ No newline at end of file
+/**
+ * Every public header of the library, for consumers that want all of it.
+ * Parsers, codecs and the string classifiers are compiled into the pb-cpp-data library; headers keep
+ * the declarations, the templates and the small inline helpers.
+ */
+
+
+#pragma once
+
+#include <pb/arrow.h>
+#include <pb/async.h>
+#include <pb/binding.h>
+#include <pb/blob.h>
+#include <pb/blob_archive.h>
+#include <pb/blob_compare.h>
+#include <pb/blob_schema.h>
+#include <pb/cbor.h>
+#include <pb/compressed_io.h>
+#include <pb/config_image.h>
+#include <pb/cpu.h>
+#include <pb/csv.h>
+#include <pb/delimited.h>
+#include <pb/executor.h>
+#include <pb/io.h>
+#include <pb/json.h>
+#include <pb/layered_properties.h>
+#include <pb/lz4.h>
+#include <pb/mapped_file.h>
+#include <pb/memory.h>
+#include <pb/msgpack.h>
+#include <pb/ndjson.h>
+#include <pb/properties.h>
+#include <pb/string_util.h>
+#include <pb/visitor.h>
+#include <pb/watched_properties.h>
@@ -0,0 +1,28 @@
+/**
+ * Dependency free implementation of the LZ4 block format.
+ * The compressor is a greedy single hash table matcher, in the spirit of LZ4's fast mode.  Its output
+ * can be decoded by any LZ4 block decoder and lz4_decompress_block accepts blocks from any LZ4 encoder.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace pb {
+
+    /**
+     * Compresses size bytes from src into out as one LZ4 block, replacing its contents.
+     */
+    void lz4_compress_block(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+    /**
+     * Decompresses one LZ4 block into dst, which must be exactly the original size.  Throws
+     * std::runtime_error if the block is corrupt or does not decode to exactly dst_size bytes.
+     */
+    void lz4_decompress_block(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+
+} // namespace pb
@@ -0,0 +1,123 @@
+/**
+ * Read only memory mapping of a whole file.
+ * Parsers that keep views into their input map the file instead of reading it, so loading costs a
+ * page table update and pages are only touched as they are parsed.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace pb {
+
+    /**
+     * MappedFile: maps a file read only for the lifetime of the object.  An empty file maps to an
+     * empty view.  Throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    class MappedFile {
+        public:
+            MappedFile() = default;
+
+            explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+                HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                          FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    throw std::runtime_error("Cannot open file: " + path);
+                }
+                LARGE_INTEGER size;
+                if (!GetFileSizeEx(file, &size)) {
+                    CloseHandle(file);
+                    throw std::runtime_error("Cannot read the size of file: " + path);
+                }
+                size_ = static_cast<size_t>(size.QuadPart);
+                if (size_ > 0) {
+                    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    if (mapping != nullptr) {
+                        data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                        CloseHandle(mapping);
+                    }
+                }
+                CloseHandle(file);
+#else
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    throw std::runtime_error("Cannot open file: " + path);
+                }
+                struct stat info;
+                if (::fstat(fd, &info) != 0) {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot read the size of file: " + path);
+                }
+                size_ = static_cast<size_t>(info.st_size);
+                if (size_ > 0) {
+                    void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    data_ = mapping == MAP_FAILED ? nullptr : static_cast<const char*>(mapping);
+                }
+                ::close(fd);
+#endif
+                if (size_ > 0 && data_ == nullptr) {
+                    throw std::runtime_error("Cannot map file: " + path);
+                }
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            MappedFile(MappedFile&& other) noexcept
+                : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+            MappedFile& operator=(MappedFile&& other) noexcept {
+                if (this != &other) {
+                    unmap();
+                    data_ = std::exchange(other.data_, nullptr);
+                    size_ = std::exchange(other.size_, 0);
+                }
+                return *this;
+            }
+
+            ~MappedFile() {
+                unmap();
+            }
+
+            const char* data() const { return data_; }
+            size_t size() const { return size_; }
+            std::string_view view() const { return std::string_view(data_, size_); }
+
+        private:
+            void unmap() {
+                if (data_ == nullptr) {
+                    return;
+                }
+#ifdef _WIN32
+                UnmapViewOfFile(data_);
+#else
+                ::munmap(const_cast<char*>(data_), size_);
+#endif
+                data_ = nullptr;
+                size_ = 0;
+            }
+
+            const char* data_ = nullptr;
+            size_t size_ = 0;
+    };
+
+} // namespace pb
@@ -9,6 +9,9 @@
 
 #include <stdexcept>
 #include <cstddef> // for size_t
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <algorithm> // for std::min
 #include <mutex>
@@ -163,6 +166,12 @@ namespace pb {
                 std::lock_guard<std::recursive_mutex> lock(mutex_);
                 return current_size_;
             }
+
+            // The buffer itself, nullptr before initialization, valid until the memory grows or is re-initialized
+            const void* data() {
+                std::lock_guard<std::recursive_mutex> lock(mutex_);
+                return data_;
+            }
             
 
         protected:
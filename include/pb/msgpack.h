@@ -0,0 +1,29 @@
+/**
+ * MessagePack reader and writer for Blob.
+ * MessagePack types map directly onto BlobElementDataType, str and bin payloads are copied in bulk and
+ * the timestamp extension (type -1) maps onto DATE.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <pb/blob.h>
+
+
+namespace pb {
+
+    /**
+     * Parses a single MessagePack document into a Blob.  Throws std::runtime_error on malformed input,
+     * non string map keys and extension types other than timestamp.
+     */
+    Blob read_msgpack(std::span<const uint8_t> data);
+
+    std::vector<uint8_t> write_msgpack(const BlobView& value);
+
+    std::vector<uint8_t> write_msgpack(const Blob& blob);
+
+} // namespace pb
@@ -0,0 +1,75 @@
+/**
+ * Parallel Blob construction from newline delimited JSON (one JSON value per line).
+ * The input is split on newline boundaries into many more chunks than threads.  Tasks on an Executor
+ * take chunks as they finish their previous one, parse them into task local Blob fragments and check
+ * whether their records shred into columns.  The fragments are then written into one ARRAY, again in
+ * parallel, as columns when every fragment shreds the same way and as rows otherwise.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/blob.h>
+#include <pb/executor.h>
+#include <pb/io.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        // A malformed record, its line numbered from the first_line given to ndjson_parse_chunk
+        class NdjsonLineError : public std::runtime_error {
+            public:
+                NdjsonLineError(const std::string& error, size_t line)
+                    : std::runtime_error(error + " on NDJSON line " + std::to_string(line)), error_(error), line_(line) {}
+
+                const std::string& error() const { return error_; }
+                size_t line() const { return line_; }
+
+            private:
+                std::string error_;
+                size_t line_;
+        };
+
+        struct NdjsonFragment {
+            Blob records;                           // Row encoded ARRAY of the chunk's records
+            size_t rows = 0;
+            size_t lines = 0;                       // Newlines in the chunk, blank lines included
+            bool nested_columnar = false;           // A record holds columnar data, which must stay aligned when copied
+
+            // How the records shred, names is empty when they do not
+            std::vector<std::string> names;         // In the order of the first record
+            std::vector<BlobElementDataType> types; // NULL_VALUE for columns that are only nulls
+            std::vector<size_t> string_bytes;       // Total STRING or BINARY bytes per column
+        };
+
+        // Parses every non blank line of chunk into an element of a row encoded ARRAY.  Errors number lines from first_line + 1.
+        NdjsonFragment ndjson_parse_chunk(std::string_view chunk, size_t first_line);
+
+        // Writes parsed chunks into the ARRAY read_ndjson returns, on at most threads tasks of executor
+        Blob ndjson_concatenate(const std::vector<NdjsonFragment>& fragments, Executor& executor, size_t threads);
+
+    } // namespace detail
+
+    /**
+     * Parses NDJSON into a Blob whose root is an ARRAY with one element per non blank line, on at most
+     * threads threads of Executor::shared(), the caller included (0 for all of them).  Homogeneous
+     * records are shredded into columns as usual.  Throws std::runtime_error naming the line of the
+     * first malformed record.
+     */
+    Blob read_ndjson(std::string_view data, size_t threads = 0);
+
+    // As above, on the workers of executor
+    Blob read_ndjson(std::string_view data, Executor& executor, size_t threads = 0);
+
+    // As above, from the rest of source
+    Blob read_ndjson(Source& source, size_t threads = 0);
+
+} // namespace pb
@@ -0,0 +1,663 @@
+/**
+ * Reader for Java style .properties files.
+ * The file is memory mapped and parsed in one pass, line breaks and separators found with the shared
+ * DelimiterScanner.  Keys and values are string_views into the mapping; only entries with escapes or
+ * continuation lines are decoded into storage owned by the Properties.
+ * Lookups go through an open addressing hash index built once after parsing, prefix and dotted subtree
+ * queries through a key ordered index.  Typed reads parse a value on first use and cache the result next
+ * to the entry.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <pb/delimited.h>
+#include <pb/io.h>
+#include <pb/mapped_file.h>
+#include <pb/string_util.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        inline uint64_t properties_hash(std::string_view key) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (char c : key) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+            }
+            return hash ^ (hash >> 29);
+        }
+
+        // Orders '.' before every other character, so a key's dotted subtree sorts right after the key
+        inline uint32_t properties_rank(char c) {
+            return c == '.' ? 0 : static_cast<uint32_t>(static_cast<uint8_t>(c)) + 1;
+        }
+
+        inline int properties_compare(std::string_view a, std::string_view b) {
+            size_t common = std::min(a.size(), b.size());
+            for (size_t i = 0; i < common; ++i) {
+                if (a[i] != b[i]) {
+                    return properties_rank(a[i]) < properties_rank(b[i]) ? -1 : 1;
+                }
+            }
+            return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+        }
+
+        inline bool properties_is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\f';
+        }
+
+        inline bool properties_is_separator(char c) {
+            return c == '=' || c == ':' || properties_is_space(c);
+        }
+
+        inline void properties_append_utf8(std::string& out, uint32_t code) {
+            if (code < 0x80) {
+                out.push_back(static_cast<char>(code));
+            } else if (code < 0x800) {
+                out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            } else if (code < 0x10000) {
+                out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            } else {
+                out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+            }
+        }
+
+        template <typename T>
+        struct properties_is_duration : std::false_type {};
+
+        template <typename Rep, typename Period>
+        struct properties_is_duration<std::chrono::duration<Rep, Period>> : std::true_type {};
+
+        template <typename T>
+        struct properties_is_sys_time : std::false_type {};
+
+        template <typename Duration>
+        struct properties_is_sys_time<std::chrono::time_point<std::chrono::system_clock, Duration>> : std::true_type {};
+
+        enum PropertiesValueKind : uint32_t {
+            PROPERTIES_BOOLEAN = 0,
+            PROPERTIES_INTEGER = 1,
+            PROPERTIES_DOUBLE = 2,
+            PROPERTIES_DURATION = 3,
+            PROPERTIES_DATE = 4,
+        };
+
+        /**
+         * Typed values parsed from one entry, one word per kind.  state holds a parsed and a valid bit
+         * per kind; a word is written before its bits are published with release, so readers that see
+         * the bits with acquire see the word.  Two threads parsing the same entry store the same value.
+         */
+        struct PropertiesCachedValue {
+            std::atomic<uint32_t> state{ 0 };
+            std::atomic<int64_t> words[5]{};
+        };
+
+    } // namespace detail
+
+    struct PropertiesEntry {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    /**
+     * PropertiesRange: a contiguous run of the key ordered index, as PropertiesEntry references.  Views
+     * stay valid for the lifetime of the Properties and iterating does not allocate.
+     */
+    class PropertiesRange {
+        public:
+            class iterator {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = PropertiesEntry;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const PropertiesEntry*;
+                    using reference = const PropertiesEntry&;
+
+                    iterator() = default;
+                    iterator(const uint32_t* position, const PropertiesEntry* entries)
+                        : position_(position), entries_(entries) {}
+
+                    reference operator*() const { return entries_[*position_]; }
+                    pointer operator->() const { return &entries_[*position_]; }
+
+                    iterator& operator++() {
+                        ++position_;
+                        return *this;
+                    }
+
+                    iterator operator++(int) {
+                        iterator previous = *this;
+                        ++position_;
+                        return previous;
+                    }
+
+                    bool operator==(const iterator& other) const { return position_ == other.position_; }
+
+                private:
+                    const uint32_t* position_ = nullptr;
+                    const PropertiesEntry* entries_ = nullptr;
+            };
+
+            PropertiesRange() = default;
+            PropertiesRange(const uint32_t* first, const uint32_t* last, const PropertiesEntry* entries)
+                : first_(first), last_(last), entries_(entries) {}
+
+            iterator begin() const { return iterator(first_, entries_); }
+            iterator end() const { return iterator(last_, entries_); }
+            size_t size() const { return static_cast<size_t>(last_ - first_); }
+            bool empty() const { return first_ == last_; }
+
+        private:
+            const uint32_t* first_ = nullptr;
+            const uint32_t* last_ = nullptr;
+            const PropertiesEntry* entries_ = nullptr;
+    };
+
+    /**
+     * Properties: key/value pairs of a .properties file, in file order.  Supports '#' and '!' comments,
+     * '=', ':' or whitespace separators, bare keys (empty value), continuation lines ending in a
+     * backslash and the \t \n \r \f \uXXXX escapes.  A repeated key keeps its first position and its
+     * last value.  Moving keeps every view valid; copying is not supported.
+     */
+    class Properties {
+        public:
+            Properties() = default;
+
+            // Maps and parses the file at path.  Throws std::runtime_error if it cannot be read.
+            explicit Properties(const std::string& path) : file_(path) {
+                parse_text(file_.view());
+            }
+
+            Properties(const Properties&) = delete;
+            Properties& operator=(const Properties&) = delete;
+            Properties(Properties&&) = default;
+            Properties& operator=(Properties&&) = default;
+
+            /**
+             * Parses text, replacing the current entries.  Views are taken into text, which must outlive
+             * the Properties.
+             */
+            void parse(std::string_view text) {
+                file_ = MappedFile();
+                owned_.reset();
+                parse_text(text);
+            }
+
+            // Parses text, replacing the current entries.  The Properties keeps text, views stay valid.
+            void parse_owned(std::string text) {
+                file_ = MappedFile();
+                owned_ = std::make_unique<std::string>(std::move(text));
+                parse_text(*owned_);
+            }
+
+            // Parses the rest of source, keeping a copy of the text since the source may not outlive the Properties
+            void parse(Source& source) {
+                std::string storage;
+                std::string_view text = read_all(source, storage);
+                parse_owned(text.data() == storage.data() ? std::move(storage) : std::string(text));
+            }
+
+            std::optional<std::string_view> get(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    return std::nullopt;
+                }
+                return entries_[index].value;
+            }
+
+            std::string_view get(std::string_view key, std::string_view fallback) const {
+                size_t index = find(key);
+                return index == NOT_FOUND ? fallback : entries_[index].value;
+            }
+
+            std::string_view at(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                return entries_[index].value;
+            }
+
+            /**
+             * The value of key as T: bool, an integer type, float or double, a std::chrono::duration
+             * ("250ms", "1.5s", "2h", plain numbers are milliseconds) or a std::chrono::sys_time (ISO
+             * 8601).  The value is parsed on the first read of each kind and cached, later reads are a
+             * hash lookup and a load.  Throws std::out_of_range if the key is missing and
+             * std::runtime_error if the value does not parse or does not fit T.  Safe to call from
+             * several threads.
+             */
+            template <typename T>
+            T get(std::string_view key) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    throw std::out_of_range("Property not found: " + std::string(key));
+                }
+                std::optional<T> value = typed<T>(index);
+                if (!value) {
+                    throw std::runtime_error("Property has an invalid value for the requested type: " + std::string(key));
+                }
+                return *value;
+            }
+
+            // As get<T>(key), returning fallback when the key is missing or its value is not a valid T
+            template <typename T>
+            T get(std::string_view key, std::type_identity_t<T> fallback) const {
+                size_t index = find(key);
+                if (index == NOT_FOUND) {
+                    return fallback;
+                }
+                std::optional<T> value = typed<T>(index);
+                return value ? *value : fallback;
+            }
+
+            bool contains(std::string_view key) const {
+                return find(key) != NOT_FOUND;
+            }
+
+            size_t size() const { return entries_.size(); }
+            bool empty() const { return entries_.empty(); }
+
+            const std::vector<PropertiesEntry>& entries() const { return entries_; }
+
+            // Every entry in key order
+            PropertiesRange sorted() const {
+                return range(sorted_.begin(), sorted_.end());
+            }
+
+            /**
+             * Entries whose key starts with prefix, in key order.  Two binary searches over the key
+             * ordered index, no allocation.
+             */
+            PropertiesRange with_prefix(std::string_view prefix) const {
+                auto first = std::partition_point(sorted_.begin(), sorted_.end(), [&](uint32_t index) {
+                    return detail::properties_compare(entries_[index].key, prefix) < 0;
+                });
+                auto last = std::partition_point(first, sorted_.end(), [&](uint32_t index) {
+                    return entries_[index].key.starts_with(prefix);
+                });
+                return range(first, last);
+            }
+
+            /**
+             * Entries below the dotted path: "deployment.security" gives every "deployment.security.*"
+             * key but not "deployment.security" itself.  An empty path gives every entry.
+             */
+            PropertiesRange subtree(std::string_view path) const {
+                auto [first, last] = subtree_bounds(path);
+                return range(first, last);
+            }
+
+            /**
+             * Calls f(std::string_view segment) once for every distinct segment directly below the dotted
+             * path, in key order: "deployment" has the children "browser", "security", ...  Each child
+             * costs one binary search to skip past its own subtree.
+             */
+            template <typename F>
+            void for_each_child(std::string_view path, F&& f) const {
+                auto [first, last] = subtree_bounds(path);
+                size_t skip = path.empty() ? 0 : path.size() + 1;
+                while (first != last) {
+                    std::string_view key = entries_[*first].key;
+                    size_t dot = key.find('.', skip);
+                    std::string_view segment = dot == std::string_view::npos ? key.substr(skip) : key.substr(skip, dot - skip);
+                    f(segment);
+                    std::string_view head = key.substr(0, skip + segment.size());
+                    first = std::partition_point(first, last, [&](uint32_t index) {
+                        std::string_view other = entries_[index].key;
+                        return other.starts_with(head) && (other.size() == head.size() || other[head.size()] == '.');
+                    });
+                }
+            }
+
+        private:
+            static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+            using SortedIterator = std::vector<uint32_t>::const_iterator;
+
+            PropertiesRange range(SortedIterator first, SortedIterator last) const {
+                const uint32_t* base = sorted_.data();
+                return PropertiesRange(base + (first - sorted_.begin()), base + (last - sorted_.begin()), entries_.data());
+            }
+
+            std::pair<SortedIterator, SortedIterator> subtree_bounds(std::string_view path) const {
+                if (path.empty()) {
+                    return { sorted_.begin(), sorted_.end() };
+                }
+                // Finds the first key not below path + ".", without building that string
+                auto first = std::partition_point(sorted_.begin(), sorted_.end(), [&](uint32_t index) {
+                    std::string_view key = entries_[index].key;
+                    int order = detail::properties_compare(key.substr(0, path.size()), path);
+                    return order < 0 || (order == 0 && key.size() <= path.size());
+                });
+                auto last = std::partition_point(first, sorted_.end(), [&](uint32_t index) {
+                    std::string_view key = entries_[index].key;
+                    return key.size() > path.size() && key[path.size()] == '.' && key.starts_with(path);
+                });
+                return { first, last };
+            }
+
+            size_t find(std::string_view key) const {
+                if (slots_.empty()) {
+                    return NOT_FOUND;
+                }
+                uint64_t hash = detail::properties_hash(key);
+                size_t mask = slots_.size() - 1;
+                for (size_t slot = hash & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+                    size_t index = slots_[slot] - 1;
+                    if (hashes_[index] == hash && entries_[index].key == key) {
+                        return index;
+                    }
+                }
+                return NOT_FOUND;
+            }
+
+            template <typename T>
+            std::optional<T> typed(size_t index) const {
+                if constexpr (std::is_same_v<T, std::string_view>) {
+                    return entries_[index].value;
+                } else if constexpr (std::is_same_v<T, std::string>) {
+                    return std::string(entries_[index].value);
+                } else if constexpr (std::is_same_v<T, bool>) {
+                    std::optional<int64_t> word = cached(index, detail::PROPERTIES_BOOLEAN, [](std::string_view text) {
+                        std::optional<bool> value = parse_boolean(text);
+                        return value ? std::optional<int64_t>(*value) : std::nullopt;
+                    });
+                    return word ? std::optional<bool>(*word != 0) : std::nullopt;
+                } else if constexpr (std::is_integral_v<T>) {
+                    std::optional<int64_t> word = cached(index, detail::PROPERTIES_INTEGER, [](std::string_view text) {
+                        return parse_integer(text);
+                    });
+                    return word && std::in_range<T>(*word) ? std::optional<T>(static_cast<T>(*word)) : std::nullopt;
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    std::optional<int64_t> word = cached(index, detail::PROPERTIES_DOUBLE, [](std::string_view text) {
+                        std::optional<double> value = parse_double(text);
+                        return value ? std::optional<int64_t>(std::bit_cast<int64_t>(*value)) : std::nullopt;
+                    });
+                    return word ? std::optional<T>(static_cast<T>(std::bit_cast<double>(*word))) : std::nullopt;
+                } else if constexpr (detail::properties_is_duration<T>::value) {
+                    std::optional<int64_t> word = cached(index, detail::PROPERTIES_DURATION, [](std::string_view text) {
+                        std::optional<std::chrono::nanoseconds> value = parse_duration(text);
+                        return value ? std::optional<int64_t>(value->count()) : std::nullopt;
+                    });
+                    return word ? std::optional<T>(std::chrono::duration_cast<T>(std::chrono::nanoseconds(*word))) : std::nullopt;
+                } else if constexpr (detail::properties_is_sys_time<T>::value) {
+                    std::optional<int64_t> word = cached(index, detail::PROPERTIES_DATE, [](std::string_view text) {
+                        return parse_iso_date(text);
+                    });
+                    return word ? std::optional<T>(std::chrono::time_point_cast<typename T::duration>(
+                        std::chrono::sys_time<std::chrono::milliseconds>(std::chrono::milliseconds(*word)))) : std::nullopt;
+                } else {
+                    static_assert(std::is_same_v<T, bool>, "Unsupported property value type");
+                }
+            }
+
+            // The cached word of one kind for entry index, parsing the value on first use
+            template <typename Parse>
+            std::optional<int64_t> cached(size_t index, uint32_t kind, Parse parse) const {
+                detail::PropertiesCachedValue& cache = cache_[index];
+                uint32_t parsed = 1u << (2 * kind);
+                uint32_t valid = parsed << 1;
+                uint32_t state = cache.state.load(std::memory_order_acquire);
+                if ((state & parsed) == 0) {
+                    std::optional<int64_t> value = parse(entries_[index].value);
+                    if (value) {
+                        cache.words[kind].store(*value, std::memory_order_relaxed);
+                    }
+                    cache.state.fetch_or(parsed | (value ? valid : 0), std::memory_order_release);
+                    return value;
+                }
+                if ((state & valid) == 0) {
+                    return std::nullopt;
+                }
+                return cache.words[kind].load(std::memory_order_relaxed);
+            }
+
+            // End of the natural line starting at p: the first '\n' or '\r', or end
+            static const char* line_end(const char* p, const char* end) {
+                static const DelimiterScanner line_breaks("\n\r");
+                return line_breaks.find(p, end);
+            }
+
+            // As line_end, also setting escaped if the line holds a backslash
+            static const char* line_end(const char* p, const char* end, bool& escaped) {
+                static const DelimiterScanner line_breaks_and_escapes("\n\r\\");
+                p = line_breaks_and_escapes.find(p, end);
+                while (p < end && *p == '\\') {
+                    escaped = true;
+                    p = line_breaks_and_escapes.find(p + 1, end);
+                }
+                return p;
+            }
+
+            void parse_text(std::string_view text) {
+                entries_.clear();
+                hashes_.clear();
+                slots_.clear();
+                sorted_.clear();
+                decoded_.clear();
+
+                const char* p = text.data();
+                const char* const end = p + text.size();
+                while (p < end) {
+                    while (p < end && detail::properties_is_space(*p)) {
+                        ++p;
+                    }
+                    if (p == end) {
+                        break;
+                    }
+                    if (*p == '\n' || *p == '\r') {
+                        ++p;
+                        continue;
+                    }
+                    if (*p == '#' || *p == '!') {
+                        p = line_end(p, end);
+                        continue;
+                    }
+
+                    // A logical line runs on while a natural line ends in an odd number of backslashes
+                    const char* start = p;
+                    bool escaped = false;
+                    while (true) {
+                        const char* eol = line_end(p, end, escaped);
+                        size_t backslashes = 0;
+                        for (const char* q = eol; q > p && q[-1] == '\\'; --q) {
+                            ++backslashes;
+                        }
+                        p = eol;
+                        if (backslashes % 2 == 0 || eol == end) {
+                            break;
+                        }
+                        p += (p + 1 < end && p[0] == '\r' && p[1] == '\n') ? 2 : 1;
+                    }
+                    if (escaped) {
+                        add_escaped(start, p);
+                    } else {
+                        add_plain(start, p);
+                    }
+                }
+                build_index();
+            }
+
+            // Skips the separator after a key: whitespace, at most one '=' or ':', whitespace
+            static const char* skip_separator(const char* p, const char* stop) {
+                while (p < stop && detail::properties_is_space(*p)) {
+                    ++p;
+                }
+                if (p < stop && (*p == '=' || *p == ':')) {
+                    ++p;
+                }
+                while (p < stop && detail::properties_is_space(*p)) {
+                    ++p;
+                }
+                return p;
+            }
+
+            void add_plain(const char* start, const char* stop) {
+                static const DelimiterScanner separators("=: \t\f");
+                const char* key_end = separators.find(start, stop);
+                const char* value = skip_separator(key_end, stop);
+                add(std::string_view(start, static_cast<size_t>(key_end - start)),
+                    std::string_view(value, static_cast<size_t>(stop - value)));
+            }
+
+            void add_escaped(const char* p, const char* stop) {
+                std::string key;
+                std::string value;
+                std::string* out = &key;
+                while (p < stop) {
+                    char c = *p++;
+                    if (c == '\\') {
+                        if (p == stop) {
+                            break;      // A trailing backslash on the last line is dropped
+                        }
+                        char escape = *p++;
+                        switch (escape) {
+                            case '\r':
+                            case '\n':
+                                if (escape == '\r' && p < stop && *p == '\n') {
+                                    ++p;
+                                }
+                                while (p < stop && detail::properties_is_space(*p)) {
+                                    ++p;
+                                }
+                                break;
+                            case 't': out->push_back('\t'); break;
+                            case 'n': out->push_back('\n'); break;
+                            case 'r': out->push_back('\r'); break;
+                            case 'f': out->push_back('\f'); break;
+                            case 'u': {
+                                uint32_t code = read_hex4(p, stop);
+                                if (code >= 0xd800 && code <= 0xdbff && stop - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                                    const char* low_start = p + 2;
+                                    uint32_t low = read_hex4(low_start, stop);
+                                    if (low >= 0xdc00 && low <= 0xdfff) {
+                                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                                        p = low_start;
+                                    }
+                                }
+                                detail::properties_append_utf8(*out, code);
+                                break;
+                            }
+                            default:
+                                out->push_back(escape);
+                                break;
+                        }
+                        continue;
+                    }
+                    if (out == &key && detail::properties_is_separator(c)) {
+                        p = skip_separator(p - 1, stop);
+                        out = &value;
+                        continue;
+                    }
+                    out->push_back(c);
+                }
+                const std::string& stored_key = decoded_.emplace_back(std::move(key));
+                const std::string& stored_value = decoded_.emplace_back(std::move(value));
+                add(stored_key, stored_value);
+            }
+
+            static uint32_t read_hex4(const char*& p, const char* stop) {
+                if (stop - p < 4) {
+                    throw std::runtime_error("Invalid \\u escape in properties");
+                }
+                uint32_t code = 0;
+                for (int i = 0; i < 4; ++i) {
+                    char c = *p++;
+                    code <<= 4;
+                    if (c >= '0' && c <= '9') {
+                        code |= static_cast<uint32_t>(c - '0');
+                    } else if (c >= 'a' && c <= 'f') {
+                        code |= static_cast<uint32_t>(c - 'a' + 10);
+                    } else if (c >= 'A' && c <= 'F') {
+                        code |= static_cast<uint32_t>(c - 'A' + 10);
+                    } else {
+                        throw std::runtime_error("Invalid \\u escape in properties");
+                    }
+                }
+                return code;
+            }
+
+            void add(std::string_view key, std::string_view value) {
+                entries_.push_back(PropertiesEntry{ key, value });
+            }
+
+            // Sizes the table once for a load factor of at most 1/2 and folds repeated keys
+            void build_index() {
+                size_t capacity = 8;
+                while (capacity < entries_.size() * 2) {
+                    capacity <<= 1;
+                }
+                slots_.assign(capacity, 0);
+                hashes_.resize(entries_.size());
+                size_t mask = capacity - 1;
+                size_t kept = 0;
+                for (size_t i = 0; i < entries_.size(); ++i) {
+                    uint64_t hash = detail::properties_hash(entries_[i].key);
+                    size_t slot = hash & mask;
+                    bool repeated = false;
+                    for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+                        size_t index = slots_[slot] - 1;
+                        if (hashes_[index] == hash && entries_[index].key == entries_[i].key) {
+                            entries_[index].value = entries_[i].value;
+                            repeated = true;
+                            break;
+                        }
+                    }
+                    if (!repeated) {
+                        entries_[kept] = entries_[i];
+                        hashes_[kept] = hash;
+                        slots_[slot] = static_cast<uint32_t>(kept + 1);
+                        ++kept;
+                    }
+                }
+                entries_.resize(kept);
+                hashes_.resize(kept);
+
+                sorted_.resize(kept);
+                for (size_t i = 0; i < kept; ++i) {
+                    sorted_[i] = static_cast<uint32_t>(i);
+                }
+                std::sort(sorted_.begin(), sorted_.end(), [&](uint32_t a, uint32_t b) {
+                    return detail::properties_compare(entries_[a].key, entries_[b].key) < 0;
+                });
+
+                cache_ = std::make_unique<detail::PropertiesCachedValue[]>(kept);
+            }
+
+            MappedFile file_;
+            std::unique_ptr<std::string> owned_;        // Text passed to parse_owned, behind a pointer so moves keep views
+            std::deque<std::string> decoded_;           // Keys and values that needed unescaping
+            std::vector<PropertiesEntry> entries_;
+            std::vector<uint64_t> hashes_;              // Hash of each entry's key
+            std::vector<uint32_t> slots_;               // Entry index + 1, 0 for an empty slot
+            std::vector<uint32_t> sorted_;              // Entry indexes in key order, '.' sorting first
+            std::unique_ptr<detail::PropertiesCachedValue[]> cache_;   // Typed values of each entry, filled on read
+    };
+
+} // namespace pb
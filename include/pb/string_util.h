@@ -1,6 +1,12 @@
+#pragma once
+
 #include <string>
+#include <string_view>
 #include <algorithm>
-#include <regex>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 
 namespace pb {
 
@@ -36,61 +42,46 @@ inline std::string to_lower(const std::string& str) {
  * and optional scientific notation (e.g., "1.23e-4"). It returns true if the string is numeric, 
  * false otherwise.
  */
-inline bool is_numeric(const std::string& str) {
-    static const std::regex pattern(R"(^\s*[-+]?\d*\.?\d+(e[-+]?\d+)?\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_numeric(const std::string& str);
 
 /**
- * This function checks if a string is an integer. It uses a regular expression to match 
+ * This function checks if a string is an integer. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - Optional sign (either + or -)
  *   - One or more digits   
  */
-inline bool is_integer(const std::string& str) {
-    static const std::regex pattern(R"(^\s*[-+]?\d+\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}   
+bool is_integer(const std::string& str);   
 
 /**
- * This function checks if a string is a valid hexadecimal number. It uses a regular expression to match
+ * This function checks if a string is a valid hexadecimal number. It matches
  * the following pattern:       
  *   - Optional whitespace
  *   - 0x or 0X prefix
  *   - One or more hexadecimal digits (0-9, a-f, A-F)
  */
-inline bool is_hexadecimal(const std::string& str) {
-    static const std::regex pattern(R"(^\s*0[xX][0-9a-fA-F]+\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}   
+bool is_hexadecimal(const std::string& str);   
 
 /**
- * This function checks if a string is a valid octal number. It uses a regular expression to match
+ * This function checks if a string is a valid octal number. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - 0o or 0O prefix
  *   - One or more octal digits (0-7)
  */
-inline bool is_octal(const std::string& str) {
-    static const std::regex pattern(R"(^\s*0[oO]?[0-7]+\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}   
+bool is_octal(const std::string& str);   
 
 /**
- * This function checks if a string is a valid binary number. It uses a regular expression to match
+ * This function checks if a string is a valid binary number. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - 0b or 0B prefix
  *   - One or more binary digits (0 or 1)
  */
-inline bool is_binary(const std::string& str) {
-    static const std::regex pattern(R"(^\s*0[bB][01]+\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_binary(const std::string& str);
 
 /**
- * This function checks if a string is a valid double-precision floating-point number. It uses a regular expression to match
+ * This function checks if a string is a valid double-precision floating-point number. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - Optional sign (either + or -)
@@ -101,7 +92,7 @@ inline bool is_binary(const std::string& str) {
 
 /**
  * This function checks if a string is a valid double-precision floating-point number that requires a decimal point.
- * It uses a regular expression to match the following pattern:
+ * It matches the following pattern:
  *   - Optional whitespace
  *   - Optional sign (either + or -)
  *   - One or more digits before the decimal point
@@ -109,14 +100,11 @@ inline bool is_binary(const std::string& str) {
  *   - One or more digits after the decimal point
  *   - Optional exponent part (e.g., e-10)
  */
-inline bool is_double(const std::string& str) {
-    static const std::regex pattern(R"(^\s*[-+]?\d+\.\d+(e[-+]?\d+)?\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_double(const std::string& str);
 
 /**
  * This function checks if a string is a valid double-precision floating-point number that may or may not have a decimal point.
- * It uses a regular expression to match the following pattern:
+ * It matches the following pattern:
  *   - Optional whitespace
  *   - Optional sign (either + or -)    
  *   - One or more digits before the decimal point
@@ -124,25 +112,19 @@ inline bool is_double(const std::string& str) {
  *   - One or more digits after the decimal point
  *   - Optional exponent part (e.g., e-10)
  */
-inline bool is_double_with_optional_decimal(const std::string& str) {
-    static const std::regex pattern(R"(^\s*[-+]?\d*\.?\d+(e[-+]?\d+)?\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_double_with_optional_decimal(const std::string& str);
 
 /**
- * This function checks if a string is a valid boolean value. It uses a regular expression to match
+ * This function checks if a string is a valid boolean value. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - The keywords "true" or "false"
  *   - The integer values 1 or 0
  */
-inline bool is_boolean(const std::string& str) {
-    static const std::regex pattern(R"(^\s*(true|false|1|0)\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_boolean(const std::string& str);
 
 /**
- * This function checks if a string is a valid real number. It uses a regular expression to match
+ * This function checks if a string is a valid real number. It matches
  * the following pattern:
  *   - Optional whitespace
  *   - Optional sign (either + or -)
@@ -150,15 +132,11 @@ inline bool is_boolean(const std::string& str) {
  *   - Optional decimal point followed by one or more digits
  *   - Optional exponent part (e.g., e-10)
  */
-inline bool is_real_number(const std::string& str) {
-    static const std::regex pattern(R"(^\s*[-+]?\d+(\.\d+)?([eE][-+]?\d+)?\s*$)", std::regex::icase);
-    return std::regex_match(str, pattern);
-}
+bool is_real_number(const std::string& str);
 
 /**
- * The is_date function in this file checks if a given string matches common date formats using 
- * regular expressions. It trims whitespace from the input string and then tests it against several 
- * regex patterns, including:
+ * The is_date function in this file checks if a given string matches common date formats. It trims
+ * whitespace from the input string and then tests it against several patterns, including:
  *
  * YYYY-MM-DD or YYYY/MM/DD
  * DD-MM-YYYY or DD/MM/YYYY
@@ -169,29 +147,208 @@ inline bool is_real_number(const std::string& str) {
  * 
  * If the string matches any of these patterns, the function returns true; otherwise, it returns false.
  */
-inline bool is_date(const std::string& str) {
-    static const std::regex date_patterns[] = {
-        // YYYY-MM-DD or YYYY/MM/DD
-        std::regex(R"(^\d{4}[-/]\d{2}[-/]\d{2}$)"),
-        // DD-MM-YYYY or DD/MM/YYYY
-        std::regex(R"(^\d{2}[-/]\d{2}[-/]\d{4}$)"),
-        // MM-DD-YYYY or MM/DD/YYYY
-        std::regex(R"(^\d{2}[-/]\d{2}[-/]\d{4}$)"),
-        // YYYY-MM-DD HH:MM:SS (with optional T and milliseconds)
-        std::regex(R"(^\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(\.\d+)?(Z|[+-]\d{2}:\d{2})?$)"),
-        // ISO 8601 (date only or datetime)
-        std::regex(R"(^\d{4}-\d{2}-\d{2}(T\d{2}:\d{2}:\d{2}(.\d+)?(Z|[+-]\d{2}:\d{2})?)?$)"),
-        // Month name formats (e.g., Jan 1, 2020 or 1 Jan 2020)
-        std::regex(R"(^([A-Za-z]{3,9})\s+\d{1,2},?\s+\d{4}$)"),
-        std::regex(R"(^\d{1,2}\s+([A-Za-z]{3,9})\s+\d{4}$)")
+bool is_date(const std::string& str);
+
+/*
+ * The is_* checks above are hand written scanners, compiled in the library.  The parse_* functions
+ * below validate and convert in one pass, for values that are read on hot paths.  Surrounding
+ * whitespace is ignored like in the is_* checks.
+ */
+
+inline std::string_view trim_view(std::string_view str) {
+    size_t start = str.find_first_not_of(" \t\n\r\f\v");
+    if (start == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t end = str.find_last_not_of(" \t\n\r\f\v");
+    return str.substr(start, end - start + 1);
+}
+
+/**
+ * This function parses "true" or "false" in any case, or 1 or 0, the values is_boolean accepts.
+ */
+inline std::optional<bool> parse_boolean(std::string_view str) {
+    str = trim_view(str);
+    auto equals = [&](std::string_view word) {
+        return str.size() == word.size() && std::equal(str.begin(), str.end(), word.begin(),
+            [](char a, char b) { return (a | 0x20) == b; });
     };
+    if (str == "1" || equals("true")) {
+        return true;
+    }
+    if (str == "0" || equals("false")) {
+        return false;
+    }
+    return std::nullopt;
+}
 
-    std::string s = pb::trim(str);
-    for (const auto& pat : date_patterns) {
-        if (std::regex_match(s, pat)) {
+/**
+ * This function parses a decimal integer with an optional sign, the values is_integer accepts, and
+ * fails if the value does not fit in an int64_t.
+ */
+inline std::optional<int64_t> parse_integer(std::string_view str) {
+    str = trim_view(str);
+    if (!str.empty() && str[0] == '+') {
+        str.remove_prefix(1);
+        if (!str.empty() && str[0] == '-') {
+            return std::nullopt;
+        }
+    }
+    int64_t value;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (str.empty() || result.ec != std::errc() || result.ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/**
+ * This function parses a real number with an optional sign, fraction and exponent, the values
+ * is_real_number and is_double_with_optional_decimal accept.  inf and nan are rejected.
+ */
+inline std::optional<double> parse_double(std::string_view str) {
+    str = trim_view(str);
+    if (!str.empty() && str[0] == '+') {
+        str.remove_prefix(1);
+    }
+    size_t digit = str.empty() || str[0] != '-' ? 0 : 1;
+    if (digit >= str.size() || !((str[digit] >= '0' && str[digit] <= '9') || str[digit] == '.')) {
+        return std::nullopt;
+    }
+    double value;
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec != std::errc() || result.ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/**
+ * This function parses a duration: a number, possibly with a fraction, followed by a unit of ns, us,
+ * ms, s, m or min, h or d.  A number without a unit is in milliseconds.  For example "250ms", "1.5s"
+ * or "2h".
+ */
+inline std::optional<std::chrono::nanoseconds> parse_duration(std::string_view str) {
+    str = trim_view(str);
+    size_t unit_start = str.find_first_not_of("0123456789.+-");
+    std::string_view number = str.substr(0, unit_start);
+    std::string_view unit = unit_start == std::string_view::npos ? std::string_view() : trim_view(str.substr(unit_start));
+
+    double nanoseconds_per_unit;
+    if (unit == "ns") nanoseconds_per_unit = 1;
+    else if (unit == "us") nanoseconds_per_unit = 1e3;
+    else if (unit == "ms" || unit.empty()) nanoseconds_per_unit = 1e6;
+    else if (unit == "s") nanoseconds_per_unit = 1e9;
+    else if (unit == "m" || unit == "min") nanoseconds_per_unit = 60e9;
+    else if (unit == "h") nanoseconds_per_unit = 3600e9;
+    else if (unit == "d") nanoseconds_per_unit = 86400e9;
+    else return std::nullopt;
+
+    if (std::optional<int64_t> whole = parse_integer(number)) {
+        // Integral amounts stay exact
+        int64_t per_unit = static_cast<int64_t>(nanoseconds_per_unit);
+        if (*whole > INT64_MAX / per_unit || *whole < INT64_MIN / per_unit) {
+            return std::nullopt;
+        }
+        return std::chrono::nanoseconds(*whole * per_unit);
+    }
+    std::optional<double> amount = parse_double(number);
+    if (!amount) {
+        return std::nullopt;
+    }
+    double nanoseconds = *amount * nanoseconds_per_unit;
+    if (!(nanoseconds > -9.2e18 && nanoseconds < 9.2e18)) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(nanoseconds));
+}
+
+/**
+ * This function parses an ISO 8601 date or date time, "YYYY-MM-DD" optionally followed by 'T' or a
+ * space, "HH:MM", optional ":SS" and fraction, and an optional "Z" or "+HH:MM" offset (UTC when
+ * absent).  It returns milliseconds since the Unix epoch, using the days from civil algorithm by
+ * Howard Hinnant.
+ */
+inline std::optional<int64_t> parse_iso_date(std::string_view str) {
+    str = trim_view(str);
+    size_t position = 0;
+    auto digits = [&](size_t count, int64_t& out) {
+        if (position + count > str.size()) {
+            return false;
+        }
+        out = 0;
+        for (size_t i = 0; i < count; ++i) {
+            char c = str[position + i];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            out = out * 10 + (c - '0');
+        }
+        position += count;
+        return true;
+    };
+    auto expect = [&](char c) {
+        if (position < str.size() && str[position] == c) {
+            ++position;
             return true;
         }
+        return false;
+    };
+
+    int64_t year, month, day;
+    if (!digits(4, year) || !expect('-') || !digits(2, month) || !expect('-') || !digits(2, day)
+        || month < 1 || month > 12 || day < 1 || day > 31) {
+        return std::nullopt;
+    }
+    int64_t hour = 0, minute = 0, second = 0, millisecond = 0, offset_minutes = 0;
+    if (position < str.size() && (str[position] == 'T' || str[position] == 't' || str[position] == ' ')) {
+        ++position;
+        if (!digits(2, hour) || !expect(':') || !digits(2, minute) || hour > 23 || minute > 59) {
+            return std::nullopt;
+        }
+        if (expect(':')) {
+            if (!digits(2, second) || second > 60) {
+                return std::nullopt;
+            }
+            if (expect('.') || expect(',')) {
+                int64_t scale = 100;
+                size_t start = position;
+                while (position < str.size() && str[position] >= '0' && str[position] <= '9') {
+                    millisecond += (str[position] - '0') * scale;
+                    scale /= 10;
+                    ++position;
+                }
+                if (position == start) {
+                    return std::nullopt;
+                }
+            }
+        }
+        if (expect('Z') || expect('z')) {
+            // UTC
+        } else if (position < str.size() && (str[position] == '+' || str[position] == '-')) {
+            int64_t sign = str[position++] == '-' ? -1 : 1;
+            int64_t offset_hours, offset_mins;
+            if (!digits(2, offset_hours)) {
+                return std::nullopt;
+            }
+            expect(':');
+            if (!digits(2, offset_mins)) {
+                return std::nullopt;
+            }
+            offset_minutes = sign * (offset_hours * 60 + offset_mins);
+        }
     }
-    return false;
+    if (position != str.size()) {
+        return std::nullopt;
+    }
+
+    int64_t y = month <= 2 ? year - 1 : year;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + doe - 719468;
+    return ((days * 24 + hour) * 60 + minute - offset_minutes) * 60000 + second * 1000 + millisecond;
 }
+
 } // namespace pb
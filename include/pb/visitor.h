@@ -0,0 +1,139 @@
+/**
+ * SAX style visitor interface shared by the parsers and Blob traversal.
+ * A visitor is any type with the on_* methods of the BlobVisitor concept.  Parsers and visit() are
+ * templates over the visitor type, so every event is a direct call the compiler can inline; consumers
+ * can stream data into their own structures without building a Blob at all.
+ */
+
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <pb/blob.h>
+
+
+namespace pb {
+
+    /**
+     * Events, in document order.  OBJECT members are reported as on_key followed by the value.  Strings
+     * passed to on_key and on_string are only valid for the duration of the call.
+     */
+    template <typename V>
+    concept BlobVisitor = requires(V& visitor, std::string_view text, std::span<const uint8_t> bytes) {
+        visitor.on_object_begin();
+        visitor.on_object_end();
+        visitor.on_array_begin();
+        visitor.on_array_end();
+        visitor.on_key(text);
+        visitor.on_null();
+        visitor.on_bool(true);
+        visitor.on_int64(int64_t(0));
+        visitor.on_uint64(uint64_t(0));
+        visitor.on_double(0.0);
+        visitor.on_date(int64_t(0));
+        visitor.on_string(text);
+        visitor.on_binary(bytes);
+    };
+
+    /**
+     * BlobVisitorBase: ignores every event.  Derive from it and declare only the events of interest,
+     * the derived declarations hide these at compile time.
+     */
+    struct BlobVisitorBase {
+        void on_object_begin() {}
+        void on_object_end() {}
+        void on_array_begin() {}
+        void on_array_end() {}
+        void on_key(std::string_view) {}
+        void on_null() {}
+        void on_bool(bool) {}
+        void on_int64(int64_t) {}
+        void on_uint64(uint64_t) {}
+        void on_double(double) {}
+        void on_date(int64_t) {}
+        void on_string(std::string_view) {}
+        void on_binary(std::span<const uint8_t>) {}
+    };
+
+    /**
+     * BlobBuilderVisitor: builds a Blob from visitor events.
+     */
+    class BlobBuilderVisitor {
+        public:
+            explicit BlobBuilderVisitor(BlobBuilder& builder) : builder_(builder) {}
+
+            void on_object_begin() { builder_.begin_object(); }
+            void on_object_end() { builder_.end_object(); }
+            void on_array_begin() { builder_.begin_array(); }
+            void on_array_end() { builder_.end_array(); }
+            void on_key(std::string_view key) { builder_.key(key); }
+            void on_null() { builder_.add_null(); }
+            void on_bool(bool value) { builder_.add_bool(value); }
+            void on_int64(int64_t value) { builder_.add_int(value); }
+            void on_uint64(uint64_t value) { builder_.add_uint(value); }
+            void on_double(double value) { builder_.add_double(value); }
+            void on_date(int64_t value) { builder_.add_date(value); }
+            void on_string(std::string_view value) { builder_.add_string(value); }
+            void on_binary(std::span<const uint8_t> value) { builder_.add_binary(value.data(), value.size()); }
+
+        private:
+            BlobBuilder& builder_;
+    };
+
+    /**
+     * Walks value depth first and reports it to visitor.  Columnar and delta arrays are reported as
+     * ordinary OBJECTs and scalars.
+     */
+    template <BlobVisitor V>
+    void visit(const BlobView& value, V& visitor) {
+        switch (value.type()) {
+            case NULL_VALUE:
+                visitor.on_null();
+                break;
+            case BOOLEAN:
+                visitor.on_bool(value.as_bool());
+                break;
+            case INTEGER:
+                visitor.on_int64(value.as_int());
+                break;
+            case UNSIGNED_INTEGER:
+                visitor.on_uint64(value.as_uint());
+                break;
+            case FLOAT:
+                visitor.on_double(value.as_double());
+                break;
+            case DATE:
+                visitor.on_date(value.as_date());
+                break;
+            case STRING:
+                visitor.on_string(value.as_string());
+                break;
+            case BINARY:
+                visitor.on_binary(value.as_binary());
+                break;
+            case ARRAY:
+                visitor.on_array_begin();
+                value.for_each_element([&](const BlobView& element) { visit(element, visitor); });
+                visitor.on_array_end();
+                break;
+            case OBJECT:
+                visitor.on_object_begin();
+                value.for_each_member([&](std::string_view key, const BlobView& member) {
+                    visitor.on_key(key);
+                    visit(member, visitor);
+                });
+                visitor.on_object_end();
+                break;
+        }
+    }
+
+    template <BlobVisitor V>
+    void visit(const Blob& blob, V& visitor) {
+        visit(blob.root(), visitor);
+    }
+
+} // namespace pb
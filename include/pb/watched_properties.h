@@ -0,0 +1,243 @@
+/**
+ * Hot reloading .properties files.
+ * WatchedProperties keeps the parsed file as an immutable snapshot behind an atomic shared pointer.  A
+ * background thread watches the file (inotify on Linux, modification time polling elsewhere), parses a
+ * changed file into a new Properties and swaps it in.  Readers take the current snapshot without blocking
+ * on a reload and keep using it for as long as they hold it, so a reload is never seen half applied.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <pb/properties.h>
+
+
+namespace pb {
+
+    /**
+     * WatchedProperties: the latest successfully parsed version of a .properties file.  The file is read
+     * into memory rather than mapped, since an in-place rewrite would change a mapped snapshot under its
+     * readers.  A reload that fails to read or parse keeps the previous snapshot.
+     *
+     *     pb::WatchedProperties config("service.properties");
+     *     auto snapshot = config.snapshot();       // per request
+     *     int port = snapshot->get<int>("http.port");
+     */
+    class WatchedProperties {
+        public:
+            using Snapshot = std::shared_ptr<const Properties>;
+            using Listener = std::function<void(const Snapshot&)>;
+
+            /**
+             * Parses the file and starts watching it.  listener, if set, is called on the watching thread
+             * after every published reload.  poll_interval is used where inotify is not available.
+             * Throws std::runtime_error if the file cannot be read.
+             */
+            explicit WatchedProperties(std::string path, Listener listener = nullptr,
+                                       std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500))
+                : path_(std::move(path)), listener_(std::move(listener)), poll_interval_(poll_interval) {
+                current_.store(load(), std::memory_order_release);
+                version_.store(1, std::memory_order_release);
+                start();
+            }
+
+            WatchedProperties(const WatchedProperties&) = delete;
+            WatchedProperties& operator=(const WatchedProperties&) = delete;
+
+            ~WatchedProperties() {
+                stop();
+            }
+
+            // The current snapshot.  Never null; holding it keeps its views valid across reloads.
+            Snapshot snapshot() const {
+                return current_.load(std::memory_order_acquire);
+            }
+
+            // Number of snapshots published so far, 1 after construction
+            uint64_t version() const {
+                return version_.load(std::memory_order_acquire);
+            }
+
+            const std::string& path() const { return path_; }
+
+            /**
+             * Reads and parses the file now and publishes it.  Returns false, keeping the current
+             * snapshot, if the file cannot be read or parsed.
+             */
+            bool reload() {
+                std::lock_guard<std::mutex> lock(reload_mutex_);
+                Snapshot next;
+                try {
+                    next = load();
+                } catch (const std::exception&) {
+                    return false;
+                }
+                current_.store(next, std::memory_order_release);
+                version_.fetch_add(1, std::memory_order_acq_rel);
+                if (listener_) {
+                    listener_(next);
+                }
+                return true;
+            }
+
+            // Stops watching; snapshots stay readable and reload() still works
+            void stop() {
+                {
+                    std::lock_guard<std::mutex> lock(stop_mutex_);
+                    if (stopping_) {
+                        return;
+                    }
+                    stopping_ = true;
+                }
+                stopped_.notify_all();
+#ifdef __linux__
+                if (wake_fd_ >= 0) {
+                    uint64_t one = 1;
+                    [[maybe_unused]] ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+                }
+#endif
+                if (watcher_.joinable()) {
+                    watcher_.join();
+                }
+#ifdef __linux__
+                if (inotify_fd_ >= 0) {
+                    ::close(inotify_fd_);
+                    inotify_fd_ = -1;
+                }
+                if (wake_fd_ >= 0) {
+                    ::close(wake_fd_);
+                    wake_fd_ = -1;
+                }
+#endif
+            }
+
+        private:
+            Snapshot load() const {
+                std::ifstream file(path_, std::ios::binary);
+                if (!file) {
+                    throw std::runtime_error("Cannot open file: " + path_);
+                }
+                std::ostringstream text;
+                text << file.rdbuf();
+                auto properties = std::make_shared<Properties>();
+                properties->parse_owned(std::move(text).str());
+                return properties;
+            }
+
+            void start() {
+#ifdef __linux__
+                // The directory is watched, so editors and deployments that replace the file by renaming
+                // over it are seen as well as in-place writes.  IN_CREATE is left out: it fires while a new
+                // file is still empty, and the IN_CLOSE_WRITE that follows covers it.
+                std::filesystem::path file(path_);
+                std::filesystem::path directory = file.parent_path().empty() ? std::filesystem::path(".") : file.parent_path();
+                inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (inotify_fd_ >= 0 && wake_fd_ >= 0
+                    && ::inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+                    watcher_ = std::thread([this, name = file.filename().string()] { watch_events(name); });
+                    return;
+                }
+                if (inotify_fd_ >= 0) {
+                    ::close(inotify_fd_);
+                    inotify_fd_ = -1;
+                }
+                if (wake_fd_ >= 0) {
+                    ::close(wake_fd_);
+                    wake_fd_ = -1;
+                }
+#endif
+                watcher_ = std::thread([this] { watch_modification_time(); });
+            }
+
+#ifdef __linux__
+            void watch_events(const std::string& name) {
+                alignas(inotify_event) char buffer[4096];
+                pollfd fds[2] = { { inotify_fd_, POLLIN, 0 }, { wake_fd_, POLLIN, 0 } };
+                while (true) {
+                    if (::poll(fds, 2, -1) < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        return;
+                    }
+                    if (fds[1].revents != 0) {
+                        return;
+                    }
+                    // Drains every pending event so a burst of writes costs one reload
+                    bool changed = false;
+                    ssize_t length;
+                    while ((length = ::read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                        for (ssize_t offset = 0; offset < length;) {
+                            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                            if (event->len > 0 && name == event->name) {
+                                changed = true;
+                            }
+                            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                        }
+                    }
+                    if (changed) {
+                        reload();
+                    }
+                }
+            }
+#endif
+
+            void watch_modification_time() {
+                std::error_code error;
+                auto last = std::filesystem::last_write_time(path_, error);
+                std::unique_lock<std::mutex> lock(stop_mutex_);
+                while (!stopped_.wait_for(lock, poll_interval_, [this] { return stopping_; })) {
+                    auto modified = std::filesystem::last_write_time(path_, error);
+                    if (!error && modified != last) {
+                        last = modified;
+                        lock.unlock();
+                        reload();
+                        lock.lock();
+                    }
+                }
+            }
+
+            std::string path_;
+            Listener listener_;
+            std::chrono::milliseconds poll_interval_;
+
+            std::atomic<Snapshot> current_;
+            std::atomic<uint64_t> version_{ 0 };
+            std::mutex reload_mutex_;                   // Serializes writers only, readers never take it
+
+            std::mutex stop_mutex_;
+            std::condition_variable stopped_;
+            bool stopping_ = false;
+            std::thread watcher_;
+#ifdef __linux__
+            int inotify_fd_ = -1;
+            int wake_fd_ = -1;
+#endif
+    };
+
+} // namespace pb
@@ -0,0 +1,180 @@
+#include <pb/async.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <pb/delimited.h>
+#include <pb/ndjson.h>
+
+
+namespace pb {
+
+    void AsyncInput::push(std::string_view data) {
+        if (closed_) {
+            throw std::runtime_error("AsyncInput is closed");
+        }
+        if (data.empty()) {
+            return;
+        }
+        pending_.append(data);
+        resume();
+    }
+
+    void AsyncInput::close() {
+        closed_ = true;
+        resume();
+    }
+
+    void AsyncInput::fail(std::exception_ptr error) {
+        error_ = error;
+        closed_ = true;
+        resume();
+    }
+
+    void AsyncInput::resume() {
+        if (waiter_) {
+            std::exchange(waiter_, nullptr).resume();
+        }
+    }
+
+    void AsyncInput::ReadAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+        if (input.waiter_) {
+            throw std::runtime_error("AsyncInput already has a waiting reader");
+        }
+        input.waiter_ = waiting;
+        handle = waiting;
+    }
+
+    bool AsyncInput::ReadAwaiter::await_resume() {
+        handle = nullptr;
+        if (!input.pending_.empty()) {
+            if (buffer.empty()) {
+                buffer.swap(input.pending_);
+            } else {
+                buffer.append(input.pending_);
+            }
+            input.pending_.clear();
+            return true;
+        }
+        if (input.error_) {
+            std::rethrow_exception(input.error_);
+        }
+        return false;
+    }
+
+    AsyncGenerator<CSV> read_csv_async(AsyncInput& input, CSVProperties properties, size_t batch_rows) {
+        batch_rows = std::max<size_t>(batch_rows, 1);
+        char quote = properties.get_quote_style() == DOUBLE ? '"' : properties.get_quote_style() == SINGLE ? '\'' : 0;
+        const DelimiterScanner scanner(quote != 0 ? std::string{ '\n', quote } : std::string("\n"));
+
+        std::string buffer;
+        size_t consumed = 0;        // Start of the records not parsed yet
+        size_t scanned = 0;         // Bytes the scanner went through
+        size_t records = 0;         // Complete records between consumed and scanned
+        bool in_quotes = false;
+        bool header = properties.get_has_header();
+        bool more = true;
+        while (more) {
+            more = co_await input.read(buffer);
+            while (true) {
+                size_t needed = batch_rows + (header ? 1 : 0);
+                size_t stop = buffer.size();
+                if (more) {
+                    const char* begin = buffer.data();
+                    const char* end = begin + buffer.size();
+                    bool full = false;
+                    for (const char* p = scanner.find(begin + scanned, end); p != end; p = scanner.find(p + 1, end)) {
+                        scanned = static_cast<size_t>(p - begin) + 1;
+                        if (*p == quote) {
+                            in_quotes = !in_quotes;
+                        } else if (!in_quotes && ++records == needed) {
+                            full = true;
+                            break;
+                        }
+                    }
+                    if (!full) {
+                        scanned = buffer.size();
+                        break;
+                    }
+                    stop = scanned;
+                } else if (consumed == buffer.size()) {
+                    break;
+                }
+
+                CSV batch(properties);
+                batch.parse(std::string_view(buffer).substr(consumed, stop - consumed));
+                // Later batches take the detected delimiter and the header's columns over
+                properties = batch.get_properties();
+                if (header && properties.getColumns().empty()) {
+                    for (const CSVColumn& column : batch.get_columns()) {
+                        properties.add_column(column);
+                    }
+                }
+                properties.set_has_header(false);
+                header = false;
+                consumed = stop;
+                records = 0;
+                if (batch.get_row_count() > 0) {
+                    co_yield std::move(batch);
+                }
+            }
+            // Keep only the partial record
+            buffer.erase(0, consumed);
+            scanned -= consumed;
+            consumed = 0;
+        }
+    }
+
+    AsyncGenerator<Blob> read_ndjson_async(AsyncInput& input, size_t batch_lines) {
+        batch_lines = std::max<size_t>(batch_lines, 1);
+        const DelimiterScanner newline("\n");
+
+        std::string buffer;
+        size_t consumed = 0;
+        size_t scanned = 0;
+        size_t lines = 0;           // Complete lines between consumed and scanned
+        size_t line_number = 0;     // Lines before consumed, for error messages
+        bool more = true;
+        while (more) {
+            more = co_await input.read(buffer);
+            while (true) {
+                size_t stop = buffer.size();
+                if (more) {
+                    const char* begin = buffer.data();
+                    const char* end = begin + buffer.size();
+                    bool full = false;
+                    for (const char* p = newline.find(begin + scanned, end); p != end; p = newline.find(p + 1, end)) {
+                        scanned = static_cast<size_t>(p - begin) + 1;
+                        if (++lines == batch_lines) {
+                            full = true;
+                            break;
+                        }
+                    }
+                    if (!full) {
+                        scanned = buffer.size();
+                        break;
+                    }
+                    stop = scanned;
+                } else if (consumed == buffer.size()) {
+                    break;
+                }
+
+                std::vector<detail::NdjsonFragment> fragments;
+                fragments.push_back(detail::ndjson_parse_chunk(std::string_view(buffer).substr(consumed, stop - consumed), line_number));
+                Blob batch = detail::ndjson_concatenate(fragments, Executor::shared(), 1);
+                line_number += lines;
+                lines = 0;
+                consumed = stop;
+                if (batch.root().size() > 0) {
+                    co_yield std::move(batch);
+                }
+            }
+            buffer.erase(0, consumed);
+            scanned -= consumed;
+            consumed = 0;
+        }
+    }
+
+} // namespace pb
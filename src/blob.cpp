@@ -0,0 +1,290 @@
+#include <pb/blob.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace pb {
+
+    void BlobBuilder::end_array(bool reencode) {
+        size_t start = stack_.empty() ? 0 : stack_.back().start;
+        end_container(ARRAY);
+        if (reencode && delta_arrays_) {
+            delta_array(start);
+        }
+        if (reencode && shred_arrays_) {
+            shred_array(start);
+        }
+    }
+
+    void BlobBuilder::add_value(const BlobView& value) {
+        const uint8_t* encoded = value.data();
+        if (encoded != nullptr) {
+            bool aligned = reinterpret_cast<uintptr_t>(encoded) % detail::BLOB_COLUMN_ALIGNMENT
+                           == buffer_.size() % detail::BLOB_COLUMN_ALIGNMENT;
+            if (aligned || !detail::blob_contains_columnar(encoded)) {
+                begin_value();
+                buffer_.insert(buffer_.end(), encoded, encoded + detail::blob_element_size(encoded));
+                return;
+            }
+        }
+        switch (value.type()) {
+            case NULL_VALUE: add_null(); break;
+            case BOOLEAN: add_bool(value.as_bool()); break;
+            case INTEGER: add_int(value.as_int()); break;
+            case UNSIGNED_INTEGER: add_uint(value.as_uint()); break;
+            case FLOAT: add_double(value.as_double()); break;
+            case DATE: add_date(value.as_date()); break;
+            case STRING: add_string(value.as_string()); break;
+            case BINARY: {
+                std::span<const uint8_t> bytes = value.as_binary();
+                add_binary(bytes.data(), bytes.size());
+                break;
+            }
+            case ARRAY:
+                begin_array();
+                value.for_each_element([&](const BlobView& element) { add_value(element); });
+                end_array();
+                break;
+            case OBJECT:
+                begin_object();
+                value.for_each_member([&](std::string_view name, const BlobView& member) {
+                    key(name);
+                    add_value(member);
+                });
+                end_object();
+                break;
+        }
+    }
+
+    void BlobBuilder::delta_array(size_t start) {
+        const uint8_t* array = buffer_.data() + start;
+        uint32_t count = detail::blob_load<uint32_t>(array + 1);
+        if (count < delta_min_values_) {
+            return;
+        }
+        BlobElementDataType type = detail::blob_tag_type(array[detail::BLOB_CONTAINER_HEADER_SIZE]);
+        if (!detail::blob_is_integer(type)) {
+            return;
+        }
+        std::vector<uint64_t> values(count);
+        const uint8_t* element = array + detail::BLOB_CONTAINER_HEADER_SIZE;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (detail::blob_tag_type(*element) != type) {
+                return;
+            }
+            values[i] = detail::blob_scalar_bits(element);
+            element += detail::blob_element_size(element);
+        }
+
+        // Deltas wrap modulo 2^64 so any sequence decodes exactly, sorted ones just pack tighter
+        int64_t min_delta = INT64_MAX;
+        for (uint32_t i = 1; i < count; ++i) {
+            min_delta = std::min(min_delta, static_cast<int64_t>(values[i] - values[i - 1]));
+        }
+        uint64_t max_packed = 0;
+        for (uint32_t i = 1; i < count; ++i) {
+            max_packed = std::max(max_packed, values[i] - values[i - 1] - static_cast<uint64_t>(min_delta));
+        }
+        unsigned bits = max_packed == 0 ? 0 : 64 - static_cast<unsigned>(std::countl_zero(max_packed));
+
+        size_t blocks = (count + detail::BLOB_DELTA_BLOCK - 1) / detail::BLOB_DELTA_BLOCK;
+        size_t packed_bytes = (static_cast<size_t>(count - 1) * bits + 7) / 8;
+        size_t encoded = detail::BLOB_DELTA_HEADER_SIZE + 8 * blocks + packed_bytes + detail::BLOB_DELTA_PADDING;
+        if (encoded >= buffer_.size() - start) {
+            return;
+        }
+
+        std::vector<uint8_t> out;
+        out.reserve(encoded);
+        out.push_back(detail::blob_make_tag(ARRAY, BLOB_ENCODING_DELTA));
+        detail::blob_append<uint32_t>(out, count);
+        detail::blob_append<uint32_t>(out, static_cast<uint32_t>(encoded - detail::BLOB_CONTAINER_HEADER_SIZE));
+        out.push_back(static_cast<uint8_t>(type));
+        out.push_back(static_cast<uint8_t>(bits));
+        detail::blob_append<int64_t>(out, min_delta);
+        for (size_t b = 0; b < blocks; ++b) {
+            detail::blob_append<uint64_t>(out, values[b * detail::BLOB_DELTA_BLOCK]);
+        }
+        size_t packed = out.size();
+        out.resize(encoded, 0);
+        for (uint32_t i = 1; i < count && bits != 0; ++i) {
+            uint64_t delta = values[i] - values[i - 1] - static_cast<uint64_t>(min_delta);
+            size_t bit = static_cast<size_t>(i - 1) * bits;
+            for (unsigned done = 0; done < bits; ) {
+                size_t byte = packed + ((bit + done) >> 3);
+                unsigned shift = (bit + done) & 7;
+                unsigned take = std::min(bits - done, 8 - shift);
+                out[byte] |= static_cast<uint8_t>(((delta >> done) & ((1u << take) - 1)) << shift);
+                done += take;
+            }
+        }
+        buffer_.resize(start);
+        buffer_.insert(buffer_.end(), out.begin(), out.end());
+    }
+
+    void BlobBuilder::shred_array(size_t start) {
+        const uint8_t* array = buffer_.data() + start;
+        uint32_t rows = detail::blob_load<uint32_t>(array + 1);
+        if (rows == 0 || rows < shred_min_rows_) {
+            return;
+        }
+        const uint8_t* row = array + detail::BLOB_CONTAINER_HEADER_SIZE;
+        if (*row != detail::blob_make_tag(OBJECT)) {
+            return;
+        }
+        uint32_t columns = detail::blob_load<uint32_t>(row + 1);
+        if (columns == 0) {
+            return;
+        }
+
+        std::vector<std::string_view> names;
+        std::vector<BlobElementDataType> types(columns, NULL_VALUE);
+        std::vector<const uint8_t*> cells(static_cast<size_t>(rows) * columns);
+        std::vector<uint32_t> seen(columns, UINT32_MAX);
+
+        for (uint32_t r = 0; r < rows; ++r) {
+            if (*row != detail::blob_make_tag(OBJECT) || detail::blob_load<uint32_t>(row + 1) != columns) {
+                return;
+            }
+            const uint8_t* member = row + detail::BLOB_CONTAINER_HEADER_SIZE;
+            for (uint32_t m = 0; m < columns; ++m) {
+                uint32_t key_len = detail::blob_load<uint32_t>(member);
+                std::string_view key(reinterpret_cast<const char*>(member + 4), key_len);
+                const uint8_t* value = member + 4 + key_len;
+
+                size_t col = find_name(names, key, m);
+                if (r == 0) {
+                    if (col != names.size()) {
+                        return;
+                    }
+                    names.push_back(key);
+                } else if (col == names.size()) {
+                    return;
+                }
+                if (seen[col] == r) {
+                    return;
+                }
+                seen[col] = r;
+
+                BlobElementDataType type = detail::blob_tag_type(*value);
+                uint8_t encoding = detail::blob_tag_encoding(*value);
+                if (!detail::blob_is_scalar(type) || (encoding != BLOB_ENCODING_DEFAULT && !detail::blob_is_integer(type))) {
+                    return;
+                }
+                if (type != NULL_VALUE) {
+                    if (types[col] == NULL_VALUE) {
+                        types[col] = type;
+                    } else if (types[col] != type) {
+                        return;
+                    }
+                }
+                cells[static_cast<size_t>(r) * columns + col] = value;
+                member = value + detail::blob_element_size(value);
+            }
+            row = member;
+        }
+
+        std::vector<uint8_t> out;
+        out.push_back(detail::blob_make_tag(ARRAY, BLOB_ENCODING_COLUMNAR));
+        detail::blob_append<uint32_t>(out, rows);
+        detail::blob_append<uint32_t>(out, 0);
+        detail::blob_append<uint32_t>(out, columns);
+
+        std::vector<size_t> offsets_at(columns);
+        for (uint32_t c = 0; c < columns; ++c) {
+            detail::blob_append<uint32_t>(out, static_cast<uint32_t>(names[c].size()));
+            out.insert(out.end(), names[c].begin(), names[c].end());
+            out.push_back(static_cast<uint8_t>(types[c]));
+            offsets_at[c] = out.size();
+            detail::blob_append<uint32_t>(out, 0);
+            detail::blob_append<uint32_t>(out, 0);
+        }
+
+        // Alignment is relative to the start of the Blob, whose buffer is at least 8 byte aligned
+        auto align = [&]() {
+            while ((start + out.size()) % detail::BLOB_COLUMN_ALIGNMENT != 0) {
+                out.push_back(0);
+            }
+        };
+        size_t bitmap_bytes = (static_cast<size_t>(rows) + 7) / 8;
+
+        for (uint32_t c = 0; c < columns; ++c) {
+            auto cell = [&](uint32_t r) { return cells[static_cast<size_t>(r) * columns + c]; };
+
+            align();
+            detail::blob_patch<uint32_t>(out, offsets_at[c], static_cast<uint32_t>(out.size()));
+            size_t validity = out.size();
+            out.resize(validity + bitmap_bytes, 0);
+            for (uint32_t r = 0; r < rows; ++r) {
+                if (*cell(r) != NULL_VALUE) {
+                    out[validity + (r >> 3)] |= static_cast<uint8_t>(1 << (r & 7));
+                }
+            }
+
+            align();
+            detail::blob_patch<uint32_t>(out, offsets_at[c] + 4, static_cast<uint32_t>(out.size()));
+            size_t values = out.size();
+            switch (types[c]) {
+                case NULL_VALUE:
+                    break;
+                case BOOLEAN:
+                    out.resize(values + bitmap_bytes, 0);
+                    for (uint32_t r = 0; r < rows; ++r) {
+                        if (*cell(r) != NULL_VALUE && cell(r)[1] != 0) {
+                            out[values + (r >> 3)] |= static_cast<uint8_t>(1 << (r & 7));
+                        }
+                    }
+                    break;
+                case STRING:
+                case BINARY: {
+                    out.resize(values + sizeof(uint32_t) * (static_cast<size_t>(rows) + 1), 0);
+                    size_t length = 0;
+                    for (uint32_t r = 0; r < rows; ++r) {
+                        detail::blob_patch<uint32_t>(out, values + sizeof(uint32_t) * r, static_cast<uint32_t>(length));
+                        if (*cell(r) != NULL_VALUE) {
+                            uint32_t len = detail::blob_load<uint32_t>(cell(r) + 1);
+                            out.insert(out.end(), cell(r) + 5, cell(r) + 5 + len);
+                            length += len;
+                        }
+                    }
+                    detail::blob_patch<uint32_t>(out, values + sizeof(uint32_t) * rows, static_cast<uint32_t>(length));
+                    break;
+                }
+                default:
+                    out.resize(values + 8 * static_cast<size_t>(rows), 0);
+                    for (uint32_t r = 0; r < rows; ++r) {
+                        if (*cell(r) != NULL_VALUE) {
+                            detail::blob_patch<uint64_t>(out, values + 8 * static_cast<size_t>(r), detail::blob_scalar_bits(cell(r)));
+                        }
+                    }
+                    break;
+            }
+        }
+
+        if (out.size() - detail::BLOB_CONTAINER_HEADER_SIZE > UINT32_MAX) {
+            return;
+        }
+        detail::blob_patch<uint32_t>(out, 5, static_cast<uint32_t>(out.size() - detail::BLOB_CONTAINER_HEADER_SIZE));
+        buffer_.resize(start);
+        buffer_.insert(buffer_.end(), out.begin(), out.end());
+    }
+
+    size_t BlobBuilder::find_name(const std::vector<std::string_view>& names, std::string_view key, size_t hint) {
+        if (hint < names.size() && names[hint] == key) {
+            return hint;
+        }
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (names[i] == key) {
+                return i;
+            }
+        }
+        return names.size();
+    }
+
+} // namespace pb
@@ -0,0 +1,346 @@
+#include <pb/cbor.h>
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t CBOR_MAX_DEPTH = 512;
+        constexpr uint64_t CBOR_TAG_EPOCH_TIME = 1;
+        constexpr uint8_t CBOR_BREAK = 0xff;
+
+        enum CborMajorType : uint8_t {
+            CBOR_UNSIGNED = 0,
+            CBOR_NEGATIVE = 1,
+            CBOR_BYTES = 2,
+            CBOR_TEXT = 3,
+            CBOR_ARRAY = 4,
+            CBOR_MAP = 5,
+            CBOR_TAG = 6,
+            CBOR_SIMPLE = 7
+        };
+
+        inline double cbor_half_to_double(uint16_t half) {
+            int exponent = (half >> 10) & 0x1f;
+            double mantissa = half & 0x3ff;
+            double value;
+            if (exponent == 0) {
+                value = std::ldexp(mantissa, -24);
+            } else if (exponent != 31) {
+                value = std::ldexp(mantissa + 1024, exponent - 25);
+            } else {
+                value = mantissa == 0 ? INFINITY : NAN;
+            }
+            return (half & 0x8000) ? -value : value;
+        }
+
+        class CborReader {
+            public:
+                CborReader(std::span<const uint8_t> data, BlobBuilder& builder)
+                    : p_(data.data()), end_(data.data() + data.size()), builder_(builder) {}
+
+                void read_document() {
+                    read_value(0);
+                    if (p_ != end_) {
+                        throw std::runtime_error("Trailing bytes after CBOR document");
+                    }
+                }
+
+            private:
+                static constexpr uint64_t INDEFINITE = UINT64_MAX;
+
+                const uint8_t* take(size_t size) {
+                    if (static_cast<size_t>(end_ - p_) < size) {
+                        throw std::runtime_error("Truncated CBOR data");
+                    }
+                    const uint8_t* at = p_;
+                    p_ += size;
+                    return at;
+                }
+
+                bool at_break() {
+                    if (p_ == end_) {
+                        throw std::runtime_error("Truncated CBOR data");
+                    }
+                    if (*p_ == CBOR_BREAK) {
+                        ++p_;
+                        return true;
+                    }
+                    return false;
+                }
+
+                // Argument of the initial byte, INDEFINITE for additional information 31
+                uint64_t read_argument(uint8_t info) {
+                    if (info < 24) {
+                        return info;
+                    }
+                    switch (info) {
+                        case 24: return *take(1);
+                        case 25: return blob_load_be<uint16_t>(take(2));
+                        case 26: return blob_load_be<uint32_t>(take(4));
+                        case 27: return blob_load_be<uint64_t>(take(8));
+                        case 31: return INDEFINITE;
+                        default:
+                            throw std::runtime_error("Invalid CBOR additional information");
+                    }
+                }
+
+                // Definite strings are returned as a view of the input, chunked ones are joined in scratch
+                std::string_view read_string(uint8_t major, uint64_t length) {
+                    if (length != INDEFINITE) {
+                        return std::string_view(reinterpret_cast<const char*>(take(length)), length);
+                    }
+                    std::string& joined = scratch_;
+                    joined.clear();
+                    while (!at_break()) {
+                        uint8_t initial = *take(1);
+                        uint64_t chunk = read_argument(initial & 0x1f);
+                        if ((initial >> 5) != major || chunk == INDEFINITE) {
+                            throw std::runtime_error("Invalid CBOR string chunk");
+                        }
+                        joined.append(reinterpret_cast<const char*>(take(chunk)), chunk);
+                    }
+                    return joined;
+                }
+
+                void read_value(size_t depth) {
+                    if (depth > CBOR_MAX_DEPTH) {
+                        throw std::runtime_error("CBOR document is nested too deeply");
+                    }
+                    uint8_t initial = *take(1);
+                    uint8_t major = initial >> 5;
+                    uint8_t info = initial & 0x1f;
+
+                    if (major == CBOR_SIMPLE) {
+                        read_simple(info);
+                        return;
+                    }
+                    uint64_t argument = read_argument(info);
+                    if (argument == INDEFINITE && major != CBOR_BYTES && major != CBOR_TEXT && major != CBOR_ARRAY && major != CBOR_MAP) {
+                        throw std::runtime_error("Invalid indefinite length CBOR item");
+                    }
+
+                    switch (major) {
+                        case CBOR_UNSIGNED:
+                            if (argument > static_cast<uint64_t>(INT64_MAX)) {
+                                builder_.add_uint(argument);
+                            } else {
+                                builder_.add_int(static_cast<int64_t>(argument));
+                            }
+                            break;
+                        case CBOR_NEGATIVE:
+                            if (argument > static_cast<uint64_t>(INT64_MAX)) {
+                                throw std::out_of_range("CBOR negative integer does not fit in an INTEGER");
+                            }
+                            builder_.add_int(-1 - static_cast<int64_t>(argument));
+                            break;
+                        case CBOR_BYTES: {
+                            std::string_view bytes = read_string(major, argument);
+                            builder_.add_binary(bytes.data(), bytes.size());
+                            break;
+                        }
+                        case CBOR_TEXT:
+                            builder_.add_string(read_string(major, argument));
+                            break;
+                        case CBOR_ARRAY:
+                            builder_.begin_array();
+                            for (uint64_t i = 0; argument == INDEFINITE ? !at_break() : i < argument; ++i) {
+                                read_value(depth + 1);
+                            }
+                            builder_.end_array();
+                            break;
+                        case CBOR_MAP:
+                            builder_.begin_object();
+                            for (uint64_t i = 0; argument == INDEFINITE ? !at_break() : i < argument; ++i) {
+                                uint8_t key_initial = *take(1);
+                                if ((key_initial >> 5) != CBOR_TEXT) {
+                                    throw std::runtime_error("CBOR map keys must be text strings");
+                                }
+                                builder_.key(read_string(CBOR_TEXT, read_argument(key_initial & 0x1f)));
+                                read_value(depth + 1);
+                            }
+                            builder_.end_object();
+                            break;
+                        case CBOR_TAG:
+                            if (argument == CBOR_TAG_EPOCH_TIME) {
+                                read_epoch_time();
+                            } else {
+                                // Unknown tags are transparent, the tagged item is read as is
+                                read_value(depth + 1);
+                            }
+                            break;
+                    }
+                }
+
+                void read_simple(uint8_t info) {
+                    switch (info) {
+                        case 20: builder_.add_bool(false); break;
+                        case 21: builder_.add_bool(true); break;
+                        case 22:
+                        case 23: builder_.add_null(); break;
+                        case 25: builder_.add_double(cbor_half_to_double(blob_load_be<uint16_t>(take(2)))); break;
+                        case 26: builder_.add_double(std::bit_cast<float>(blob_load_be<uint32_t>(take(4)))); break;
+                        case 27: builder_.add_double(std::bit_cast<double>(blob_load_be<uint64_t>(take(8)))); break;
+                        default:
+                            throw std::runtime_error("Unsupported CBOR simple value");
+                    }
+                }
+
+                void read_epoch_time() {
+                    uint8_t initial = *take(1);
+                    uint8_t major = initial >> 5;
+                    uint8_t info = initial & 0x1f;
+                    if (major == CBOR_UNSIGNED || major == CBOR_NEGATIVE) {
+                        uint64_t argument = read_argument(info);
+                        if (argument > static_cast<uint64_t>(INT64_MAX / 1000)) {
+                            throw std::out_of_range("CBOR epoch time is out of range");
+                        }
+                        int64_t seconds = major == CBOR_UNSIGNED ? static_cast<int64_t>(argument) : -1 - static_cast<int64_t>(argument);
+                        builder_.add_date(seconds * 1000);
+                        return;
+                    }
+                    double seconds;
+                    if (initial == 0xf9) {
+                        seconds = cbor_half_to_double(blob_load_be<uint16_t>(take(2)));
+                    } else if (initial == 0xfa) {
+                        seconds = std::bit_cast<float>(blob_load_be<uint32_t>(take(4)));
+                    } else if (initial == 0xfb) {
+                        seconds = std::bit_cast<double>(blob_load_be<uint64_t>(take(8)));
+                    } else {
+                        throw std::runtime_error("Invalid CBOR epoch time");
+                    }
+                    double millis = seconds * 1000;
+                    // 2^63 is exact as a double; anything at or past it does not fit in int64
+                    if (!std::isfinite(millis) || millis >= 0x1p63 || millis < -0x1p63) {
+                        throw std::out_of_range("CBOR epoch time is out of range");
+                    }
+                    builder_.add_date(static_cast<int64_t>(std::llround(millis)));
+                }
+
+                const uint8_t* p_;
+                const uint8_t* end_;
+                BlobBuilder& builder_;
+                std::string scratch_;
+        };
+
+        class CborWriter {
+            public:
+                explicit CborWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+                void write(const BlobView& value) {
+                    switch (value.type()) {
+                        case NULL_VALUE:
+                            out_.push_back(0xf6);
+                            break;
+                        case BOOLEAN:
+                            out_.push_back(value.as_bool() ? 0xf5 : 0xf4);
+                            break;
+                        case INTEGER:
+                            write_int(value.as_int());
+                            break;
+                        case UNSIGNED_INTEGER:
+                            write_head(CBOR_UNSIGNED, value.as_uint());
+                            break;
+                        case FLOAT:
+                            out_.push_back(0xfb);
+                            blob_append_be(out_, std::bit_cast<uint64_t>(value.as_double()));
+                            break;
+                        case DATE: {
+                            int64_t milliseconds = value.as_date();
+                            write_head(CBOR_TAG, CBOR_TAG_EPOCH_TIME);
+                            if (milliseconds % 1000 == 0) {
+                                write_int(milliseconds / 1000);
+                            } else {
+                                out_.push_back(0xfb);
+                                blob_append_be(out_, std::bit_cast<uint64_t>(milliseconds / 1000.0));
+                            }
+                            break;
+                        }
+                        case STRING: {
+                            std::string_view text = value.as_string();
+                            write_head(CBOR_TEXT, text.size());
+                            out_.insert(out_.end(), text.begin(), text.end());
+                            break;
+                        }
+                        case BINARY: {
+                            std::span<const uint8_t> bytes = value.as_binary();
+                            write_head(CBOR_BYTES, bytes.size());
+                            out_.insert(out_.end(), bytes.begin(), bytes.end());
+                            break;
+                        }
+                        case ARRAY:
+                            write_head(CBOR_ARRAY, value.size());
+                            value.for_each_element([&](const BlobView& element) { write(element); });
+                            break;
+                        case OBJECT:
+                            write_head(CBOR_MAP, value.size());
+                            value.for_each_member([&](std::string_view key, const BlobView& member) {
+                                write_head(CBOR_TEXT, key.size());
+                                out_.insert(out_.end(), key.begin(), key.end());
+                                write(member);
+                            });
+                            break;
+                    }
+                }
+
+            private:
+                void write_int(int64_t value) {
+                    if (value >= 0) {
+                        write_head(CBOR_UNSIGNED, static_cast<uint64_t>(value));
+                    } else {
+                        write_head(CBOR_NEGATIVE, static_cast<uint64_t>(-1 - value));
+                    }
+                }
+
+                void write_head(uint8_t major, uint64_t argument) {
+                    uint8_t type = static_cast<uint8_t>(major << 5);
+                    if (argument < 24) {
+                        out_.push_back(type | static_cast<uint8_t>(argument));
+                    } else if (argument <= UINT8_MAX) {
+                        out_.push_back(type | 24);
+                        out_.push_back(static_cast<uint8_t>(argument));
+                    } else if (argument <= UINT16_MAX) {
+                        out_.push_back(type | 25);
+                        blob_append_be(out_, static_cast<uint16_t>(argument));
+                    } else if (argument <= UINT32_MAX) {
+                        out_.push_back(type | 26);
+                        blob_append_be(out_, static_cast<uint32_t>(argument));
+                    } else {
+                        out_.push_back(type | 27);
+                        blob_append_be(out_, argument);
+                    }
+                }
+
+                std::vector<uint8_t>& out_;
+        };
+
+    } // namespace detail
+
+    Blob read_cbor(std::span<const uint8_t> data) {
+        BlobBuilder builder;
+        detail::CborReader reader(data, builder);
+        reader.read_document();
+        return builder.build();
+    }
+
+    std::vector<uint8_t> write_cbor(const BlobView& value) {
+        std::vector<uint8_t> out;
+        detail::CborWriter writer(out);
+        writer.write(value);
+        return out;
+    }
+
+    std::vector<uint8_t> write_cbor(const Blob& blob) {
+        return write_cbor(blob.root());
+    }
+
+} // namespace pb
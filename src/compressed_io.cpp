@@ -0,0 +1,138 @@
+#include <pb/compressed_io.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace pb {
+
+    CompressingSink::CompressingSink(Sink& sink, BlobBlockCodec& codec, size_t block_size)
+        : sink_(sink), codec_(codec), block_size_(block_size) {
+        if (block_size == 0 || block_size > UINT32_MAX) {
+            throw std::runtime_error("Invalid compressed stream block size");
+        }
+        std::vector<uint8_t> header;
+        detail::blob_append<uint32_t>(header, detail::COMPRESSED_STREAM_MAGIC);
+        detail::blob_append<uint16_t>(header, detail::COMPRESSED_STREAM_VERSION);
+        detail::blob_append<uint16_t>(header, codec.id());
+        detail::blob_append<uint32_t>(header, static_cast<uint32_t>(block_size));
+        sink_.write(std::string_view(reinterpret_cast<const char*>(header.data()), header.size()));
+        pending_.reserve(block_size);
+    }
+
+    CompressingSink::~CompressingSink() {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    void CompressingSink::write(std::string_view data) {
+        while (!data.empty()) {
+            size_t take = std::min(data.size(), block_size_ - pending_.size());
+            pending_.append(data.substr(0, take));
+            data.remove_prefix(take);
+            if (pending_.size() == block_size_) {
+                write_block();
+            }
+        }
+    }
+
+    void CompressingSink::flush() {
+        write_block();
+        sink_.flush();
+    }
+
+    void CompressingSink::finish() {
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        write_block();
+        std::vector<uint8_t> end;
+        detail::blob_append<uint32_t>(end, 0);
+        sink_.write(std::string_view(reinterpret_cast<const char*>(end.data()), end.size()));
+        sink_.flush();
+    }
+
+    void CompressingSink::write_block() {
+        if (pending_.empty()) {
+            return;
+        }
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(pending_.data());
+        codec_.compress(raw, pending_.size(), compressed_);
+        bool stored = compressed_.size() >= pending_.size();
+        std::vector<uint8_t> sizes;
+        detail::blob_append<uint32_t>(sizes, static_cast<uint32_t>(pending_.size()));
+        detail::blob_append<uint32_t>(sizes, static_cast<uint32_t>(stored ? pending_.size() : compressed_.size()));
+        sink_.write(std::string_view(reinterpret_cast<const char*>(sizes.data()), sizes.size()));
+        if (stored) {
+            sink_.write(pending_);
+        } else {
+            sink_.write(std::string_view(reinterpret_cast<const char*>(compressed_.data()), compressed_.size()));
+        }
+        pending_.clear();
+    }
+
+    DecompressingSource::DecompressingSource(Source& source, BlobBlockCodec& codec) : source_(source), codec_(codec) {
+        std::string_view header = read(detail::COMPRESSED_STREAM_HEADER_SIZE);
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(header.data());
+        if (detail::blob_load<uint32_t>(p) != detail::COMPRESSED_STREAM_MAGIC) {
+            throw std::runtime_error("Not a compressed stream");
+        }
+        if (detail::blob_load<uint16_t>(p + 4) != detail::COMPRESSED_STREAM_VERSION) {
+            throw std::runtime_error("Unsupported compressed stream version");
+        }
+        if (detail::blob_load<uint16_t>(p + 6) != codec.id()) {
+            throw std::runtime_error("Compressed stream was written with another codec");
+        }
+        block_size_ = detail::blob_load<uint32_t>(p + 8);
+    }
+
+    std::string_view DecompressingSource::next() {
+        if (ended_) {
+            return std::string_view();
+        }
+        uint32_t raw_size = read_u32();
+        if (raw_size == 0) {
+            ended_ = true;
+            return std::string_view();
+        }
+        uint32_t stored_size = read_u32();
+        if (raw_size > block_size_ || stored_size > raw_size) {
+            throw std::runtime_error("Corrupt compressed stream block header");
+        }
+        std::string_view stored = read(stored_size);
+        if (stored_size == raw_size) {
+            return stored;
+        }
+        block_.resize(raw_size);
+        codec_.decompress(reinterpret_cast<const uint8_t*>(stored.data()), stored.size(), block_.data(), raw_size);
+        return std::string_view(reinterpret_cast<const char*>(block_.data()), raw_size);
+    }
+
+    std::string_view DecompressingSource::read(size_t size) {
+        if (buffer_.size() >= size) {
+            std::string_view bytes = buffer_.substr(0, size);
+            buffer_.remove_prefix(size);
+            return bytes;
+        }
+        gathered_.assign(buffer_);
+        buffer_ = std::string_view();
+        while (gathered_.size() < size) {
+            std::string_view piece = source_.next();
+            if (piece.empty()) {
+                throw std::runtime_error("Truncated compressed stream");
+            }
+            size_t take = std::min(piece.size(), size - gathered_.size());
+            gathered_.append(piece.substr(0, take));
+            buffer_ = piece.substr(take);
+        }
+        return gathered_;
+    }
+
+    uint32_t DecompressingSource::read_u32() {
+        return detail::blob_load<uint32_t>(reinterpret_cast<const uint8_t*>(read(4).data()));
+    }
+
+} // namespace pb
@@ -0,0 +1,535 @@
+#include <pb/cpu.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PB_CPU_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PB_TARGET(features)
+#else
+#include <cpuid.h>
+#define PB_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+
+namespace pb {
+
+    namespace detail {
+
+#ifdef PB_CPU_X86
+        inline void cpu_id(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int values[4];
+            __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; ++i) {
+                registers[i] = static_cast<uint32_t>(values[i]);
+            }
+#else
+            __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+        }
+
+        // Register state the operating system saves on context switches
+        inline uint64_t cpu_xcr0() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            return _xgetbv(0);
+#else
+            uint32_t eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+        }
+#endif
+
+        CpuFeatures cpu_detect() {
+            CpuFeatures features;
+#ifdef PB_CPU_X86
+            uint32_t registers[4];
+            cpu_id(0, 0, registers);
+            uint32_t max_leaf = registers[0];
+            cpu_id(1, 0, registers);
+            features.sse2 = (registers[3] >> 26) & 1;
+            features.sse42 = (registers[2] >> 20) & 1;
+            features.popcnt = (registers[2] >> 23) & 1;
+            bool osxsave = (registers[2] >> 27) & 1;
+            uint64_t xcr0 = osxsave ? cpu_xcr0() : 0;
+            bool ymm = (xcr0 & 0x6) == 0x6;                // XMM and YMM state
+            bool zmm = ymm && (xcr0 & 0xe0) == 0xe0;       // Opmask and ZMM state
+            if (max_leaf >= 7) {
+                cpu_id(7, 0, registers);
+                features.bmi1 = (registers[1] >> 3) & 1;
+                features.avx2 = ymm && ((registers[1] >> 5) & 1);
+                features.bmi2 = (registers[1] >> 8) & 1;
+                features.avx512f = zmm && ((registers[1] >> 16) & 1);
+                features.avx512bw = zmm && ((registers[1] >> 30) & 1);
+            }
+#endif
+            return features;
+        }
+
+        CpuLevel cpu_level_of(const CpuFeatures& features) {
+            if (features.avx512f && features.avx512bw && features.avx2 && features.bmi1 && features.bmi2) {
+                return CpuLevel::AVX512;
+            }
+            if (features.avx2 && features.bmi1 && features.bmi2) {
+                return CpuLevel::AVX2;
+            }
+            if (features.sse42 && features.popcnt) {
+                return CpuLevel::SSE42;
+            }
+            return features.sse2 ? CpuLevel::SSE2 : CpuLevel::SCALAR;
+        }
+
+        std::atomic<int>& cpu_active_level() {
+            static std::atomic<int> level([] {
+                CpuLevel supported = cpu_supported_level();
+                const char* forced = std::getenv("PB_CPU_LEVEL");
+                std::optional<CpuLevel> requested = forced ? parse_cpu_level(forced) : std::nullopt;
+                return static_cast<int>(requested ? std::min(*requested, supported) : supported);
+            }());
+            return level;
+        }
+
+        const char* scan_scalar(const ScanSet& set, const char* p, const char* end) {
+            while (p < end && !set.table[static_cast<uint8_t>(*p)]) {
+                ++p;
+            }
+            return p;
+        }
+
+#ifdef PB_CPU_X86
+        PB_TARGET("sse2")
+        const char* scan_sse2(const ScanSet& set, const char* p, const char* end) {
+            __m128i splats[8];
+            for (size_t k = 0; k < set.count; ++k) {
+                splats[k] = _mm_set1_epi8(static_cast<char>(set.characters[k]));
+            }
+            while (end - p >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i hits = _mm_cmpeq_epi8(block, splats[0]);
+                for (size_t k = 1; k < set.count; ++k) {
+                    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, splats[k]));
+                }
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+                if (mask != 0) {
+                    return p + std::countr_zero(mask);
+                }
+                p += 16;
+            }
+            return scan_scalar(set, p, end);
+        }
+
+        // PCMPESTRI compares sixteen bytes against the whole set in one instruction
+        PB_TARGET("sse4.2")
+        const char* scan_sse42(const ScanSet& set, const char* p, const char* end) {
+            __m128i characters = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(set.characters));
+            int count = static_cast<int>(set.count);
+            while (end - p >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                int index = _mm_cmpestri(characters, count, block, 16,
+                                         _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+                if (index < 16) {
+                    return p + index;
+                }
+                p += 16;
+            }
+            return scan_scalar(set, p, end);
+        }
+
+        PB_TARGET("avx2,bmi,bmi2")
+        const char* scan_avx2(const ScanSet& set, const char* p, const char* end) {
+            __m256i splats[8];
+            for (size_t k = 0; k < set.count; ++k) {
+                splats[k] = _mm256_set1_epi8(static_cast<char>(set.characters[k]));
+            }
+            while (end - p >= 32) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                __m256i hits = _mm256_cmpeq_epi8(block, splats[0]);
+                for (size_t k = 1; k < set.count; ++k) {
+                    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, splats[k]));
+                }
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+                if (mask != 0) {
+                    return p + std::countr_zero(mask);
+                }
+                p += 32;
+            }
+            return scan_sse42(set, p, end);
+        }
+
+        PB_TARGET("avx512f,avx512bw,avx2,bmi,bmi2")
+        const char* scan_avx512(const ScanSet& set, const char* p, const char* end) {
+            __m512i splats[8];
+            for (size_t k = 0; k < set.count; ++k) {
+                splats[k] = _mm512_set1_epi8(static_cast<char>(set.characters[k]));
+            }
+            while (end - p >= 64) {
+                __m512i block = _mm512_loadu_si512(p);
+                __mmask64 mask = _mm512_cmpeq_epi8_mask(block, splats[0]);
+                for (size_t k = 1; k < set.count; ++k) {
+                    mask |= _mm512_cmpeq_epi8_mask(block, splats[k]);
+                }
+                if (mask != 0) {
+                    return p + std::countr_zero(static_cast<uint64_t>(mask));
+                }
+                p += 64;
+            }
+            return scan_avx2(set, p, end);
+        }
+#endif
+
+        void lines_scalar(const char* p, const char* end, char quote, bool& in_quotes, uint64_t base,
+                          std::vector<uint64_t>& line_ends) {
+            for (const char* begin = p; p < end; ++p) {
+                if (*p == '\n' && !in_quotes) {
+                    line_ends.push_back(base + static_cast<uint64_t>(p - begin) + 1);
+                } else if (quote != 0 && *p == quote) {
+                    in_quotes = !in_quotes;
+                }
+            }
+        }
+
+        /**
+         * One 64 byte block of the line kernels, from its newline and quote bit masks.  Bit i of the
+         * prefix XOR of the quotes is set when an odd number of quotes precede byte i, that is when it is
+         * inside quotes, so all the newlines of the block are masked without a branch per quote.
+         */
+        inline void lines_block(uint64_t newlines, uint64_t quotes, bool& in_quotes, uint64_t offset,
+                                std::vector<uint64_t>& line_ends) {
+            uint64_t inside = in_quotes ? ~uint64_t(0) : 0;
+            if (quotes != 0) {
+                quotes ^= quotes << 1;
+                quotes ^= quotes << 2;
+                quotes ^= quotes << 4;
+                quotes ^= quotes << 8;
+                quotes ^= quotes << 16;
+                quotes ^= quotes << 32;
+                inside ^= quotes;
+                in_quotes = (inside >> 63) != 0;
+            }
+            newlines &= ~inside;
+            while (newlines != 0) {
+                line_ends.push_back(offset + static_cast<uint64_t>(std::countr_zero(newlines)) + 1);
+                newlines &= newlines - 1;
+            }
+        }
+
+#ifdef PB_CPU_X86
+        PB_TARGET("sse2")
+        void lines_sse2(const char* p, const char* end, char quote, bool& in_quotes, uint64_t base,
+                        std::vector<uint64_t>& line_ends) {
+            const char* begin = p;
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i quotes = _mm_set1_epi8(quote);
+            while (end - p >= 64) {
+                uint64_t newline_mask = 0;
+                uint64_t quote_mask = 0;
+                for (int k = 0; k < 4; ++k) {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+                    newline_mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)))) << (16 * k);
+                    quote_mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quotes)))) << (16 * k);
+                }
+                lines_block(newline_mask, quote != 0 ? quote_mask : 0, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+                p += 64;
+            }
+            lines_scalar(p, end, quote, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+        }
+
+        PB_TARGET("avx2,bmi,bmi2")
+        void lines_avx2(const char* p, const char* end, char quote, bool& in_quotes, uint64_t base,
+                        std::vector<uint64_t>& line_ends) {
+            const char* begin = p;
+            const __m256i newline = _mm256_set1_epi8('\n');
+            const __m256i quotes = _mm256_set1_epi8(quote);
+            while (end - p >= 64) {
+                __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+                uint64_t newline_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)))
+                    | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)))) << 32;
+                uint64_t quote_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, quotes)))
+                    | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, quotes)))) << 32;
+                lines_block(newline_mask, quote != 0 ? quote_mask : 0, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+                p += 64;
+            }
+            lines_scalar(p, end, quote, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+        }
+
+        PB_TARGET("avx512f,avx512bw,avx2,bmi,bmi2")
+        void lines_avx512(const char* p, const char* end, char quote, bool& in_quotes, uint64_t base,
+                          std::vector<uint64_t>& line_ends) {
+            const char* begin = p;
+            const __m512i newline = _mm512_set1_epi8('\n');
+            const __m512i quotes = _mm512_set1_epi8(quote);
+            while (end - p >= 64) {
+                __m512i block = _mm512_loadu_si512(p);
+                uint64_t newline_mask = _mm512_cmpeq_epi8_mask(block, newline);
+                uint64_t quote_mask = quote != 0 ? _mm512_cmpeq_epi8_mask(block, quotes) : 0;
+                lines_block(newline_mask, quote_mask, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+                p += 64;
+            }
+            lines_scalar(p, end, quote, in_quotes, base + static_cast<uint64_t>(p - begin), line_ends);
+        }
+#endif
+
+        void unpack_scalar(const uint8_t* packed, unsigned bits, size_t first, size_t count, uint64_t* out) {
+            if (bits == 0) {
+                std::fill(out, out + count, 0);
+                return;
+            }
+            const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+            for (size_t k = 0; k < count; ++k) {
+                size_t bit = (first + k) * bits;
+                unsigned shift = bit & 7;
+                uint64_t value;
+                std::memcpy(&value, packed + (bit >> 3), 8);
+                value >>= shift;
+                // Past 56 bits a value can spill into a ninth byte
+                if (bits > 56 && shift != 0) {
+                    value |= static_cast<uint64_t>(packed[(bit >> 3) + 8]) << (64 - shift);
+                }
+                out[k] = value & mask;
+            }
+        }
+
+        void prefix_sum_scalar(uint64_t* values, size_t count, uint64_t start, uint64_t step) {
+            for (size_t k = 0; k < count; ++k) {
+                start += step + values[k];
+                values[k] = start;
+            }
+        }
+
+#ifdef PB_CPU_X86
+        // Two lanes: add the lane shifted up by one, then the running total
+        PB_TARGET("sse2")
+        void prefix_sum_sse2(uint64_t* values, size_t count, uint64_t start, uint64_t step) {
+            const __m128i steps = _mm_set1_epi64x(static_cast<long long>(step));
+            __m128i carry = _mm_set1_epi64x(static_cast<long long>(start));
+            size_t k = 0;
+            for (; k + 2 <= count; k += 2) {
+                __m128i v = _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + k)), steps);
+                v = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+                v = _mm_add_epi64(v, carry);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(values + k), v);
+                carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            prefix_sum_scalar(values + k, count - k, k == 0 ? start : values[k - 1], step);
+        }
+
+        /**
+         * Four values per step.  Every value is loaded at its own bit offset with a gather, shifted into
+         * place with a per lane variable shift and masked.  Widths past 56 bits gather the ninth byte too.
+         */
+        PB_TARGET("avx2,bmi,bmi2")
+        void unpack_avx2(const uint8_t* packed, unsigned bits, size_t first, size_t count, uint64_t* out) {
+            if (bits == 0) {
+                unpack_scalar(packed, bits, first, count, out);
+                return;
+            }
+            const long long* base = reinterpret_cast<const long long*>(packed);
+            const long long* next = reinterpret_cast<const long long*>(packed + 1);
+            const __m256i mask = _mm256_set1_epi64x(bits == 64 ? -1 : static_cast<long long>((uint64_t(1) << bits) - 1));
+            const __m256i lanes = _mm256_setr_epi64x(0, bits, 2 * bits, 3 * bits);
+            const __m256i seven = _mm256_set1_epi64x(7);
+            const __m256i sixty_four = _mm256_set1_epi64x(64);
+            size_t k = 0;
+            for (; k + 4 <= count; k += 4) {
+                __m256i bit = _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>((first + k) * bits)), lanes);
+                __m256i byte = _mm256_srli_epi64(bit, 3);
+                __m256i shift = _mm256_and_si256(bit, seven);
+                __m256i value = _mm256_srlv_epi64(_mm256_i64gather_epi64(base, byte, 1), shift);
+                if (bits > 56) {
+                    // A shift of 64 yields zero, so lanes starting on a byte boundary take nothing here
+                    __m256i high = _mm256_srli_epi64(_mm256_i64gather_epi64(next, byte, 1), 56);
+                    value = _mm256_or_si256(value, _mm256_sllv_epi64(high, _mm256_sub_epi64(sixty_four, shift)));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), _mm256_and_si256(value, mask));
+            }
+            unpack_scalar(packed, bits, first + k, count - k, out + k);
+        }
+
+        PB_TARGET("avx2,bmi,bmi2")
+        void prefix_sum_avx2(uint64_t* values, size_t count, uint64_t start, uint64_t step) {
+            const __m256i steps = _mm256_set1_epi64x(static_cast<long long>(step));
+            __m256i carry = _mm256_set1_epi64x(static_cast<long long>(start));
+            size_t k = 0;
+            for (; k + 4 <= count; k += 4) {
+                __m256i v = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + k)), steps);
+                v = _mm256_add_epi64(v, _mm256_slli_si256(v, 8));      // within each 128 bit half
+                v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_setzero_si256(),
+                                                           _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 1, 1, 1)), 0xf0));
+                v = _mm256_add_epi64(v, carry);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + k), v);
+                carry = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+            }
+            prefix_sum_scalar(values + k, count - k, k == 0 ? start : values[k - 1], step);
+        }
+
+        PB_TARGET("avx512f,avx512bw,avx2,bmi,bmi2")
+        void unpack_avx512(const uint8_t* packed, unsigned bits, size_t first, size_t count, uint64_t* out) {
+            if (bits == 0) {
+                unpack_scalar(packed, bits, first, count, out);
+                return;
+            }
+            const __m512i mask = _mm512_set1_epi64(bits == 64 ? -1 : static_cast<long long>((uint64_t(1) << bits) - 1));
+            const __m512i lanes = _mm512_setr_epi64(0, bits, 2 * bits, 3 * bits, 4 * bits, 5 * bits, 6 * bits, 7 * bits);
+            const __m512i seven = _mm512_set1_epi64(7);
+            const __m512i sixty_four = _mm512_set1_epi64(64);
+            size_t k = 0;
+            for (; k + 8 <= count; k += 8) {
+                __m512i bit = _mm512_add_epi64(_mm512_set1_epi64(static_cast<long long>((first + k) * bits)), lanes);
+                __m512i byte = _mm512_srli_epi64(bit, 3);
+                __m512i shift = _mm512_and_si512(bit, seven);
+                __m512i value = _mm512_srlv_epi64(_mm512_i64gather_epi64(byte, packed, 1), shift);
+                if (bits > 56) {
+                    __m512i high = _mm512_srli_epi64(_mm512_i64gather_epi64(byte, packed + 1, 1), 56);
+                    value = _mm512_or_si512(value, _mm512_sllv_epi64(high, _mm512_sub_epi64(sixty_four, shift)));
+                }
+                _mm512_storeu_si512(out + k, _mm512_and_si512(value, mask));
+            }
+            unpack_avx2(packed, bits, first + k, count - k, out + k);
+        }
+
+        // Log step scan over eight lanes, each round adding the lanes 1, 2 and 4 below
+        PB_TARGET("avx512f,avx512bw,avx2,bmi,bmi2")
+        void prefix_sum_avx512(uint64_t* values, size_t count, uint64_t start, uint64_t step) {
+            const __m512i steps = _mm512_set1_epi64(static_cast<long long>(step));
+            const __m512i by_one = _mm512_setr_epi64(0, 0, 1, 2, 3, 4, 5, 6);
+            const __m512i by_two = _mm512_setr_epi64(0, 0, 0, 1, 2, 3, 4, 5);
+            const __m512i by_four = _mm512_setr_epi64(0, 0, 0, 0, 0, 1, 2, 3);
+            const __m512i last = _mm512_set1_epi64(7);
+            __m512i carry = _mm512_set1_epi64(static_cast<long long>(start));
+            size_t k = 0;
+            for (; k + 8 <= count; k += 8) {
+                __m512i v = _mm512_add_epi64(_mm512_loadu_si512(values + k), steps);
+                v = _mm512_add_epi64(v, _mm512_maskz_permutexvar_epi64(0xfe, by_one, v));
+                v = _mm512_add_epi64(v, _mm512_maskz_permutexvar_epi64(0xfc, by_two, v));
+                v = _mm512_add_epi64(v, _mm512_maskz_permutexvar_epi64(0xf0, by_four, v));
+                v = _mm512_add_epi64(v, carry);
+                _mm512_storeu_si512(values + k, v);
+                carry = _mm512_permutexvar_epi64(last, v);
+            }
+            prefix_sum_avx2(values + k, count - k, k == 0 ? start : values[k - 1], step);
+        }
+#endif
+
+        ScanKernel scan_kernel(CpuLevel level) {
+#ifdef PB_CPU_X86
+            switch (level) {
+                case CpuLevel::AVX512: return scan_avx512;
+                case CpuLevel::AVX2: return scan_avx2;
+                case CpuLevel::SSE42: return scan_sse42;
+                case CpuLevel::SSE2: return scan_sse2;
+                case CpuLevel::SCALAR: break;
+            }
+#else
+            (void)level;
+#endif
+            return scan_scalar;
+        }
+
+        // SSE4.2 adds nothing for two characters, so it takes the SSE2 kernel
+        LineKernel line_kernel(CpuLevel level) {
+#ifdef PB_CPU_X86
+            switch (level) {
+                case CpuLevel::AVX512: return lines_avx512;
+                case CpuLevel::AVX2: return lines_avx2;
+                case CpuLevel::SSE42:
+                case CpuLevel::SSE2: return lines_sse2;
+                case CpuLevel::SCALAR: break;
+            }
+#else
+            (void)level;
+#endif
+            return lines_scalar;
+        }
+
+        // Without gathers or per lane shifts the SSE levels unpack as well as scalar code
+        UnpackKernel unpack_kernel(CpuLevel level) {
+#ifdef PB_CPU_X86
+            switch (level) {
+                case CpuLevel::AVX512: return unpack_avx512;
+                case CpuLevel::AVX2: return unpack_avx2;
+                case CpuLevel::SSE42:
+                case CpuLevel::SSE2:
+                case CpuLevel::SCALAR: break;
+            }
+#else
+            (void)level;
+#endif
+            return unpack_scalar;
+        }
+
+        PrefixSumKernel prefix_sum_kernel(CpuLevel level) {
+#ifdef PB_CPU_X86
+            switch (level) {
+                case CpuLevel::AVX512: return prefix_sum_avx512;
+                case CpuLevel::AVX2: return prefix_sum_avx2;
+                case CpuLevel::SSE42:
+                case CpuLevel::SSE2: return prefix_sum_sse2;
+                case CpuLevel::SCALAR: break;
+            }
+#else
+            (void)level;
+#endif
+            return prefix_sum_scalar;
+        }
+
+    } // namespace detail
+
+    const CpuFeatures& cpu_features() {
+        static const CpuFeatures features = detail::cpu_detect();
+        return features;
+    }
+
+    CpuLevel cpu_supported_level() {
+        static const CpuLevel level = detail::cpu_level_of(cpu_features());
+        return level;
+    }
+
+    CpuLevel cpu_level() {
+        return static_cast<CpuLevel>(detail::cpu_active_level().load(std::memory_order_relaxed));
+    }
+
+    CpuLevel set_cpu_level(CpuLevel level) {
+        CpuLevel applied = std::min(level, cpu_supported_level());
+        detail::cpu_active_level().store(static_cast<int>(applied), std::memory_order_relaxed);
+        return applied;
+    }
+
+    std::string_view cpu_level_name(CpuLevel level) {
+        switch (level) {
+            case CpuLevel::SCALAR: return "scalar";
+            case CpuLevel::SSE2: return "sse2";
+            case CpuLevel::SSE42: return "sse4.2";
+            case CpuLevel::AVX2: return "avx2";
+            case CpuLevel::AVX512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    std::optional<CpuLevel> parse_cpu_level(std::string_view name) {
+        std::string lower(name);
+        for (char& c : lower) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        for (int level = static_cast<int>(CpuLevel::SCALAR); level <= static_cast<int>(CpuLevel::AVX512); ++level) {
+            if (lower == cpu_level_name(static_cast<CpuLevel>(level))) {
+                return static_cast<CpuLevel>(level);
+            }
+        }
+        if (lower == "sse42") {
+            return CpuLevel::SSE42;
+        }
+        return std::nullopt;
+    }
+
+} // namespace pb
@@ -0,0 +1,162 @@
+#include <pb/executor.h>
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+
+namespace pb {
+
+    namespace detail {
+
+        // The executor and worker index of the calling thread, when it is a worker
+        struct ExecutorWorker {
+            const Executor* executor = nullptr;
+            size_t index = 0;
+        };
+
+        thread_local ExecutorWorker executor_worker;
+
+        void executor_pin(std::thread& thread, size_t index) {
+            size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(index % cores, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#elif defined(_WIN32)
+            SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (index % std::min<size_t>(cores, 64)));
+#else
+            (void)thread;
+            (void)index;
+            (void)cores;
+#endif
+        }
+
+    } // namespace detail
+
+    Executor::Executor(size_t threads, bool pin_threads) {
+        if (threads == 0) {
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        // Every deque exists before the first worker can try to steal from it
+        for (size_t i = 0; i < threads; ++i) {
+            workers_[i]->thread = std::thread([this, i] { work(i); });
+            if (pin_threads) {
+                detail::executor_pin(workers_[i]->thread, i);
+            }
+        }
+    }
+
+    Executor::~Executor() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        sleep_.notify_all();
+        for (std::unique_ptr<Worker>& worker : workers_) {
+            worker->thread.join();
+        }
+    }
+
+    Executor& Executor::shared() {
+        static Executor executor(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+        return executor;
+    }
+
+    bool Executor::in_worker() const {
+        return detail::executor_worker.executor == this;
+    }
+
+    void Executor::submit(Task task) {
+        if (in_worker()) {
+            Worker& worker = *workers_[detail::executor_worker.index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        } else {
+            std::lock_guard<std::mutex> lock(injected_mutex_);
+            injected_.push_back(std::move(task));
+        }
+        {
+            // Taking the lock orders the count with a worker that is about to sleep, so the wake up is not lost
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            ++queued_;
+        }
+        sleep_.notify_one();
+    }
+
+    std::optional<Executor::Task> Executor::take(size_t self) {
+        std::optional<Task> task;
+        if (self < workers_.size()) {
+            Worker& own = *workers_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        if (!task) {
+            std::lock_guard<std::mutex> lock(injected_mutex_);
+            if (!injected_.empty()) {
+                task = std::move(injected_.front());
+                injected_.pop_front();
+            }
+        }
+        // Steal the oldest task of another worker, the one most likely to fork more work
+        for (size_t k = 1; !task && k <= workers_.size(); ++k) {
+            size_t victim = (self + k) % workers_.size();
+            if (victim == self) {
+                continue;
+            }
+            Worker& other = *workers_[victim];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if (!other.tasks.empty()) {
+                task = std::move(other.tasks.front());
+                other.tasks.pop_front();
+            }
+        }
+        if (task) {
+            --queued_;
+        }
+        return task;
+    }
+
+    bool Executor::run_one() {
+        size_t self = in_worker() ? detail::executor_worker.index : workers_.size();
+        std::optional<Task> task = take(self);
+        if (!task) {
+            return false;
+        }
+        (*task)();
+        return true;
+    }
+
+    void Executor::work(size_t index) {
+        detail::executor_worker = detail::ExecutorWorker{ this, index };
+        while (true) {
+            if (std::optional<Task> task = take(index)) {
+                (*task)();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_ && queued_ <= 0) {
+                return;
+            }
+        }
+    }
+
+} // namespace pb
@@ -0,0 +1,123 @@
+#include <pb/io.h>
+#include <pb/memory.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+
+namespace pb {
+
+    std::string_view SpanSource::next() {
+        return std::exchange(data_, std::string_view());
+    }
+
+    MemorySource::MemorySource(Memory& memory) : MemorySource(memory, memory.current_size()) {}
+
+    MemorySource::MemorySource(Memory& memory, size_t size)
+        : SpanSource(std::string_view(static_cast<const char*>(memory.data()), size)) {
+        if (size > memory.current_size()) {
+            throw std::out_of_range("MemorySource exceeds current memory size");
+        }
+    }
+
+    std::string_view MappedFileSource::next() {
+        return std::exchange(data_, std::string_view());
+    }
+
+    FileSource::FileSource(const std::string& path, size_t buffer_size)
+        : file_(std::fopen(path.c_str(), "rb")), owned_(true), buffer_(std::max<size_t>(buffer_size, 1)) {
+        if (file_ == nullptr) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+        std::error_code error;
+        if (std::filesystem::is_regular_file(path, error)) {
+            uintmax_t size = std::filesystem::file_size(path, error);
+            if (!error) {
+                remaining_ = size;
+            }
+        }
+    }
+
+    FileSource::FileSource(std::FILE* file, size_t buffer_size)
+        : file_(file), owned_(false), buffer_(std::max<size_t>(buffer_size, 1)) {
+        if (file_ == nullptr) {
+            throw std::runtime_error("FileSource needs an open stream");
+        }
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+    }
+
+    FileSource::~FileSource() {
+        if (owned_) {
+            std::fclose(file_);
+        }
+    }
+
+    std::string_view FileSource::next() {
+        size_t read = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+        if (read < buffer_.size() && std::ferror(file_)) {
+            throw std::runtime_error("Cannot read file");
+        }
+        if (remaining_) {
+            *remaining_ -= std::min<uint64_t>(*remaining_, read);
+        }
+        return std::string_view(buffer_.data(), read);
+    }
+
+    std::optional<uint64_t> FileSource::remaining() const {
+        return remaining_;
+    }
+
+    void MemorySink::write(std::string_view data) {
+        memory_.write(data.data(), data.size(), offset_);
+        offset_ += data.size();
+    }
+
+    FileSink::FileSink(const std::string& path) : file_(std::fopen(path.c_str(), "wb")), owned_(true) {
+        if (file_ == nullptr) {
+            throw std::runtime_error("Cannot create file: " + path);
+        }
+    }
+
+    FileSink::~FileSink() {
+        if (owned_) {
+            std::fclose(file_);
+        }
+    }
+
+    void FileSink::write(std::string_view data) {
+        if (std::fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+            throw std::runtime_error("Cannot write file");
+        }
+    }
+
+    void FileSink::flush() {
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Cannot write file");
+        }
+    }
+
+    std::string_view read_all(Source& source, std::string& storage) {
+        if (std::optional<std::string_view> whole = source.next_contiguous()) {
+            return *whole;
+        }
+        storage.clear();
+        if (std::optional<uint64_t> remaining = source.remaining()) {
+            storage.reserve(static_cast<size_t>(*remaining));
+        }
+        for (std::string_view piece = source.next(); !piece.empty(); piece = source.next()) {
+            storage.append(piece);
+        }
+        return storage;
+    }
+
+    void copy_all(Source& source, Sink& sink) {
+        for (std::string_view piece = source.next(); !piece.empty(); piece = source.next()) {
+            sink.write(piece);
+        }
+    }
+
+} // namespace pb
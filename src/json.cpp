@@ -0,0 +1,117 @@
+#include <pb/json.h>
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+
+namespace pb {
+
+    namespace detail {
+
+        template class JsonReader<BlobBuilderVisitor>;
+
+        void json_write(std::string& out, const BlobView& value) {
+            switch (value.type()) {
+                case NULL_VALUE:
+                    out += "null";
+                    break;
+                case BOOLEAN:
+                    out += value.as_bool() ? "true" : "false";
+                    break;
+                case INTEGER:
+                    out += std::to_string(value.as_int());
+                    break;
+                case UNSIGNED_INTEGER:
+                    out += std::to_string(value.as_uint());
+                    break;
+                case FLOAT: {
+                    double number = value.as_double();
+                    if (!std::isfinite(number)) {
+                        out += "null";
+                        break;
+                    }
+                    char buffer[32];
+                    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+                    std::string_view text(buffer, static_cast<size_t>(result.ptr - buffer));
+                    out += text;
+                    if (text.find_first_of(".eE") == std::string_view::npos) {
+                        // Keep the value a FLOAT when read back
+                        out += ".0";
+                    }
+                    break;
+                }
+                case DATE:
+                    out.push_back('"');
+                    json_append_date(out, value.as_date());
+                    out.push_back('"');
+                    break;
+                case STRING:
+                    json_append_string(out, value.as_string());
+                    break;
+                case BINARY:
+                    out.push_back('"');
+                    json_append_base64(out, value.as_binary());
+                    out.push_back('"');
+                    break;
+                case ARRAY: {
+                    out.push_back('[');
+                    bool first = true;
+                    value.for_each_element([&](const BlobView& element) {
+                        if (!first) {
+                            out.push_back(',');
+                        }
+                        first = false;
+                        json_write(out, element);
+                    });
+                    out.push_back(']');
+                    break;
+                }
+                case OBJECT: {
+                    out.push_back('{');
+                    bool first = true;
+                    value.for_each_member([&](std::string_view key, const BlobView& member) {
+                        if (!first) {
+                            out.push_back(',');
+                        }
+                        first = false;
+                        json_append_string(out, key);
+                        out.push_back(':');
+                        json_write(out, member);
+                    });
+                    out.push_back('}');
+                    break;
+                }
+            }
+        }
+
+    } // namespace detail
+
+    Blob read_json(std::string_view text) {
+        BlobBuilder builder;
+        BlobBuilderVisitor visitor(builder);
+        detail::JsonReader<BlobBuilderVisitor> reader(text, visitor);
+        reader.read_document();
+        return builder.build();
+    }
+
+    Blob read_json(Source& source) {
+        std::string storage;
+        return read_json(read_all(source, storage));
+    }
+
+    std::string write_json(const BlobView& value) {
+        std::string out;
+        detail::json_write(out, value);
+        return out;
+    }
+
+    std::string write_json(const Blob& blob) {
+        return write_json(blob.root());
+    }
+
+    void write_json(const BlobView& value, Sink& sink) {
+        sink.write(write_json(value));
+    }
+
+} // namespace pb
@@ -1 +1,2 @@
-// dummy implementation file for library.
\ No newline at end of file
+// Compiles every public header once, so a header that does not stand on its own breaks the library build
+#include <pb/library.h>
@@ -0,0 +1,151 @@
+#include <pb/lz4.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t LZ4_MIN_MATCH = 4;
+        constexpr size_t LZ4_LAST_LITERALS = 5;     // The last 5 bytes of a block are always literals
+        constexpr size_t LZ4_MATCH_LIMIT = 12;      // The last match starts at least 12 bytes before the end
+        constexpr size_t LZ4_MAX_OFFSET = 65535;
+        constexpr unsigned LZ4_HASH_BITS = 12;
+
+        inline uint32_t lz4_load32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t lz4_hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        }
+
+        inline void lz4_write_length(std::vector<uint8_t>& out, size_t length) {
+            while (length >= 255) {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<uint8_t>(length));
+        }
+
+        inline void lz4_write_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literal_length,
+                                       size_t offset, size_t match_length) {
+            size_t match_code = match_length == 0 ? 0 : match_length - LZ4_MIN_MATCH;
+            uint8_t token = static_cast<uint8_t>((literal_length >= 15 ? 15 : literal_length) << 4);
+            token |= static_cast<uint8_t>(match_code >= 15 ? 15 : match_code);
+            out.push_back(token);
+            if (literal_length >= 15) {
+                lz4_write_length(out, literal_length - 15);
+            }
+            out.insert(out.end(), literals, literals + literal_length);
+            if (match_length == 0) {
+                return;
+            }
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (match_code >= 15) {
+                lz4_write_length(out, match_code - 15);
+            }
+        }
+
+    } // namespace detail
+
+    void lz4_compress_block(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+        out.clear();
+        size_t anchor = 0;
+        if (size > detail::LZ4_MATCH_LIMIT) {
+            std::vector<int64_t> table(size_t(1) << detail::LZ4_HASH_BITS, -1);
+            const size_t match_limit = size - detail::LZ4_MATCH_LIMIT;
+            const size_t end_limit = size - detail::LZ4_LAST_LITERALS;
+            size_t i = 0;
+            while (i < match_limit) {
+                uint32_t sequence = detail::lz4_load32(src + i);
+                uint32_t hash = detail::lz4_hash(sequence);
+                int64_t candidate = table[hash];
+                table[hash] = static_cast<int64_t>(i);
+                if (candidate < 0 || i - static_cast<size_t>(candidate) > detail::LZ4_MAX_OFFSET
+                    || detail::lz4_load32(src + candidate) != sequence) {
+                    ++i;
+                    continue;
+                }
+                size_t length = detail::LZ4_MIN_MATCH;
+                while (i + length < end_limit && src[candidate + length] == src[i + length]) {
+                    ++length;
+                }
+                detail::lz4_write_sequence(out, src + anchor, i - anchor, i - static_cast<size_t>(candidate), length);
+                i += length;
+                anchor = i;
+            }
+        }
+        detail::lz4_write_sequence(out, src + anchor, size - anchor, 0, 0);
+    }
+
+    void lz4_decompress_block(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size) {
+        const uint8_t* ip = src;
+        const uint8_t* const iend = src + src_size;
+        uint8_t* op = dst;
+        uint8_t* const oend = dst + dst_size;
+
+        auto read_length = [&](size_t length) {
+            if (length == 15) {
+                uint8_t byte;
+                do {
+                    if (ip >= iend) {
+                        throw std::runtime_error("Corrupt LZ4 block");
+                    }
+                    byte = *ip++;
+                    length += byte;
+                } while (byte == 255);
+            }
+            return length;
+        };
+
+        while (true) {
+            if (ip >= iend) {
+                throw std::runtime_error("Corrupt LZ4 block");
+            }
+            uint8_t token = *ip++;
+            size_t literal_length = read_length(token >> 4);
+            if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+                throw std::runtime_error("Corrupt LZ4 block");
+            }
+            std::memcpy(op, ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+            if (ip == iend) {
+                break;
+            }
+
+            if (iend - ip < 2) {
+                throw std::runtime_error("Corrupt LZ4 block");
+            }
+            size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            size_t match_length = read_length(token & 0x0f) + detail::LZ4_MIN_MATCH;
+            if (offset == 0 || offset > static_cast<size_t>(op - dst) || match_length > static_cast<size_t>(oend - op)) {
+                throw std::runtime_error("Corrupt LZ4 block");
+            }
+            const uint8_t* match = op - offset;
+            if (offset >= match_length) {
+                std::memcpy(op, match, match_length);
+                op += match_length;
+            } else {
+                // Overlapping match repeats the last offset bytes
+                for (size_t i = 0; i < match_length; ++i) {
+                    *op++ = match[i];
+                }
+            }
+        }
+        if (op != oend) {
+            throw std::runtime_error("Corrupt LZ4 block");
+        }
+    }
+
+} // namespace pb
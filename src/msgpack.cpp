@@ -0,0 +1,350 @@
+#include <pb/msgpack.h>
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t MSGPACK_MAX_DEPTH = 512;
+        constexpr int8_t MSGPACK_TIMESTAMP_EXT = -1;
+
+        class MsgPackReader {
+            public:
+                MsgPackReader(std::span<const uint8_t> data, BlobBuilder& builder)
+                    : p_(data.data()), end_(data.data() + data.size()), builder_(builder) {}
+
+                void read_document() {
+                    read_value(0);
+                    if (p_ != end_) {
+                        throw std::runtime_error("Trailing bytes after MessagePack document");
+                    }
+                }
+
+            private:
+                const uint8_t* take(size_t size) {
+                    if (static_cast<size_t>(end_ - p_) < size) {
+                        throw std::runtime_error("Truncated MessagePack data");
+                    }
+                    const uint8_t* at = p_;
+                    p_ += size;
+                    return at;
+                }
+
+                template <typename T>
+                T take_be() {
+                    return blob_load_be<T>(take(sizeof(T)));
+                }
+
+                std::string_view take_bytes(size_t size) {
+                    return std::string_view(reinterpret_cast<const char*>(take(size)), size);
+                }
+
+                void read_value(size_t depth) {
+                    if (depth > MSGPACK_MAX_DEPTH) {
+                        throw std::runtime_error("MessagePack document is nested too deeply");
+                    }
+                    uint8_t marker = *take(1);
+
+                    if (marker <= 0x7f) {
+                        builder_.add_int(marker);
+                    } else if (marker >= 0xe0) {
+                        builder_.add_int(static_cast<int8_t>(marker));
+                    } else if ((marker & 0xf0) == 0x80) {
+                        read_map(marker & 0x0f, depth);
+                    } else if ((marker & 0xf0) == 0x90) {
+                        read_array(marker & 0x0f, depth);
+                    } else if ((marker & 0xe0) == 0xa0) {
+                        builder_.add_string(take_bytes(marker & 0x1f));
+                    } else {
+                        switch (marker) {
+                            case 0xc0: builder_.add_null(); break;
+                            case 0xc2: builder_.add_bool(false); break;
+                            case 0xc3: builder_.add_bool(true); break;
+                            case 0xc4: read_binary(take_be<uint8_t>()); break;
+                            case 0xc5: read_binary(take_be<uint16_t>()); break;
+                            case 0xc6: read_binary(take_be<uint32_t>()); break;
+                            case 0xc7: read_ext(take_be<uint8_t>()); break;
+                            case 0xc8: read_ext(take_be<uint16_t>()); break;
+                            case 0xc9: read_ext(take_be<uint32_t>()); break;
+                            case 0xca: builder_.add_double(std::bit_cast<float>(take_be<uint32_t>())); break;
+                            case 0xcb: builder_.add_double(std::bit_cast<double>(take_be<uint64_t>())); break;
+                            case 0xcc: builder_.add_uint(take_be<uint8_t>()); break;
+                            case 0xcd: builder_.add_uint(take_be<uint16_t>()); break;
+                            case 0xce: builder_.add_uint(take_be<uint32_t>()); break;
+                            case 0xcf: builder_.add_uint(take_be<uint64_t>()); break;
+                            case 0xd0: builder_.add_int(static_cast<int8_t>(take_be<uint8_t>())); break;
+                            case 0xd1: builder_.add_int(static_cast<int16_t>(take_be<uint16_t>())); break;
+                            case 0xd2: builder_.add_int(static_cast<int32_t>(take_be<uint32_t>())); break;
+                            case 0xd3: builder_.add_int(static_cast<int64_t>(take_be<uint64_t>())); break;
+                            case 0xd4: read_ext(1); break;
+                            case 0xd5: read_ext(2); break;
+                            case 0xd6: read_ext(4); break;
+                            case 0xd7: read_ext(8); break;
+                            case 0xd8: read_ext(16); break;
+                            case 0xd9: builder_.add_string(take_bytes(take_be<uint8_t>())); break;
+                            case 0xda: builder_.add_string(take_bytes(take_be<uint16_t>())); break;
+                            case 0xdb: builder_.add_string(take_bytes(take_be<uint32_t>())); break;
+                            case 0xdc: read_array(take_be<uint16_t>(), depth); break;
+                            case 0xdd: read_array(take_be<uint32_t>(), depth); break;
+                            case 0xde: read_map(take_be<uint16_t>(), depth); break;
+                            case 0xdf: read_map(take_be<uint32_t>(), depth); break;
+                            default:
+                                throw std::runtime_error("Invalid MessagePack marker");
+                        }
+                    }
+                }
+
+                void read_binary(size_t size) {
+                    builder_.add_binary(take(size), size);
+                }
+
+                void read_array(size_t count, size_t depth) {
+                    builder_.begin_array();
+                    for (size_t i = 0; i < count; ++i) {
+                        read_value(depth + 1);
+                    }
+                    builder_.end_array();
+                }
+
+                void read_map(size_t count, size_t depth) {
+                    builder_.begin_object();
+                    for (size_t i = 0; i < count; ++i) {
+                        builder_.key(read_key());
+                        read_value(depth + 1);
+                    }
+                    builder_.end_object();
+                }
+
+                std::string_view read_key() {
+                    uint8_t marker = *take(1);
+                    if ((marker & 0xe0) == 0xa0) {
+                        return take_bytes(marker & 0x1f);
+                    }
+                    switch (marker) {
+                        case 0xd9: return take_bytes(take_be<uint8_t>());
+                        case 0xda: return take_bytes(take_be<uint16_t>());
+                        case 0xdb: return take_bytes(take_be<uint32_t>());
+                        default:
+                            throw std::runtime_error("MessagePack map keys must be strings");
+                    }
+                }
+
+                // Timestamp extension: 32 bit seconds, 30 bit nanoseconds + 34 bit seconds, or 32 bit nanoseconds + 64 bit seconds
+                void read_ext(size_t size) {
+                    int8_t type = static_cast<int8_t>(*take(1));
+                    const uint8_t* data = take(size);
+                    if (type != MSGPACK_TIMESTAMP_EXT) {
+                        throw std::runtime_error("Unsupported MessagePack extension type");
+                    }
+                    int64_t seconds = 0;
+                    uint32_t nanoseconds = 0;
+                    if (size == 4) {
+                        seconds = blob_load_be<uint32_t>(data);
+                    } else if (size == 8) {
+                        uint64_t value = blob_load_be<uint64_t>(data);
+                        nanoseconds = static_cast<uint32_t>(value >> 34);
+                        seconds = static_cast<int64_t>(value & 0x3ffffffffULL);
+                    } else if (size == 12) {
+                        nanoseconds = blob_load_be<uint32_t>(data);
+                        seconds = static_cast<int64_t>(blob_load_be<uint64_t>(data + 4));
+                    } else {
+                        throw std::runtime_error("Invalid MessagePack timestamp");
+                    }
+                    if (nanoseconds > 999999999) {
+                        throw std::runtime_error("Invalid MessagePack timestamp nanoseconds");
+                    }
+                    constexpr int64_t max_seconds = std::numeric_limits<int64_t>::max() / 1000;
+                    constexpr int64_t min_seconds = std::numeric_limits<int64_t>::min() / 1000;
+                    int64_t milliseconds = nanoseconds / 1000000;
+                    // Only the largest whole second can still overflow once its milliseconds are added
+                    if (seconds < min_seconds || seconds > max_seconds
+                        || seconds * 1000 > std::numeric_limits<int64_t>::max() - milliseconds) {
+                        throw std::runtime_error("MessagePack timestamp is out of range");
+                    }
+                    builder_.add_date(seconds * 1000 + milliseconds);
+                }
+
+                const uint8_t* p_;
+                const uint8_t* end_;
+                BlobBuilder& builder_;
+        };
+
+        class MsgPackWriter {
+            public:
+                explicit MsgPackWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+                void write(const BlobView& value) {
+                    switch (value.type()) {
+                        case NULL_VALUE:
+                            out_.push_back(0xc0);
+                            break;
+                        case BOOLEAN:
+                            out_.push_back(value.as_bool() ? 0xc3 : 0xc2);
+                            break;
+                        case INTEGER:
+                            write_int(value.as_int());
+                            break;
+                        case UNSIGNED_INTEGER:
+                            write_uint(value.as_uint());
+                            break;
+                        case FLOAT:
+                            out_.push_back(0xcb);
+                            blob_append_be(out_, std::bit_cast<uint64_t>(value.as_double()));
+                            break;
+                        case DATE:
+                            write_timestamp(value.as_date());
+                            break;
+                        case STRING:
+                            write_string(value.as_string());
+                            break;
+                        case BINARY:
+                            write_binary(value.as_binary());
+                            break;
+                        case ARRAY:
+                            write_header(value.size(), 0x90, 0xdc);
+                            value.for_each_element([&](const BlobView& element) { write(element); });
+                            break;
+                        case OBJECT:
+                            write_header(value.size(), 0x80, 0xde);
+                            value.for_each_member([&](std::string_view key, const BlobView& member) {
+                                write_string(key);
+                                write(member);
+                            });
+                            break;
+                    }
+                }
+
+            private:
+                // INTEGER always uses the fixint or signed forms so it reads back as INTEGER
+                void write_int(int64_t value) {
+                    if (value >= -32 && value <= 127) {
+                        out_.push_back(static_cast<uint8_t>(value));
+                    } else if (value >= INT8_MIN && value <= INT8_MAX) {
+                        out_.push_back(0xd0);
+                        out_.push_back(static_cast<uint8_t>(value));
+                    } else if (value >= INT16_MIN && value <= INT16_MAX) {
+                        out_.push_back(0xd1);
+                        blob_append_be(out_, static_cast<uint16_t>(value));
+                    } else if (value >= INT32_MIN && value <= INT32_MAX) {
+                        out_.push_back(0xd2);
+                        blob_append_be(out_, static_cast<uint32_t>(value));
+                    } else {
+                        out_.push_back(0xd3);
+                        blob_append_be(out_, static_cast<uint64_t>(value));
+                    }
+                }
+
+                // UNSIGNED_INTEGER always uses the uint forms so it reads back as UNSIGNED_INTEGER
+                void write_uint(uint64_t value) {
+                    if (value <= UINT8_MAX) {
+                        out_.push_back(0xcc);
+                        out_.push_back(static_cast<uint8_t>(value));
+                    } else if (value <= UINT16_MAX) {
+                        out_.push_back(0xcd);
+                        blob_append_be(out_, static_cast<uint16_t>(value));
+                    } else if (value <= UINT32_MAX) {
+                        out_.push_back(0xce);
+                        blob_append_be(out_, static_cast<uint32_t>(value));
+                    } else {
+                        out_.push_back(0xcf);
+                        blob_append_be(out_, value);
+                    }
+                }
+
+                void write_timestamp(int64_t milliseconds) {
+                    int64_t seconds = milliseconds / 1000;
+                    int64_t remainder = milliseconds % 1000;
+                    if (remainder < 0) {
+                        seconds -= 1;
+                        remainder += 1000;
+                    }
+                    uint32_t nanoseconds = static_cast<uint32_t>(remainder * 1000000);
+                    if (seconds >= 0 && seconds <= 0x3ffffffffLL) {
+                        out_.push_back(0xd7);
+                        out_.push_back(static_cast<uint8_t>(MSGPACK_TIMESTAMP_EXT));
+                        blob_append_be(out_, (static_cast<uint64_t>(nanoseconds) << 34) | static_cast<uint64_t>(seconds));
+                    } else {
+                        out_.push_back(0xc7);
+                        out_.push_back(12);
+                        out_.push_back(static_cast<uint8_t>(MSGPACK_TIMESTAMP_EXT));
+                        blob_append_be(out_, nanoseconds);
+                        blob_append_be(out_, static_cast<uint64_t>(seconds));
+                    }
+                }
+
+                void write_string(std::string_view value) {
+                    size_t size = value.size();
+                    if (size <= 31) {
+                        out_.push_back(static_cast<uint8_t>(0xa0 | size));
+                    } else if (size <= UINT8_MAX) {
+                        out_.push_back(0xd9);
+                        out_.push_back(static_cast<uint8_t>(size));
+                    } else if (size <= UINT16_MAX) {
+                        out_.push_back(0xda);
+                        blob_append_be(out_, static_cast<uint16_t>(size));
+                    } else {
+                        out_.push_back(0xdb);
+                        blob_append_be(out_, static_cast<uint32_t>(size));
+                    }
+                    out_.insert(out_.end(), value.begin(), value.end());
+                }
+
+                void write_binary(std::span<const uint8_t> value) {
+                    size_t size = value.size();
+                    if (size <= UINT8_MAX) {
+                        out_.push_back(0xc4);
+                        out_.push_back(static_cast<uint8_t>(size));
+                    } else if (size <= UINT16_MAX) {
+                        out_.push_back(0xc5);
+                        blob_append_be(out_, static_cast<uint16_t>(size));
+                    } else {
+                        out_.push_back(0xc6);
+                        blob_append_be(out_, static_cast<uint32_t>(size));
+                    }
+                    out_.insert(out_.end(), value.begin(), value.end());
+                }
+
+                void write_header(size_t count, uint8_t fix, uint8_t marker16) {
+                    if (count <= 15) {
+                        out_.push_back(static_cast<uint8_t>(fix | count));
+                    } else if (count <= UINT16_MAX) {
+                        out_.push_back(marker16);
+                        blob_append_be(out_, static_cast<uint16_t>(count));
+                    } else {
+                        out_.push_back(marker16 + 1);
+                        blob_append_be(out_, static_cast<uint32_t>(count));
+                    }
+                }
+
+                std::vector<uint8_t>& out_;
+        };
+
+    } // namespace detail
+
+    Blob read_msgpack(std::span<const uint8_t> data) {
+        BlobBuilder builder;
+        detail::MsgPackReader reader(data, builder);
+        reader.read_document();
+        return builder.build();
+    }
+
+    std::vector<uint8_t> write_msgpack(const BlobView& value) {
+        std::vector<uint8_t> out;
+        detail::MsgPackWriter writer(out);
+        writer.write(value);
+        return out;
+    }
+
+    std::vector<uint8_t> write_msgpack(const Blob& blob) {
+        return write_msgpack(blob.root());
+    }
+
+} // namespace pb
@@ -0,0 +1,441 @@
+#include <pb/ndjson.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pb/json.h>
+
+
+namespace pb {
+
+    namespace detail {
+
+        constexpr size_t NDJSON_MIN_CHUNK_SIZE = 256 * 1024;
+        constexpr size_t NDJSON_CHUNKS_PER_THREAD = 8;
+        constexpr size_t NDJSON_MIN_SHRED_ROWS = 2;        // As BlobBuilder shreds arrays by default
+
+        // Splits data into chunks of roughly chunk_size that end just after a newline
+        inline std::vector<std::string_view> ndjson_split(std::string_view data, size_t chunk_size) {
+            std::vector<std::string_view> chunks;
+            size_t start = 0;
+            while (start < data.size()) {
+                size_t end = std::min(start + chunk_size, data.size());
+                if (end < data.size()) {
+                    size_t newline = data.find('\n', end);
+                    end = newline == std::string_view::npos ? data.size() : newline + 1;
+                }
+                chunks.push_back(data.substr(start, end - start));
+                start = end;
+            }
+            return chunks;
+        }
+
+        // Index of key in names, checking the expected position first, names.size() if missing
+        inline size_t ndjson_find_name(const std::vector<std::string_view>& names, std::string_view key, size_t hint) {
+            if (hint < names.size() && names[hint] == key) {
+                return hint;
+            }
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (names[i] == key) {
+                    return i;
+                }
+            }
+            return names.size();
+        }
+
+        /**
+         * Checks the records of fragment against the rules BlobBuilder shreds an ARRAY by: every record an
+         * OBJECT with the keys of the first, each once, holding scalars of one type per key besides nulls.
+         * Only the column summary is kept, the values are written straight into the result later.
+         */
+        bool ndjson_summarize_columns(NdjsonFragment& fragment) {
+            const uint8_t* array = fragment.records.root().data();
+            uint32_t rows = blob_load<uint32_t>(array + 1);
+            const uint8_t* row = array + BLOB_CONTAINER_HEADER_SIZE;
+            if (rows == 0 || *row != blob_make_tag(OBJECT)) {
+                return false;
+            }
+            uint32_t columns = blob_load<uint32_t>(row + 1);
+            if (columns == 0) {
+                return false;
+            }
+
+            std::vector<std::string_view> names;
+            std::vector<BlobElementDataType> types(columns, NULL_VALUE);
+            std::vector<size_t> string_bytes(columns, 0);
+            std::vector<uint32_t> seen(columns, UINT32_MAX);
+            for (uint32_t r = 0; r < rows; ++r) {
+                if (*row != blob_make_tag(OBJECT) || blob_load<uint32_t>(row + 1) != columns) {
+                    return false;
+                }
+                const uint8_t* member = row + BLOB_CONTAINER_HEADER_SIZE;
+                for (uint32_t m = 0; m < columns; ++m) {
+                    uint32_t key_len = blob_load<uint32_t>(member);
+                    std::string_view key(reinterpret_cast<const char*>(member + 4), key_len);
+                    const uint8_t* value = member + 4 + key_len;
+
+                    size_t col = ndjson_find_name(names, key, m);
+                    if (r == 0) {
+                        if (col != names.size()) {
+                            return false;
+                        }
+                        names.push_back(key);
+                    } else if (col == names.size()) {
+                        return false;
+                    }
+                    if (seen[col] == r) {
+                        return false;
+                    }
+                    seen[col] = r;
+
+                    BlobElementDataType type = blob_tag_type(*value);
+                    uint8_t encoding = blob_tag_encoding(*value);
+                    if (!blob_is_scalar(type) || (encoding != BLOB_ENCODING_DEFAULT && !blob_is_integer(type))) {
+                        return false;
+                    }
+                    if (type != NULL_VALUE) {
+                        if (types[col] == NULL_VALUE) {
+                            types[col] = type;
+                        } else if (types[col] != type) {
+                            return false;
+                        }
+                    }
+                    if (type == STRING || type == BINARY) {
+                        string_bytes[col] += blob_load<uint32_t>(value + 1);
+                    }
+                    member = value + blob_element_size(value);
+                }
+                row = member;
+            }
+            fragment.names.assign(names.begin(), names.end());
+            fragment.types = std::move(types);
+            fragment.string_bytes = std::move(string_bytes);
+            return true;
+        }
+
+        NdjsonFragment ndjson_parse_chunk(std::string_view chunk, size_t first_line) {
+            NdjsonFragment fragment;
+            BlobBuilder builder;
+            BlobBuilderVisitor visitor(builder);
+            builder.begin_array();
+            size_t line_number = first_line;
+            while (!chunk.empty()) {
+                size_t newline = chunk.find('\n');
+                std::string_view line = chunk.substr(0, newline);
+                chunk.remove_prefix(newline == std::string_view::npos ? chunk.size() : newline + 1);
+                ++line_number;
+                if (newline != std::string_view::npos) {
+                    ++fragment.lines;
+                }
+                if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+                    continue;
+                }
+                try {
+                    JsonReader<BlobBuilderVisitor> reader(line, visitor);
+                    reader.read_document();
+                } catch (const std::runtime_error& e) {
+                    throw NdjsonLineError(e.what(), line_number);
+                }
+            }
+            builder.end_array(false);
+            fragment.records = builder.build();
+            fragment.rows = fragment.records.root().size();
+            if (!ndjson_summarize_columns(fragment)) {
+                fragment.nested_columnar = blob_contains_columnar(fragment.records.root().data());
+            }
+            return fragment;
+        }
+
+        /**
+         * Merges the column summaries of the fragments into names and types, mapping each fragment column
+         * to its result column.  False when the fragments do not shred together.
+         */
+        bool ndjson_merge_columns(const std::vector<NdjsonFragment>& fragments, std::vector<std::string_view>& names,
+                                  std::vector<BlobElementDataType>& types, std::vector<std::vector<size_t>>& column_maps) {
+            column_maps.resize(fragments.size());
+            for (size_t f = 0; f < fragments.size(); ++f) {
+                const NdjsonFragment& fragment = fragments[f];
+                if (fragment.rows == 0) {
+                    continue;
+                }
+                if (fragment.names.empty()) {
+                    return false;
+                }
+                if (names.empty()) {
+                    names.assign(fragment.names.begin(), fragment.names.end());
+                    types = fragment.types;
+                } else if (fragment.names.size() != names.size()) {
+                    return false;
+                }
+                for (size_t c = 0; c < fragment.names.size(); ++c) {
+                    size_t col = ndjson_find_name(names, fragment.names[c], c);
+                    if (col == names.size()) {
+                        return false;
+                    }
+                    if (fragment.types[c] != NULL_VALUE) {
+                        if (types[col] == NULL_VALUE) {
+                            types[col] = fragment.types[c];
+                        } else if (types[col] != fragment.types[c]) {
+                            return false;
+                        }
+                    }
+                    column_maps[f].push_back(col);
+                }
+            }
+            return !names.empty();
+        }
+
+        /**
+         * Writes the fragments as one columnar ARRAY, the layout BlobBuilder::shred_array produces.  The
+         * layout is computed from the column summaries first, then every fragment writes its rows into
+         * place on its own task.  Returns an empty Blob if the result exceeds the container size limit.
+         */
+        Blob ndjson_write_columns(const std::vector<NdjsonFragment>& fragments, size_t rows, const std::vector<std::string_view>& names,
+                                  const std::vector<BlobElementDataType>& types, const std::vector<std::vector<size_t>>& column_maps,
+                                  Executor& executor, size_t threads) {
+            size_t columns = names.size();
+            std::vector<uint8_t> out;
+            out.push_back(blob_make_tag(ARRAY, BLOB_ENCODING_COLUMNAR));
+            blob_append<uint32_t>(out, static_cast<uint32_t>(rows));
+            blob_append<uint32_t>(out, 0);
+            blob_append<uint32_t>(out, static_cast<uint32_t>(columns));
+            std::vector<size_t> offsets_at(columns);
+            for (size_t c = 0; c < columns; ++c) {
+                blob_append<uint32_t>(out, static_cast<uint32_t>(names[c].size()));
+                out.insert(out.end(), names[c].begin(), names[c].end());
+                out.push_back(static_cast<uint8_t>(types[c]));
+                offsets_at[c] = out.size();
+                blob_append<uint32_t>(out, 0);
+                blob_append<uint32_t>(out, 0);
+            }
+
+            // First row of every fragment, and where its strings start in each column
+            std::vector<size_t> first_rows(fragments.size());
+            std::vector<std::vector<size_t>> first_chars(fragments.size(), std::vector<size_t>(columns, 0));
+            std::vector<size_t> chars(columns, 0);
+            for (size_t f = 0, row = 0; f < fragments.size(); ++f) {
+                first_rows[f] = row;
+                row += fragments[f].rows;
+                first_chars[f] = chars;
+                for (size_t c = 0; c < column_maps[f].size(); ++c) {
+                    chars[column_maps[f][c]] += fragments[f].string_bytes[c];
+                }
+            }
+
+            size_t bitmap_bytes = (rows + 7) / 8;
+            size_t size = out.size();
+            auto align = [&]() {
+                size = (size + BLOB_COLUMN_ALIGNMENT - 1) / BLOB_COLUMN_ALIGNMENT * BLOB_COLUMN_ALIGNMENT;
+            };
+            std::vector<size_t> validity(columns);
+            std::vector<size_t> values(columns);
+            for (size_t c = 0; c < columns; ++c) {
+                align();
+                validity[c] = size;
+                size += bitmap_bytes;
+                align();
+                values[c] = size;
+                switch (types[c]) {
+                    case NULL_VALUE: break;
+                    case BOOLEAN: size += bitmap_bytes; break;
+                    case STRING:
+                    case BINARY: size += sizeof(uint32_t) * (rows + 1) + chars[c]; break;
+                    default: size += 8 * rows; break;
+                }
+            }
+            if (size - BLOB_CONTAINER_HEADER_SIZE > UINT32_MAX) {
+                return Blob();
+            }
+            blob_patch<uint32_t>(out, 5, static_cast<uint32_t>(size - BLOB_CONTAINER_HEADER_SIZE));
+            for (size_t c = 0; c < columns; ++c) {
+                blob_patch<uint32_t>(out, offsets_at[c], static_cast<uint32_t>(validity[c]));
+                blob_patch<uint32_t>(out, offsets_at[c] + 4, static_cast<uint32_t>(values[c]));
+            }
+            out.resize(size, 0);
+            for (size_t c = 0; c < columns; ++c) {
+                if (types[c] == STRING || types[c] == BINARY) {
+                    blob_patch<uint32_t>(out, values[c] + sizeof(uint32_t) * rows, static_cast<uint32_t>(chars[c]));
+                }
+            }
+
+            uint8_t* base = out.data();
+            parallel_for(executor, fragments.size(), [&](size_t f) {
+                const NdjsonFragment& fragment = fragments[f];
+                if (fragment.rows == 0) {
+                    return;
+                }
+                size_t first = first_rows[f];
+                size_t last = first + fragment.rows - 1;
+                // Bitmap bytes shared with the neighbouring fragments are set atomically
+                auto set_bit = [&](size_t bitmap, size_t r) {
+                    uint8_t& byte = base[bitmap + (r >> 3)];
+                    uint8_t bit = static_cast<uint8_t>(1 << (r & 7));
+                    if ((r >> 3) == (first >> 3) || (r >> 3) == (last >> 3)) {
+                        std::atomic_ref<uint8_t>(byte).fetch_or(bit, std::memory_order_relaxed);
+                    } else {
+                        byte |= bit;
+                    }
+                };
+
+                std::vector<size_t> next_char = first_chars[f];
+                const uint8_t* row = fragment.records.root().data() + BLOB_CONTAINER_HEADER_SIZE;
+                for (size_t r = first; r <= last; ++r) {
+                    const uint8_t* member = row + BLOB_CONTAINER_HEADER_SIZE;
+                    for (size_t m = 0; m < columns; ++m) {
+                        uint32_t key_len = blob_load<uint32_t>(member);
+                        std::string_view key(reinterpret_cast<const char*>(member + 4), key_len);
+                        const uint8_t* value = member + 4 + key_len;
+                        size_t col = ndjson_find_name(names, key, m);
+                        bool present = *value != blob_make_tag(NULL_VALUE);
+                        if (present) {
+                            set_bit(validity[col], r);
+                        }
+                        switch (types[col]) {
+                            case NULL_VALUE:
+                                break;
+                            case BOOLEAN:
+                                if (present && value[1] != 0) {
+                                    set_bit(values[col], r);
+                                }
+                                break;
+                            case STRING:
+                            case BINARY: {
+                                uint32_t offset = static_cast<uint32_t>(next_char[col]);
+                                std::memcpy(base + values[col] + sizeof(uint32_t) * r, &offset, sizeof(offset));
+                                if (present) {
+                                    uint32_t len = blob_load<uint32_t>(value + 1);
+                                    std::memcpy(base + values[col] + sizeof(uint32_t) * (rows + 1) + next_char[col], value + 5, len);
+                                    next_char[col] += len;
+                                }
+                                break;
+                            }
+                            default:
+                                if (present) {
+                                    uint64_t bits = blob_scalar_bits(value);
+                                    std::memcpy(base + values[col] + 8 * r, &bits, sizeof(bits));
+                                }
+                                break;
+                        }
+                        member = value + blob_element_size(value);
+                    }
+                    row = member;
+                }
+            }, threads);
+            return Blob(std::move(out));
+        }
+
+        /**
+         * Writes the fragments as one row encoded ARRAY.  Elements are position independent, so each
+         * fragment's elements are copied in one piece on its own task.  Only when a fragment holding
+         * columnar data would land misaligned are its records appended one at a time instead, re-encoding
+         * the misaligned ones.
+         */
+        Blob ndjson_write_rows(const std::vector<NdjsonFragment>& fragments, size_t rows, Executor& executor, size_t threads) {
+            std::vector<size_t> starts(fragments.size());
+            size_t body = 0;
+            bool bulk = true;
+            for (size_t f = 0; f < fragments.size(); ++f) {
+                starts[f] = BLOB_CONTAINER_HEADER_SIZE + body;
+                if (fragments[f].nested_columnar && body % BLOB_COLUMN_ALIGNMENT != 0) {
+                    bulk = false;
+                }
+                body += fragments[f].records.size() - fragments[f].records.root_offset() - BLOB_CONTAINER_HEADER_SIZE;
+            }
+            if (body > UINT32_MAX) {
+                throw std::runtime_error("Blob container exceeds maximum size");
+            }
+
+            if (!bulk) {
+                BlobBuilder builder;
+                builder.reserve(BLOB_CONTAINER_HEADER_SIZE + body);
+                builder.begin_array();
+                for (const NdjsonFragment& fragment : fragments) {
+                    fragment.records.root().for_each_element([&](const BlobView& record) { builder.add_value(record); });
+                }
+                builder.end_array(false);
+                return builder.build();
+            }
+
+            std::vector<uint8_t> out;
+            out.push_back(blob_make_tag(ARRAY));
+            blob_append<uint32_t>(out, static_cast<uint32_t>(rows));
+            blob_append<uint32_t>(out, static_cast<uint32_t>(body));
+            out.resize(BLOB_CONTAINER_HEADER_SIZE + body);
+            uint8_t* base = out.data();
+            parallel_for(executor, fragments.size(), [&](size_t f) {
+                const uint8_t* array = fragments[f].records.root().data();
+                size_t size = blob_element_size(array) - BLOB_CONTAINER_HEADER_SIZE;
+                std::memcpy(base + starts[f], array + BLOB_CONTAINER_HEADER_SIZE, size);
+            }, threads);
+            return Blob(std::move(out));
+        }
+
+        Blob ndjson_concatenate(const std::vector<NdjsonFragment>& fragments, Executor& executor, size_t threads) {
+            size_t rows = 0;
+            for (const NdjsonFragment& fragment : fragments) {
+                rows += fragment.rows;
+            }
+            std::vector<std::string_view> names;
+            std::vector<BlobElementDataType> types;
+            std::vector<std::vector<size_t>> column_maps;
+            if (rows >= NDJSON_MIN_SHRED_ROWS && ndjson_merge_columns(fragments, names, types, column_maps)) {
+                Blob columns = ndjson_write_columns(fragments, rows, names, types, column_maps, executor, threads);
+                if (!columns.empty()) {
+                    return columns;
+                }
+            }
+            return ndjson_write_rows(fragments, rows, executor, threads);
+        }
+
+    } // namespace detail
+
+    Blob read_ndjson(std::string_view data, size_t threads) {
+        return read_ndjson(data, Executor::shared(), threads);
+    }
+
+    Blob read_ndjson(Source& source, size_t threads) {
+        std::string storage;
+        return read_ndjson(read_all(source, storage), threads);
+    }
+
+    Blob read_ndjson(std::string_view data, Executor& executor, size_t threads) {
+        if (threads == 0) {
+            threads = executor.size() + 1;
+        }
+        size_t chunk_size = std::max(detail::NDJSON_MIN_CHUNK_SIZE, data.size() / (threads * detail::NDJSON_CHUNKS_PER_THREAD) + 1);
+        std::vector<std::string_view> chunks = detail::ndjson_split(data, chunk_size);
+
+        // Errors are kept per chunk, so the one reported is the first in the input whatever thread hit it
+        std::vector<detail::NdjsonFragment> fragments(chunks.size());
+        std::vector<std::exception_ptr> errors(chunks.size());
+        parallel_for(executor, chunks.size(), [&](size_t c) {
+            try {
+                fragments[c] = detail::ndjson_parse_chunk(chunks[c], 0);
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        }, threads);
+
+        // Chunks number their lines from zero, the lines of the chunks before the failing one are added here
+        size_t lines = 0;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            if (errors[c]) {
+                try {
+                    std::rethrow_exception(errors[c]);
+                } catch (const detail::NdjsonLineError& e) {
+                    throw detail::NdjsonLineError(e.error(), lines + e.line());
+                }
+            }
+            lines += fragments[c].lines;
+        }
+
+        return detail::ndjson_concatenate(fragments, executor, threads);
+    }
+
+} // namespace pb
@@ -0,0 +1,199 @@
+#include <pb/string_util.h>
+
+#include <string>
+#include <string_view>
+
+namespace pb {
+
+namespace {
+
+    inline bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    inline bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool is_letter(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    /**
+     * A cursor over the text being classified.  Each check walks the text once, left to right, the way
+     * the patterns in string_util.h read.
+     */
+    struct Cursor {
+        std::string_view text;
+        size_t position = 0;
+
+        bool done() const { return position == text.size(); }
+
+        bool take(char c) {
+            if (position < text.size() && text[position] == c) {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        bool take_any(std::string_view characters) {
+            if (position < text.size() && characters.find(text[position]) != std::string_view::npos) {
+                ++position;
+                return true;
+            }
+            return false;
+        }
+
+        // Skips characters matching is_class, returning how many there were
+        template <typename Class>
+        size_t skip(Class is_class) {
+            size_t start = position;
+            while (position < text.size() && is_class(text[position])) {
+                ++position;
+            }
+            return position - start;
+        }
+
+        bool digits(size_t count) {
+            return skip(is_digit) == count;
+        }
+
+        // Optional exponent: e or E, an optional sign and at least one digit
+        bool exponent() {
+            if (!take_any("eE")) {
+                return true;
+            }
+            take_any("+-");
+            return skip(is_digit) > 0;
+        }
+    };
+
+    // Text without the whitespace the patterns allow around a value
+    inline Cursor trimmed(const std::string& str) {
+        size_t start = 0;
+        size_t end = str.size();
+        while (start < end && is_space(str[start])) {
+            ++start;
+        }
+        while (end > start && is_space(str[end - 1])) {
+            --end;
+        }
+        return Cursor{ std::string_view(str).substr(start, end - start) };
+    }
+
+    // 0, the prefix characters, then at least one digit accepted by is_class
+    template <typename Class>
+    bool is_prefixed(const std::string& str, std::string_view prefix, bool prefix_required, Class is_class) {
+        Cursor cursor = trimmed(str);
+        return cursor.take('0') && (cursor.take_any(prefix) || !prefix_required) && cursor.skip(is_class) > 0 && cursor.done();
+    }
+
+    // YYYY-MM-DD or YYYY/MM/DD, the separators chosen independently
+    bool is_year_first_date(Cursor cursor) {
+        return cursor.digits(4) && cursor.take_any("-/") && cursor.digits(2) && cursor.take_any("-/") && cursor.digits(2) && cursor.done();
+    }
+
+    // DD-MM-YYYY or MM/DD/YYYY, the separators chosen independently
+    bool is_year_last_date(Cursor cursor) {
+        return cursor.digits(2) && cursor.take_any("-/") && cursor.digits(2) && cursor.take_any("-/") && cursor.digits(4) && cursor.done();
+    }
+
+    // YYYY-MM-DD, 'T' or a space, HH:MM:SS, an optional fraction and an optional Z or +HH:MM offset
+    bool is_date_time(Cursor cursor) {
+        if (!(cursor.digits(4) && cursor.take('-') && cursor.digits(2) && cursor.take('-') && cursor.digits(2)
+              && cursor.take_any(" T") && cursor.digits(2) && cursor.take(':') && cursor.digits(2) && cursor.take(':') && cursor.digits(2))) {
+            return false;
+        }
+        if (cursor.take('.') && cursor.skip(is_digit) == 0) {
+            return false;
+        }
+        if (!cursor.take('Z') && cursor.take_any("+-")) {
+            if (!(cursor.digits(2) && cursor.take(':') && cursor.digits(2))) {
+                return false;
+            }
+        }
+        return cursor.done();
+    }
+
+    // "Jan 1, 2020" or "1 January 2020": a month name of 3 to 9 letters, day and year
+    bool is_month_name_date(Cursor cursor) {
+        auto month = [&]() {
+            size_t letters = cursor.skip(is_letter);
+            return letters >= 3 && letters <= 9;
+        };
+        auto day = [&]() {
+            size_t digits = cursor.skip(is_digit);
+            return digits >= 1 && digits <= 2;
+        };
+        if (is_letter(cursor.text.empty() ? 0 : cursor.text[0])) {
+            if (!(month() && cursor.skip(is_space) > 0 && day())) {
+                return false;
+            }
+            cursor.take(',');
+        } else if (!(day() && cursor.skip(is_space) > 0 && month())) {
+            return false;
+        }
+        return cursor.skip(is_space) > 0 && cursor.digits(4) && cursor.done();
+    }
+
+} // namespace
+
+bool is_numeric(const std::string& str) {
+    return is_double_with_optional_decimal(str);
+}
+
+bool is_integer(const std::string& str) {
+    Cursor cursor = trimmed(str);
+    cursor.take_any("+-");
+    return cursor.skip(is_digit) > 0 && cursor.done();
+}
+
+bool is_hexadecimal(const std::string& str) {
+    return is_prefixed(str, "xX", true, [](char c) { return is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f'); });
+}
+
+bool is_octal(const std::string& str) {
+    return is_prefixed(str, "oO", false, [](char c) { return c >= '0' && c <= '7'; });
+}
+
+bool is_binary(const std::string& str) {
+    return is_prefixed(str, "bB", true, [](char c) { return c == '0' || c == '1'; });
+}
+
+bool is_double(const std::string& str) {
+    Cursor cursor = trimmed(str);
+    cursor.take_any("+-");
+    return cursor.skip(is_digit) > 0 && cursor.take('.') && cursor.skip(is_digit) > 0 && cursor.exponent() && cursor.done();
+}
+
+bool is_double_with_optional_decimal(const std::string& str) {
+    Cursor cursor = trimmed(str);
+    cursor.take_any("+-");
+    size_t whole = cursor.skip(is_digit);
+    // Digits are required after a decimal point, or before it when there is none
+    if (cursor.take('.') ? cursor.skip(is_digit) == 0 : whole == 0) {
+        return false;
+    }
+    return cursor.exponent() && cursor.done();
+}
+
+bool is_boolean(const std::string& str) {
+    return parse_boolean(str).has_value();
+}
+
+bool is_real_number(const std::string& str) {
+    Cursor cursor = trimmed(str);
+    cursor.take_any("+-");
+    if (cursor.skip(is_digit) == 0 || (cursor.take('.') && cursor.skip(is_digit) == 0)) {
+        return false;
+    }
+    return cursor.exponent() && cursor.done();
+}
+
+bool is_date(const std::string& str) {
+    Cursor cursor = trimmed(str);
+    return is_year_first_date(cursor) || is_year_last_date(cursor) || is_date_time(cursor) || is_month_name_date(cursor);
+}
+
+} // namespace pb
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <pb/arrow.h>
+
+#include <cstring>
+
+
+TEST(ArrowTests, ExportCsvWithoutCopy)
+{
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV csv(properties);
+    csv.parse("city,zip\nOslo,0150\nBergen,5003\n");
+
+    ArrowArray array;
+    ArrowSchema schema;
+    pb::export_arrow(csv, &array, &schema);
+
+    ASSERT_STREQ(schema.format, "+s");
+    ASSERT_EQ(schema.n_children, 2);
+    ASSERT_STREQ(schema.children[0]->name, "city");
+    ASSERT_EQ(array.length, 2);
+
+    ArrowArray* city = array.children[0];
+    ASSERT_EQ(city->buffers[2], csv.get_column_data()[0]->chars().data());
+
+    // The buffers outlive the next parse
+    csv.parse("other\n");
+    const int32_t* offsets = static_cast<const int32_t*>(city->buffers[1]);
+    const char* chars = static_cast<const char*>(city->buffers[2]);
+    ASSERT_EQ(std::string(chars + offsets[1], offsets[2] - offsets[1]), "Bergen");
+
+    array.release(&array);
+    schema.release(&schema);
+    ASSERT_EQ(array.release, nullptr);
+}
+
+TEST(ArrowTests, ExportShreddedBlob)
+{
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    for (int i = 0; i < 10; ++i) {
+        builder.begin_object();
+        builder.key("price");
+        builder.add_double(i * 2.0);
+        builder.key("note");
+        if (i == 3) {
+            builder.add_null();
+        } else {
+            builder.add_string("n" + std::to_string(i));
+        }
+        builder.end_object();
+    }
+    builder.end_array();
+    auto blob = std::make_shared<const pb::Blob>(builder.build());
+
+    ArrowArray array;
+    ArrowSchema schema;
+    pb::export_arrow(blob, blob->root(), &array, &schema);
+
+    ASSERT_STREQ(schema.children[0]->format, "g");
+    ASSERT_STREQ(schema.children[1]->format, "u");
+    ASSERT_EQ(array.children[1]->null_count, 1);
+
+    const double* prices = static_cast<const double*>(array.children[0]->buffers[1]);
+    ASSERT_EQ(prices, blob->root().column("price").values<double>().data());
+    ASSERT_EQ(prices[9], 18.0);
+
+    const uint8_t* validity = static_cast<const uint8_t*>(array.children[1]->buffers[0]);
+    ASSERT_FALSE(validity[0] & (1 << 3));
+
+    array.release(&array);
+    schema.release(&schema);
+}
+
+TEST(ArrowTests, RowBlobIsRejected)
+{
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    builder.add_int(1);
+    builder.end_array();
+    auto blob = std::make_shared<const pb::Blob>(builder.build());
+
+    ArrowArray array;
+    ArrowSchema schema;
+    ASSERT_THROW(pb::export_arrow(blob, blob->root(), &array, &schema), std::runtime_error);
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <pb/async.h>
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    // Starts eagerly and frees itself at the end, like a task spawned on an event loop
+    struct Spawned {
+        struct promise_type {
+            Spawned get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    struct CsvResult {
+        std::vector<std::vector<std::string>> rows;
+        std::vector<size_t> batch_sizes;
+        std::string first_column;
+        std::string error;
+        bool done = false;
+    };
+
+    Spawned collect_csv(pb::AsyncGenerator<pb::CSV> batches, CsvResult& result) {
+        try {
+            while (auto batch = co_await batches.next()) {
+                if (result.batch_sizes.empty()) {
+                    result.first_column = batch->get_column_name(0);
+                }
+                result.batch_sizes.push_back(batch->get_row_count());
+                for (const auto& row : batch->getData()) {
+                    result.rows.push_back(row);
+                }
+            }
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        result.done = true;
+    }
+
+    struct NdjsonResult {
+        std::vector<size_t> batch_sizes;
+        int64_t sum = 0;
+        std::string error;
+        bool done = false;
+    };
+
+    Spawned collect_ndjson(pb::AsyncGenerator<pb::Blob> batches, NdjsonResult& result) {
+        try {
+            while (auto batch = co_await batches.next()) {
+                result.batch_sizes.push_back(batch->root().size());
+                for (size_t i = 0; i < batch->root().size(); ++i) {
+                    result.sum += batch->root()[i]["n"].as_int();
+                }
+            }
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        result.done = true;
+    }
+
+    void push_in_pieces(pb::AsyncInput& input, std::string_view text, size_t piece) {
+        for (size_t i = 0; i < text.size(); i += piece) {
+            input.push(text.substr(i, piece));
+        }
+    }
+
+}
+
+
+TEST(AsyncTests, CsvBatchesAcrossPieces)
+{
+    std::string text = "name,note\n";
+    for (int i = 0; i < 25; ++i) {
+        text += "row" + std::to_string(i) + ",\"line one\nline two, " + std::to_string(i) + "\"\n";
+    }
+
+    for (size_t piece : { size_t(1), size_t(7), text.size() }) {
+        pb::AsyncInput input;
+        pb::CSVProperties properties;
+        properties.set_has_header(true);
+        CsvResult result;
+        collect_csv(pb::read_csv_async(input, properties, 10), result);
+        push_in_pieces(input, text, piece);
+        ASSERT_FALSE(result.done);
+        input.close();
+        ASSERT_TRUE(result.done);
+        ASSERT_EQ(result.error, "");
+
+        ASSERT_EQ(result.batch_sizes, (std::vector<size_t>{ 10, 10, 5 }));
+        ASSERT_EQ(result.first_column, "name");
+        ASSERT_EQ(result.rows.size(), 25u);
+        ASSERT_EQ(result.rows[0][0], "row0");
+        ASSERT_EQ(result.rows[24][1], "line one\nline two, 24");
+    }
+
+    // Without a trailing newline the last record arrives on close
+    pb::AsyncInput input;
+    CsvResult result;
+    collect_csv(pb::read_csv_async(input), result);
+    input.push("a\tb\n1\t2");
+    ASSERT_TRUE(result.rows.empty());
+    input.close();
+    ASSERT_EQ(result.rows.size(), 2u);
+    ASSERT_EQ(result.rows[1][1], "2");
+}
+
+TEST(AsyncTests, NdjsonBatchesAndErrors)
+{
+    std::string text;
+    for (int i = 1; i <= 7; ++i) {
+        text += "{\"n\": " + std::to_string(i) + "}\n";
+    }
+
+    pb::AsyncInput input;
+    NdjsonResult result;
+    collect_ndjson(pb::read_ndjson_async(input, 3), result);
+    push_in_pieces(input, text, 5);
+    input.close();
+    ASSERT_TRUE(result.done);
+    ASSERT_EQ(result.batch_sizes, (std::vector<size_t>{ 3, 3, 1 }));
+    ASSERT_EQ(result.sum, 28);
+
+    // Line numbers count from the start of the input, not the batch
+    pb::AsyncInput broken;
+    NdjsonResult failed;
+    collect_ndjson(pb::read_ndjson_async(broken, 2), failed);
+    broken.push(text.substr(0, text.find("{\"n\": 5}")));
+    broken.push("{\"n\": }\n");
+    broken.push("{\"n\": 6}\n");
+    ASSERT_TRUE(failed.done);
+    ASSERT_NE(failed.error.find("line 5"), std::string::npos) << failed.error;
+    ASSERT_EQ(failed.sum, 10);
+}
+
+TEST(AsyncTests, FailedInputReachesTheConsumer)
+{
+    pb::AsyncInput input;
+    CsvResult result;
+    collect_csv(pb::read_csv_async(input), result);
+    input.push("a,b\n");
+    input.fail(std::make_exception_ptr(std::runtime_error("connection reset")));
+    ASSERT_TRUE(result.done);
+    ASSERT_EQ(result.error, "connection reset");
+    ASSERT_TRUE(input.closed());
+    ASSERT_THROW(input.push("c,d\n"), std::runtime_error);
+}
+
+TEST(AsyncTests, GeneratorDestroyedWhileWaiting)
+{
+    pb::AsyncInput input;
+    {
+        pb::AsyncGenerator<pb::Blob> batches = pb::read_ndjson_async(input);
+        // Run the parser until it waits for input, without a consumer coroutine
+        auto next = batches.next();
+        ASSERT_FALSE(next.await_ready());
+        next.await_suspend(std::noop_coroutine()).resume();
+    }
+    // The parser is gone, so pushing must not resume it
+    input.push("{\"n\": 1}\n");
+    ASSERT_EQ(input.buffered(), 9u);
+}
+
+TEST(AsyncTests, ManyStreamsOnOneThread)
+{
+    const size_t streams = 100;
+    std::vector<std::unique_ptr<pb::AsyncInput>> inputs;
+    std::vector<NdjsonResult> results(streams);
+    for (size_t s = 0; s < streams; ++s) {
+        inputs.push_back(std::make_unique<pb::AsyncInput>());
+        collect_ndjson(pb::read_ndjson_async(*inputs[s], 4), results[s]);
+    }
+
+    // Interleave the streams line by line, as an event loop would
+    for (int i = 1; i <= 20; ++i) {
+        std::string line = "{\"n\": " + std::to_string(i) + "}\n";
+        for (size_t s = 0; s < streams; ++s) {
+            if (i <= static_cast<int>(s % 20) + 1) {
+                push_in_pieces(*inputs[s], line, 3);
+            }
+        }
+    }
+    for (size_t s = 0; s < streams; ++s) {
+        inputs[s]->close();
+        int64_t lines = static_cast<int64_t>(s % 20) + 1;
+        ASSERT_TRUE(results[s].done);
+        ASSERT_EQ(results[s].sum, lines * (lines + 1) / 2);
+    }
+}
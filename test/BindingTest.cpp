@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <pb/binding.h>
+
+
+struct Address {
+    std::string city;
+    uint16_t zip = 0;
+};
+
+struct Person {
+    std::string name;
+    int age = 0;
+    double score = 0;
+    bool active = false;
+    std::optional<std::string> nickname;
+    std::vector<int64_t> visits;
+    Address address;
+    pb::BlobDate joined;
+};
+
+PB_BIND(Address, PB_FIELD(Address, city), PB_FIELD(Address, zip))
+PB_BIND(Person, PB_FIELD(Person, name), PB_FIELD(Person, age), PB_FIELD(Person, score), PB_FIELD(Person, active),
+        PB_FIELD(Person, nickname), PB_FIELD(Person, visits), PB_FIELD(Person, address), PB_FIELD(Person, joined))
+
+struct Trade {
+    int64_t id = 0;
+    double price = 0;
+    float quantity = 0;
+    std::string symbol;
+    std::optional<int> venue;
+};
+
+PB_BIND(Trade, PB_FIELD(Trade, id), PB_FIELD(Trade, price), PB_FIELD(Trade, quantity), PB_FIELD(Trade, symbol),
+        PB_FIELD(Trade, venue))
+
+TEST(BindingTests, DecodesJsonInAnyKeyOrder)
+{
+    Person person = pb::from_json<Person>(R"({
+        "address": {"zip": 12345, "city": "Oslo"},
+        "unknown": [1, 2, 3],
+        "name": "Ada", "age": 36, "score": 9, "active": true,
+        "visits": [1, 5, 9], "nickname": null
+    })");
+    ASSERT_EQ(person.name, "Ada");
+    ASSERT_EQ(person.age, 36);
+    ASSERT_EQ(person.score, 9.0);
+    ASSERT_TRUE(person.active);
+    ASSERT_FALSE(person.nickname.has_value());
+    ASSERT_EQ(person.visits, (std::vector<int64_t>{ 1, 5, 9 }));
+    ASSERT_EQ(person.address.city, "Oslo");
+    ASSERT_EQ(person.address.zip, 12345);
+}
+
+TEST(BindingTests, EncodeDecodeRoundTrip)
+{
+    Person person;
+    person.name = "Grace";
+    person.age = 85;
+    person.score = 1.5;
+    person.nickname = "amazing";
+    person.address = { "Arlington", 22201 };
+    person.joined = pb::BlobDate(std::chrono::milliseconds(1700000000000));
+    for (int i = 0; i < 100; ++i) {
+        person.visits.push_back(1000 + i);
+    }
+
+    pb::Blob blob = pb::to_blob(person);
+    ASSERT_TRUE(blob.root()["visits"].is_delta());
+    ASSERT_EQ(blob.root()["joined"].type(), pb::DATE);
+
+    Person copy = pb::from_blob<Person>(blob);
+    ASSERT_EQ(copy.name, person.name);
+    ASSERT_EQ(copy.nickname, person.nickname);
+    ASSERT_EQ(copy.visits, person.visits);
+    ASSERT_EQ(copy.address.zip, person.address.zip);
+    ASSERT_EQ(copy.joined, person.joined);
+    ASSERT_EQ(pb::to_json(copy), pb::write_json(blob));
+}
+
+/**
+ * This test checks that a vector of structs decodes from a columnar ARRAY, the column by column path,
+ * with nulls and widening conversions.
+ */
+TEST(BindingTests, DecodesColumnarArrays)
+{
+    std::vector<Trade> trades;
+    for (int i = 0; i < 500; ++i) {
+        Trade trade;
+        trade.id = i;
+        trade.price = 100 + i * 0.25;
+        trade.quantity = static_cast<float>(i % 7);
+        trade.symbol = i % 2 ? "ABC" : "XYZ";
+        if (i % 3 == 0) {
+            trade.venue = i % 4;
+        }
+        trades.push_back(trade);
+    }
+    pb::Blob blob = pb::to_blob(trades);
+    ASSERT_TRUE(blob.root().is_columnar());
+
+    std::vector<Trade> decoded = pb::from_blob<std::vector<Trade>>(blob);
+    ASSERT_EQ(decoded.size(), 500);
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        ASSERT_EQ(decoded[i].id, trades[i].id);
+        ASSERT_EQ(decoded[i].price, trades[i].price);
+        ASSERT_EQ(decoded[i].quantity, trades[i].quantity);
+        ASSERT_EQ(decoded[i].symbol, trades[i].symbol);
+        ASSERT_EQ(decoded[i].venue, trades[i].venue);
+    }
+}
+
+TEST(BindingTests, RejectsMismatchedValues)
+{
+    ASSERT_THROW(pb::from_json<Address>(R"({"city": "x", "zip": 70000})"), std::runtime_error);
+    ASSERT_THROW(pb::from_json<Address>(R"({"city": 5})"), std::runtime_error);
+    ASSERT_THROW(pb::from_json<Trade>(R"({"id": 1.5})"), std::runtime_error);
+    ASSERT_THROW(pb::from_json<std::vector<int>>(R"({"a": 1})"), std::runtime_error);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <pb/blob_archive.h>
+
+
+static pb::Blob build_catalog() {
+    pb::BlobBuilder builder;
+    builder.begin_object();
+    builder.key("name");
+    builder.add_string("catalog");
+    builder.key("notes");
+    builder.begin_array();
+    for (int i = 0; i < 5000; ++i) {
+        builder.add_string("note number " + std::to_string(i));
+    }
+    builder.end_array();
+    builder.key("items");
+    builder.begin_array();
+    for (int i = 0; i < 2000; ++i) {
+        builder.begin_object();
+        builder.key("id");
+        builder.add_int(i);
+        builder.key("price");
+        builder.add_double(i * 0.25);
+        builder.end_object();
+    }
+    builder.end_array();
+    builder.key("last");
+    builder.add_int(7);
+    builder.end_object();
+    return builder.build();
+}
+
+TEST(BlobArchiveTests, RoundTripLZ4)
+{
+    pb::Blob blob = build_catalog();
+    pb::BlobBlockCodecLZ4 codec;
+    std::vector<uint8_t> archive = pb::write_blob_archive(blob, codec, 4096);
+    ASSERT_LT(archive.size(), blob.size() / 2);
+
+    pb::BlobArchiveReader reader(archive, codec);
+    pb::Blob copy = reader.to_blob();
+    ASSERT_EQ(copy.size(), blob.size());
+    ASSERT_EQ(std::memcmp(copy.data(), blob.data(), blob.size()), 0);
+}
+
+/**
+ * This test checks that a point lookup only decompresses the blocks along its path and that the LRU
+ * serves repeated lookups without decompressing again.
+ */
+TEST(BlobArchiveTests, PointLookupDecodesFewBlocks)
+{
+    pb::Blob blob = build_catalog();
+    pb::BlobBlockCodecLZ4 codec;
+    std::vector<uint8_t> archive = pb::write_blob_archive(blob, codec, 4096);
+    size_t blocks = (blob.size() + 4095) / 4096;
+
+    pb::BlobArchiveReader reader(archive, codec, 4);
+    ASSERT_EQ(reader.at("/last").root().as_int(), 7);
+    ASSERT_LT(reader.blocks_decoded(), blocks / 2);
+
+    size_t decoded = reader.blocks_decoded();
+    ASSERT_EQ(reader.at("/last").root().as_int(), 7);
+    ASSERT_EQ(reader.blocks_decoded(), decoded);
+
+    ASSERT_EQ(reader.at("/notes/4321").root().as_string(), "note number 4321");
+    ASSERT_EQ(reader.at("/items/1500/price").root().as_double(), 375.0);
+    ASSERT_THROW(reader.at("/missing"), std::out_of_range);
+}
+
+TEST(BlobArchiveTests, ColumnarElementKeepsAlignment)
+{
+    pb::Blob blob = build_catalog();
+    pb::BlobBlockCodecLZ4 codec;
+    std::vector<uint8_t> archive = pb::write_blob_archive(blob, codec, 4096);
+
+    pb::BlobArchiveReader reader(archive, codec);
+    pb::Blob items = reader.at("/items");
+    ASSERT_TRUE(items.root().is_columnar());
+    ASSERT_EQ(items.root().column("price").values<double>()[8], 2.0);
+}
+
+TEST(BlobArchiveTests, CodecMismatchThrows)
+{
+    pb::BlobBlockCodecLZ4 lz4;
+    pb::BlobBlockCodecNone none;
+    std::vector<uint8_t> archive = pb::write_blob_archive(build_catalog(), lz4);
+
+    ASSERT_THROW(pb::BlobArchiveReader(archive, none), std::runtime_error);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <pb/blob_compare.h>
+#include <pb/json.h>
+
+#include <unordered_set>
+
+
+static pb::Blob build_rows(bool encode, int changed_row) {
+    pb::BlobBuilder builder;
+    builder.set_shred_arrays(encode);
+    builder.set_delta_arrays(encode);
+    builder.set_compact_integers(encode);
+    builder.begin_object();
+    builder.key("ids");
+    builder.begin_array();
+    for (int i = 0; i < 300; ++i) {
+        builder.add_int(1000 + 2 * i);
+    }
+    builder.end_array();
+    builder.key("rows");
+    builder.begin_array();
+    for (int i = 0; i < 50; ++i) {
+        builder.begin_object();
+        builder.key("n");
+        builder.add_int(i == changed_row ? -1 : i);
+        builder.key("s");
+        builder.add_string("v" + std::to_string(i));
+        builder.end_object();
+    }
+    builder.end_array();
+    builder.end_object();
+    return builder.build();
+}
+
+/**
+ * This test checks that equality and hashing look at values, not at how they happen to be encoded.
+ */
+TEST(BlobCompareTests, EqualAcrossEncodings)
+{
+    pb::Blob encoded = build_rows(true, -1);
+    pb::Blob plain = build_rows(false, -1);
+    ASSERT_TRUE(encoded.root()["ids"].is_delta());
+    ASSERT_TRUE(encoded.root()["rows"].is_columnar());
+    ASSERT_NE(encoded.size(), plain.size());
+
+    ASSERT_TRUE(encoded == plain);
+    ASSERT_EQ(pb::hash(encoded), pb::hash(plain));
+    ASSERT_TRUE(encoded.root()["rows"][7] == plain.root()["rows"][7]);
+
+    pb::Blob changed = build_rows(true, 42);
+    ASSERT_FALSE(encoded == changed);
+    ASSERT_NE(pb::hash(encoded), pb::hash(changed));
+}
+
+TEST(BlobCompareTests, ObjectOrderDoesNotMatter)
+{
+    pb::Blob a = pb::read_json(R"({"a": 1, "b": [1, 2], "c": {"x": null, "y": -0.0}})");
+    pb::Blob b = pb::read_json(R"({"c": {"y": 0.0, "x": null}, "b": [1, 2], "a": 1})");
+    pb::Blob c = pb::read_json(R"({"a": 1, "b": [2, 1], "c": {"x": null, "y": 0.0}})");
+    ASSERT_TRUE(a == b);
+    ASSERT_EQ(pb::hash(a), pb::hash(b));
+    ASSERT_FALSE(a == c);
+    ASSERT_NE(pb::hash(a), pb::hash(c));
+    ASSERT_FALSE(pb::read_json("1") == pb::read_json("1.0"));
+
+    std::unordered_set<pb::Blob> unique;
+    unique.insert(a);
+    unique.insert(b);
+    unique.insert(c);
+    ASSERT_EQ(unique.size(), 2);
+}
+
+TEST(BlobCompareTests, LargeObjectsMatchByKey)
+{
+    std::string forward = "{", backward = "{";
+    for (int i = 0; i < 100; ++i) {
+        forward += (i ? "," : "") + std::string("\"k") + std::to_string(i) + "\":" + std::to_string(i);
+        backward += (i ? "," : "") + std::string("\"k") + std::to_string(99 - i) + "\":" + std::to_string(99 - i);
+    }
+    ASSERT_TRUE(pb::read_json(forward + "}") == pb::read_json(backward + "}"));
+}
+
+TEST(BlobCompareTests, DiffProducesJsonPatch)
+{
+    pb::Blob a = pb::read_json(R"({"name": "pb", "tags": ["a", "b", "c"], "meta": {"v": 1, "old": true, "a/b": 1}})");
+    pb::Blob b = pb::read_json(R"({"name": "pb", "tags": ["a", "x"], "meta": {"v": 2, "a/b": 1, "new": [1]}})");
+
+    pb::Blob patch = pb::diff(a, b);
+    ASSERT_EQ(pb::write_json(patch),
+              R"([{"op":"replace","path":"/tags/1","value":"x"},)"
+              R"({"op":"remove","path":"/tags/2"},)"
+              R"({"op":"replace","path":"/meta/v","value":2},)"
+              R"({"op":"remove","path":"/meta/old"},)"
+              R"({"op":"add","path":"/meta/new","value":[1]}])");
+    ASSERT_TRUE(pb::apply_patch(a, patch) == b);
+    ASSERT_TRUE(pb::apply_patch(b, pb::diff(b, a)) == a);
+    ASSERT_EQ(pb::diff(a, a).root().size(), 0);
+}
+
+TEST(BlobCompareTests, DiffOfEncodedArrays)
+{
+    pb::Blob a = build_rows(true, -1);
+    pb::Blob b = build_rows(true, 42);
+    pb::Blob patch = pb::diff(a, b);
+    ASSERT_EQ(pb::write_json(patch), R"([{"op":"replace","path":"/rows/42/n","value":-1}])");
+    ASSERT_TRUE(pb::apply_patch(a, patch) == b);
+}
+
+TEST(BlobCompareTests, ApplyPatchRejectsUnsupportedEdits)
+{
+    pb::Blob document = pb::read_json(R"({"list": [1, 2, 3]})");
+    ASSERT_TRUE(pb::apply_patch(document, pb::read_json(R"([{"op":"add","path":"/list/-","value":4}])"))
+                == pb::read_json(R"({"list": [1, 2, 3, 4]})"));
+    ASSERT_TRUE(pb::apply_patch(document, pb::read_json(R"([{"op":"replace","path":"","value":7}])"))
+                == pb::read_json("7"));
+    ASSERT_THROW(pb::apply_patch(document, pb::read_json(R"([{"op":"add","path":"/list/0","value":0}])")), std::runtime_error);
+    ASSERT_THROW(pb::apply_patch(document, pb::read_json(R"([{"op":"remove","path":"/list/0"}])")), std::runtime_error);
+    ASSERT_THROW(pb::apply_patch(document, pb::read_json(R"([{"op":"move","from":"/list","path":"/x"}])")), std::runtime_error);
+    ASSERT_THROW(pb::apply_patch(document, pb::read_json(R"([{"op":"remove","path":"/missing"}])")), std::runtime_error);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <pb/blob_archive.h>
+#include <pb/blob_schema.h>
+
+
+TEST(BlobSchemaTests, InfersTypesRangesAndNullability)
+{
+    pb::Blob blob = pb::read_json(R"([
+        {"id": 1, "name": "ann", "score": 2.5, "tags": [1, 2]},
+        {"id": 2, "name": "bob", "score": null},
+        {"id": -3, "name": "célia", "score": 7}
+    ])");
+    pb::BlobSchema schema;
+    schema.add(blob);
+
+    const pb::BlobSchemaNode& rows = *schema.root().items;
+    ASSERT_EQ(rows.object_count, 3);
+    ASSERT_TRUE(rows.is_required("id"));
+    ASSERT_TRUE(rows.is_required("score"));
+    ASSERT_FALSE(rows.is_required("tags"));
+
+    const pb::BlobSchemaNode& id = *rows.property("id");
+    ASSERT_EQ(id.int_min, -3);
+    ASSERT_EQ(id.int_max, 2);
+    ASSERT_EQ(id.distinct(), 3);
+
+    const pb::BlobSchemaNode& name = *rows.property("name");
+    ASSERT_EQ(name.length_min, 3);
+    ASSERT_EQ(name.length_max, 5);
+
+    const pb::BlobSchemaNode& score = *rows.property("score");
+    ASSERT_TRUE(score.has(pb::NULL_VALUE));
+    ASSERT_TRUE(score.has(pb::FLOAT));
+    ASSERT_EQ(score.null_count, 1);
+
+    pb::Blob json_schema = schema.to_json_schema();
+    pb::BlobView properties = json_schema.root()["items"]["properties"];
+    ASSERT_EQ(properties["id"]["type"].as_string(), "integer");
+    ASSERT_EQ(properties["id"]["minimum"].as_int(), -3);
+    ASSERT_EQ(properties["score"]["type"][0].as_string(), "null");
+    ASSERT_EQ(properties["score"]["type"][1].as_string(), "number");
+    ASSERT_EQ(properties["score"]["maximum"].as_double(), 7.0);
+    ASSERT_EQ(properties["score"]["x-null-count"].as_uint(), 1);
+    ASSERT_EQ(properties["tags"]["items"]["type"].as_string(), "integer");
+    ASSERT_EQ(json_schema.root()["items"]["required"].size(), 3);
+}
+
+/**
+ * This test checks that columnar and delta arrays, which are summarized without visiting their
+ * elements one by one, give the same schema as their row encoded form.
+ */
+TEST(BlobSchemaTests, EncodedArraysMatchRowArrays)
+{
+    auto build = [](bool encode) {
+        pb::BlobBuilder builder;
+        builder.set_shred_arrays(encode);
+        builder.set_delta_arrays(encode);
+        builder.begin_object();
+        builder.key("rows");
+        builder.begin_array();
+        for (int i = 0; i < 100; ++i) {
+            builder.begin_object();
+            builder.key("id");
+            builder.add_int(i);
+            builder.key("label");
+            if (i % 10 == 0) {
+                builder.add_null();
+            } else {
+                builder.add_string("l" + std::to_string(i % 7));
+            }
+            builder.key("at");
+            builder.add_date(1700000000000 + i);
+            builder.end_object();
+        }
+        builder.end_array();
+        builder.key("ids");
+        builder.begin_array();
+        for (int i = 0; i < 1000; ++i) {
+            builder.add_uint(5000 + 3 * i);
+        }
+        builder.end_array();
+        builder.end_object();
+        return builder.build();
+    };
+    pb::Blob encoded = build(true);
+    pb::Blob rows = build(false);
+    ASSERT_TRUE(encoded.root()["rows"].is_columnar());
+    ASSERT_TRUE(encoded.root()["ids"].is_delta());
+
+    pb::BlobSchema encoded_schema;
+    encoded_schema.add(encoded);
+    pb::BlobSchema row_schema;
+    row_schema.add(rows);
+
+    pb::Blob a = encoded_schema.to_json_schema();
+    pb::Blob b = row_schema.to_json_schema();
+    ASSERT_EQ(a.root()["properties"]["rows"]["x-pb-encoding"].as_string(), "columnar");
+    ASSERT_EQ(a.root()["properties"]["ids"]["x-pb-encoding"].as_string(), "delta");
+
+    pb::BlobView label = a.root()["properties"]["rows"]["items"]["properties"]["label"];
+    ASSERT_EQ(label["x-null-count"].as_uint(), 10);
+    ASSERT_EQ(label["x-distinct"].as_uint(), 7);
+    pb::BlobView at = a.root()["properties"]["rows"]["items"]["properties"]["at"];
+    ASSERT_EQ(at["format"].as_string(), "date-time");
+    ASSERT_EQ(at["formatMinimum"].as_date(), 1700000000000);
+    pb::BlobView ids = a.root()["properties"]["ids"]["items"];
+    ASSERT_EQ(ids["minimum"].as_uint(), 5000);
+    ASSERT_EQ(ids["maximum"].as_uint(), 5000 + 3 * 999);
+
+    const pb::BlobSchemaNode& id_a = *encoded_schema.root().property("ids")->items;
+    const pb::BlobSchemaNode& id_b = *row_schema.root().property("ids")->items;
+    ASSERT_EQ(id_a.registers, id_b.registers);
+    ASSERT_GT(id_a.distinct(), 900);
+    ASSERT_LT(id_a.distinct(), 1100);
+}
+
+TEST(BlobSchemaTests, MergeCombinesStreams)
+{
+    pb::BlobSchema first;
+    first.add(pb::read_json(R"({"a": 1, "b": "x"})"));
+    pb::BlobSchema second;
+    second.add(pb::read_json(R"({"a": 10.5})"));
+    second.add(pb::read_json(R"({"a": null, "c": true})"));
+    first.merge(second);
+
+    const pb::BlobSchemaNode& root = first.root();
+    ASSERT_EQ(root.object_count, 3);
+    ASSERT_TRUE(root.is_required("a"));
+    ASSERT_FALSE(root.is_required("b"));
+    ASSERT_EQ(root.properties[2].first, "c");
+    ASSERT_EQ(root.property("a")->int_max, 1);
+    ASSERT_EQ(root.property("a")->double_max, 10.5);
+    ASSERT_EQ(root.property("a")->null_count, 1);
+}
+
+TEST(BlobSchemaTests, SchemaTravelsInArchiveMetadata)
+{
+    pb::Blob blob = pb::read_json(R"({"name": "pb", "size": 3})");
+    pb::store_schema(blob);
+    blob.set_metadata("format", "json");
+
+    pb::BlobBlockCodecLZ4 codec;
+    std::vector<uint8_t> archive = pb::write_blob_archive(blob, codec);
+    pb::BlobArchiveReader reader(archive, codec);
+    ASSERT_EQ(reader.metadata().at("format"), "json");
+    ASSERT_EQ(reader.blocks_decoded(), 0);
+
+    pb::Blob restored = reader.to_blob();
+    std::optional<std::string_view> text = restored.get_metadata(pb::BLOB_SCHEMA_METADATA_KEY);
+    ASSERT_TRUE(text.has_value());
+    pb::Blob schema = pb::read_json(*text);
+    ASSERT_EQ(schema.root()["type"].as_string(), "object");
+    ASSERT_EQ(schema.root()["properties"]["size"]["x-pb-type"].as_string(), "INTEGER");
+    ASSERT_FALSE(restored.get_metadata("missing").has_value());
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <pb/blob.h>
+
+#include <numeric>
+
+
+static pb::Blob build_orders(size_t rows) {
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    for (size_t i = 0; i < rows; ++i) {
+        builder.begin_object();
+        builder.key("id");
+        builder.add_int(static_cast<int64_t>(i));
+        builder.key("price");
+        builder.add_double(i * 0.5);
+        builder.key("name");
+        builder.add_string("item" + std::to_string(i));
+        builder.key("paid");
+        if (i % 3 == 0) {
+            builder.add_null();
+        } else {
+            builder.add_bool(i % 2 == 0);
+        }
+        builder.end_object();
+    }
+    builder.end_array();
+    return builder.build();
+}
+
+TEST(BlobTests, BuildObject)
+{
+    pb::BlobBuilder builder;
+    builder.begin_object();
+    builder.key("name");
+    builder.add_string("blob");
+    builder.key("size");
+    builder.add_uint(42);
+    builder.key("tags");
+    builder.begin_array();
+    builder.add_string("a");
+    builder.add_int(-1);
+    builder.end_array();
+    builder.end_object();
+    pb::Blob blob = builder.build();
+
+    pb::BlobView root = blob.root();
+    ASSERT_EQ(root.type(), pb::OBJECT);
+    ASSERT_EQ(root.size(), 3);
+    ASSERT_EQ(root["name"].as_string(), "blob");
+    ASSERT_EQ(root["size"].as_uint(), 42);
+    ASSERT_FALSE(root["tags"].is_columnar());
+    ASSERT_EQ(root["tags"][1].as_int(), -1);
+    ASSERT_THROW(root["missing"], std::out_of_range);
+}
+
+TEST(BlobTests, BuilderRejectsValueWithoutKey)
+{
+    pb::BlobBuilder builder;
+    builder.begin_object();
+
+    ASSERT_THROW(builder.add_int(1), std::runtime_error);
+}
+
+/**
+ * This test checks that an array of same-shaped objects is shredded into columns and that scans
+ * can run directly over the contiguous values.
+ */
+TEST(BlobTests, ShredHomogeneousArray)
+{
+    pb::Blob blob = build_orders(1000);
+    pb::BlobView root = blob.root();
+
+    ASSERT_TRUE(root.is_columnar());
+    ASSERT_EQ(root.size(), 1000);
+    ASSERT_EQ(root.column_count(), 4);
+
+    std::span<const double> prices = root.column("price").values<double>();
+    ASSERT_EQ(std::accumulate(prices.begin(), prices.end(), 0.0), 0.5 * 999 * 1000 / 2);
+
+    pb::BlobColumn paid = root.column("paid");
+    ASSERT_EQ(paid.type(), pb::BOOLEAN);
+    ASSERT_EQ(paid.null_count(), 334);
+    ASSERT_THROW(paid.values<double>(), std::runtime_error);
+}
+
+TEST(BlobTests, ShreddedRowsReadAsObjects)
+{
+    pb::Blob blob = build_orders(10);
+    pb::BlobView row = blob.root()[7];
+
+    ASSERT_EQ(row.type(), pb::OBJECT);
+    ASSERT_EQ(row["id"].as_int(), 7);
+    ASSERT_EQ(row["name"].as_string(), "item7");
+    ASSERT_FALSE(row["paid"].as_bool());
+    ASSERT_TRUE(blob.root()[6]["paid"].is_null());
+}
+
+TEST(BlobTests, MixedArrayIsNotShredded)
+{
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    builder.begin_object();
+    builder.key("a");
+    builder.add_int(1);
+    builder.end_object();
+    builder.begin_object();
+    builder.key("a");
+    builder.add_string("1");
+    builder.end_object();
+    builder.end_array();
+    pb::Blob blob = builder.build();
+
+    ASSERT_FALSE(blob.root().is_columnar());
+    ASSERT_EQ(blob.root()[1]["a"].as_string(), "1");
+}
+
+TEST(BlobTests, CompactIntegers)
+{
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    builder.add_int(-5);
+    builder.add_int(70000);
+    builder.add_uint(200);
+    builder.add_date(1700000000000);
+    builder.end_array();
+    pb::Blob blob = builder.build();
+
+    // 9 byte header, 2 + 5 + 2 + 9 byte elements
+    ASSERT_EQ(blob.size(), 27);
+    ASSERT_EQ(blob.root()[0].as_int(), -5);
+    ASSERT_EQ(blob.root()[1].as_int(), 70000);
+    ASSERT_EQ(blob.root()[2].as_uint(), 200);
+    ASSERT_EQ(blob.root()[3].as_date(), 1700000000000);
+}
+
+/**
+ * This test checks that a sorted timestamp array is delta encoded, that it is much smaller than the
+ * plain encoding and that random access and bulk decode return the original values.
+ */
+TEST(BlobTests, DeltaEncodedTimestamps)
+{
+    std::vector<int64_t> timestamps;
+    int64_t t = 1700000000000;
+    for (int i = 0; i < 1000; ++i) {
+        t += 1000 + (i * 7919) % 50;
+        timestamps.push_back(t);
+    }
+
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    for (int64_t value : timestamps) {
+        builder.add_date(value);
+    }
+    builder.end_array();
+    pb::Blob blob = builder.build();
+    pb::BlobView root = blob.root();
+
+    ASSERT_TRUE(root.is_delta());
+    ASSERT_LT(blob.size(), 1000 * 9 / 4);
+    ASSERT_EQ(root[0].as_date(), timestamps[0]);
+    ASSERT_EQ(root[517].as_date(), timestamps[517]);
+    ASSERT_EQ(root[999].type(), pb::DATE);
+
+    std::vector<int64_t> decoded;
+    root.decode_integers(decoded);
+    ASSERT_EQ(decoded, timestamps);
+}
+
+TEST(BlobTests, DeltaEncodingWrapsExtremes)
+{
+    std::vector<int64_t> values = { INT64_MIN, INT64_MAX, 0, -1, 1, INT64_MIN, 5, 6, 7 };
+
+    pb::BlobBuilder builder;
+    builder.begin_array();
+    for (int64_t value : values) {
+        builder.add_int(value);
+    }
+    builder.end_array();
+    pb::Blob blob = builder.build();
+
+    std::vector<int64_t> decoded;
+    blob.root().decode_integers(decoded);
+    ASSERT_EQ(decoded, values);
+}
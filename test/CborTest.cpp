@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <pb/cbor.h>
+
+
+TEST(CborTests, RoundTrip)
+{
+    pb::BlobBuilder builder;
+    builder.begin_object();
+    builder.key("id");
+    builder.add_int(-500);
+    builder.key("ok");
+    builder.add_bool(true);
+    builder.key("when");
+    builder.add_date(1700000000000);
+    builder.key("bytes");
+    builder.add_binary("abc", 3);
+    builder.key("list");
+    builder.begin_array();
+    builder.add_double(1.5);
+    builder.add_null();
+    builder.end_array();
+    builder.end_object();
+
+    pb::Blob blob = pb::read_cbor(pb::write_cbor(builder.build()));
+    pb::BlobView root = blob.root();
+
+    ASSERT_EQ(root["id"].as_int(), -500);
+    ASSERT_TRUE(root["ok"].as_bool());
+    ASSERT_EQ(root["when"].as_date(), 1700000000000);
+    ASSERT_EQ(root["bytes"].type(), pb::BINARY);
+    ASSERT_EQ(root["list"][0].as_double(), 1.5);
+    ASSERT_TRUE(root["list"][1].is_null());
+}
+
+/**
+ * Indefinite length array holding a chunked text string and a half float.
+ */
+TEST(CborTests, ReadIndefiniteAndHalfFloat)
+{
+    std::vector<uint8_t> data = { 0x9f, 0x7f, 0x62, 'a', 'b', 0x61, 'c', 0xff, 0xf9, 0x3e, 0x00, 0xff };
+    pb::Blob blob = pb::read_cbor(data);
+
+    ASSERT_EQ(blob.root().size(), 2);
+    ASSERT_EQ(blob.root()[0].as_string(), "abc");
+    ASSERT_EQ(blob.root()[1].as_double(), 1.5);
+}
+
+TEST(CborTests, NonTextKeyThrows)
+{
+    std::vector<uint8_t> data = { 0xa1, 0x01, 0x02 };
+
+    ASSERT_THROW(pb::read_cbor(data), std::runtime_error);
+}
+
+TEST(CborTests, NonFiniteEpochTimeThrows)
+{
+    // tag 1 wrapping a half float NaN, then a double past the int64 range
+    std::vector<uint8_t> nan = { 0xc1, 0xf9, 0x7e, 0x00 };
+    std::vector<uint8_t> huge = { 0xc1, 0xfb, 0x7f, 0xef, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+    ASSERT_THROW(pb::read_cbor(nan), std::out_of_range);
+    ASSERT_THROW(pb::read_cbor(huge), std::out_of_range);
+}
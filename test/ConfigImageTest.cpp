@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <pb/config_image.h>
+
+#include <filesystem>
+#include <fstream>
+
+
+TEST(ConfigImageTests, CompilesProperties)
+{
+    std::string text =
+        "http.port = 8080\n"
+        "ratio = 0.25\n"
+        "enabled = TRUE\n"
+        "expires = 2014-02-28T11:01:31Z\n"
+        "timeout = 1.5s\n"
+        "name = service\n"
+        "name = override\n"
+        "empty\n";
+    std::vector<uint8_t> bytes = pb::compile_properties_image(text);
+    pb::ConfigImage image(bytes);
+
+    ASSERT_TRUE(image.verify());
+    ASSERT_FALSE(image.is_stale(text));
+    ASSERT_TRUE(image.is_stale(text + "x = 1\n"));
+    ASSERT_EQ(image.size(), 7u);
+
+    ASSERT_EQ(image.type("http.port"), pb::INTEGER);
+    ASSERT_EQ(image.get<int>("http.port"), 8080);
+    ASSERT_EQ(image.at("http.port"), "8080");
+    ASSERT_EQ(image.type("ratio"), pb::FLOAT);
+    ASSERT_DOUBLE_EQ(image.get<double>("ratio"), 0.25);
+    ASSERT_EQ(image.type("enabled"), pb::BOOLEAN);
+    ASSERT_TRUE(image.get<bool>("enabled"));
+    ASSERT_EQ(image.type("expires"), pb::DATE);
+    ASSERT_EQ(image.get<std::chrono::sys_time<std::chrono::seconds>>("expires").time_since_epoch().count(), 1393585291);
+    ASSERT_EQ(image.type("timeout"), pb::STRING);
+    ASSERT_EQ(image.get<std::chrono::milliseconds>("timeout"), std::chrono::milliseconds(1500));
+    ASSERT_EQ(image.get<std::chrono::milliseconds>("http.port"), std::chrono::milliseconds(8080));
+    ASSERT_EQ(image.at("name"), "override");
+    ASSERT_EQ(image.at("empty"), "");
+
+    ASSERT_FALSE(image.contains("missing"));
+    ASSERT_FALSE(image.get("http.portx"));
+    ASSERT_EQ(image.get("missing", "fallback"), "fallback");
+    ASSERT_EQ(image.get<int>("name", 3), 3);
+    ASSERT_THROW(image.get<int>("name"), std::runtime_error);
+    ASSERT_THROW(image.at("missing"), std::out_of_range);
+
+    bytes[bytes.size() - 1] ^= 1;
+    ASSERT_FALSE(pb::ConfigImage(bytes).verify());
+    bytes.resize(20);
+    ASSERT_THROW(pb::ConfigImage image(bytes), std::runtime_error);
+}
+
+TEST(ConfigImageTests, CompilesJson)
+{
+    std::string json = R"({"http": {"port": 8080, "hosts": ["a", "b"]}, "limits": {"max": 18446744073709551615, "ratio": 1.5}, "debug": false, "proxy": null})";
+    pb::ConfigImage image(pb::compile_json_image(json));
+
+    ASSERT_EQ(image.get<int>("http.port"), 8080);
+    ASSERT_EQ(image.at("http.hosts.1"), "b");
+    ASSERT_EQ(image.type("limits.max"), pb::UNSIGNED_INTEGER);
+    ASSERT_EQ(image.get<uint64_t>("limits.max"), UINT64_MAX);
+    ASSERT_THROW(image.get<int64_t>("limits.max"), std::runtime_error);
+    ASSERT_DOUBLE_EQ(image.get<double>("limits.ratio"), 1.5);
+    ASSERT_FALSE(image.get<bool>("debug"));
+    ASSERT_EQ(image.type("proxy"), pb::NULL_VALUE);
+    ASSERT_FALSE(image.contains("http"));
+    ASSERT_FALSE(image.is_stale(json));
+
+    size_t visited = 0;
+    image.for_each([&](std::string_view, std::string_view) { ++visited; });
+    ASSERT_EQ(visited, image.size());
+}
+
+TEST(ConfigImageTests, CompilesFileAndPerfectHash)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string image_path = (directory / ("pb-config-" + std::to_string(::getpid()) + ".pbci")).string();
+    pb::compile_config_file("test/resource/test.properties", image_path);
+    pb::Properties properties("test/resource/test.properties");
+    {
+        pb::ConfigImage image(image_path);
+        ASSERT_TRUE(image.verify());
+        ASSERT_EQ(image.size(), properties.size());
+        for (const pb::PropertiesEntry& entry : properties.entries()) {
+            ASSERT_EQ(image.at(entry.key), entry.value);
+        }
+        pb::MappedFile source("test/resource/test.properties");
+        ASSERT_FALSE(image.is_stale(source.view()));
+    }
+    std::filesystem::remove(image_path);
+
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "key." + std::to_string(i) + " = " + std::to_string(i * 3) + "\n";
+    }
+    pb::ConfigImage image(pb::compile_properties_image(text));
+    ASSERT_EQ(image.size(), 20000u);
+    for (int i = 0; i < 20000; ++i) {
+        ASSERT_EQ(image.get<int>("key." + std::to_string(i)), i * 3);
+        ASSERT_FALSE(image.contains("other." + std::to_string(i)));
+    }
+
+    pb::ConfigImage empty(pb::compile_properties_image(""));
+    ASSERT_TRUE(empty.empty());
+    ASSERT_FALSE(empty.contains("a"));
+}
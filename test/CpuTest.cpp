@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <pb/cpu.h>
+#include <pb/delimited.h>
+
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    std::vector<pb::CpuLevel> supported_levels() {
+        std::vector<pb::CpuLevel> levels;
+        for (int level = 0; level <= static_cast<int>(pb::cpu_supported_level()); ++level) {
+            levels.push_back(static_cast<pb::CpuLevel>(level));
+        }
+        return levels;
+    }
+
+    size_t naive_find(std::string_view text, std::string_view characters, size_t from) {
+        for (size_t i = from; i < text.size(); ++i) {
+            if (characters.find(text[i]) != std::string_view::npos) {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+}
+
+
+TEST(CpuTests, LevelNames)
+{
+    for (pb::CpuLevel level : { pb::CpuLevel::SCALAR, pb::CpuLevel::SSE2, pb::CpuLevel::SSE42,
+                                pb::CpuLevel::AVX2, pb::CpuLevel::AVX512 }) {
+        ASSERT_EQ(pb::parse_cpu_level(pb::cpu_level_name(level)), level);
+    }
+    ASSERT_EQ(pb::parse_cpu_level("AVX2"), pb::CpuLevel::AVX2);
+    ASSERT_EQ(pb::parse_cpu_level("sse42"), pb::CpuLevel::SSE42);
+    ASSERT_FALSE(pb::parse_cpu_level("neon").has_value());
+}
+
+TEST(CpuTests, SetLevelIsCapped)
+{
+    pb::CpuLevel original = pb::cpu_level();
+    ASSERT_LE(original, pb::cpu_supported_level());
+    ASSERT_EQ(pb::set_cpu_level(pb::CpuLevel::AVX512), pb::cpu_supported_level());
+    ASSERT_EQ(pb::cpu_level(), pb::cpu_supported_level());
+    ASSERT_EQ(pb::set_cpu_level(pb::CpuLevel::SCALAR), pb::CpuLevel::SCALAR);
+    ASSERT_EQ(pb::cpu_level(), pb::CpuLevel::SCALAR);
+    pb::set_cpu_level(original);
+}
+
+TEST(CpuTests, ScanKernelsAgree)
+{
+    pb::CpuLevel original = pb::cpu_level();
+    const std::vector<std::string> sets = { ",", "\n\r", ",\n\r\"", "=: \t\f", "abcdefgh", "\x80\xff" };
+
+    // Sparse matches at every offset and tail length, so each block size and remainder is covered
+    std::string text;
+    for (size_t i = 0; i < 300; ++i) {
+        text.push_back(static_cast<char>('i' + i % 17));
+        if (i % 37 == 5) {
+            text.push_back(',');
+        }
+        if (i % 53 == 11) {
+            text += "\r\n";
+        }
+        if (i % 71 == 3) {
+            text.push_back('\xff');
+        }
+    }
+
+    for (pb::CpuLevel level : supported_levels()) {
+        pb::set_cpu_level(level);
+        for (const std::string& characters : sets) {
+            pb::DelimiterScanner scanner(characters);
+            for (size_t length = 0; length <= 130; ++length) {
+                std::string_view window(text.data(), length);
+                ASSERT_EQ(scanner.find(window), naive_find(window, characters, 0))
+                    << pb::cpu_level_name(level) << " length " << length;
+            }
+            for (size_t from = 0; from < text.size(); ++from) {
+                ASSERT_EQ(scanner.find(text, from), naive_find(text, characters, from))
+                    << pb::cpu_level_name(level) << " from " << from;
+            }
+        }
+    }
+    pb::set_cpu_level(original);
+}
+
+TEST(CpuTests, TokenizerAgreesAcrossLevels)
+{
+    pb::CpuLevel original = pb::cpu_level();
+    std::string data;
+    for (int row = 0; row < 200; ++row) {
+        data += "field" + std::to_string(row) + ",\"quoted, with \"\"quotes\"\"\"," + std::string(row % 70, 'x');
+        data += row % 3 == 0 ? "\r\n" : "\n";
+    }
+
+    auto tokenize = [&] {
+        std::vector<std::string> fields;
+        pb::tokenize_delimited(data, pb::DelimitedFormat{},
+            [&](size_t, std::string_view field) { fields.emplace_back(field); },
+            [&](size_t) { fields.emplace_back("|"); });
+        return fields;
+    };
+
+    pb::set_cpu_level(pb::CpuLevel::SCALAR);
+    std::vector<std::string> expected = tokenize();
+    ASSERT_EQ(expected.size(), 800u);
+    ASSERT_EQ(expected[1], "quoted, with \"quotes\"");
+    for (pb::CpuLevel level : supported_levels()) {
+        pb::set_cpu_level(level);
+        ASSERT_EQ(tokenize(), expected) << pb::cpu_level_name(level);
+    }
+    pb::set_cpu_level(original);
+}
+
+TEST(CpuTests, LineKernelsAgree)
+{
+    pb::CpuLevel original = pb::cpu_level();
+    // Quotes and newlines at every position of a 64 byte block, quoted runs crossing blocks
+    std::string text;
+    for (size_t i = 0; i < 700; ++i) {
+        text.push_back(i % 7 == 0 ? '\n' : i % 29 == 3 ? '"' : static_cast<char>('a' + i % 26));
+        if (i % 101 == 50) {
+            text += "\"\"";
+        }
+    }
+
+    auto naive = [&](std::string_view data, char quote) {
+        std::vector<uint64_t> ends;
+        bool in_quotes = false;
+        for (size_t i = 0; i < data.size(); ++i) {
+            if (quote != 0 && data[i] == quote) {
+                in_quotes = !in_quotes;
+            } else if (data[i] == '\n' && !in_quotes) {
+                ends.push_back(i + 1);
+            }
+        }
+        return ends;
+    };
+
+    for (pb::CpuLevel level : supported_levels()) {
+        pb::set_cpu_level(level);
+        for (char quote : { '"', '\0' }) {
+            for (size_t length : { size_t(0), size_t(63), size_t(64), size_t(130), text.size() }) {
+                std::string_view window(text.data(), length);
+                pb::LineIndexer indexer(quote);
+                std::vector<uint64_t> ends;
+                indexer.find(window, 0, ends);
+                ASSERT_EQ(ends, naive(window, quote)) << pb::cpu_level_name(level) << " length " << length;
+            }
+
+            // In pieces, the quoted state carrying over
+            pb::LineIndexer indexer(quote);
+            std::vector<uint64_t> ends;
+            for (size_t offset = 0; offset < text.size(); offset += 97) {
+                indexer.find(std::string_view(text).substr(offset, 97), offset, ends);
+            }
+            ASSERT_EQ(ends, naive(text, quote)) << pb::cpu_level_name(level);
+        }
+    }
+    pb::set_cpu_level(original);
+}
+
+TEST(CpuTests, UnpackAndPrefixSumKernelsAgree)
+{
+    // Random 64 bit patterns packed at every width, with the padding the delta encoding adds
+    std::vector<uint64_t> source(300);
+    uint64_t state = 0x9e3779b97f4a7c15;
+    for (uint64_t& value : source) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        value = state;
+    }
+
+    for (unsigned bits = 0; bits <= 64; ++bits) {
+        uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        std::vector<uint8_t> packed((source.size() * bits + 7) / 8 + 8, 0);
+        for (size_t i = 0; i < source.size(); ++i) {
+            for (unsigned b = 0; b < bits; ++b) {
+                size_t bit = i * bits + b;
+                packed[bit >> 3] |= static_cast<uint8_t>(((source[i] >> b) & 1) << (bit & 7));
+            }
+        }
+
+        for (pb::CpuLevel level : supported_levels()) {
+            for (size_t first : { size_t(0), size_t(3), size_t(128) }) {
+                size_t count = source.size() - first;
+                std::vector<uint64_t> out(count);
+                pb::detail::unpack_kernel(level)(packed.data(), bits, first, count, out.data());
+                for (size_t k = 0; k < count; ++k) {
+                    ASSERT_EQ(out[k], source[first + k] & mask)
+                        << pb::cpu_level_name(level) << " bits " << bits << " index " << first + k;
+                }
+            }
+        }
+    }
+
+    for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(8), size_t(127), source.size() }) {
+        std::vector<uint64_t> expected(source.begin(), source.begin() + count);
+        pb::detail::prefix_sum_kernel(pb::CpuLevel::SCALAR)(expected.data(), count, 42, 0xfffffffffffffff0);
+        for (pb::CpuLevel level : supported_levels()) {
+            std::vector<uint64_t> values(source.begin(), source.begin() + count);
+            pb::detail::prefix_sum_kernel(level)(values.data(), count, 42, 0xfffffffffffffff0);
+            ASSERT_EQ(values, expected) << pb::cpu_level_name(level) << " count " << count;
+        }
+    }
+}
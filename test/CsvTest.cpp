@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <pb/csv.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+TEST(CsvTests, ParseQuotedFields)
+{
+    pb::CSV csv;
+    csv.parse("a,\"b,c\",\"say \"\"hi\"\"\"\r\n1,2,3\n");
+
+    const auto& data = csv.getData();
+    ASSERT_EQ(data.size(), 2);
+    ASSERT_EQ(data[0][1], "b,c");
+    ASSERT_EQ(data[0][2], "say \"hi\"");
+    ASSERT_EQ(data[1][2], "3");
+    ASSERT_EQ(csv.get_properties().get_delimiter(), pb::COMMA);
+}
+
+TEST(CsvTests, DetectTabAndHeader)
+{
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV csv(properties);
+    csv.parse("name\tvalue\nx\t1\ny\n");
+
+    ASSERT_EQ(csv.get_properties().get_delimiter(), pb::TAB);
+    ASSERT_EQ(csv.get_column_name(1), "value");
+    ASSERT_EQ(csv.get_row_count(), 2);
+    ASSERT_EQ(csv.get_column_data()[1]->at(0), "1");
+    ASSERT_EQ(csv.get_column_data()[1]->at(1), "");
+}
+
+TEST(CsvTests, ReparseTakesTheNewHeader)
+{
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV csv(properties);
+    csv.parse("a,b\n1,2\n");
+    csv.parse("x,y,z\n3,4,5\n");
+
+    ASSERT_EQ(csv.get_column_name(0), "x");
+    ASSERT_EQ(csv.get_column_name(1), "y");
+    ASSERT_EQ(csv.get_column_name(2), "z");
+    ASSERT_TRUE(csv.get_properties().getColumns().empty());
+
+    csv.parse("p\n6\n");
+    ASSERT_EQ(csv.get_columns().size(), 1);
+    ASSERT_EQ(csv.get_column_name(0), "p");
+    ASSERT_EQ(csv.get_column_name(1), "1");
+}
+
+TEST(CsvTests, UnterminatedQuoteThrows)
+{
+    pb::CSV csv;
+
+    ASSERT_THROW(csv.parse("a,\"b\n"), std::runtime_error);
+}
+
+TEST(CsvTests, DialectParsersMatchTheGenericTokenizer)
+{
+    auto fields = [](auto&& tokenize) {
+        std::vector<std::string> out;
+        tokenize([&](size_t column, std::string_view field) { out.push_back(std::to_string(column) + ":" + std::string(field)); },
+                 [&](size_t fields) { out.push_back("/" + std::to_string(fields)); });
+        return out;
+    };
+    const char* inputs[] = {
+        "a,\"b,c\",\"say \"\"hi\"\"\"\r\n1,2,3\n",
+        "\n\nx,\"multi\nline\"tail,\r\r\n,\n",
+        "a\tb\t\"c\td\"\n1\t\t3",
+        "last,",
+        "",
+    };
+    for (std::string_view input : inputs) {
+        pb::DelimitedFormat comma;
+        comma.quote = '"';
+        ASSERT_EQ(fields([&](auto&& f, auto&& r) { pb::CSVParser<pb::CSVDialectComma>::tokenize(input, f, r); }),
+                  fields([&](auto&& f, auto&& r) { pb::tokenize_delimited(input, comma, f, r); }));
+
+        pb::DelimitedFormat tab;
+        tab.field = '\t';
+        tab.quote = 0;
+        ASSERT_EQ(fields([&](auto&& f, auto&& r) { pb::CSVParser<pb::CSVDialectTab>::tokenize(input, f, r); }),
+                  fields([&](auto&& f, auto&& r) { pb::tokenize_delimited(input, tab, f, r); }));
+
+        tab.quote = '"';
+        ASSERT_EQ(fields([&](auto&& f, auto&& r) { pb::CSVParser<pb::CSVDialectQuotedTab>::tokenize(input, f, r); }),
+                  fields([&](auto&& f, auto&& r) { pb::tokenize_delimited(input, tab, f, r); }));
+    }
+    ASSERT_THROW(fields([](auto&& f, auto&& r) { pb::CSVParser<pb::CSVDialectComma>::tokenize("a,\"b\n", f, r); }),
+                 std::runtime_error);
+
+    // A backslash escape instead of doubled quotes
+    using Escaped = pb::CSVDialect<';', '\'', '\\'>;
+    ASSERT_EQ(fields([](auto&& f, auto&& r) { pb::CSVParser<Escaped>::tokenize("'it\\'s';'a\\\\b'\n", f, r); }),
+              (std::vector<std::string>{ "0:it's", "1:a\\b", "/2" }));
+    ASSERT_THROW(fields([](auto&& f, auto&& r) { pb::CSVParser<Escaped>::tokenize("'open\\", f, r); }),
+                 std::runtime_error);
+
+    // Tab files without quoting keep quote characters as data
+    pb::CSVProperties properties;
+    properties.set_delimiter(pb::TAB);
+    properties.set_quote_style(pb::NONE);
+    pb::CSV csv(properties);
+    csv.parse("\"a\tb\"\n");
+    ASSERT_EQ(csv.getData()[0][0], "\"a");
+    ASSERT_EQ(csv.getData()[0][1], "b\"");
+}
+
+TEST(CsvTests, CountAndIndexRowsWithoutParsing)
+{
+    const char* inputs[] = {
+        "a,b\n1,2\n",
+        "name,note\r\n\r\nx,\"multi\nline, \"\"quoted\"\"\"\r\n\n\ny,2",
+        "\n\n",
+        "",
+        "only",
+    };
+    for (bool header : { false, true }) {
+        for (std::string_view input : inputs) {
+            pb::CSVProperties properties;
+            properties.set_has_header(header);
+            pb::CSV csv(properties);
+            csv.parse(input);
+            ASSERT_EQ(csv.count_rows(input), csv.get_row_count()) << input;
+        }
+    }
+
+    std::string data = "id,text\n";
+    for (int row = 0; row < 20000; ++row) {
+        data += std::to_string(row) + (row % 3 == 0 ? ",\"with\nnewline\"\r\n" : ",plain\n");
+        if (row % 1000 == 0) {
+            data += "\n";
+        }
+    }
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV csv(properties);
+    ASSERT_EQ(csv.count_rows(data), 20000u);
+
+    // A stream in small pieces, quoted fields crossing them
+    struct PieceSource : public pb::Source {
+        std::string_view text;
+        virtual std::string_view next() override {
+            std::string_view piece = text.substr(0, 1000);
+            text.remove_prefix(piece.size());
+            return piece;
+        }
+    } pieces;
+    pieces.text = data;
+    ASSERT_EQ(csv.count_rows(pieces), 20000u);
+
+    // Ranges of the index parse on their own, as parallel parses would
+    std::vector<uint64_t> offsets = csv.index_lines(data);
+    ASSERT_EQ(offsets.size(), 20001u);
+    ASSERT_EQ(offsets[0], 0u);
+    ASSERT_EQ(data.substr(offsets[1], 2), "0,");
+    size_t rows = 0;
+    for (size_t first = 1; first < offsets.size(); first += 4096) {
+        size_t last = std::min(first + 4096, offsets.size());
+        uint64_t end = last < offsets.size() ? offsets[last] : data.size();
+        pb::CSV part;
+        part.parse(std::string_view(data).substr(offsets[first], end - offsets[first]));
+        rows += part.get_row_count();
+    }
+    ASSERT_EQ(rows, 20000u);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <pb/delimited.h>
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+TEST(DelimitedTests, ScannerFindsEveryCharacter)
+{
+    pb::DelimiterScanner scanner(",\n\r=");
+    std::string text(100, 'a');
+    for (size_t position = 0; position < text.size(); ++position) {
+        for (char c : std::string(",\n\r=")) {
+            std::string probe = text;
+            probe[position] = c;
+            ASSERT_EQ(scanner.find(probe), position);
+            ASSERT_EQ(scanner.find(probe.data(), probe.data() + probe.size()), probe.data() + position);
+        }
+    }
+    ASSERT_EQ(scanner.find(text), std::string_view::npos);
+    ASSERT_EQ(scanner.find(std::string_view("a,b"), 2), std::string_view::npos);
+    ASSERT_TRUE(scanner.matches('='));
+    ASSERT_FALSE(scanner.matches('a'));
+    ASSERT_THROW(pb::DelimiterScanner("123456789"), std::runtime_error);
+}
+
+TEST(DelimitedTests, TokenizesRecords)
+{
+    std::vector<std::vector<std::string>> records(1);
+    auto on_field = [&](size_t, std::string_view field) { records.back().emplace_back(field); };
+    auto on_record = [&](size_t) { records.emplace_back(); };
+
+    pb::DelimitedFormat format;
+    format.field = '|';
+    format.record = ';';
+    pb::tokenize_delimited("a|\"b;|\"\"c\"|d;;e|", format, on_field, on_record);
+    records.pop_back();
+    ASSERT_EQ(records.size(), 2u);
+    ASSERT_EQ(records[0], (std::vector<std::string>{ "a", "b;|\"c", "d" }));
+    ASSERT_EQ(records[1], (std::vector<std::string>{ "e", "" }));
+
+    ASSERT_THROW(pb::tokenize_delimited("\"open", format, on_field, on_record), std::runtime_error);
+}
+
+TEST(DelimitedTests, KeyValuesAndQueryStrings)
+{
+    std::vector<std::pair<std::string, std::string>> pairs;
+    auto collect = [&](std::string_view key, std::string_view value) { pairs.emplace_back(key, value); };
+
+    pb::DelimitedFormat log;
+    log.field = ';';
+    log.assignment = '=';
+    pb::parse_key_values("user=bob; ip = 10.0.0.1 ;msg=\"a;b\" ;flag;;token=x==", log, collect);
+    ASSERT_EQ(pairs, (std::vector<std::pair<std::string, std::string>>{
+        { "user", "bob" }, { "ip", "10.0.0.1" }, { "msg", "a;b" }, { "flag", "" }, { "token", "x==" } }));
+
+    pairs.clear();
+    pb::parse_query_string("?q=two+words&lang=en%2DGB&empty=&=x&flag", collect);
+    ASSERT_EQ(pairs, (std::vector<std::pair<std::string, std::string>>{
+        { "q", "two words" }, { "lang", "en-GB" }, { "empty", "" }, { "", "x" }, { "flag", "" } }));
+}
+
+TEST(DelimitedTests, ParsesIni)
+{
+    std::vector<std::tuple<std::string, std::string, std::string>> entries;
+    pb::parse_ini(
+        "; comment\r\n"
+        "global = 1\r\n"
+        "[server]\r\n"
+        "host = example.org\r\n"
+        "  port: 8080  \r\n"
+        "# another comment\n"
+        "[ paths ]\n"
+        "root = \"/var/www data\"\n"
+        "bare\n",
+        [&](std::string_view section, std::string_view key, std::string_view value) {
+            entries.emplace_back(section, key, value);
+        });
+    ASSERT_EQ(entries, (std::vector<std::tuple<std::string, std::string, std::string>>{
+        { "", "global", "1" }, { "server", "host", "example.org" }, { "server", "port", "8080" },
+        { "paths", "root", "/var/www data" }, { "paths", "bare", "" } }));
+
+    ASSERT_THROW(pb::parse_ini("[open\n", [](auto, auto, auto) {}), std::runtime_error);
+}
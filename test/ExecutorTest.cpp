@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <pb/executor.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+    // Forks both halves recursively, so groups nest much deeper than there are workers
+    uint64_t fibonacci(pb::Executor& executor, unsigned n) {
+        if (n < 2) {
+            return n;
+        }
+        uint64_t left = 0;
+        pb::TaskGroup group(executor);
+        group.run([&] { left = fibonacci(executor, n - 1); });
+        uint64_t right = fibonacci(executor, n - 2);
+        group.wait();
+        return left + right;
+    }
+
+}
+
+
+TEST(ExecutorTests, RunsSubmittedTasks)
+{
+    std::atomic<int> done(0);
+    {
+        pb::Executor executor(3);
+        ASSERT_EQ(executor.size(), 3u);
+        ASSERT_FALSE(executor.in_worker());
+        for (int i = 0; i < 1000; ++i) {
+            executor.submit([&] { ++done; });
+        }
+    }
+    // The destructor runs what is still queued
+    ASSERT_EQ(done.load(), 1000);
+}
+
+TEST(ExecutorTests, NestedForkJoin)
+{
+    pb::Executor executor(2);
+    ASSERT_EQ(fibonacci(executor, 20), 6765u);
+
+    // A single worker must not deadlock either, waiting threads run the queued tasks themselves
+    pb::Executor single(1);
+    ASSERT_EQ(fibonacci(single, 16), 987u);
+}
+
+TEST(ExecutorTests, TaskGroupRethrows)
+{
+    pb::Executor executor(2);
+    pb::TaskGroup group(executor);
+    std::atomic<int> done(0);
+    for (int i = 0; i < 50; ++i) {
+        group.run([&, i] {
+            if (i == 17) {
+                throw std::runtime_error("task 17");
+            }
+            ++done;
+        });
+    }
+    ASSERT_THROW(group.wait(), std::runtime_error);
+    ASSERT_EQ(done.load(), 49);
+
+    // The group is reusable once the error was reported
+    group.run([&] { ++done; });
+    group.wait();
+    ASSERT_EQ(done.load(), 50);
+}
+
+TEST(ExecutorTests, ParallelForVisitsEveryIndexOnce)
+{
+    pb::Executor executor(4, true);
+    std::vector<std::atomic<int>> visits(10000);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    pb::parallel_for(executor, visits.size(), [&](size_t i) {
+        ++visits[i];
+        if (i % 100 == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+    });
+    for (const std::atomic<int>& count : visits) {
+        ASSERT_EQ(count.load(), 1);
+    }
+    ASSERT_GE(threads.size(), 1u);
+
+    // Capped at one task, everything runs on the caller
+    threads.clear();
+    pb::parallel_for(executor, 100, [&](size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    }, 1);
+    ASSERT_EQ(threads, std::set<std::thread::id>{ std::this_thread::get_id() });
+
+    ASSERT_THROW(pb::parallel_for(executor, 1000, [](size_t i) {
+        if (i == 500) {
+            throw std::out_of_range("500");
+        }
+    }), std::out_of_range);
+}
+
+TEST(ExecutorTests, SharedExecutor)
+{
+    pb::Executor& shared = pb::Executor::shared();
+    ASSERT_EQ(&shared, &pb::Executor::shared());
+    ASSERT_GE(shared.size(), 1u);
+    std::atomic<int> sum(0);
+    pb::parallel_for(shared, 100, [&](size_t i) { sum += static_cast<int>(i); });
+    ASSERT_EQ(sum.load(), 4950);
+}
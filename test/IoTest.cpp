@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <pb/compressed_io.h>
+#include <pb/csv.h>
+#include <pb/io.h>
+#include <pb/json.h>
+#include <pb/memory.h>
+#include <pb/ndjson.h>
+#include <pb/properties.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+
+namespace {
+
+    // Hands out its text in pieces of at most piece bytes, like a stream would
+    class PieceSource : public pb::Source {
+        public:
+            PieceSource(std::string_view text, size_t piece) : text_(text), piece_(piece) {}
+
+            virtual std::string_view next() override {
+                std::string_view result = text_.substr(0, piece_);
+                text_.remove_prefix(result.size());
+                return result;
+            }
+
+        private:
+            std::string_view text_;
+            size_t piece_;
+    };
+
+    std::string make_text(size_t lines) {
+        std::string text;
+        for (size_t i = 0; i < lines; ++i) {
+            text += "line " + std::to_string(i) + " with some repeated text, repeated text\n";
+        }
+        return text;
+    }
+
+}
+
+
+TEST(IoTests, InMemorySourcesAreBorrowed)
+{
+    std::string text = "a,b\n1,2\n";
+    pb::SpanSource source(text);
+    ASSERT_EQ(source.remaining(), text.size());
+    std::string storage;
+    std::string_view all = pb::read_all(source, storage);
+    ASSERT_EQ(all.data(), text.data());
+    ASSERT_TRUE(storage.empty());
+    ASSERT_TRUE(source.next().empty());
+
+    pb::MemoryGrowthPolicyExponential policy;
+    pb::Memory memory(policy, 16);
+    memory.initialize();
+    pb::MemorySink sink(memory);
+    sink.write("hello ");
+    sink.write("memory");
+    ASSERT_EQ(sink.offset(), 12u);
+    pb::MemorySource from_memory(memory, sink.offset());
+    std::string_view borrowed = pb::read_all(from_memory, storage);
+    ASSERT_EQ(borrowed, "hello memory");
+    ASSERT_EQ(borrowed.data(), memory.data());
+    ASSERT_THROW(pb::MemorySource(memory, memory.current_size() + 1), std::out_of_range);
+}
+
+TEST(IoTests, FileSourcesAndSinks)
+{
+    std::string path = (std::filesystem::temp_directory_path() / ("pb_io_test-" + std::to_string(::getpid()) + ".txt")).string();
+    std::string text = make_text(1000);
+    {
+        pb::FileSink sink(path);
+        pb::SpanSource source(text);
+        pb::copy_all(source, sink);
+    }
+
+    pb::MappedFileSource mapped(path);
+    std::string storage;
+    ASSERT_EQ(pb::read_all(mapped, storage), text);
+    ASSERT_TRUE(storage.empty());
+
+    pb::FileSource file(path, 4096);
+    ASSERT_EQ(file.remaining(), text.size());
+    std::string_view first = file.next();
+    ASSERT_EQ(first.size(), 4096u);
+    ASSERT_EQ(first, std::string_view(text).substr(0, 4096));
+    ASSERT_EQ(file.remaining(), text.size() - 4096);
+    ASSERT_EQ(pb::read_all(file, storage), text.substr(4096));
+
+    std::FILE* stream = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(stream, nullptr);
+    {
+        pb::FileSource open_stream(stream, 1000);
+        ASSERT_FALSE(open_stream.remaining().has_value());
+        ASSERT_EQ(pb::read_all(open_stream, storage), text);
+    }
+    std::fclose(stream);
+
+    std::filesystem::remove(path);
+    ASSERT_THROW(pb::FileSource{ path }, std::runtime_error);
+}
+
+TEST(IoTests, CompressedRoundTrip)
+{
+    std::string text = make_text(20000);
+    pb::BlobBlockCodecLZ4 lz4;
+    std::string compressed;
+    {
+        pb::StringSink out(compressed);
+        pb::CompressingSink sink(out, lz4, 64 * 1024);
+        // Uneven writes, and a flush in the middle producing a short block
+        PieceSource source(text, 10007);
+        for (std::string_view piece = source.next(); !piece.empty(); piece = source.next()) {
+            sink.write(piece);
+            if (piece.data() == text.data()) {
+                sink.flush();
+            }
+        }
+        sink.finish();
+    }
+    ASSERT_LT(compressed.size(), text.size() / 4);
+
+    // Read back through a source that splits block headers and data across pieces
+    for (size_t piece : { size_t(3), size_t(4096), compressed.size() }) {
+        PieceSource source(compressed, piece);
+        pb::DecompressingSource decompressed(source, lz4);
+        std::string storage;
+        ASSERT_EQ(pb::read_all(decompressed, storage), text);
+    }
+
+    // Incompressible blocks are stored as they are
+    std::string noise;
+    uint32_t state = 1;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1664525 + 1013904223;
+        noise.push_back(static_cast<char>(state >> 24));
+    }
+    std::string stored;
+    {
+        pb::StringSink out(stored);
+        pb::CompressingSink sink(out, lz4, 16 * 1024);
+        sink.write(noise);
+    }
+    pb::SpanSource stored_source(stored);
+    pb::DecompressingSource decompressed(stored_source, lz4);
+    std::string storage;
+    ASSERT_EQ(pb::read_all(decompressed, storage), noise);
+
+    pb::BlobBlockCodecNone none;
+    pb::SpanSource wrong_codec(compressed);
+    ASSERT_THROW(pb::DecompressingSource(wrong_codec, none), std::runtime_error);
+    pb::SpanSource truncated(std::string_view(compressed).substr(0, compressed.size() / 2));
+    pb::DecompressingSource partial(truncated, lz4);
+    ASSERT_THROW(pb::read_all(partial, storage), std::runtime_error);
+}
+
+TEST(IoTests, ReadersTakeSources)
+{
+    PieceSource csv_source("name,size\nalpha,1\nbeta,2\n", 5);
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV csv(properties);
+    csv.parse(csv_source);
+    ASSERT_EQ(csv.get_row_count(), 2u);
+
+    PieceSource json_source(R"({"name": "pb", "list": [1, 2, 3]})", 4);
+    pb::Blob blob = pb::read_json(json_source);
+    ASSERT_EQ(blob.root()["list"].size(), 3u);
+
+    std::string written;
+    pb::StringSink sink(written);
+    pb::write_json(blob.root(), sink);
+    ASSERT_EQ(written, pb::write_json(blob));
+
+    PieceSource ndjson_source("{\"a\":1}\n{\"a\":2}\n", 3);
+    ASSERT_EQ(pb::read_ndjson(ndjson_source).root().size(), 2u);
+
+    pb::Properties config;
+    {
+        PieceSource properties_source("a = 1\nb: two\n", 2);
+        config.parse(properties_source);
+    }
+    ASSERT_EQ(config.get<int>("a"), 1);
+    ASSERT_EQ(config.at("b"), "two");
+
+    pb::MappedFileSource mapped("test/resource/test.properties");
+    config.parse(mapped);
+    ASSERT_EQ(config.at("deployment.webjava.enabled"), "true");
+}
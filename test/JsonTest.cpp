@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <pb/json.h>
+
+#include <cmath>
+#include <limits>
+
+
+TEST(JsonTests, ReadDocument)
+{
+    pb::Blob blob = pb::read_json(R"( {"name": "pb", "size": 12, "big": 18446744073709551615,
+                                       "ratio": -1.5e2, "ok": true, "none": null, "list": [1, [], {}]} )");
+    pb::BlobView root = blob.root();
+
+    ASSERT_EQ(root["name"].as_string(), "pb");
+    ASSERT_EQ(root["size"].type(), pb::INTEGER);
+    ASSERT_EQ(root["big"].type(), pb::UNSIGNED_INTEGER);
+    ASSERT_EQ(root["ratio"].as_double(), -150.0);
+    ASSERT_TRUE(root["ok"].as_bool());
+    ASSERT_TRUE(root["none"].is_null());
+    ASSERT_EQ(root["list"].size(), 3);
+}
+
+TEST(JsonTests, ReadEscapes)
+{
+    pb::Blob blob = pb::read_json(R"(["a\"b\\c\n", "é😀"])");
+
+    ASSERT_EQ(blob.root()[0].as_string(), "a\"b\\c\n");
+    ASSERT_EQ(blob.root()[1].as_string(), "\xc3\xa9\xf0\x9f\x98\x80");
+}
+
+TEST(JsonTests, WriteRoundTrip)
+{
+    std::string text = R"({"a":[1,2.5,"x"],"b":{"c":null,"d":false},"e":1.0})";
+
+    ASSERT_EQ(pb::write_json(pb::read_json(text)), text);
+}
+
+TEST(JsonTests, WriteDate)
+{
+    pb::BlobBuilder builder;
+    builder.add_date(1700000000123);
+
+    ASSERT_EQ(pb::write_json(builder.build()), "\"2023-11-14T22:13:20.123Z\"");
+}
+
+TEST(JsonTests, ReadOutOfRangeNumbers)
+{
+    pb::Blob blob = pb::read_json("[1e400, -1e400, 1e-400, -1e-400, 0.0001e-400, 1" + std::string(400, '0') + "]");
+    pb::BlobView root = blob.root();
+
+    ASSERT_EQ(root[0].as_double(), std::numeric_limits<double>::infinity());
+    ASSERT_EQ(root[1].as_double(), -std::numeric_limits<double>::infinity());
+    ASSERT_EQ(root[2].as_double(), 0.0);
+    ASSERT_FALSE(std::signbit(root[2].as_double()));
+    ASSERT_EQ(root[3].as_double(), 0.0);
+    ASSERT_TRUE(std::signbit(root[3].as_double()));
+    ASSERT_EQ(root[4].as_double(), 0.0);
+    ASSERT_EQ(root[5].as_double(), std::numeric_limits<double>::infinity());
+}
+
+TEST(JsonTests, MalformedInputThrows)
+{
+    ASSERT_THROW(pb::read_json("{\"a\": 1,}"), std::runtime_error);
+    ASSERT_THROW(pb::read_json("[1 2]"), std::runtime_error);
+    ASSERT_THROW(pb::read_json("01"), std::runtime_error);
+    ASSERT_THROW(pb::read_json("\"abc"), std::runtime_error);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <pb/layered_properties.h>
+
+
+TEST(LayeredPropertiesTests, LaterLayersOverride)
+{
+    pb::Properties defaults;
+    defaults.parse("deployment.security.level = HIGH\nhttp.port = 80\nname = service\n");
+
+    pb::LayeredProperties config;
+    ASSERT_EQ(config.add("defaults", std::move(defaults)), 0u);
+    ASSERT_EQ(config.add("file", pb::Properties("test/resource/test.properties")), 1u);
+
+    const char* environment[] = { "SERVICE_HTTP_PORT=8080", "SERVICE_LOG_PATH= C:\\logs", "PATH=/usr/bin", "SERVICE_=x", nullptr };
+    ASSERT_EQ(config.add_environment("environment", "SERVICE_", environment), 2u);
+
+    const char* argv[] = { "service", "--http.port=9090", "-Dname=a=b", "--verbose", "input.txt", "--" };
+    ASSERT_EQ(config.add_arguments("command line", 6, argv), 3u);
+
+    // The sample file repeats this key; the last definition wins within a layer
+    ASSERT_EQ(config.at("deployment.security.revocation.check"), "NO_CHECK");
+    ASSERT_EQ(config.layer_name(*config.layer_of("deployment.security.revocation.check")), "file");
+
+    ASSERT_EQ(config.at("deployment.security.level"), "MEDIUM");
+    ASSERT_EQ(*config.layer_of("deployment.security.level"), 1u);
+    ASSERT_EQ(config.get<int>("http.port"), 9090);
+    ASSERT_EQ(config.layer_name(*config.layer_of("http.port")), "command line");
+    ASSERT_EQ(config.layer(2).at("http.port"), "8080");
+    ASSERT_EQ(config.at("log.path"), " C:\\logs");
+    ASSERT_EQ(config.at("name"), "a=b");
+    ASSERT_TRUE(config.get<bool>("verbose"));
+    ASSERT_FALSE(config.contains("path"));
+    ASSERT_FALSE(config.layer_of("missing"));
+    ASSERT_EQ(config.get("missing", "fallback"), "fallback");
+    ASSERT_EQ(config.get<int>("missing", 5), 5);
+    ASSERT_THROW(config.at("missing"), std::out_of_range);
+
+    size_t defined = config.layer(0).size();
+    ASSERT_EQ(config.entries()[0].key, "deployment.security.level");
+    ASSERT_GE(config.size(), defined);
+
+    pb::LayeredProperties moved = std::move(config);
+    ASSERT_EQ(moved.at("name"), "a=b");
+    ASSERT_EQ(moved.layer_count(), 4u);
+}
+
+TEST(LayeredPropertiesTests, ManyLayers)
+{
+    pb::LayeredProperties config;
+    for (int layer = 0; layer < 20; ++layer) {
+        std::string text;
+        for (int i = layer; i < 500; ++i) {
+            text += "key." + std::to_string(i) + " = " + std::to_string(layer) + "\n";
+        }
+        pb::Properties properties;
+        properties.parse_owned(std::move(text));
+        config.add("layer " + std::to_string(layer), std::move(properties));
+    }
+    ASSERT_EQ(config.size(), 500u);
+    for (int i = 0; i < 500; ++i) {
+        int expected = std::min(i, 19);
+        ASSERT_EQ(config.get<int>("key." + std::to_string(i)), expected);
+        ASSERT_EQ(*config.layer_of("key." + std::to_string(i)), static_cast<size_t>(expected));
+    }
+}
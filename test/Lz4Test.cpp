@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <pb/lz4.h>
+
+#include <string>
+
+
+TEST(Lz4Tests, RoundTripRepetitiveData)
+{
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "deployment.security.level=MEDIUM " + std::to_string(i % 17) + "\n";
+    }
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(text.data());
+
+    std::vector<uint8_t> compressed;
+    pb::lz4_compress_block(src, text.size(), compressed);
+    ASSERT_LT(compressed.size(), text.size() / 4);
+
+    std::string decoded(text.size(), '\0');
+    pb::lz4_decompress_block(compressed.data(), compressed.size(), reinterpret_cast<uint8_t*>(decoded.data()), decoded.size());
+    ASSERT_EQ(decoded, text);
+}
+
+/**
+ * A hand assembled block: the literals "abc", an overlapping match of offset 3 and length 13, then
+ * 5 final literals.
+ */
+TEST(Lz4Tests, DecodeReferenceBlock)
+{
+    std::vector<uint8_t> block = { 0x39, 'a', 'b', 'c', 0x03, 0x00, 0x50, 'a', 'b', 'c', 'a', 'b' };
+    std::string decoded(21, '\0');
+    pb::lz4_decompress_block(block.data(), block.size(), reinterpret_cast<uint8_t*>(decoded.data()), decoded.size());
+
+    ASSERT_EQ(decoded, "abcabcabcabcabca" "abcab");
+}
+
+TEST(Lz4Tests, CorruptBlockThrows)
+{
+    std::vector<uint8_t> block = { 0x1f, 'a', 0x09, 0x00 };
+    uint8_t out[32];
+
+    ASSERT_THROW(pb::lz4_decompress_block(block.data(), block.size(), out, sizeof(out)), std::runtime_error);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <pb/msgpack.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+static pb::Blob build_document() {
+    pb::BlobBuilder builder;
+    builder.begin_object();
+    builder.key("id");
+    builder.add_int(-70000);
+    builder.key("count");
+    builder.add_uint(3);
+    builder.key("ratio");
+    builder.add_double(0.25);
+    builder.key("created");
+    builder.add_date(1700000000123);
+    builder.key("payload");
+    builder.add_binary("\x00\x01\x02", 3);
+    builder.key("items");
+    builder.begin_array();
+    for (int i = 0; i < 3; ++i) {
+        builder.begin_object();
+        builder.key("n");
+        builder.add_int(i);
+        builder.end_object();
+    }
+    builder.end_array();
+    builder.end_object();
+    return builder.build();
+}
+
+TEST(MsgPackTests, RoundTrip)
+{
+    pb::Blob blob = pb::read_msgpack(pb::write_msgpack(build_document()));
+    pb::BlobView root = blob.root();
+
+    ASSERT_EQ(root["id"].type(), pb::INTEGER);
+    ASSERT_EQ(root["id"].as_int(), -70000);
+    ASSERT_EQ(root["count"].type(), pb::UNSIGNED_INTEGER);
+    ASSERT_EQ(root["ratio"].as_double(), 0.25);
+    ASSERT_EQ(root["created"].as_date(), 1700000000123);
+    ASSERT_EQ(root["payload"].as_binary().size(), 3);
+    ASSERT_TRUE(root["items"].is_columnar());
+    ASSERT_EQ(root["items"][2]["n"].as_int(), 2);
+}
+
+/**
+ * {"a": [1, "x"], "b": nil} encoded by hand with fix forms.
+ */
+TEST(MsgPackTests, ReadFixForms)
+{
+    std::vector<uint8_t> data = { 0x82, 0xa1, 'a', 0x92, 0x01, 0xa1, 'x', 0xa1, 'b', 0xc0 };
+    pb::Blob blob = pb::read_msgpack(data);
+
+    ASSERT_EQ(blob.root()["a"][0].as_int(), 1);
+    ASSERT_EQ(blob.root()["a"][1].as_string(), "x");
+    ASSERT_TRUE(blob.root()["b"].is_null());
+    ASSERT_EQ(pb::write_msgpack(blob), data);
+}
+
+TEST(MsgPackTests, TruncatedInputThrows)
+{
+    std::vector<uint8_t> data = { 0x92, 0x01 };
+
+    ASSERT_THROW(pb::read_msgpack(data), std::runtime_error);
+}
+
+static std::vector<uint8_t> timestamp96(uint32_t nanoseconds, int64_t seconds) {
+    std::vector<uint8_t> data = { 0xc7, 12, 0xff };
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<uint8_t>(nanoseconds >> shift));
+    }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<uint8_t>(static_cast<uint64_t>(seconds) >> shift));
+    }
+    return data;
+}
+
+TEST(MsgPackTests, TimestampNanosecondsOutOfRangeThrows)
+{
+    // timestamp 64: nanoseconds 1000000000 in the upper 30 bits, seconds 1
+    uint64_t value = (1000000000ULL << 34) | 1;
+    std::vector<uint8_t> data = { 0xd7, 0xff };
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<uint8_t>(value >> shift));
+    }
+
+    ASSERT_THROW(pb::read_msgpack(data), std::runtime_error);
+    ASSERT_THROW(pb::read_msgpack(timestamp96(1000000000, 1)), std::runtime_error);
+    ASSERT_EQ(pb::read_msgpack(timestamp96(999999999, 1)).root().as_date(), 1999);
+}
+
+TEST(MsgPackTests, TimestampSecondsOutOfRangeThrows)
+{
+    constexpr int64_t max_seconds = std::numeric_limits<int64_t>::max() / 1000;
+    constexpr int64_t min_seconds = std::numeric_limits<int64_t>::min() / 1000;
+
+    ASSERT_THROW(pb::read_msgpack(timestamp96(0, std::numeric_limits<int64_t>::max())), std::runtime_error);
+    ASSERT_THROW(pb::read_msgpack(timestamp96(0, std::numeric_limits<int64_t>::min())), std::runtime_error);
+    ASSERT_THROW(pb::read_msgpack(timestamp96(0, max_seconds + 1)), std::runtime_error);
+    ASSERT_THROW(pb::read_msgpack(timestamp96(0, min_seconds - 1)), std::runtime_error);
+    ASSERT_THROW(pb::read_msgpack(timestamp96(999000000, max_seconds)), std::runtime_error);
+    ASSERT_EQ(pb::read_msgpack(timestamp96(0, max_seconds)).root().as_date(), max_seconds * 1000);
+    ASSERT_EQ(pb::read_msgpack(timestamp96(0, min_seconds)).root().as_date(), min_seconds * 1000);
+}
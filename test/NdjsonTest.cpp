@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <pb/ndjson.h>
+
+
+static std::string make_events(size_t count) {
+    std::string data;
+    for (size_t i = 0; i < count; ++i) {
+        data += "{\"id\":" + std::to_string(i) + ",\"user\":\"u" + std::to_string(i % 97)
+              + "\",\"tags\":[{\"k\":" + std::to_string(i % 5) + "},{\"k\":7}],\"ms\":" + std::to_string(1700000000000 + i) + "}\n";
+        if (i % 1000 == 0) {
+            data += "\n";
+        }
+    }
+    return data;
+}
+
+/**
+ * This test checks that a parallel parse over many chunks produces exactly the same Blob as a single
+ * threaded one.
+ */
+TEST(NdjsonTests, ParallelMatchesSerial)
+{
+    std::string data = make_events(40000);
+    pb::Blob serial = pb::read_ndjson(data, 1);
+    pb::Blob parallel = pb::read_ndjson(data, 4);
+
+    ASSERT_EQ(serial.size(), parallel.size());
+    ASSERT_EQ(std::memcmp(serial.data(), parallel.data(), serial.size()), 0);
+    ASSERT_EQ(parallel.root().size(), 40000);
+    ASSERT_EQ(parallel.root()[31234]["user"].as_string(), "u" + std::to_string(31234 % 97));
+    ASSERT_EQ(parallel.root()[31234]["tags"].column("k").values<int64_t>()[0], 31234 % 5);
+}
+
+TEST(NdjsonTests, HomogeneousRecordsAreShredded)
+{
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += "{\"id\":" + std::to_string(i) + ",\"price\":" + std::to_string(i) + ".5}\r\n";
+    }
+    pb::Blob blob = pb::read_ndjson(data, 3);
+
+    ASSERT_TRUE(blob.root().is_columnar());
+    ASSERT_EQ(blob.root().column("price").values<double>()[999], 999.5);
+}
+
+TEST(NdjsonTests, ErrorNamesLine)
+{
+    std::string data = make_events(10) + "{\"id\": }\n";
+
+    try {
+        pb::read_ndjson(data, 2);
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        ASSERT_NE(std::string(e.what()).find("line 12"), std::string::npos);
+    }
+}
+
+TEST(NdjsonTests, RunsOnCallerExecutor)
+{
+    std::string data = make_events(20000);
+    pb::Executor executor(2);
+    pb::Blob pooled = pb::read_ndjson(data, executor);
+    pb::Blob serial = pb::read_ndjson(data, 1);
+
+    ASSERT_EQ(pooled.size(), serial.size());
+    ASSERT_EQ(std::memcmp(pooled.data(), serial.data(), serial.size()), 0);
+}
+
+/**
+ * Records that shred within each chunk but not across them, a key changing type half way, fall back to
+ * rows.  Line numbers of errors deep in the input count the lines of every chunk before.
+ */
+TEST(NdjsonTests, ChunksThatDoNotShredTogether)
+{
+    std::string data;
+    for (int i = 0; i < 60000; ++i) {
+        data += i < 30000 ? "{\"id\":" + std::to_string(i) + ",\"v\":1}\n" : "{\"id\":" + std::to_string(i) + ",\"v\":\"x\"}\n";
+    }
+    pb::Blob serial = pb::read_ndjson(data, 1);
+    pb::Blob parallel = pb::read_ndjson(data, 4);
+
+    ASSERT_FALSE(parallel.root().is_columnar());
+    ASSERT_EQ(serial.size(), parallel.size());
+    ASSERT_EQ(std::memcmp(serial.data(), parallel.data(), serial.size()), 0);
+    ASSERT_EQ(parallel.root()[45000]["v"].as_string(), "x");
+
+    data += "\n{\"id\": ]\n";
+    try {
+        pb::read_ndjson(data, 4);
+        FAIL();
+    } catch (const std::runtime_error& e) {
+        ASSERT_NE(std::string(e.what()).find("line 60002"), std::string::npos) << e.what();
+    }
+}
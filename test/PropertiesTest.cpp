@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <pb/properties.h>
+
+
+TEST(PropertiesTests, LoadsMappedFile)
+{
+    pb::Properties properties("test/resource/test.properties");
+    ASSERT_EQ(properties.at("deployment.webjava.enabled"), "true");
+    ASSERT_EQ(properties.at("deployment.security.level"), "MEDIUM");
+    ASSERT_EQ(properties.at("deployment.console.startup.mode"), "HIDE");
+    ASSERT_TRUE(properties.contains("deployment.trace.locked"));
+    ASSERT_EQ(properties.at("deployment.trace.locked"), "");
+    ASSERT_EQ(properties.at("deployment.expiration.decision.timestamp.10.10.2"), "2/28/2014 12:1:31");
+    ASSERT_FALSE(properties.contains("# Security Tab"));
+    ASSERT_EQ(properties.entries().front().key, "deployment.webjava.enabled");
+    ASSERT_THROW(properties.at("missing"), std::out_of_range);
+    ASSERT_EQ(properties.get("missing", "fallback"), "fallback");
+
+    pb::Properties moved = std::move(properties);
+    ASSERT_EQ(moved.at("deployment.security.level"), "MEDIUM");
+}
+
+TEST(PropertiesTests, SeparatorsAndComments)
+{
+    std::string text =
+        "  # comment\n"
+        "! also a comment\n"
+        "a=1\r\n"
+        "b : 2\n"
+        "c 3\n"
+        "d\t=\t 4 \n"
+        "bare\n"
+        "e==5\n"
+        "\n"
+        "a=6";
+    pb::Properties properties;
+    properties.parse(text);
+    ASSERT_EQ(properties.size(), 6);
+    ASSERT_EQ(properties.at("a"), "6");
+    ASSERT_EQ(properties.entries()[0].key, "a");
+    ASSERT_EQ(properties.at("b"), "2");
+    ASSERT_EQ(properties.at("c"), "3");
+    ASSERT_EQ(properties.at("d"), "4 ");
+    ASSERT_EQ(properties.at("bare"), "");
+    ASSERT_EQ(properties.at("e"), "=5");
+
+    // Plain entries are views into the input
+    ASSERT_GE(properties.at("b").data(), text.data());
+    ASSERT_LT(properties.at("b").data(), text.data() + text.size());
+}
+
+TEST(PropertiesTests, EscapesAndContinuations)
+{
+    pb::Properties properties;
+    properties.parse(
+        "fruits = apple, banana, \\\n"
+        "         cherry\n"
+        "key\\ with\\ spaces = value\\tand\\\\ backslash\n"
+        "unicode=caf\\u00e9 \\ud83d\\ude00\n"
+        "path=c:\\\\dir\\\\\n"
+        "next=after\n"
+        "colon\\:key=x\n"
+        "dangling=end\\");
+    ASSERT_EQ(properties.at("fruits"), "apple, banana, cherry");
+    ASSERT_EQ(properties.at("key with spaces"), "value\tand\\ backslash");
+    ASSERT_EQ(properties.at("unicode"), "caf\xc3\xa9 \xf0\x9f\x98\x80");
+    ASSERT_EQ(properties.at("path"), "c:\\dir\\");
+    ASSERT_EQ(properties.at("next"), "after");
+    ASSERT_EQ(properties.at("colon:key"), "x");
+    ASSERT_EQ(properties.at("dangling"), "end");
+    ASSERT_THROW(properties.parse("bad=\\u12"), std::runtime_error);
+}
+
+TEST(PropertiesTests, ManyEntries)
+{
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "service.node" + std::to_string(i) + ".port=" + std::to_string(8000 + i) + "\n";
+    }
+    pb::Properties properties;
+    properties.parse(text);
+    ASSERT_EQ(properties.size(), 5000);
+    for (int i = 0; i < 5000; i += 7) {
+        ASSERT_EQ(properties.at("service.node" + std::to_string(i) + ".port"), std::to_string(8000 + i));
+    }
+    ASSERT_FALSE(properties.contains("service.node5000.port"));
+}
+
+TEST(PropertiesTests, PrefixAndSubtreeQueries)
+{
+    pb::Properties properties("test/resource/test.properties");
+
+    std::vector<std::string_view> keys;
+    for (const pb::PropertiesEntry& entry : properties.subtree("deployment.security")) {
+        keys.push_back(entry.key);
+    }
+    ASSERT_FALSE(keys.empty());
+    size_t expected = 0;
+    for (const pb::PropertiesEntry& entry : properties.entries()) {
+        expected += entry.key.starts_with("deployment.security.") ? 1 : 0;
+    }
+    ASSERT_EQ(keys.size(), expected);
+    ASSERT_EQ(properties.subtree("deployment.security.level").size(), 1);
+    ASSERT_EQ(properties.subtree("deployment.security.lev").size(), 0);
+    ASSERT_EQ(properties.subtree("").size(), properties.size());
+    ASSERT_EQ(properties.with_prefix("deployment.security.lev").size(), 2);
+}
+
+/**
+ * This test checks the ordering corner: '-' sorts before '.' in ASCII, but subtrees must stay
+ * contiguous so "a.b.c" is found under "a.b" even though "a.b-x" exists.
+ */
+TEST(PropertiesTests, SubtreesStayContiguous)
+{
+    pb::Properties properties;
+    properties.parse("a.b=1\na.b-x=2\na.b.c=3\na.b.d.e=4\na.c=5\na.b0=6\nz=7\n");
+    ASSERT_EQ(properties.subtree("a.b").size(), 2);
+    ASSERT_EQ(properties.with_prefix("a.b").size(), 5);
+
+    std::vector<std::string_view> children;
+    properties.for_each_child("a", [&](std::string_view segment) { children.push_back(segment); });
+    ASSERT_EQ(children, (std::vector<std::string_view>{ "b", "b-x", "b0", "c" }));
+
+    std::vector<std::string_view> roots;
+    properties.for_each_child("", [&](std::string_view segment) { roots.push_back(segment); });
+    ASSERT_EQ(roots, (std::vector<std::string_view>{ "a", "z" }));
+
+    std::vector<std::string_view> deeper;
+    properties.for_each_child("a.b", [&](std::string_view segment) { deeper.push_back(segment); });
+    ASSERT_EQ(deeper, (std::vector<std::string_view>{ "c", "d" }));
+}
+
+TEST(PropertiesTests, TypedValues)
+{
+    pb::Properties properties;
+    properties.parse(
+        "enabled = true\n"
+        "locked = 0\n"
+        "port = 8080\n"
+        "offset = -12\n"
+        "ratio = 0.75\n"
+        "timeout = 1.5s\n"
+        "interval = 250\n"
+        "expires = 2014-02-28T12:01:31.500+01:00\n"
+        "name = MEDIUM\n");
+
+    ASSERT_TRUE(properties.get<bool>("enabled"));
+    ASSERT_FALSE(properties.get<bool>("locked"));
+    ASSERT_EQ(properties.get<int>("port"), 8080);
+    ASSERT_EQ(properties.get<int64_t>("offset"), -12);
+    ASSERT_EQ(properties.get<uint16_t>("port"), 8080);
+    ASSERT_DOUBLE_EQ(properties.get<double>("ratio"), 0.75);
+    ASSERT_DOUBLE_EQ(properties.get<double>("port"), 8080.0);
+    ASSERT_EQ(properties.get<std::chrono::milliseconds>("timeout"), std::chrono::milliseconds(1500));
+    ASSERT_EQ(properties.get<std::chrono::milliseconds>("interval"), std::chrono::milliseconds(250));
+    ASSERT_EQ(properties.get<std::chrono::sys_time<std::chrono::milliseconds>>("expires").time_since_epoch().count(),
+              1393585291500);
+    ASSERT_EQ(properties.get<std::string_view>("name"), "MEDIUM");
+
+    // Cached results, valid or not, are returned again
+    ASSERT_EQ(properties.get<int>("port"), 8080);
+    ASSERT_THROW(properties.get<int>("name"), std::runtime_error);
+    ASSERT_THROW(properties.get<int>("name"), std::runtime_error);
+    ASSERT_THROW(properties.get<uint8_t>("port"), std::runtime_error);
+    ASSERT_THROW(properties.get<uint32_t>("offset"), std::runtime_error);
+    ASSERT_THROW(properties.get<bool>("missing"), std::out_of_range);
+
+    ASSERT_EQ(properties.get<int>("name", 7), 7);
+    ASSERT_EQ(properties.get<int>("missing", 9), 9);
+    ASSERT_EQ(properties.get<int>("port", 9), 8080);
+    ASSERT_EQ(properties.get("missing", "fallback"), "fallback");
+}
+
+TEST(PropertiesTests, ValueParsers)
+{
+    ASSERT_EQ(pb::parse_boolean(" TRUE "), true);
+    ASSERT_EQ(pb::parse_boolean("False"), false);
+    ASSERT_FALSE(pb::parse_boolean("yes"));
+
+    ASSERT_EQ(pb::parse_integer("+42"), 42);
+    ASSERT_EQ(pb::parse_integer("-9223372036854775808"), INT64_MIN);
+    ASSERT_FALSE(pb::parse_integer("9223372036854775808"));
+    ASSERT_FALSE(pb::parse_integer("12a"));
+    ASSERT_FALSE(pb::parse_integer(""));
+
+    ASSERT_EQ(pb::parse_double("1e3"), 1000.0);
+    ASSERT_EQ(pb::parse_double(".5"), 0.5);
+    ASSERT_FALSE(pb::parse_double("inf"));
+    ASSERT_FALSE(pb::parse_double("1.2.3"));
+
+    ASSERT_EQ(pb::parse_duration("2h"), std::chrono::hours(2));
+    ASSERT_EQ(pb::parse_duration("10 us"), std::chrono::microseconds(10));
+    ASSERT_EQ(pb::parse_duration("1d"), std::chrono::hours(24));
+    ASSERT_FALSE(pb::parse_duration("5 weeks"));
+    ASSERT_FALSE(pb::parse_duration("s"));
+
+    ASSERT_EQ(pb::parse_iso_date("1970-01-01"), 0);
+    ASSERT_EQ(pb::parse_iso_date("2000-03-01T00:00:00Z"), 951868800000);
+    ASSERT_EQ(pb::parse_iso_date("1969-12-31 23:59"), -60000);
+    ASSERT_FALSE(pb::parse_iso_date("2014-13-01"));
+    ASSERT_FALSE(pb::parse_iso_date("2014-02-28T12"));
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <pb/string_util.h>
+
+#include <functional>
+#include <regex>
+#include <string>
+#include <vector>
+
+
+/**
+ * The classifiers are hand written scanners.  This test checks them against the regular expressions
+ * that define the accepted formats, over a corpus of near misses.
+ */
+TEST(StringUtilTests, ClassifiersMatchTheirPatterns)
+{
+    const std::vector<std::string> corpus = {
+        "", " ", "0", "1", "00", "07", "08", "0o17", "0O7", "0o", "0x", "0x1F", " 0Xab ", "0xg", "0b101", "0B2", "0b",
+        "12", "-12", "+12", "+-1", "1.", ".5", "-.5", "1.5", "1.5e3", "1.5E-3", "1e5", "1e", "1.e5", "e5", ".", "-",
+        " \t42\r\n", "4 2", "12a", "true", "FALSE", " True ", "tru", "yes", "1.5.5", "1,5",
+        "2020-01-31", "2020/01/31", "2020-01/31", "31-01-2020", "31/01/2020", "2020-1-31", "20200131",
+        "2020-01-31T10:20:30", "2020-01-31 10:20:30", "2020-01-31T10:20:30.123Z", "2020-01-31T10:20:30+02:00",
+        "2020-01-31T10:20:30-0200", "2020-01-31T10:20", "2020-01-31T10:20:30.", "2020-01-31T10:20:30Z+01:00",
+        "Jan 1, 2020", "January 12 2020", "1 Jan 2020", "12  September\t2020", "Sept 1,2020", "Ja 1, 2020",
+        "Septembers 1, 2020", "1 Jan, 2020", "123 Jan 2020", " 2020-01-31 ",
+    };
+
+    const auto matches = [](const char* pattern) {
+        std::regex regex(pattern, std::regex::icase);
+        return [regex](const std::string& text) { return std::regex_match(text, regex); };
+    };
+    const std::vector<std::pair<bool (*)(const std::string&), std::function<bool(const std::string&)>>> checks = {
+        { pb::is_numeric, matches(R"(^\s*[-+]?\d*\.?\d+(e[-+]?\d+)?\s*$)") },
+        { pb::is_integer, matches(R"(^\s*[-+]?\d+\s*$)") },
+        { pb::is_hexadecimal, matches(R"(^\s*0[xX][0-9a-fA-F]+\s*$)") },
+        { pb::is_octal, matches(R"(^\s*0[oO]?[0-7]+\s*$)") },
+        { pb::is_binary, matches(R"(^\s*0[bB][01]+\s*$)") },
+        { pb::is_double, matches(R"(^\s*[-+]?\d+\.\d+(e[-+]?\d+)?\s*$)") },
+        { pb::is_double_with_optional_decimal, matches(R"(^\s*[-+]?\d*\.?\d+(e[-+]?\d+)?\s*$)") },
+        { pb::is_boolean, matches(R"(^\s*(true|false|1|0)\s*$)") },
+        { pb::is_real_number, matches(R"(^\s*[-+]?\d+(\.\d+)?([eE][-+]?\d+)?\s*$)") },
+    };
+    for (size_t c = 0; c < checks.size(); ++c) {
+        for (const std::string& text : corpus) {
+            ASSERT_EQ(checks[c].first(text), checks[c].second(text)) << "check " << c << " on '" << text << "'";
+        }
+    }
+
+    const std::regex dates[] = {
+        std::regex(R"(^\d{4}[-/]\d{2}[-/]\d{2}$)"),
+        std::regex(R"(^\d{2}[-/]\d{2}[-/]\d{4}$)"),
+        std::regex(R"(^\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(\.\d+)?(Z|[+-]\d{2}:\d{2})?$)"),
+        std::regex(R"(^([A-Za-z]{3,9})\s+\d{1,2},?\s+\d{4}$)"),
+        std::regex(R"(^\d{1,2}\s+([A-Za-z]{3,9})\s+\d{4}$)"),
+    };
+    for (const std::string& text : corpus) {
+        std::string trimmed = pb::trim(text);
+        bool expected = false;
+        for (const std::regex& date : dates) {
+            expected = expected || std::regex_match(trimmed, date);
+        }
+        ASSERT_EQ(pb::is_date(text), expected) << "'" << text << "'";
+    }
+}
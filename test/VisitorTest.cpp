@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <pb/blob_compare.h>
+#include <pb/csv.h>
+#include <pb/json.h>
+#include <pb/visitor.h>
+
+
+// Sums every integer and records the keys, ignoring everything else
+struct SumVisitor : pb::BlobVisitorBase {
+    int64_t sum = 0;
+    std::string keys;
+
+    void on_int64(int64_t value) { sum += value; }
+    void on_key(std::string_view key) { keys += key; }
+};
+
+static_assert(pb::BlobVisitor<SumVisitor>);
+static_assert(pb::BlobVisitor<pb::BlobBuilderVisitor>);
+
+TEST(VisitorTests, JsonDrivesVisitorWithoutBlob)
+{
+    SumVisitor visitor;
+    pb::read_json(R"({"a": 1, "b": [2, 3, {"c": -4}], "d": "xAy", "e": 1.5})", visitor);
+    ASSERT_EQ(visitor.sum, 2);
+    ASSERT_EQ(visitor.keys, "abcde");
+
+    SumVisitor broken;
+    ASSERT_THROW(pb::read_json(R"({"a": 1,})", broken), std::runtime_error);
+}
+
+/**
+ * This test checks that visiting a Blob into a BlobBuilderVisitor reproduces it, including the rows of a
+ * columnar array and the values of a delta array.
+ */
+TEST(VisitorTests, BlobTraversalRoundTrips)
+{
+    std::string text = R"({"rows": [)";
+    for (int i = 0; i < 20; ++i) {
+        text += (i ? "," : "") + std::string(R"({"id":)") + std::to_string(i) + R"(,"name":"n)" + std::to_string(i) + R"("})";
+    }
+    text += R"(], "ids": [)";
+    for (int i = 0; i < 100; ++i) {
+        text += (i ? "," : "") + std::to_string(i * 3);
+    }
+    text += "]}";
+    pb::Blob blob = pb::read_json(text);
+    ASSERT_TRUE(blob.root()["rows"].is_columnar());
+    ASSERT_TRUE(blob.root()["ids"].is_delta());
+
+    pb::BlobBuilder builder;
+    pb::BlobBuilderVisitor visitor(builder);
+    pb::visit(blob, visitor);
+    pb::Blob copy = builder.build();
+    ASSERT_TRUE(copy == blob);
+
+    SumVisitor sum;
+    pb::visit(blob, sum);
+    ASSERT_EQ(sum.sum, 190 + 3 * 4950);
+}
+
+TEST(VisitorTests, CsvDrivesVisitor)
+{
+    pb::CSVProperties properties;
+    properties.add_column(pb::CSVColumn("name"));
+    properties.add_column(pb::CSVColumn("count", pb::CSVDataType::INTEGER));
+    properties.add_column(pb::CSVColumn("price", pb::CSVDataType::FLOAT));
+    properties.add_column(pb::CSVColumn("active", pb::CSVDataType::BOOLEAN));
+    pb::CSV csv(properties);
+
+    pb::BlobBuilder builder;
+    pb::BlobBuilderVisitor visitor(builder);
+    csv.parse("\"a, b\",3,1.5,true\nc,,2,0\nd,7\n", visitor);
+    pb::Blob blob = builder.build();
+    ASSERT_EQ(pb::write_json(blob),
+              R"([{"name":"a, b","count":3,"price":1.5,"active":true},)"
+              R"({"name":"c","count":null,"price":2.0,"active":false},)"
+              R"({"name":"d","count":7,"price":null,"active":null}])");
+    ASSERT_EQ(csv.get_row_count(), 0);
+
+    pb::CSV bad(properties);
+    SumVisitor ignore;
+    ASSERT_THROW(bad.parse("x,notanumber,1,true\n", ignore), std::runtime_error);
+}
+
+TEST(VisitorTests, CsvWithoutColumnsReportsArrays)
+{
+    pb::CSV csv;
+    pb::BlobBuilder builder;
+    pb::BlobBuilderVisitor visitor(builder);
+    csv.parse("a\tb\r\n1\t2\r\n", visitor);
+    ASSERT_EQ(pb::write_json(builder.build()), R"([["a","b"],["1","2"]])");
+
+    pb::CSVProperties properties;
+    properties.set_has_header(true);
+    pb::CSV with_header(properties);
+    pb::BlobBuilder header_builder;
+    pb::BlobBuilderVisitor header_visitor(header_builder);
+    with_header.parse("x,y\n1,2\n", header_visitor);
+    ASSERT_EQ(pb::write_json(header_builder.build()), R"([{"x":"1","y":"2"}])");
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <pb/watched_properties.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+
+namespace {
+
+    std::filesystem::path temporary_path(const std::string& name) {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / ("pb-watched-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(directory);
+        return directory / name;
+    }
+
+    void write_file(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << text;
+    }
+
+    bool wait_for_version(const pb::WatchedProperties& properties, uint64_t version) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (properties.version() < version) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+}
+
+
+TEST(WatchedPropertiesTests, ReloadsOnWriteAndRename)
+{
+    std::filesystem::path path = temporary_path("service.properties");
+    write_file(path, "http.port = 8080\nname = first\n");
+
+    pb::WatchedProperties properties(path.string(), nullptr, std::chrono::milliseconds(10));
+    ASSERT_EQ(properties.version(), 1u);
+    pb::WatchedProperties::Snapshot first = properties.snapshot();
+    ASSERT_EQ(first->get<int>("http.port"), 8080);
+
+    write_file(path, "http.port = 9090\nname = second\n");
+    ASSERT_TRUE(wait_for_version(properties, 2));
+    ASSERT_EQ(properties.snapshot()->get<int>("http.port"), 9090);
+
+    // A held snapshot is unaffected by reloads
+    ASSERT_EQ(first->at("name"), "first");
+
+    std::filesystem::path staged = temporary_path("service.properties.new");
+    write_file(staged, "http.port = 7070\nname = third\n");
+    uint64_t before = properties.version();
+    std::filesystem::rename(staged, path);
+    ASSERT_TRUE(wait_for_version(properties, before + 1));
+    ASSERT_EQ(properties.snapshot()->at("name"), "third");
+
+    properties.stop();
+    std::filesystem::remove(path);
+    ASSERT_FALSE(properties.reload());
+    ASSERT_EQ(properties.snapshot()->at("name"), "third");
+}
+
+TEST(WatchedPropertiesTests, ReadersNeverSeeHalfAppliedReloads)
+{
+    std::filesystem::path path = temporary_path("consistent.properties");
+    write_file(path, "a = 0\nb = 0\n");
+
+    std::atomic<int> reloads{ 0 };
+    pb::WatchedProperties properties(path.string(), [&](const pb::WatchedProperties::Snapshot&) { ++reloads; });
+    properties.stop();
+
+    std::atomic<bool> done{ false };
+    std::atomic<bool> consistent{ true };
+    std::thread reader([&] {
+        while (!done.load()) {
+            pb::WatchedProperties::Snapshot snapshot = properties.snapshot();
+            if (snapshot->get<int>("a") != snapshot->get<int>("b")) {
+                consistent = false;
+            }
+        }
+    });
+    for (int i = 1; i <= 50; ++i) {
+        write_file(path, "a = " + std::to_string(i) + "\nb = " + std::to_string(i) + "\n");
+        ASSERT_TRUE(properties.reload());
+    }
+    done = true;
+    reader.join();
+
+    ASSERT_TRUE(consistent.load());
+    ASSERT_EQ(reloads.load(), 50);
+    ASSERT_EQ(properties.version(), 51u);
+    ASSERT_EQ(properties.snapshot()->get<int>("a"), 50);
+    std::filesystem::remove(path);
+}
+
+TEST(WatchedPropertiesTests, MissingFileThrows)
+{
+    ASSERT_THROW(pb::WatchedProperties(temporary_path("missing.properties").string()), std::runtime_error);
+}